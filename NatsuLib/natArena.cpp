@@ -0,0 +1,112 @@
+﻿#include "stdafx.h"
+#include "natArena.h"
+#include "natException.h"
+
+#include <algorithm>
+#include <cstdint>
+
+using namespace NatsuLib;
+
+namespace
+{
+	nByte* AlignUp(nByte* ptr, std::size_t alignment) noexcept
+	{
+		const auto value = reinterpret_cast<std::uintptr_t>(ptr);
+		return ptr + ((alignment - value % alignment) % alignment);
+	}
+}
+
+natArena::natArena(std::size_t blockSize)
+	: m_BlockSize{ blockSize ? blockSize : static_cast<std::size_t>(DefaultBlockSize) }, m_CurrentBlock{}, m_Current{}, m_End{}, m_AllocatedSize{}
+{
+}
+
+natArena::~natArena()
+{
+}
+
+void* natArena::Allocate(std::size_t size, std::size_t alignment)
+{
+	if (!alignment || (alignment & (alignment - 1)))
+	{
+		nat_Throw(natErrException, NatErr_InvalidArg, "alignment should be a power of 2."_nv);
+	}
+
+	auto ptr = AlignUp(m_Current, alignment);
+	if (!m_Current || static_cast<std::size_t>(m_End - ptr) < size)
+	{
+		auto found = false;
+		for (auto i = m_Current ? m_CurrentBlock + 1 : m_CurrentBlock; i < m_Blocks.size(); ++i)
+		{
+			if (SwitchToBlock(i, size, alignment))
+			{
+				found = true;
+				break;
+			}
+		}
+
+		if (!found)
+		{
+			m_Blocks.push_back({ std::make_unique<nByte[]>(std::max(m_BlockSize, size + alignment)), std::max(m_BlockSize, size + alignment) });
+			SwitchToBlock(m_Blocks.size() - 1, size, alignment);
+		}
+
+		ptr = AlignUp(m_Current, alignment);
+	}
+
+	m_Current = ptr + size;
+	m_AllocatedSize += size;
+	return ptr;
+}
+
+nBool natArena::TryExtend(void* ptr, std::size_t oldSize, std::size_t newSize) noexcept
+{
+	const auto begin = static_cast<nByte*>(ptr);
+	if (!begin || begin + oldSize != m_Current || newSize < oldSize || static_cast<std::size_t>(m_End - begin) < newSize)
+	{
+		return false;
+	}
+
+	m_Current = begin + newSize;
+	m_AllocatedSize += newSize - oldSize;
+	return true;
+}
+
+void natArena::Reset() noexcept
+{
+	m_CurrentBlock = 0;
+	m_Current = m_Blocks.empty() ? nullptr : m_Blocks.front().Memory.get();
+	m_End = m_Blocks.empty() ? nullptr : m_Current + m_Blocks.front().Size;
+	m_AllocatedSize = 0;
+}
+
+std::size_t natArena::GetAllocatedSize() const noexcept
+{
+	return m_AllocatedSize;
+}
+
+std::size_t natArena::GetReservedSize() const noexcept
+{
+	std::size_t size{};
+	for (auto const& block : m_Blocks)
+	{
+		size += block.Size;
+	}
+	return size;
+}
+
+nBool natArena::SwitchToBlock(std::size_t index, std::size_t size, std::size_t alignment) noexcept
+{
+	auto const& block = m_Blocks[index];
+	const auto begin = block.Memory.get();
+	const auto end = begin + block.Size;
+	if (static_cast<std::size_t>(end - AlignUp(begin, alignment)) < size)
+	{
+		return false;
+	}
+
+	m_CurrentBlock = index;
+	m_Current = begin;
+	m_End = end;
+	return true;
+}
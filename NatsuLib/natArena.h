@@ -0,0 +1,77 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+///	@file	natArena.h
+///	@brief	线性分配的内存区域
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "natType.h"
+#include "natMisc.h"
+
+namespace NatsuLib
+{
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	线性（bump）分配器
+	///	@remark	从预先分配的内存块中顺序分配内存，不支持单独释放，所有内存在 Reset 或析构时统一回收
+	///	@note	非线程安全，内存块在 Reset 后会被复用
+	////////////////////////////////////////////////////////////////////////////////
+	class natArena final
+		: public nonmovable
+	{
+	public:
+		enum : std::size_t
+		{
+			DefaultBlockSize = 4096,
+		};
+
+		explicit natArena(std::size_t blockSize = DefaultBlockSize);
+		~natArena();
+
+		///	@brief	分配内存
+		///	@param[in]	size		要分配的字节数
+		///	@param[in]	alignment	对齐，必须为 2 的幂
+		///	@return	分配得到的内存，在 Reset 或析构之前有效
+		void* Allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t));
+
+		template <typename T>
+		T* AllocateArray(std::size_t count)
+		{
+			return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+		}
+
+		///	@brief	尝试原地扩展最近一次分配的内存
+		///	@param[in]	ptr		之前分配的内存
+		///	@param[in]	oldSize	之前分配的字节数
+		///	@param[in]	newSize	扩展后的字节数
+		///	@return	若 ptr 为最近一次分配且当前内存块剩余空间足够则扩展并返回 true，否则不做任何修改并返回 false
+		nBool TryExtend(void* ptr, std::size_t oldSize, std::size_t newSize) noexcept;
+
+		///	@brief	回收所有已分配的内存
+		///	@note	已分配的内存块将会被保留以供之后的分配使用
+		void Reset() noexcept;
+
+		///	@brief	获得已分配的字节数（不包括因对齐及内存块切换浪费的空间）
+		std::size_t GetAllocatedSize() const noexcept;
+
+		///	@brief	获得所持有的内存块的总字节数
+		std::size_t GetReservedSize() const noexcept;
+
+	private:
+		struct Block
+		{
+			std::unique_ptr<nByte[]> Memory;
+			std::size_t Size;
+		};
+
+		nBool SwitchToBlock(std::size_t index, std::size_t size, std::size_t alignment) noexcept;
+
+		std::size_t m_BlockSize;
+		std::vector<Block> m_Blocks;
+		std::size_t m_CurrentBlock;
+		nByte* m_Current;
+		nByte* m_End;
+		std::size_t m_AllocatedSize;
+	};
+}
@@ -0,0 +1,470 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+///	@file	natColumnar.h
+///	@brief	列式存储及列式语言集成查询
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <algorithm>
+#include <functional>
+#include <tuple>
+#include <vector>
+
+#include "natConfig.h"
+#include "natLinq.h"
+
+#ifdef UseSSE2
+#	include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#	pragma push_macro("max")
+#	pragma push_macro("min")
+#endif
+
+#undef max
+#undef min
+
+namespace NatsuLib
+{
+	namespace detail_
+	{
+		///	@brief	选择位图，每一位表示对应的行是否被选中
+		class SelectionBitmap
+		{
+		public:
+			typedef nuLong Word_t;
+
+			enum : size_t
+			{
+				BitsPerWord = sizeof(Word_t) * 8,
+			};
+
+			SelectionBitmap() noexcept
+				: m_Size{}
+			{
+			}
+
+			explicit SelectionBitmap(size_t size, nBool value = true)
+				: m_Words((size + BitsPerWord - 1) / BitsPerWord, value ? ~Word_t{} : Word_t{}), m_Size{ size }
+			{
+				// 保证超出 size 的位始终为 0
+				if (value && size % BitsPerWord)
+				{
+					m_Words.back() = (Word_t{ 1 } << size % BitsPerWord) - 1;
+				}
+			}
+
+			size_t size() const noexcept
+			{
+				return m_Size;
+			}
+
+			size_t GetWordCount() const noexcept
+			{
+				return m_Words.size();
+			}
+
+			Word_t* GetWords() noexcept
+			{
+				return m_Words.data();
+			}
+
+			const Word_t* GetWords() const noexcept
+			{
+				return m_Words.data();
+			}
+
+			nBool Test(size_t index) const noexcept
+			{
+				return (m_Words[index / BitsPerWord] >> index % BitsPerWord) & 1;
+			}
+
+			size_t Count() const noexcept
+			{
+				size_t count{};
+				for (const auto word : m_Words)
+				{
+					count += PopCount(word);
+				}
+				return count;
+			}
+
+			nBool Any() const noexcept
+			{
+				return std::any_of(m_Words.begin(), m_Words.end(), [](Word_t word) { return word != 0; });
+			}
+
+			///	@brief	按升序对每个被选中的行调用 callableObj
+			template <typename CallableObj>
+			void ForEach(CallableObj&& callableObj) const
+			{
+				const auto wordCount = m_Words.size();
+				for (size_t i = 0; i < wordCount; ++i)
+				{
+					auto word = m_Words[i];
+					while (word)
+					{
+						callableObj(i * BitsPerWord + CountTrailingZeros(word));
+						word &= word - 1;
+					}
+				}
+			}
+
+			std::vector<size_t> ToIndices() const
+			{
+				std::vector<size_t> result;
+				result.reserve(Count());
+				ForEach([&result](size_t index)
+				{
+					result.emplace_back(index);
+				});
+				return result;
+			}
+
+			///	@brief	将 BitsPerWord 个取值为 0 或 1 的标记压缩为一个字
+			static Word_t PackFlags(const nByte* flags) noexcept
+			{
+				Word_t result{};
+#ifdef UseSSE2
+				// 标记只有最低位可能为 1，左移到每个字节的最高位后由 movemask 一次取出 16 位
+				for (size_t i = 0; i < BitsPerWord / 16; ++i)
+				{
+					const auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(flags + i * 16));
+					result |= static_cast<Word_t>(static_cast<nuShort>(_mm_movemask_epi8(_mm_slli_epi16(value, 7)))) << i * 16;
+				}
+#else
+				for (size_t i = 0; i < BitsPerWord; ++i)
+				{
+					result |= static_cast<Word_t>(flags[i]) << i;
+				}
+#endif
+				return result;
+			}
+
+		private:
+			std::vector<Word_t> m_Words;
+			size_t m_Size;
+		};
+
+		template <typename Table_t, size_t... Columns>
+		struct ColumnGather
+		{
+			typedef std::conditional_t<sizeof...(Columns) == 1,
+				std::tuple_element_t<0, std::tuple<typename Table_t::template ColumnType<Columns> const&...>>,
+				std::tuple<typename Table_t::template ColumnType<Columns>...>> result_type;
+
+			const Table_t* m_pTable;
+
+			result_type operator()(size_t row) const
+			{
+				if constexpr (sizeof...(Columns) == 1)
+				{
+					return m_pTable->template GetColumn<Columns...>()[row];
+				}
+				else
+				{
+					return result_type{ m_pTable->template GetColumn<Columns>()[row]... };
+				}
+			}
+		};
+
+		template <typename Table_t, typename CallableObj_t, size_t... Columns>
+		struct ColumnProject
+		{
+			const Table_t* m_pTable;
+			CallableObj_t m_CallableObj;
+
+			decltype(auto) operator()(size_t row) const
+			{
+				return m_CallableObj(m_pTable->template GetColumn<Columns>()[row]...);
+			}
+		};
+	}
+
+	///	@brief	列式表
+	///	@remark	每一列单独连续存储，查询只涉及部分列时可以避免读取无关的字段
+	///	@tparam	Columns_t	各列的类型，由于 std::vector<bool> 不连续存储，bool 列请使用 nByte 代替
+	template <typename... Columns_t>
+	class ColumnTable
+	{
+		static_assert(sizeof...(Columns_t) > 0, "ColumnTable requires at least one column.");
+		static_assert(!std::disjunction_v<std::is_same<Columns_t, bool>...>, "bool column is not supported, use nByte instead.");
+
+	public:
+		typedef std::tuple<Columns_t...> RowType;
+
+		template <size_t Column>
+		using ColumnType = std::tuple_element_t<Column, RowType>;
+
+		enum : size_t
+		{
+			ColumnCount = sizeof...(Columns_t),
+		};
+
+		ColumnTable() = default;
+
+		///	@brief	从按行存储的记录中提取各列以创建列式表
+		///	@param[in]	rows		记录的范围
+		///	@param[in]	projections	各列对应的投影，可以是成员指针或可调用对象
+		template <typename Range_t, typename... Projections_t>
+		static ColumnTable FromRows(Range_t const& rows, Projections_t... projections)
+		{
+			static_assert(sizeof...(Projections_t) == sizeof...(Columns_t), "Projection count mismatch.");
+
+			ColumnTable result;
+			result.reserve(static_cast<size_t>(std::distance(std::begin(rows), std::end(rows))));
+			for (auto&& row : rows)
+			{
+				result.push_back(static_cast<Columns_t>(std::invoke(projections, row))...);
+			}
+			return result;
+		}
+
+		size_t size() const noexcept
+		{
+			return std::get<0>(m_Columns).size();
+		}
+
+		nBool empty() const noexcept
+		{
+			return std::get<0>(m_Columns).empty();
+		}
+
+		void reserve(size_t capacity)
+		{
+			std::apply([capacity](auto&... columns)
+			{
+				(columns.reserve(capacity), ...);
+			}, m_Columns);
+		}
+
+		void clear() noexcept
+		{
+			std::apply([](auto&... columns)
+			{
+				(columns.clear(), ...);
+			}, m_Columns);
+		}
+
+		void push_back(Columns_t... values)
+		{
+			PushBackImpl(std::index_sequence_for<Columns_t...>{}, std::move(values)...);
+		}
+
+		void push_back(RowType row)
+		{
+			std::apply([this](auto&&... values)
+			{
+				PushBackImpl(std::index_sequence_for<Columns_t...>{}, std::move(values)...);
+			}, std::move(row));
+		}
+
+		RowType GetRow(size_t row) const
+		{
+			if (row >= size())
+			{
+				nat_Throw(natErrException, NatErr_OutOfRange, "Row out of range."_nv);
+			}
+
+			return std::apply([row](auto const&... columns)
+			{
+				return RowType{ columns[row]... };
+			}, m_Columns);
+		}
+
+		template <size_t Column>
+		std::vector<ColumnType<Column>> const& GetColumn() const noexcept
+		{
+			return std::get<Column>(m_Columns);
+		}
+
+		///	@brief	获得指定单元格的引用
+		///	@note	不检查越界
+		template <size_t Column>
+		ColumnType<Column>& At(size_t row) noexcept
+		{
+			return std::get<Column>(m_Columns)[row];
+		}
+
+		template <size_t Column>
+		ColumnType<Column> const& At(size_t row) const noexcept
+		{
+			return std::get<Column>(m_Columns)[row];
+		}
+
+	private:
+		std::tuple<std::vector<Columns_t>...> m_Columns;
+
+		template <size_t... Index>
+		void PushBackImpl(std::index_sequence<Index...>, Columns_t... values)
+		{
+			const auto oldSize = size();
+			try
+			{
+				(std::get<Index>(m_Columns).push_back(std::move(values)), ...);
+			}
+			catch (...)
+			{
+				// 保持各列长度一致
+				std::apply([oldSize](auto&... columns)
+				{
+					((columns.size() > oldSize ? columns.resize(oldSize) : void()), ...);
+				}, m_Columns);
+				throw;
+			}
+		}
+	};
+
+	///	@brief	列式查询
+	///	@remark	where 按列逐块求值谓词并与选择位图按位与，已被全部排除的块不会再求值；
+	///			select 只读取被请求的列，并以 LinqEnumerable 的形式返回以便继续使用普通的查询操作
+	///	@note	不持有列式表的所有权，列式表必须比查询及由其创建的 LinqEnumerable 存活更久
+	template <typename Table_t>
+	class ColumnQuery
+	{
+	public:
+		typedef Table_t TableType;
+		typedef detail_::SelectionBitmap::Word_t Word_t;
+
+		explicit ColumnQuery(Table_t const& table)
+			: m_pTable{ &table }, m_Selection(table.size())
+		{
+		}
+
+		ColumnQuery(Table_t const& table, detail_::SelectionBitmap selection)
+			: m_pTable{ &table }, m_Selection(std::move(selection))
+		{
+			if (m_Selection.size() != table.size())
+			{
+				nat_Throw(natErrException, NatErr_InvalidArg, "Selection size mismatch."_nv);
+			}
+		}
+
+		///	@brief	以指定列为参数的谓词筛选行
+		///	@tparam	Columns		谓词的参数对应的列
+		///	@param[in]	callableObj	谓词，参数依次为各列的值
+		///	@remark	谓词在连续的列数据上按块求值，结果压缩为位图，简单的比较可被编译器向量化
+		template <size_t... Columns, typename CallableObj>
+		ColumnQuery where(CallableObj&& callableObj) const&
+		{
+			auto result = *this;
+			result.template Filter<Columns...>(callableObj);
+			return result;
+		}
+
+		template <size_t... Columns, typename CallableObj>
+		ColumnQuery where(CallableObj&& callableObj) &&
+		{
+			Filter<Columns...>(callableObj);
+			return std::move(*this);
+		}
+
+		///	@brief	以指定列创建 LinqEnumerable
+		///	@remark	只请求一列时元素为该列的值的常量引用，否则为各列的值组成的 std::tuple
+		template <size_t... Columns>
+		auto select() const
+		{
+			static_assert(sizeof...(Columns) > 0, "At least one column is required.");
+			return indices().select(detail_::ColumnGather<Table_t, Columns...>{ m_pTable });
+		}
+
+		///	@brief	以指定列为参数的可调用对象的结果创建 LinqEnumerable
+		template <size_t... Columns, typename CallableObj>
+		auto select(CallableObj&& callableObj) const
+		{
+			static_assert(sizeof...(Columns) > 0, "At least one column is required.");
+			return indices().select(detail_::ColumnProject<Table_t, std::decay_t<CallableObj>, Columns...>{ m_pTable, std::forward<CallableObj>(callableObj) });
+		}
+
+		///	@brief	被选中的行号
+		auto indices() const
+		{
+			return from_container(m_Selection.ToIndices());
+		}
+
+		size_t count() const noexcept
+		{
+			return m_Selection.Count();
+		}
+
+		nBool any() const noexcept
+		{
+			return m_Selection.Any();
+		}
+
+		template <size_t Column>
+		auto sum() const
+		{
+			const auto pData = m_pTable->template GetColumn<Column>().data();
+			typename Table_t::template ColumnType<Column> result{};
+			m_Selection.ForEach([&result, pData](size_t row)
+			{
+				result += pData[row];
+			});
+			return result;
+		}
+
+		Table_t const& GetTable() const noexcept
+		{
+			return *m_pTable;
+		}
+
+		detail_::SelectionBitmap const& GetSelection() const noexcept
+		{
+			return m_Selection;
+		}
+
+	private:
+		const Table_t* m_pTable;
+		detail_::SelectionBitmap m_Selection;
+
+		template <size_t... Columns, typename CallableObj>
+		void Filter(CallableObj& callableObj)
+		{
+			static_assert(sizeof...(Columns) > 0, "At least one column is required.");
+
+			constexpr size_t BitsPerWord = detail_::SelectionBitmap::BitsPerWord;
+			const auto columns = std::make_tuple(m_pTable->template GetColumn<Columns>().data()...);
+			const auto size = m_Selection.size();
+			const auto wordCount = m_Selection.GetWordCount();
+			const auto pWords = m_Selection.GetWords();
+			nByte flags[BitsPerWord];
+
+			for (size_t i = 0; i < wordCount; ++i)
+			{
+				if (!pWords[i])
+				{
+					continue;
+				}
+
+				const auto base = i * BitsPerWord;
+				const auto blockSize = std::min<size_t>(BitsPerWord, size - base);
+				std::apply([&](auto const*... pColumns)
+				{
+					for (size_t j = 0; j < blockSize; ++j)
+					{
+						flags[j] = static_cast<nByte>(static_cast<nBool>(callableObj(pColumns[base + j]...)));
+					}
+				}, columns);
+				std::fill(flags + blockSize, flags + BitsPerWord, nByte{});
+
+				pWords[i] &= detail_::SelectionBitmap::PackFlags(flags);
+			}
+		}
+	};
+
+	///	@brief	以列式表创建列式查询
+	///	@note	不持有列式表的所有权
+	template <typename... Columns_t>
+	ColumnQuery<ColumnTable<Columns_t...>> from_columns(ColumnTable<Columns_t...> const& table)
+	{
+		return ColumnQuery<ColumnTable<Columns_t...>>(table);
+	}
+
+	template <typename... Columns_t>
+	void from_columns(ColumnTable<Columns_t...> const&& table) = delete;
+}
+
+#ifdef _MSC_VER
+#	pragma pop_macro("min")
+#	pragma pop_macro("max")
+#endif
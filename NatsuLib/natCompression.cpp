@@ -495,7 +495,7 @@ natZipArchive::natZipArchive(natRefPointer<natStream> stream, ZipArchiveMode mod
 }
 
 natZipArchive::natZipArchive(natRefPointer<natStream> stream, StringType encoding, ZipArchiveMode mode)
-	: m_Stream{ std::move(stream) }, m_Reader{ make_ref<natBinaryReader>(m_Stream, Environment::Endianness::LittleEndian) }, m_Encoding{ encoding }, m_Mode{ mode }
+	: m_Stream{ std::move(stream) }, m_Reader{ make_ref<natBinaryReader>(m_Stream, Environment::Endianness::LittleEndian) }, m_Encoding{ encoding }, m_Mode{ mode }, m_ZipEndOfCentralDirectory{}, m_Zip64EndOfCentralDirectoryLocator{}, m_Zip64EndOfCentralDirectory{}
 {
 	switch (mode)
 	{
@@ -986,7 +986,7 @@ nBool natZipArchive::LocalFileHeader::TrySkip(natRefPointer<natBinaryReader> rea
 	return true;
 }
 
-nBool natZipArchive::LocalFileHeader::Write(natRefPointer<natBinaryWriter> writer, CentralDirectoryFileHeader& header, Optional<std::deque<ExtraField>> const& localFileHeaderFields, StringType encoding)
+nBool natZipArchive::LocalFileHeader::Write(natRefPointer<natBinaryWriter> writer, CentralDirectoryFileHeader& header, Optional<ExtraFieldList> const& localFileHeaderFields, StringType encoding)
 {
 	assert(writer);
 
@@ -10,6 +10,8 @@
 #include "natBinary.h"
 #include "natMisc.h"
 #include "natLinq.h"
+#include "natFlatHash.h"
+#include "natSmallVector.h"
 #include "natCompressionStream.h"
 #include "natCryptography.h"
 
@@ -77,7 +79,7 @@ namespace NatsuLib
 		natRefPointer<natBinaryReader> m_Reader;
 		natRefPointer<natBinaryWriter> m_Writer;
 
-		std::unordered_map<nStrView, natRefPointer<ZipEntry>> m_EntriesMap;
+		FlatHashMap<nStrView, natRefPointer<ZipEntry>> m_EntriesMap;
 
 		const StringType m_Encoding;
 		const ZipArchiveMode m_Mode;
@@ -94,7 +96,7 @@ namespace NatsuLib
 
 			nuShort Tag;
 			nuShort Size;
-			std::vector<nByte> Data;
+			SmallVector<nByte, 32> Data;
 
 			void Read(natRefPointer<natBinaryReader> reader);
 			nBool ReadWithLimit(natRefPointer<natBinaryReader> reader, nLen endExtraField);
@@ -103,6 +105,9 @@ namespace NatsuLib
 			size_t GetSize() const noexcept;
 		};
 
+		// ֻͨкٵĸֶΣֱӱ洢
+		typedef SmallVector<ExtraField, 2> ExtraFieldList;
+
 		struct Zip64ExtraField
 		{
 			static constexpr size_t OffsetToFirstField = 4;
@@ -141,7 +146,7 @@ namespace NatsuLib
 
 			nString Filename;
 			nString FileComment;
-			std::vector<ExtraField> ExtraFields;
+			ExtraFieldList ExtraFields;
 
 			nBool Read(natRefPointer<natBinaryReader> reader, nBool saveExtraFieldsAndComments, StringType encoding);
 			void Write(natRefPointer<natBinaryWriter> writer, StringType encoding);
@@ -158,7 +163,7 @@ namespace NatsuLib
 			static nBool TrySkip(natRefPointer<natBinaryReader> reader);
 
 			// ʵʾ޸headerеFilenameLengthΪʵдļ
-			static nBool Write(natRefPointer<natBinaryWriter> writer, CentralDirectoryFileHeader& header, Optional<std::deque<ExtraField>> const& localFileHeaderFields, StringType encoding);
+			static nBool Write(natRefPointer<natBinaryWriter> writer, CentralDirectoryFileHeader& header, Optional<ExtraFieldList> const& localFileHeaderFields, StringType encoding);
 			static void WriteCrcAndSizes(natRefPointer<natBinaryWriter> writer, CentralDirectoryFileHeader const& header, nBool usedZip64);
 		};
 
@@ -308,7 +313,7 @@ namespace NatsuLib
 
 			nBool m_EverOpenedForWrite, m_CurrentOpeningForWrite;
 
-			Optional<std::deque<ExtraField>> m_LocalHeaderFields;
+			Optional<ExtraFieldList> m_LocalHeaderFields;
 
 			Optional<std::vector<nByte>> m_Password;
 			DecryptStatus m_DecryptStatus;
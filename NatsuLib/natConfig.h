@@ -7,3 +7,12 @@
 #endif
 
 #define UseFastInverseSqrt 1
+
+// ڵ־0  4 Ϊ DebugInfoWarningErrorOffڴ˼־òɴ
+#ifndef NatLogMinLevel
+#	define NatLogMinLevel 0
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define UseSSE2 1
+#endif
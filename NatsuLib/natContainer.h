@@ -1,4 +1,4 @@
-#pragma once
+﻿#pragma once
 #include "natConfig.h"
 #include "natRefObj.h"
 #include "natMisc.h"
@@ -11,8 +11,23 @@
 
 namespace NatsuLib
 {
+	template <typename T, typename C = void>
+	class Container;
+
 	namespace detail_
 	{
+		template <typename C>
+		struct IsTypedContainer
+			: std::false_type
+		{
+		};
+
+		template <typename T, typename C>
+		struct IsTypedContainer<Container<T, C>>
+			: std::bool_constant<!std::is_void<C>::value>
+		{
+		};
+
 		struct DummyType
 		{
 			template <typename T>
@@ -202,8 +217,12 @@ namespace NatsuLib
 		};
 	}
 
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	类型擦除的容器
+	///	@remark	所有操作均通过虚函数转发到实际的容器
+	////////////////////////////////////////////////////////////////////////////////
 	template <typename T>
-	class Container
+	class Container<T, void>
 		: public natRefObjImpl<Container<T>>
 	{
 	public:
@@ -362,22 +381,50 @@ namespace NatsuLib
 
 			reverse_iterator RBegin() override
 			{
-				return static_cast<reverse_iterator>(detail_::ReversibleContainerConcept<C>::rbegin(m_Container));
+				if constexpr (detail_::ReversibleContainerConcept<C>::IsReversibleContainer)
+				{
+					return static_cast<reverse_iterator>(detail_::ReversibleContainerConcept<C>::rbegin(m_Container));
+				}
+				else
+				{
+					nat_Throw(natErrException, NatErr_NotSupport, "Container is not reversible."_nv);
+				}
 			}
 
 			reverse_iterator REnd() override
 			{
-				return static_cast<reverse_iterator>(detail_::ReversibleContainerConcept<C>::rend(m_Container));
+				if constexpr (detail_::ReversibleContainerConcept<C>::IsReversibleContainer)
+				{
+					return static_cast<reverse_iterator>(detail_::ReversibleContainerConcept<C>::rend(m_Container));
+				}
+				else
+				{
+					nat_Throw(natErrException, NatErr_NotSupport, "Container is not reversible."_nv);
+				}
 			}
 
 			const_reverse_iterator CRBegin() const
 			{
-				return static_cast<const_reverse_iterator>(detail_::ReversibleContainerConcept<C>::crbegin(m_Container));
+				if constexpr (detail_::ReversibleContainerConcept<C>::IsReversibleContainer)
+				{
+					return static_cast<const_reverse_iterator>(detail_::ReversibleContainerConcept<C>::crbegin(m_Container));
+				}
+				else
+				{
+					nat_Throw(natErrException, NatErr_NotSupport, "Container is not reversible."_nv);
+				}
 			}
 
 			const_reverse_iterator CREnd() const
 			{
-				return static_cast<const_reverse_iterator>(detail_::ReversibleContainerConcept<C>::crend(m_Container));
+				if constexpr (detail_::ReversibleContainerConcept<C>::IsReversibleContainer)
+				{
+					return static_cast<const_reverse_iterator>(detail_::ReversibleContainerConcept<C>::crend(m_Container));
+				}
+				else
+				{
+					nat_Throw(natErrException, NatErr_NotSupport, "Container is not reversible."_nv);
+				}
 			}
 
 		private:
@@ -385,7 +432,7 @@ namespace NatsuLib
 
 			static natRefPointer<ContainerWrapper> cast(natRefPointer<IContainerWrapper> const& other)
 			{
-				const auto realOther = other.Cast<ContainerWrapper>();
+				const auto realOther = other.template Cast<ContainerWrapper>();
 				if (!realOther)
 				{
 					nat_Throw(natErrException, NatErr_InvalidArg, "Require same type."_nv);
@@ -399,12 +446,18 @@ namespace NatsuLib
 		{
 		}
 
-		template <typename C, std::enable_if_t<NonSelf<C, Container>::value, int> = 0>
+		template <typename C, std::enable_if_t<NonSelf<C, Container>::value && !detail_::IsTypedContainer<std::remove_const_t<C>>::value, int> = 0>
 		Container(C& container)
 			: m_Wrapper{ make_ref<ContainerWrapper<C>>(container) }
 		{
 		}
 
+		template <typename C>
+		Container(Container<T, C> const& other)
+			: Container(*other.template GetOriginalContainer<C>())
+		{
+		}
+
 		Container(Container const& other) = default;
 
 		/*Container(Container&& other) noexcept
@@ -420,7 +473,7 @@ namespace NatsuLib
 		template <typename C>
 		C* GetOriginalContainer() const
 		{
-			const auto wrapper = m_Wrapper.Cast<ContainerWrapper<C>>();
+			const auto wrapper = m_Wrapper.template Cast<ContainerWrapper<C>>();
 			if (!wrapper)
 			{
 				return nullptr;
@@ -546,11 +599,170 @@ namespace NatsuLib
 		natRefPointer<IContainerWrapper> m_Wrapper;
 	};
 
-	template <typename T>
-	void swap(Container<T>& a, Container<T>& b) noexcept
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	已知实际容器类型的容器
+	///	@remark	接口与类型擦除的 Container<T> 一致，但直接调用 C 的成员而不经过虚函数，也不需要分配包装对象，
+	///			需要类型擦除时可以隐式转换为 Container<T>
+	////////////////////////////////////////////////////////////////////////////////
+	template <typename T, typename C>
+	class Container
+	{
+		typedef detail_::ContainerWithSizeConcept<std::remove_const_t<C>> SizeConcept;
+		typedef detail_::ReversibleContainerConcept<std::remove_const_t<C>> ReversibleConcept;
+
+	public:
+		typedef T value_type;
+		typedef std::add_lvalue_reference_t<T> reference;
+		typedef std::add_lvalue_reference_t<std::add_const_t<T>> const_reference;
+		typedef std::conditional_t<std::is_const<C>::value, typename C::const_iterator, typename C::iterator> iterator;
+		typedef typename C::const_iterator const_iterator;
+		typedef typename C::difference_type difference_type;
+		typedef typename C::size_type size_type;
+
+		Container(C& container) noexcept
+			: m_Container{ std::addressof(container) }
+		{
+		}
+
+		static constexpr nBool HasContainer() noexcept
+		{
+			return true;
+		}
+
+		template <typename U>
+		U* GetOriginalContainer() const noexcept
+		{
+			if constexpr (std::is_same<U, C>::value)
+			{
+				return m_Container;
+			}
+			else
+			{
+				return nullptr;
+			}
+		}
+
+		Container& operator=(Container const& other)
+		{
+			detail_::ConstContainerConcept<C>::Clone(*m_Container, *other.m_Container);
+			return *this;
+		}
+
+		Container& operator=(Container&& other)
+		{
+			detail_::ConstContainerConcept<C>::Move(*m_Container, std::move(*other.m_Container));
+			return *this;
+		}
+
+		iterator begin() const
+		{
+			return m_Container->begin();
+		}
+
+		iterator end() const
+		{
+			return m_Container->end();
+		}
+
+		const_iterator cbegin() const
+		{
+			return m_Container->cbegin();
+		}
+
+		const_iterator cend() const
+		{
+			return m_Container->cend();
+		}
+
+		nBool operator==(Container const& other) const
+		{
+			return *m_Container == *other.m_Container;
+		}
+
+		nBool operator!=(Container const& other) const
+		{
+			return *m_Container != *other.m_Container;
+		}
+
+		void swap(Container& other)
+		{
+			detail_::ConstContainerConcept<C>::Swap(*m_Container, *other.m_Container);
+		}
+
+		static constexpr nBool HasSize() noexcept
+		{
+			return SizeConcept::HasSize;
+		}
+
+		size_type size() const
+		{
+			if constexpr (SizeConcept::HasSize)
+			{
+				return m_Container->size();
+			}
+			else
+			{
+				return static_cast<size_type>(std::distance(m_Container->begin(), m_Container->end()));
+			}
+		}
+
+		size_type max_size() const
+		{
+			return m_Container->max_size();
+		}
+
+		nBool empty() const
+		{
+			return m_Container->empty();
+		}
+
+		// ReversibleContainer
+		static constexpr nBool IsReversibleContainer() noexcept
+		{
+			return ReversibleConcept::IsReversibleContainer;
+		}
+
+		auto rbegin() const
+		{
+			static_assert(ReversibleConcept::IsReversibleContainer, "This container is not a ReversibleContainer.");
+			return m_Container->rbegin();
+		}
+
+		auto rend() const
+		{
+			static_assert(ReversibleConcept::IsReversibleContainer, "This container is not a ReversibleContainer.");
+			return m_Container->rend();
+		}
+
+		auto crbegin() const
+		{
+			static_assert(ReversibleConcept::IsReversibleContainer, "This container is not a ReversibleContainer.");
+			return m_Container->crbegin();
+		}
+
+		auto crend() const
+		{
+			static_assert(ReversibleConcept::IsReversibleContainer, "This container is not a ReversibleContainer.");
+			return m_Container->crend();
+		}
+
+	private:
+		C* m_Container;
+	};
+
+	template <typename T, typename C>
+	void swap(Container<T, C>& a, Container<T, C>& b) noexcept(noexcept(a.swap(b)))
 	{
 		a.swap(b);
 	}
+
+	///	@brief	以已知的容器类型创建 Container
+	///	@remark	元素类型由 C 推导，C 为 const 时元素类型也为 const
+	template <typename C>
+	Container<std::conditional_t<std::is_const<C>::value, std::add_const_t<typename C::value_type>, typename C::value_type>, C> make_container(C& container) noexcept
+	{
+		return { container };
+	}
 }
 
 #ifdef _MSC_VER
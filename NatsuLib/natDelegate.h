@@ -1,66 +1,401 @@
-#pragma once
+﻿#pragma once
 #include "natType.h"
+#include <cassert>
+#include <cstddef>
+#include <cstring>
 #include <functional>
+#include <new>
+#include <type_traits>
 #include "natException.h"
 
 namespace NatsuLib
 {
-	template <typename Func>
+	enum : size_t
+	{
+		///	@brief	Delegate 默认的内联存储大小，此时 Delegate 恰好占据 64 字节
+		DefaultDelegateInlineSize = 48,
+	};
+
+	namespace detail_
+	{
+		///	@brief	以模板参数保存成员函数的绑定，仅需保存对象指针
+		template <auto Method, typename ThisObj>
+		struct BoundMethod
+		{
+			ThisObj* Object;
+
+			template <typename... Args>
+			decltype(auto) operator()(Args&&... args) const
+			{
+				return (Object->*Method)(std::forward<Args>(args)...);
+			}
+		};
+
+		///	@brief	成员函数指针与对象指针的绑定
+		template <typename Method, typename ThisObj>
+		struct MethodBinding
+		{
+			Method MethodPointer;
+			ThisObj* Object;
+
+			template <typename... Args>
+			decltype(auto) operator()(Args&&... args) const
+			{
+				return (Object->*MethodPointer)(std::forward<Args>(args)...);
+			}
+		};
+	}
+
+	template <typename Func, size_t InlineSize = DefaultDelegateInlineSize>
 	class Delegate;
 
-	template <typename Ret, typename... Args>
-	class Delegate<Ret(Args...)>
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	可调用对象的包装
+	///	@remark	大小不超过 InlineSize 且可无异常移动的可调用对象保存在内联存储中，否则在堆上分配，
+	///			可平凡复制的可调用对象在复制及移动时直接复制内存
+	///	@tparam	InlineSize	内联存储的字节数
+	////////////////////////////////////////////////////////////////////////////////
+	template <typename Ret, typename... Args, size_t InlineSize>
+	class Delegate<Ret(Args...), InlineSize>
 	{
+		static_assert(InlineSize >= sizeof(void*), "InlineSize is too small.");
+
+		union Storage
+		{
+			alignas(std::max_align_t) nByte Buffer[InlineSize];
+			void* HeapObject;
+		};
+
+		enum class Operation
+		{
+			Copy,
+			Move,
+			Destroy,
+		};
+
+		typedef Ret(*Invoker)(Storage&, Args&&...);
+		typedef void(*Manager)(Operation, Storage&, Storage&);
+
+		template <typename CallableObj>
+		struct IsInline
+			: std::bool_constant<sizeof(CallableObj) <= InlineSize && alignof(CallableObj) <= alignof(Storage) && std::is_nothrow_move_constructible<CallableObj>::value>
+		{
+		};
+
+		template <typename CallableObj>
+		struct IsTrivial
+			: std::bool_constant<IsInline<CallableObj>::value && std::is_trivially_copyable<CallableObj>::value && std::is_trivially_destructible<CallableObj>::value>
+		{
+		};
+
 	public:
-		Delegate() noexcept = default;
-		Delegate(Delegate const& other) noexcept
-			: m_Functor(other.m_Functor)
+		Delegate() noexcept
+			: m_Invoker{ &InvokeEmpty }, m_Manager{}
+		{
+		}
+
+		Delegate(std::nullptr_t) noexcept
+			: Delegate()
+		{
+		}
+
+		Delegate(Delegate const& other)
+			: m_Invoker{ &InvokeEmpty }, m_Manager{}
 		{
+			if (other.m_Manager)
+			{
+				other.m_Manager(Operation::Copy, m_Storage, other.m_Storage);
+			}
+			else
+			{
+				std::memcpy(&m_Storage, &other.m_Storage, sizeof(Storage));
+			}
+			m_Invoker = other.m_Invoker;
+			m_Manager = other.m_Manager;
 		}
+
 		Delegate(Delegate&& other) noexcept
-			: m_Functor(std::move(other.m_Functor))
+			: m_Invoker{ &InvokeEmpty }, m_Manager{}
 		{
+			MoveFrom(other);
 		}
 
-		Delegate& operator=(Delegate const& other) = default;
-		Delegate& operator=(Delegate && other) = default;
+		~Delegate()
+		{
+			Reset();
+		}
 
-		template <typename CallableObj, std::enable_if_t<NonSelf<CallableObj, Delegate>::value, int> = 0>
-		constexpr Delegate(CallableObj&& callableObj) noexcept
-			: m_Functor(std::forward<CallableObj>(callableObj))
+		Delegate& operator=(Delegate const& other)
 		{
+			if (this != &other)
+			{
+				Delegate copy{ other };
+				Reset();
+				MoveFrom(copy);
+			}
+			return *this;
 		}
 
-		template <typename CallableObj, typename ThisObj>
-		constexpr Delegate(CallableObj&& callableObj, ThisObj&& thisObj) noexcept
-			: m_Functor([callableObj, &thisObj](Args... args)
+		Delegate& operator=(Delegate&& other) noexcept
+		{
+			if (this != &other)
 			{
-				return (thisObj.*callableObj)(std::forward<Args>(args)...);
-			})
+				Reset();
+				MoveFrom(other);
+			}
+			return *this;
+		}
+
+		Delegate& operator=(std::nullptr_t) noexcept
 		{
+			Reset();
+			return *this;
 		}
 
-		decltype(auto) operator()(Args... args) const
+		template <typename CallableObj, std::enable_if_t<NonSelf<CallableObj, Delegate>::value && !std::is_same<std::decay_t<CallableObj>, std::nullptr_t>::value, int> = 0>
+		Delegate(CallableObj&& callableObj)
+			: m_Invoker{ &InvokeEmpty }, m_Manager{}
 		{
-			if (!m_Functor)
+			typedef std::decay_t<CallableObj> Callable_t;
+
+			if constexpr (std::is_pointer<std::remove_reference_t<CallableObj>>::value || std::is_member_pointer<Callable_t>::value)
 			{
-				nat_Throw(natException, "Null delegate."_nv);
+				if (!callableObj)
+				{
+					return;
+				}
 			}
 
-			return m_Functor(std::forward<Args>(args)...);
+			if constexpr (IsInline<Callable_t>::value)
+			{
+				if constexpr (IsTrivial<Callable_t>::value)
+				{
+					// 复制及移动时会复制整个存储，先清零以免复制未初始化的字节
+					m_Storage = Storage{};
+				}
+				::new(static_cast<void*>(m_Storage.Buffer)) Callable_t(std::forward<CallableObj>(callableObj));
+				m_Invoker = &InvokeInline<Callable_t>;
+				m_Manager = IsTrivial<Callable_t>::value ? nullptr : &ManageInline<Callable_t>;
+			}
+			else
+			{
+				m_Storage.HeapObject = new Callable_t(std::forward<CallableObj>(callableObj));
+				m_Invoker = &InvokeHeap<Callable_t>;
+				m_Manager = &ManageHeap<Callable_t>;
+			}
+		}
+
+		///	@brief	绑定成员函数及对象
+		///	@note	仅保存对象的指针，调用者需保证对象的生存期
+		template <typename CallableObj, typename ThisObj>
+		Delegate(CallableObj&& callableObj, ThisObj&& thisObj)
+			: Delegate(detail_::MethodBinding<std::decay_t<CallableObj>, std::remove_reference_t<ThisObj>>{ std::forward<CallableObj>(callableObj), std::addressof(thisObj) })
+		{
+		}
+
+		///	@brief	绑定以模板参数指定的成员函数及对象
+		///	@remark	仅保存对象的指针，调用时直接调用成员函数
+		///	@note	调用者需保证对象的生存期
+		template <auto Method, typename ThisObj>
+		static Delegate Bind(ThisObj& thisObj) noexcept
+		{
+			return Delegate{ detail_::BoundMethod<Method, ThisObj>{ std::addressof(thisObj) } };
+		}
+
+		decltype(auto) operator()(Args... args) const
+		{
+			return m_Invoker(m_Storage, std::forward<Args>(args)...);
 		}
 
 		explicit operator bool() const noexcept
 		{
-			return static_cast<bool>(m_Functor);
+			return m_Invoker != &InvokeEmpty;
 		}
 
 		nBool operator!() const noexcept
 		{
-			return !m_Functor;
+			return m_Invoker == &InvokeEmpty;
+		}
+
+		void swap(Delegate& other) noexcept
+		{
+			Delegate temp{ std::move(other) };
+			other.MoveFrom(*this);
+			MoveFrom(temp);
 		}
 
 	private:
-		std::function<Ret(Args...)> m_Functor;
+		mutable Storage m_Storage;
+		Invoker m_Invoker;
+		Manager m_Manager;
+
+		void Reset() noexcept
+		{
+			if (m_Manager)
+			{
+				m_Manager(Operation::Destroy, m_Storage, m_Storage);
+			}
+			m_Invoker = &InvokeEmpty;
+			m_Manager = nullptr;
+		}
+
+		// 要求自身为空
+		void MoveFrom(Delegate& other) noexcept
+		{
+			if (other.m_Manager)
+			{
+				other.m_Manager(Operation::Move, m_Storage, other.m_Storage);
+			}
+			else
+			{
+				std::memcpy(&m_Storage, &other.m_Storage, sizeof(Storage));
+			}
+			m_Invoker = std::exchange(other.m_Invoker, &InvokeEmpty);
+			m_Manager = std::exchange(other.m_Manager, nullptr);
+		}
+
+		template <typename Callable_t>
+		static Ret Invoke(Callable_t& callableObj, Args&&... args)
+		{
+			if constexpr (std::is_void<Ret>::value)
+			{
+				std::invoke(callableObj, std::forward<Args>(args)...);
+			}
+			else
+			{
+				return std::invoke(callableObj, std::forward<Args>(args)...);
+			}
+		}
+
+		[[noreturn]] static Ret InvokeEmpty(Storage&, Args&&...)
+		{
+			nat_Throw(natException, "Null delegate."_nv);
+		}
+
+		template <typename Callable_t>
+		static Ret InvokeInline(Storage& storage, Args&&... args)
+		{
+			return Invoke(*std::launder(reinterpret_cast<Callable_t*>(storage.Buffer)), std::forward<Args>(args)...);
+		}
+
+		template <typename Callable_t>
+		static Ret InvokeHeap(Storage& storage, Args&&... args)
+		{
+			return Invoke(*static_cast<Callable_t*>(storage.HeapObject), std::forward<Args>(args)...);
+		}
+
+		template <typename Callable_t>
+		static void ManageInline(Operation operation, Storage& dst, Storage& src)
+		{
+			const auto pSrc = std::launder(reinterpret_cast<Callable_t*>(src.Buffer));
+			switch (operation)
+			{
+			case Operation::Copy:
+				::new(static_cast<void*>(dst.Buffer)) Callable_t(*pSrc);
+				break;
+			case Operation::Move:
+				::new(static_cast<void*>(dst.Buffer)) Callable_t(std::move(*pSrc));
+				pSrc->~Callable_t();
+				break;
+			case Operation::Destroy:
+				pSrc->~Callable_t();
+				break;
+			}
+		}
+
+		template <typename Callable_t>
+		static void ManageHeap(Operation operation, Storage& dst, Storage& src)
+		{
+			switch (operation)
+			{
+			case Operation::Copy:
+				dst.HeapObject = new Callable_t(*static_cast<const Callable_t*>(src.HeapObject));
+				break;
+			case Operation::Move:
+				dst.HeapObject = src.HeapObject;
+				break;
+			case Operation::Destroy:
+				delete static_cast<Callable_t*>(src.HeapObject);
+				break;
+			}
+		}
+	};
+
+	template <typename Func, size_t InlineSize>
+	void swap(Delegate<Func, InlineSize>& lhs, Delegate<Func, InlineSize>& rhs) noexcept
+	{
+		lhs.swap(rhs);
+	}
+
+	template <typename Func>
+	class DelegateRef;
+
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	不持有可调用对象的委托，用于同步调用的回调
+	///	@remark	仅保存可调用对象的地址及调用函数，构造及复制均不会分配内存
+	///	@note	DelegateRef 不能比所引用的可调用对象存活更久，不应被保存
+	////////////////////////////////////////////////////////////////////////////////
+	template <typename Ret, typename... Args>
+	class DelegateRef<Ret(Args...)>
+	{
+		union Target
+		{
+			void* Object;
+			Ret(*Function)(Args...);
+		};
+
+		typedef Ret(*Invoker)(Target, Args&&...);
+
+	public:
+		DelegateRef(Ret(*function)(Args...)) noexcept
+			: m_Invoker{ &InvokeFunction }
+		{
+			assert(function && "function should not be nullptr.");
+			m_Target.Function = function;
+		}
+
+		template <typename CallableObj, std::enable_if_t<NonSelf<CallableObj, DelegateRef>::value && std::is_invocable_r<Ret, CallableObj&, Args...>::value, int> = 0>
+		DelegateRef(CallableObj&& callableObj) noexcept
+		{
+			typedef std::remove_reference_t<CallableObj> Callable_t;
+
+			if constexpr (std::is_function<Callable_t>::value)
+			{
+				m_Target.Function = callableObj;
+				m_Invoker = &InvokeFunction;
+			}
+			else
+			{
+				m_Target.Object = const_cast<void*>(static_cast<const volatile void*>(std::addressof(callableObj)));
+				m_Invoker = &InvokeObject<Callable_t>;
+			}
+		}
+
+		Ret operator()(Args... args) const
+		{
+			return m_Invoker(m_Target, std::forward<Args>(args)...);
+		}
+
+	private:
+		Target m_Target;
+		Invoker m_Invoker;
+
+		static Ret InvokeFunction(Target target, Args&&... args)
+		{
+			return target.Function(std::forward<Args>(args)...);
+		}
+
+		template <typename Callable_t>
+		static Ret InvokeObject(Target target, Args&&... args)
+		{
+			if constexpr (std::is_void<Ret>::value)
+			{
+				std::invoke(*static_cast<Callable_t*>(target.Object), std::forward<Args>(args)...);
+			}
+			else
+			{
+				return std::invoke(*static_cast<Callable_t*>(target.Object), std::forward<Args>(args)...);
+			}
+		}
 	};
 }
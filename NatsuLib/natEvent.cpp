@@ -24,3 +24,78 @@ nBool natEventBase::IsCanceled() const noexcept
 {
 	return m_Canceled;
 }
+
+natEventBus::natEventBus()
+	: m_Table{ make_ref<EventTable>() }
+{
+}
+
+natEventBus::~natEventBus()
+{
+	// ȷַѽе¼ַַֹ֮ͣ¼
+	for (auto&& event : m_Table.Peek()->Events)
+	{
+		if (const auto& queue = event.second.Queue)
+		{
+			queue->Flush();
+			queue->Close();
+		}
+	}
+}
+
+void natEventBus::RegisterEvent(std::type_index const& type, natRefPointer<AsyncEventQueueBase> queue)
+{
+	natRefScopeGuard<natCriticalSection> guard{ m_Section };
+	auto table = make_ref<EventTable>(*m_Table.Peek());
+	bool Succeeded;
+	tie(std::ignore, Succeeded) = table->Events.try_emplace(type, EventEntry{ make_ref<ListenerArray>(), std::move(queue) });
+
+	if (!Succeeded)
+	{
+		nat_Throw(natException, "Cannot register event \"{0}\""_nv, U8StringView{ type.name() });
+	}
+
+	m_Table.Store(std::move(table));
+}
+
+void natEventBus::FlushAsyncEvent(std::type_index const& type)
+{
+	const auto table = m_Table.Load();
+	const auto iter = table->Events.find(type);
+	if (iter == table->Events.end())
+	{
+		nat_Throw(natException, "Unregistered event."_nv);
+	}
+
+	if (const auto& queue = iter->second.Queue)
+	{
+		queue->Flush();
+	}
+}
+
+natRefPointer<const natEventBus::ListenerArray> natEventBus::LoadListeners(std::type_index const& type) const
+{
+	const auto table = m_Table.Load();
+	const auto iter = table->Events.find(type);
+	assert(iter != table->Events.end() && "Event should have been registered.");
+	return iter->second.Listeners;
+}
+
+natRefPointer<const natEventBus::ListenerArray> const& natEventBus::FindListeners(std::type_index const& type) const
+{
+	auto const& events = m_Table.Peek()->Events;
+	const auto iter = events.find(type);
+	if (iter == events.end())
+	{
+		nat_Throw(natException, "Unregistered event."_nv);
+	}
+
+	return iter->second.Listeners;
+}
+
+void natEventBus::Publish(std::type_index const& type, natRefPointer<const ListenerArray> listeners)
+{
+	auto table = make_ref<EventTable>(*m_Table.Peek());
+	table->Events.find(type)->second.Listeners = std::move(listeners);
+	m_Table.Store(std::move(table));
+}
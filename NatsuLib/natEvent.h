@@ -8,10 +8,19 @@
 #include "natDelegate.h"
 #include "natUtil.h"
 #include "natMultiThread.h"
+#include "natFlatHash.h"
+#include "natMisc.h"
+#include "natRefObj.h"
 
-#include <map>
-#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 #include <typeindex>
+#include <vector>
 
 namespace NatsuLib
 {
@@ -47,6 +56,233 @@ namespace NatsuLib
 		nBool m_Canceled;
 	};
 
+	namespace detail_
+	{
+		////////////////////////////////////////////////////////////////////////////////
+		///	@brief	дʱƵüָ
+		///	@remark	ȡڻõĶݴڵǼǣȫ̲
+		///			д뷽ֵȴڴڵĶȡ뿪ֵ֮ü
+		///	@note	д뷽֮ɵ߻
+		////////////////////////////////////////////////////////////////////////////////
+		template <typename T>
+		class CopyOnWritePointer final
+			: public nonmovable
+		{
+		public:
+			explicit CopyOnWritePointer(natRefPointer<T> value) noexcept
+				: m_Owner{ std::move(value) }, m_Current{ m_Owner.Get() }, m_Epoch{}, m_Readers{}
+			{
+			}
+
+			///	@brief	õǰֵ
+			natRefPointer<T> Load() const noexcept
+			{
+				nuInt epoch;
+				while (true)
+				{
+					epoch = m_Epoch.load();
+					m_Readers[epoch & 1].fetch_add(1);
+					// ǼǺԪδı䣬֮д뷽ضȴζȡ
+					if (m_Epoch.load() == epoch)
+					{
+						break;
+					}
+					m_Readers[epoch & 1].fetch_sub(1);
+				}
+
+				natRefPointer<T> result{ m_Current.load() };
+				m_Readers[epoch & 1].fetch_sub(1);
+				return result;
+			}
+
+			///	@brief	õǰֵд뷽ʹ
+			natRefPointer<T> const& Peek() const noexcept
+			{
+				return m_Owner;
+			}
+
+			///	@brief	ֵ
+			void Store(natRefPointer<T> value) noexcept
+			{
+				m_Current.store(value.Get());
+				const auto epoch = m_Epoch.fetch_add(1);
+				while (m_Readers[epoch & 1].load())
+				{
+					std::this_thread::yield();
+				}
+				m_Owner = std::move(value);
+			}
+
+		private:
+			natRefPointer<T> m_Owner;
+			std::atomic<T*> m_Current;
+			std::atomic<nuInt> m_Epoch;
+			mutable std::atomic<size_t> m_Readers[2];
+		};
+
+		////////////////////////////////////////////////////////////////////////////////
+		///	@brief	ȼ ID Ĳɱ
+		///	@remark	޸ʱµ飬ԭ鱣ֲԹڽе Post ʹ
+		////////////////////////////////////////////////////////////////////////////////
+		template <typename Listener_t>
+		struct EventListenerArray final
+			: natRefObjImpl<EventListenerArray<Listener_t>>
+		{
+			struct Entry
+			{
+				nInt Priority;
+				nuInt ID;
+				Listener_t Listener;
+			};
+
+			std::vector<Entry> Listeners;
+
+			///	@brief	ɲ
+			///	@remark	µ ID Ϊͬһȼ ID  1
+			natRefPointer<const EventListenerArray> Insert(Listener_t const& listener, nInt priority, nuInt& id) const
+			{
+				const auto position = std::upper_bound(Listeners.begin(), Listeners.end(), priority, [](nInt value, Entry const& entry)
+				{
+					return value < entry.Priority;
+				});
+				id = position != Listeners.begin() && std::prev(position)->Priority == priority ? std::prev(position)->ID + 1u : 0u;
+
+				auto result = make_ref<EventListenerArray>();
+				result->Listeners.reserve(Listeners.size() + 1);
+				result->Listeners.insert(result->Listeners.end(), Listeners.begin(), position);
+				result->Listeners.push_back({ priority, id, listener });
+				result->Listeners.insert(result->Listeners.end(), position, Listeners.end());
+				return result;
+			}
+
+			///	@brief	Ƴ
+			///	@return	ָļʱ nullptr
+			natRefPointer<const EventListenerArray> Remove(nInt priority, nuInt id) const
+			{
+				const auto position = std::find_if(Listeners.begin(), Listeners.end(), [priority, id](Entry const& entry)
+				{
+					return entry.Priority == priority && entry.ID == id;
+				});
+				if (position == Listeners.end())
+				{
+					return {};
+				}
+
+				auto result = make_ref<EventListenerArray>();
+				result->Listeners.reserve(Listeners.size() - 1);
+				result->Listeners.insert(result->Listeners.end(), Listeners.begin(), position);
+				result->Listeners.insert(result->Listeners.end(), std::next(position), Listeners.end());
+				return result;
+			}
+		};
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	̬͵¼ͨ
+	///	@remark	ֱӽ EventClass&Post ʱõǰò
+	///			Ҫ std::type_index ɢСҼת¼\n
+	///			ͨɵʹãҲͨ natEventBus::GetChannel ú󻺴
+	///	@note	Post ʼעעļӰ챾 Post
+	////////////////////////////////////////////////////////////////////////////////
+	template <typename EventClass>
+	class EventChannel final
+		: public natRefObjImpl<EventChannel<EventClass>>
+	{
+		static_assert(std::is_base_of<natEventBase, EventClass>::value, "EventClass should derive from natEventBase.");
+
+		typedef detail_::EventListenerArray<Delegate<void(EventClass&)>> ListenerArray;
+
+	public:
+		typedef Delegate<void(EventClass&)> EventListenerDelegate;
+		typedef nInt PriorityType;
+		typedef nuInt ListenerIDType;
+
+		EventChannel()
+			: m_Listeners{ make_ref<ListenerArray>() }
+		{
+		}
+
+		ListenerIDType RegisterEventListener(EventListenerDelegate const& listener, PriorityType priority = Priority::Normal)
+		{
+			natRefScopeGuard<natCriticalSection> guard{ m_Section };
+			ListenerIDType ret;
+			m_Listeners.Store(m_Listeners.Peek()->Insert(listener, priority, ret));
+			return ret;
+		}
+
+		void UnregisterEventListener(PriorityType priority, ListenerIDType ListenerID)
+		{
+			natRefScopeGuard<natCriticalSection> guard{ m_Section };
+			if (auto listeners = m_Listeners.Peek()->Remove(priority, ListenerID))
+			{
+				m_Listeners.Store(std::move(listeners));
+			}
+		}
+
+		///	@brief	¼
+		///	@return	¼Ƿȡ
+		nBool Post(EventClass& event)
+		{
+			const auto listeners = m_Listeners.Load();
+			for (auto&& listener : listeners->Listeners)
+			{
+				listener.Listener(event);
+			}
+
+			return event.IsCanceled();
+		}
+
+	private:
+		natCriticalSection m_Section;
+		detail_::CopyOnWritePointer<const ListenerArray> m_Listeners;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	첽¼ʱĴ
+	////////////////////////////////////////////////////////////////////////////////
+	enum class EventBackpressurePolicy
+	{
+		Block,		///< @brief	ͷֱпλ
+		DropOldest,	///< @brief	¼
+		DropNewest,	///< @brief	ڷ͵¼
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	첽¼ѡ
+	////////////////////////////////////////////////////////////////////////////////
+	struct AsyncEventOptions
+	{
+		size_t Capacity = 1024;											///< @brief	ౣ¼
+		size_t BatchSize = 64;											///< @brief	ַ߳ÿδӶȡ¼
+		EventBackpressurePolicy Policy = EventBackpressurePolicy::Block;	///< @brief	ʱĴ
+		nBool Coalesce = false;											///< @brief	βδַ¼ʱϲҪ¼Ϳ == Ƚ
+		std::chrono::microseconds KeepAlive = std::chrono::milliseconds{ 1 };	///< @brief	Ϊպַȴ¼ʱ䣬ڼ䷢͵¼Ҫύַ
+	};
+
+	namespace detail_
+	{
+		template <typename T, typename = void>
+		struct IsEqualityComparable
+			: std::false_type
+		{
+		};
+
+		template <typename T>
+		struct IsEqualityComparable<T, std::void_t<decltype(std::declval<T const&>() == std::declval<T const&>())>>
+			: std::true_type
+		{
+		};
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	¼
+	///	@remark	ÿ¼ļȼע˳󱣴ڲɱУ
+	///			עἰעʱƲµ飬Post ʱõǰúֱӱҪ\n
+	///			첽ʽע¼ Post ʱƵ¼нУ̳߳еַ̳߳
+	///			ͬһ¼ķַ˳е˳һ
+	///	@note	Post ʼעעļӰ챾 Post\n
+	///			첽¼ļڷַ߳еã׳쳣
+	////////////////////////////////////////////////////////////////////////////////
 	class natEventBus final
 	{
 	public:
@@ -54,32 +290,42 @@ namespace NatsuLib
 		typedef nInt PriorityType;
 		typedef nuInt ListenerIDType;
 
+		natEventBus();
+		~natEventBus();
+
+		///	@brief	עͬʽַ¼
 		template <typename EventClass>
 		std::enable_if_t<std::is_base_of<natEventBase, EventClass>::value, void> RegisterEvent()
 		{
-			natRefScopeGuard<natCriticalSection> guard{ m_Section };
-			bool Succeeded;
-			tie(std::ignore, Succeeded) = m_EventListenerMap.try_emplace(typeid(EventClass));
+			RegisterEvent(typeid(EventClass), nullptr);
+		}
 
-			if (!Succeeded)
+		///	@brief	ע첽ʽַ¼
+		///	@param[in]	dispatcher	ڷַ¼̳߳أ¼ߴ
+		///	@param[in]	options		첽¼ѡ
+		template <typename EventClass>
+		std::enable_if_t<std::is_base_of<natEventBase, EventClass>::value, void> RegisterEvent(natThreadPool& dispatcher, AsyncEventOptions const& options = {})
+		{
+			static_assert(std::is_copy_constructible<EventClass>::value, "EventClass should be copy constructible to be posted asynchronously.");
+
+			if (!options.Capacity || !options.BatchSize)
+			{
+				nat_Throw(natErrException, NatErr_InvalidArg, "Capacity and BatchSize should not be zero."_nv);
+			}
+			if (options.Coalesce && !detail_::IsEqualityComparable<EventClass>::value)
 			{
-				nat_Throw(natException, "Cannot register event \"{0}\""_nv, U8StringView{ typeid(EventClass).name() });
+				nat_Throw(natErrException, NatErr_InvalidArg, "EventClass should be equality comparable to be coalesced."_nv);
 			}
+
+			RegisterEvent(typeid(EventClass), make_ref<AsyncEventQueue<EventClass>>(*this, dispatcher, options));
 		}
 
 		template <typename EventClass>
 		ListenerIDType RegisterEventListener(EventListenerDelegate const& listener, PriorityType priority = Priority::Normal)
 		{
 			natRefScopeGuard<natCriticalSection> guard{ m_Section };
-			auto iter = m_EventListenerMap.find(typeid(EventClass));
-			if (iter == m_EventListenerMap.end())
-			{
-				nat_Throw(natException, "Unregistered event."_nv);
-			}
-
-			auto&& listeners = iter->second[priority];
-			auto ret = listeners.empty() ? 0u : listeners.rbegin()->first + 1u;
-			listeners.try_emplace(ret, listener);
+			ListenerIDType ret;
+			Publish(typeid(EventClass), FindListeners(typeid(EventClass))->Insert(listener, priority, ret));
 			return ret;
 		}
 
@@ -87,42 +333,292 @@ namespace NatsuLib
 		void UnregisterEventListener(PriorityType priority, ListenerIDType ListenerID)
 		{
 			natRefScopeGuard<natCriticalSection> guard{ m_Section };
-			auto iter = m_EventListenerMap.find(typeid(EventClass));
-			if (iter == m_EventListenerMap.end())
-			{
-				nat_Throw(natException, "Unregistered event."_nv);
-			}
-
-			auto listeneriter = iter->second.find(priority);
-			if (listeneriter != iter->second.end())
+			if (auto listeners = FindListeners(typeid(EventClass))->Remove(priority, ListenerID))
 			{
-				listeneriter->second.erase(ListenerID);
+				Publish(typeid(EventClass), std::move(listeners));
 			}
 		}
 
+		///	@brief	¼
+		///	@remark	첽¼ƵУԸ޸Ĳᷴӳ event 
+		///	@return	¼Ƿȡ
 		template <typename EventClass>
 		nBool Post(EventClass& event)
 		{
-			natRefScopeGuard<natCriticalSection> guard{ m_Section };
-			auto iter = m_EventListenerMap.find(typeid(EventClass));
-			if (iter == m_EventListenerMap.end())
+			const auto table = m_Table.Load();
+			const auto iter = table->Events.find(typeid(EventClass));
+			if (iter == table->Events.end())
 			{
 				nat_Throw(natException, "Unregistered event."_nv);
 			}
 
-			for (auto&& listeners : iter->second)
+			if constexpr (std::is_copy_constructible<EventClass>::value)
 			{
-				for (auto&& listener : listeners.second)
+				if (const auto queue = static_cast<AsyncEventQueue<EventClass>*>(iter->second.Queue.Get()))
 				{
-					listener.second(static_cast<natEventBase&>(event));
+					queue->Push(event);
+					return event.IsCanceled();
 				}
 			}
 
+			for (auto&& listener : iter->second.Listeners->Listeners)
+			{
+				listener.Listener(static_cast<natEventBase&>(event));
+			}
+
 			return event.IsCanceled();
 		}
 
+		///	@brief	ȴ첽¼Ķе¼ȫַ
+		///	@note	ͬ¼ڸ¼ķַ߳еʱ
+		template <typename EventClass>
+		void FlushAsyncEvent()
+		{
+			FlushAsyncEvent(typeid(EventClass));
+		}
+
+		///	@brief	 EventClass ¼ͨ
+		///	@remark	״λʱͬһ¼߶ͬһ¼Ƿͬһͨ߿ɻ淵صͨԱ֮Ĳ\n
+		///			ͨ RegisterEvent ע¼໥
+		template <typename EventClass>
+		natRefPointer<EventChannel<EventClass>> GetChannel()
+		{
+			natRefScopeGuard<natCriticalSection> guard{ m_Section };
+			auto& channel = m_Channels[typeid(EventClass)];
+			if (!channel)
+			{
+				channel = make_ref<EventChannel<EventClass>>();
+			}
+
+			return natRefPointer<EventChannel<EventClass>>{ static_cast<EventChannel<EventClass>*>(channel.Get()) };
+		}
+
 	private:
+		typedef detail_::EventListenerArray<EventListenerDelegate> ListenerArray;
+
+		class AsyncEventQueueBase
+			: public natRefObjImpl<AsyncEventQueueBase>
+		{
+		public:
+			///	@brief	ȴе¼ȫַ
+			virtual void Flush() = 0;
+
+			///	@brief	е¼ȴڽеķַ֮͵¼
+			virtual void Close() = 0;
+		};
+
+		////////////////////////////////////////////////////////////////////////////////
+		///	@brief	첽¼н
+		///	@remark	߳̾ɷͣͬһʱһַ̣߳
+		///			ûзַʱ̳߳ύַ񣬷ַÿȡ BatchSize ¼
+		///			üΪպٵȴ KeepAlive ʱ䣬¼ʱ
+		///	@note	ַ߳зͬһ¼ʱ Block ȴ
+		////////////////////////////////////////////////////////////////////////////////
+		template <typename EventClass>
+		class AsyncEventQueue final
+			: public AsyncEventQueueBase
+		{
+		public:
+			AsyncEventQueue(natEventBus& bus, natThreadPool& dispatcher, AsyncEventOptions const& options)
+				: m_Bus(bus), m_Dispatcher(dispatcher), m_Options(options), m_Scheduled{ false }, m_Waiting{ false }, m_Delivering{ false }, m_Closed{ false }
+			{
+			}
+
+			void Push(EventClass const& event)
+			{
+				std::unique_lock<std::mutex> lock{ m_Mutex };
+				if (m_Closed)
+				{
+					return;
+				}
+
+				if constexpr (detail_::IsEqualityComparable<EventClass>::value)
+				{
+					if (m_Options.Coalesce && !m_Events.empty() && m_Events.back() == event)
+					{
+						return;
+					}
+				}
+
+				if (m_Events.size() >= m_Options.Capacity)
+				{
+					switch (m_Options.Policy)
+					{
+					case EventBackpressurePolicy::Block:
+						if (m_DispatchThread != std::this_thread::get_id())
+						{
+							m_NotFull.wait(lock, [this]
+							{
+								return m_Closed || m_Events.size() < m_Options.Capacity;
+							});
+							if (m_Closed)
+							{
+								return;
+							}
+						}
+						break;
+					case EventBackpressurePolicy::DropOldest:
+						m_Events.pop_front();
+						break;
+					case EventBackpressurePolicy::DropNewest:
+						return;
+					}
+				}
+
+				m_Events.push_back(event);
+				if (!m_Scheduled)
+				{
+					m_Scheduled = true;
+					lock.unlock();
+					Schedule();
+				}
+				else if (m_Waiting)
+				{
+					// ڵȴķַ֮ķ֮ǰظ
+					m_Waiting = false;
+					lock.unlock();
+					m_NotEmpty.notify_one();
+				}
+			}
+
+			void Flush() override
+			{
+				std::unique_lock<std::mutex> lock{ m_Mutex };
+				if (m_DispatchThread == std::this_thread::get_id())
+				{
+					return;
+				}
+
+				m_Idle.wait(lock, [this]
+				{
+					return !m_Scheduled || (m_Events.empty() && !m_Delivering);
+				});
+			}
+
+			void Close() override
+			{
+				std::unique_lock<std::mutex> lock{ m_Mutex };
+				m_Closed = true;
+				m_Events.clear();
+				m_NotFull.notify_all();
+				m_NotEmpty.notify_all();
+				if (m_DispatchThread == std::this_thread::get_id())
+				{
+					return;
+				}
+
+				m_Idle.wait(lock, [this]
+				{
+					return !m_Scheduled;
+				});
+			}
+
+		private:
+			void Schedule()
+			{
+				try
+				{
+					m_Dispatcher.QueueWork([self = natRefPointer<AsyncEventQueue>{ this }](void*)
+					{
+						self->Dispatch();
+						return 0u;
+					});
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock{ m_Mutex };
+					m_Scheduled = false;
+					m_Idle.notify_all();
+					throw;
+				}
+			}
+
+			void Dispatch()
+			{
+				std::vector<EventClass> batch;
+				std::unique_lock<std::mutex> lock{ m_Mutex };
+				m_DispatchThread = std::this_thread::get_id();
+
+				while (!m_Closed)
+				{
+					if (m_Events.empty())
+					{
+						// ݵȴµ¼ÿɿձΪǿʱҪ̳߳ύַ
+						m_Idle.notify_all();
+						m_Waiting = true;
+						const auto notEmpty = m_NotEmpty.wait_for(lock, m_Options.KeepAlive, [this]
+						{
+							return m_Closed || !m_Events.empty();
+						});
+						m_Waiting = false;
+						if (!notEmpty || m_Closed)
+						{
+							break;
+						}
+					}
+
+					const auto end = m_Events.begin() + std::min(m_Events.size(), m_Options.BatchSize);
+					batch.insert(batch.end(), std::make_move_iterator(m_Events.begin()), std::make_move_iterator(end));
+					m_Events.erase(m_Events.begin(), end);
+					m_NotFull.notify_all();
+					m_Delivering = true;
+					lock.unlock();
+
+					const auto listeners = m_Bus.LoadListeners(typeid(EventClass));
+					for (auto& event : batch)
+					{
+						for (auto&& listener : listeners->Listeners)
+						{
+							try
+							{
+								listener.Listener(static_cast<natEventBase&>(event));
+							}
+							catch (...)
+							{
+							}
+						}
+					}
+					batch.clear();
+
+					lock.lock();
+					m_Delivering = false;
+				}
+
+				m_DispatchThread = {};
+				m_Scheduled = false;
+				m_Idle.notify_all();
+			}
+
+			natEventBus& m_Bus;
+			natThreadPool& m_Dispatcher;
+			const AsyncEventOptions m_Options;
+			std::mutex m_Mutex;
+			std::condition_variable m_NotFull, m_NotEmpty, m_Idle;
+			std::deque<EventClass> m_Events;
+			std::thread::id m_DispatchThread;
+			nBool m_Scheduled, m_Waiting, m_Delivering, m_Closed;
+		};
+
+		struct EventEntry
+		{
+			natRefPointer<const ListenerArray> Listeners;
+			natRefPointer<AsyncEventQueueBase> Queue;
+		};
+
+		struct EventTable final
+			: natRefObjImpl<EventTable>
+		{
+			FlatHashMap<std::type_index, EventEntry> Events;
+		};
+
+		void RegisterEvent(std::type_index const& type, natRefPointer<AsyncEventQueueBase> queue);
+		void FlushAsyncEvent(std::type_index const& type);
+		natRefPointer<const ListenerArray> LoadListeners(std::type_index const& type) const;
+		natRefPointer<const ListenerArray> const& FindListeners(std::type_index const& type) const;
+		void Publish(std::type_index const& type, natRefPointer<const ListenerArray> listeners);
+
 		natCriticalSection m_Section;
-		std::unordered_map<std::type_index, std::map<PriorityType, std::map<ListenerIDType, EventListenerDelegate>>> m_EventListenerMap;
+		detail_::CopyOnWritePointer<const EventTable> m_Table;
+		FlatHashMap<std::type_index, natRefPointer<natRefObj>> m_Channels;
 	};
 }
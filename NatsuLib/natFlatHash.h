@@ -0,0 +1,1000 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+///	@file	natFlatHash.h
+///	@brief	开放寻址的平坦哈希表
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <utility>
+
+#include "natConfig.h"
+#include "natMisc.h"
+#include "natString.h"
+#include "natException.h"
+
+#ifdef UseSSE2
+#	include <emmintrin.h>
+#endif
+
+namespace NatsuLib
+{
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	平坦哈希表使用的默认哈希函数
+	///	@remark	对字符串及字符串视图是透明的，可以直接以 StringView 或字符串字面量查找而不构造字符串
+	////////////////////////////////////////////////////////////////////////////////
+	template <typename T>
+	struct FlatHash
+		: std::hash<T>
+	{
+	};
+
+	template <StringType stringType>
+	struct FlatHash<String<stringType>>
+	{
+		typedef void is_transparent;
+
+		size_t operator()(StringView<stringType> const& view) const
+		{
+			return std::hash<StringView<stringType>>{}(view);
+		}
+	};
+
+	template <StringType stringType>
+	struct FlatHash<StringView<stringType>>
+		: FlatHash<String<stringType>>
+	{
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	平坦哈希表使用的默认相等比较
+	///	@remark	与 FlatHash 相同，对字符串及字符串视图是透明的
+	////////////////////////////////////////////////////////////////////////////////
+	template <typename T>
+	struct FlatEqualTo
+		: std::equal_to<T>
+	{
+	};
+
+	template <StringType stringType>
+	struct FlatEqualTo<String<stringType>>
+	{
+		typedef void is_transparent;
+
+		nBool operator()(StringView<stringType> const& a, StringView<stringType> const& b) const noexcept
+		{
+			return a == b;
+		}
+	};
+
+	template <StringType stringType>
+	struct FlatEqualTo<StringView<stringType>>
+		: FlatEqualTo<String<stringType>>
+	{
+	};
+
+	namespace detail_
+	{
+		// 控制字节，非负值表示槽已被占用，其值为哈希值的低 7 位
+		enum : nSByte
+		{
+			FlatCtrlEmpty = -128,
+			FlatCtrlDeleted = -2,
+			FlatCtrlSentinel = -1,
+		};
+
+		enum : size_t
+		{
+			FlatGroupWidth = 16,
+			// 容量总为 2 的幂减 1，且不小于一组的宽度减 1，保证一组控制字节内的每一字节都对应一个槽、哨兵或槽的副本
+			FlatMinCapacity = FlatGroupWidth - 1,
+		};
+
+		////////////////////////////////////////////////////////////////////////////////
+		///	@brief	一组连续的控制字节
+		///	@remark	支持 SSE2 时以一次比较及 movemask 得到整组的匹配位
+		////////////////////////////////////////////////////////////////////////////////
+		class FlatGroup
+		{
+		public:
+			typedef nuInt Mask_t;
+
+			explicit FlatGroup(const nSByte* ctrl) noexcept
+			{
+#ifdef UseSSE2
+				m_Ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+#else
+				std::memcpy(m_Ctrl, ctrl, FlatGroupWidth);
+#endif
+			}
+
+			///	@brief	控制字节等于 h2 的槽
+			Mask_t Match(nSByte h2) const noexcept
+			{
+#ifdef UseSSE2
+				return static_cast<Mask_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), m_Ctrl)));
+#else
+				return MatchIf([h2](nSByte ctrl) noexcept { return ctrl == h2; });
+#endif
+			}
+
+			Mask_t MatchEmpty() const noexcept
+			{
+#ifdef UseSSE2
+				return static_cast<Mask_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(FlatCtrlEmpty), m_Ctrl)));
+#else
+				return MatchIf([](nSByte ctrl) noexcept { return ctrl == FlatCtrlEmpty; });
+#endif
+			}
+
+			///	@brief	可以插入元素的槽
+			Mask_t MatchEmptyOrDeleted() const noexcept
+			{
+#ifdef UseSSE2
+				// 空槽及已删除的槽的控制字节均小于哨兵
+				return static_cast<Mask_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(FlatCtrlSentinel), m_Ctrl)));
+#else
+				return MatchIf([](nSByte ctrl) noexcept { return ctrl < FlatCtrlSentinel; });
+#endif
+			}
+
+		private:
+#ifdef UseSSE2
+			__m128i m_Ctrl;
+#else
+			nSByte m_Ctrl[FlatGroupWidth];
+
+			template <typename Pred_t>
+			Mask_t MatchIf(Pred_t pred) const noexcept
+			{
+				Mask_t result{};
+				for (size_t i = 0; i < FlatGroupWidth; ++i)
+				{
+					result |= static_cast<Mask_t>(pred(m_Ctrl[i])) << i;
+				}
+				return result;
+			}
+#endif
+		};
+
+		template <nBool IsTransparent>
+		struct FlatKeyArg
+		{
+			template <typename K, typename Key_t>
+			using type = K;
+		};
+
+		template <>
+		struct FlatKeyArg<false>
+		{
+			template <typename K, typename Key_t>
+			using type = Key_t;
+		};
+
+		template <typename T, typename = void>
+		struct HasTransparentTag
+			: std::false_type
+		{
+		};
+
+		template <typename T>
+		struct HasTransparentTag<T, std::void_t<typename T::is_transparent>>
+			: std::true_type
+		{
+		};
+
+		template <typename Key_t, typename Value_t>
+		struct FlatMapPolicy
+		{
+			typedef Key_t key_type;
+			typedef std::pair<const Key_t, Value_t> value_type;
+
+			static constexpr nBool IsConstIterator = false;
+
+			static Key_t const& GetKey(value_type const& value) noexcept
+			{
+				return value.first;
+			}
+
+			// 与 std::map 的节点句柄相同，搬移元素时需移动 const 的键
+			static void Relocate(value_type* dest, value_type* src)
+			{
+				::new (static_cast<void*>(dest)) value_type(std::move(const_cast<Key_t&>(src->first)), std::move(src->second));
+				src->~value_type();
+			}
+		};
+
+		template <typename Key_t>
+		struct FlatSetPolicy
+		{
+			typedef Key_t key_type;
+			typedef Key_t value_type;
+
+			static constexpr nBool IsConstIterator = true;
+
+			static Key_t const& GetKey(value_type const& value) noexcept
+			{
+				return value;
+			}
+
+			static void Relocate(value_type* dest, value_type* src)
+			{
+				::new (static_cast<void*>(dest)) value_type(std::move(*src));
+				src->~value_type();
+			}
+		};
+
+		////////////////////////////////////////////////////////////////////////////////
+		///	@brief	FlatHashMap 及 FlatHashSet 的实现
+		///	@remark	元素直接保存在槽数组中，每个槽对应一个控制字节，记录槽的状态及哈希值的低 7 位（H2），
+		///			哈希值的其余位（H1）决定探测的起始位置，查找时以组为单位比较控制字节，仅对 H2 相同的槽比较键，
+		///			控制字节数组的末尾有一个哨兵及前 FlatGroupWidth - 1 个控制字节的副本，使得任意位置都可以读取一整组
+		////////////////////////////////////////////////////////////////////////////////
+		template <typename Policy_t, typename Hash_t, typename Equal_t>
+		class FlatHashTable
+		{
+			static constexpr nBool IsTransparent = HasTransparentTag<Hash_t>::value && HasTransparentTag<Equal_t>::value;
+
+		public:
+			typedef typename Policy_t::key_type key_type;
+			typedef typename Policy_t::value_type value_type;
+			typedef size_t size_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef Hash_t hasher;
+			typedef Equal_t key_equal;
+			typedef value_type& reference;
+			typedef value_type const& const_reference;
+			typedef value_type* pointer;
+			typedef value_type const* const_pointer;
+
+		protected:
+			// 哈希函数及相等比较均透明时查找可使用任意类型的键，否则只能使用 key_type
+			template <typename K>
+			using KeyArg = typename FlatKeyArg<IsTransparent>::template type<K, key_type>;
+
+		public:
+			template <nBool IsConst>
+			class Iterator
+			{
+				friend class FlatHashTable;
+				template <nBool>
+				friend class Iterator;
+
+			public:
+				typedef std::forward_iterator_tag iterator_category;
+				typedef typename FlatHashTable::value_type value_type;
+				typedef std::ptrdiff_t difference_type;
+				typedef std::conditional_t<IsConst, value_type const*, value_type*> pointer;
+				typedef std::conditional_t<IsConst, value_type const&, value_type&> reference;
+
+				Iterator() noexcept
+					: m_Ctrl{}, m_Slot{}
+				{
+				}
+
+				template <nBool OtherIsConst, std::enable_if_t<IsConst && !OtherIsConst, int> = 0>
+				Iterator(Iterator<OtherIsConst> const& other) noexcept
+					: m_Ctrl{ other.m_Ctrl }, m_Slot{ other.m_Slot }
+				{
+				}
+
+				reference operator*() const noexcept
+				{
+					return *m_Slot;
+				}
+
+				pointer operator->() const noexcept
+				{
+					return m_Slot;
+				}
+
+				Iterator& operator++() noexcept
+				{
+					++m_Ctrl;
+					++m_Slot;
+					SkipEmptyOrDeleted();
+					return *this;
+				}
+
+				Iterator operator++(int) noexcept
+				{
+					auto ret = *this;
+					++*this;
+					return ret;
+				}
+
+				friend nBool operator==(Iterator const& a, Iterator const& b) noexcept
+				{
+					return a.m_Ctrl == b.m_Ctrl;
+				}
+
+				friend nBool operator!=(Iterator const& a, Iterator const& b) noexcept
+				{
+					return a.m_Ctrl != b.m_Ctrl;
+				}
+
+			private:
+				const nSByte* m_Ctrl;
+				pointer m_Slot;
+
+				Iterator(const nSByte* ctrl, pointer slot) noexcept
+					: m_Ctrl{ ctrl }, m_Slot{ slot }
+				{
+				}
+
+				// 控制字节数组以哨兵结尾，跳过空槽及已删除的槽时无需检查边界
+				void SkipEmptyOrDeleted() noexcept
+				{
+					while (*m_Ctrl < FlatCtrlSentinel)
+					{
+						const auto shift = CountTrailingZeros(~static_cast<nuLong>(FlatGroup{ m_Ctrl }.MatchEmptyOrDeleted()));
+						m_Ctrl += shift;
+						m_Slot += shift;
+					}
+				}
+			};
+
+			typedef Iterator<Policy_t::IsConstIterator> iterator;
+			typedef Iterator<true> const_iterator;
+
+			FlatHashTable() noexcept(std::is_nothrow_default_constructible<Hash_t>::value && std::is_nothrow_default_constructible<Equal_t>::value)
+				: m_Ctrl{}, m_Slots{}, m_Capacity{}, m_Size{}, m_GrowthLeft{}
+			{
+			}
+
+			explicit FlatHashTable(size_type bucketCount, Hash_t const& hash = Hash_t{}, Equal_t const& equal = Equal_t{})
+				: m_Ctrl{}, m_Slots{}, m_Capacity{}, m_Size{}, m_GrowthLeft{}, m_Hasher(hash), m_Equal(equal)
+			{
+				reserve(bucketCount);
+			}
+
+			FlatHashTable(std::initializer_list<value_type> il)
+				: FlatHashTable(il.size())
+			{
+				insert(il);
+			}
+
+			template <typename InputIterator>
+			FlatHashTable(InputIterator first, InputIterator last)
+				: FlatHashTable()
+			{
+				insert(first, last);
+			}
+
+			FlatHashTable(FlatHashTable const& other)
+				: FlatHashTable(other.size(), other.m_Hasher, other.m_Equal)
+			{
+				for (auto&& item : other)
+				{
+					const auto index = PrepareInsert(HashKey(Policy_t::GetKey(item)));
+					try
+					{
+						::new (static_cast<void*>(m_Slots + index)) value_type(item);
+					}
+					catch (...)
+					{
+						EraseMeta(index);
+						throw;
+					}
+				}
+			}
+
+			FlatHashTable(FlatHashTable&& other) noexcept(std::is_nothrow_move_constructible<Hash_t>::value && std::is_nothrow_move_constructible<Equal_t>::value)
+				: m_Ctrl{ other.m_Ctrl }, m_Slots{ other.m_Slots }, m_Capacity{ other.m_Capacity }, m_Size{ other.m_Size }, m_GrowthLeft{ other.m_GrowthLeft },
+				m_Hasher(std::move(other.m_Hasher)), m_Equal(std::move(other.m_Equal))
+			{
+				other.m_Ctrl = nullptr;
+				other.m_Slots = nullptr;
+				other.m_Capacity = 0;
+				other.m_Size = 0;
+				other.m_GrowthLeft = 0;
+			}
+
+			~FlatHashTable()
+			{
+				DestroyAndDeallocate();
+			}
+
+			FlatHashTable& operator=(FlatHashTable const& other)
+			{
+				if (this != &other)
+				{
+					auto copy = other;
+					swap(copy);
+				}
+				return *this;
+			}
+
+			FlatHashTable& operator=(FlatHashTable&& other) noexcept
+			{
+				if (this != &other)
+				{
+					DestroyAndDeallocate();
+					m_Ctrl = std::exchange(other.m_Ctrl, nullptr);
+					m_Slots = std::exchange(other.m_Slots, nullptr);
+					m_Capacity = std::exchange(other.m_Capacity, 0);
+					m_Size = std::exchange(other.m_Size, 0);
+					m_GrowthLeft = std::exchange(other.m_GrowthLeft, 0);
+					m_Hasher = std::move(other.m_Hasher);
+					m_Equal = std::move(other.m_Equal);
+				}
+				return *this;
+			}
+
+			iterator begin() noexcept
+			{
+				auto ret = MakeIterator(0);
+				if (m_Capacity)
+				{
+					ret.SkipEmptyOrDeleted();
+				}
+				return ret;
+			}
+
+			const_iterator begin() const noexcept
+			{
+				return const_cast<FlatHashTable*>(this)->begin();
+			}
+
+			const_iterator cbegin() const noexcept
+			{
+				return begin();
+			}
+
+			iterator end() noexcept
+			{
+				return MakeIterator(m_Capacity);
+			}
+
+			const_iterator end() const noexcept
+			{
+				return const_cast<FlatHashTable*>(this)->end();
+			}
+
+			const_iterator cend() const noexcept
+			{
+				return end();
+			}
+
+			nBool empty() const noexcept
+			{
+				return !m_Size;
+			}
+
+			size_type size() const noexcept
+			{
+				return m_Size;
+			}
+
+			///	@brief	槽的数量
+			size_type capacity() const noexcept
+			{
+				return m_Capacity;
+			}
+
+			float load_factor() const noexcept
+			{
+				return m_Capacity ? static_cast<float>(m_Size) / static_cast<float>(m_Capacity) : 0.0f;
+			}
+
+			///	@brief	最大负载因子，固定为 7/8
+			static constexpr float max_load_factor() noexcept
+			{
+				return 0.875f;
+			}
+
+			hasher hash_function() const
+			{
+				return m_Hasher;
+			}
+
+			key_equal key_eq() const
+			{
+				return m_Equal;
+			}
+
+			///	@brief	移除所有元素
+			///	@note	不会释放已分配的槽
+			void clear() noexcept
+			{
+				if (m_Capacity)
+				{
+					DestroyAll();
+					ResetCtrl();
+					m_Size = 0;
+					m_GrowthLeft = CapacityToGrowth(m_Capacity);
+				}
+			}
+
+			///	@brief	预留至少可容纳 count 个元素而不需要重新散列的空间
+			void reserve(size_type count)
+			{
+				if (count > m_Size + m_GrowthLeft)
+				{
+					Resize(CapacityForGrowth(count));
+				}
+			}
+
+			///	@brief	以至少 count 个槽重新散列，同时清除所有删除标记
+			void rehash(size_type count)
+			{
+				const auto newCapacity = std::max(NormalizeCapacity(count), CapacityForGrowth(m_Size));
+				if (m_Size || newCapacity != m_Capacity)
+				{
+					Resize(newCapacity);
+				}
+			}
+
+			template <typename K = key_type>
+			iterator find(KeyArg<K> const& key)
+			{
+				return MakeIterator(FindIndex(key));
+			}
+
+			template <typename K = key_type>
+			const_iterator find(KeyArg<K> const& key) const
+			{
+				return const_cast<FlatHashTable*>(this)->find(key);
+			}
+
+			template <typename K = key_type>
+			nBool contains(KeyArg<K> const& key) const
+			{
+				return FindIndex(key) != m_Capacity;
+			}
+
+			template <typename K = key_type>
+			size_type count(KeyArg<K> const& key) const
+			{
+				return contains(key);
+			}
+
+			std::pair<iterator, nBool> insert(value_type const& value)
+			{
+				return EmplaceWithKey(Policy_t::GetKey(value), value);
+			}
+
+			std::pair<iterator, nBool> insert(value_type&& value)
+			{
+				return EmplaceWithKey(Policy_t::GetKey(value), std::move(value));
+			}
+
+			template <typename InputIterator>
+			void insert(InputIterator first, InputIterator last)
+			{
+				for (; first != last; ++first)
+				{
+					emplace(*first);
+				}
+			}
+
+			void insert(std::initializer_list<value_type> il)
+			{
+				insert(il.begin(), il.end());
+			}
+
+			///	@brief	构造元素并插入
+			///	@note	需要先构造元素才能获得键，对映射应优先使用 try_emplace
+			template <typename... Args>
+			std::pair<iterator, nBool> emplace(Args&&... args)
+			{
+				if constexpr (sizeof...(Args) == 1 && std::conjunction<std::is_same<std::decay_t<Args>, value_type>...>::value)
+				{
+					return EmplaceWithKey(Policy_t::GetKey(args)..., std::forward<Args>(args)...);
+				}
+				else
+				{
+					value_type value(std::forward<Args>(args)...);
+					return EmplaceWithKey(Policy_t::GetKey(value), std::move(value));
+				}
+			}
+
+			iterator erase(const_iterator pos)
+			{
+				auto next = iterator{ pos.m_Ctrl, const_cast<typename iterator::pointer>(pos.m_Slot) };
+				++next;
+				EraseAt(static_cast<size_t>(pos.m_Ctrl - m_Ctrl));
+				return next;
+			}
+
+			template <nBool IsConst = Policy_t::IsConstIterator, std::enable_if_t<!IsConst, int> = 0>
+			iterator erase(iterator pos)
+			{
+				return erase(const_iterator{ pos });
+			}
+
+			template <typename K = key_type, std::enable_if_t<!std::is_convertible<K const&, const_iterator>::value, int> = 0>
+			size_type erase(KeyArg<K> const& key)
+			{
+				const auto index = FindIndex(key);
+				if (index == m_Capacity)
+				{
+					return 0;
+				}
+				EraseAt(index);
+				return 1;
+			}
+
+			void swap(FlatHashTable& other) noexcept
+			{
+				using std::swap;
+				swap(m_Ctrl, other.m_Ctrl);
+				swap(m_Slots, other.m_Slots);
+				swap(m_Capacity, other.m_Capacity);
+				swap(m_Size, other.m_Size);
+				swap(m_GrowthLeft, other.m_GrowthLeft);
+				swap(m_Hasher, other.m_Hasher);
+				swap(m_Equal, other.m_Equal);
+			}
+
+			friend void swap(FlatHashTable& a, FlatHashTable& b) noexcept
+			{
+				a.swap(b);
+			}
+
+		protected:
+			// 查找键为 key 的元素，不存在时以 args 构造新元素
+			template <typename K, typename... Args>
+			std::pair<iterator, nBool> EmplaceWithKey(K const& key, Args&&... args)
+			{
+				const auto hash = HashKey(key);
+				auto index = FindIndex(key, hash);
+				if (index != m_Capacity)
+				{
+					return { MakeIterator(index), false };
+				}
+
+				index = PrepareInsert(hash);
+				try
+				{
+					::new (static_cast<void*>(m_Slots + index)) value_type(std::forward<Args>(args)...);
+				}
+				catch (...)
+				{
+					EraseMeta(index);
+					throw;
+				}
+
+				return { MakeIterator(index), true };
+			}
+
+			template <typename K>
+			size_t FindIndex(K const& key) const
+			{
+				return m_Size ? FindIndex(key, HashKey(key)) : m_Capacity;
+			}
+
+			iterator MakeIterator(size_t index) noexcept
+			{
+				return { m_Ctrl + index, m_Slots + index };
+			}
+
+		private:
+			nSByte* m_Ctrl;
+			value_type* m_Slots;
+			size_t m_Capacity;
+			size_t m_Size;
+			// 在需要重新散列之前还可以占用的空槽数量，已删除的槽可以直接重用，不计入其中
+			size_t m_GrowthLeft;
+			Hash_t m_Hasher;
+			Equal_t m_Equal;
+
+			static constexpr size_t H1(size_t hash) noexcept
+			{
+				return hash >> 7;
+			}
+
+			static constexpr nSByte H2(size_t hash) noexcept
+			{
+				return static_cast<nSByte>(hash & 0x7F);
+			}
+
+			static constexpr size_t CapacityToGrowth(size_t capacity) noexcept
+			{
+				return capacity - capacity / 8;
+			}
+
+			static size_t NormalizeCapacity(size_t capacity) noexcept
+			{
+				size_t result = FlatMinCapacity;
+				while (result < capacity)
+				{
+					result = result * 2 + 1;
+				}
+				return result;
+			}
+
+			// 可以容纳 growth 个元素的最小容量
+			static size_t CapacityForGrowth(size_t growth) noexcept
+			{
+				size_t result = FlatMinCapacity;
+				while (CapacityToGrowth(result) < growth)
+				{
+					result = result * 2 + 1;
+				}
+				return result;
+			}
+
+			template <typename K>
+			size_t HashKey(K const& key) const
+			{
+				return MixHash(m_Hasher(key));
+			}
+
+			// 以三角数步长按组探测，容量加 1 是组宽度的倍数，因此可以探测到所有组
+			template <typename K>
+			size_t FindIndex(K const& key, size_t hash) const
+			{
+				if (!m_Capacity)
+				{
+					return m_Capacity;
+				}
+
+				const auto h2 = H2(hash);
+				auto offset = H1(hash) & m_Capacity;
+				size_t step{};
+				while (true)
+				{
+					const FlatGroup group{ m_Ctrl + offset };
+					for (auto mask = group.Match(h2); mask; mask &= mask - 1)
+					{
+						const auto index = (offset + CountTrailingZeros(mask)) & m_Capacity;
+						if (m_Equal(Policy_t::GetKey(m_Slots[index]), key))
+						{
+							return index;
+						}
+					}
+
+					if (group.MatchEmpty())
+					{
+						return m_Capacity;
+					}
+
+					step += FlatGroupWidth;
+					offset = (offset + step) & m_Capacity;
+				}
+			}
+
+			size_t FindFirstNonFull(size_t hash) const noexcept
+			{
+				auto offset = H1(hash) & m_Capacity;
+				size_t step{};
+				while (true)
+				{
+					if (const auto mask = FlatGroup{ m_Ctrl + offset }.MatchEmptyOrDeleted())
+					{
+						return (offset + CountTrailingZeros(mask)) & m_Capacity;
+					}
+
+					step += FlatGroupWidth;
+					offset = (offset + step) & m_Capacity;
+				}
+			}
+
+			// 为哈希值为 hash 的新元素占用一个槽，返回槽的序号，调用者需在此槽上构造元素
+			size_t PrepareInsert(size_t hash)
+			{
+				if (!m_Capacity)
+				{
+					Resize(FlatMinCapacity);
+				}
+
+				auto index = FindFirstNonFull(hash);
+				if (!m_GrowthLeft && m_Ctrl[index] != FlatCtrlDeleted)
+				{
+					// 删除标记较多时以原容量重新散列即可
+					Resize(m_Size * 32 <= m_Capacity * 25 ? m_Capacity : m_Capacity * 2 + 1);
+					index = FindFirstNonFull(hash);
+				}
+
+				m_GrowthLeft -= m_Ctrl[index] == FlatCtrlEmpty;
+				SetCtrl(index, H2(hash));
+				++m_Size;
+				return index;
+			}
+
+			void SetCtrl(size_t index, nSByte ctrl) noexcept
+			{
+				m_Ctrl[index] = ctrl;
+				if (index < FlatGroupWidth - 1)
+				{
+					m_Ctrl[m_Capacity + 1 + index] = ctrl;
+				}
+			}
+
+			void ResetCtrl() noexcept
+			{
+				std::memset(m_Ctrl, static_cast<nByte>(FlatCtrlEmpty), m_Capacity + FlatGroupWidth);
+				m_Ctrl[m_Capacity] = FlatCtrlSentinel;
+			}
+
+			void EraseAt(size_t index)
+			{
+				m_Slots[index].~value_type();
+				EraseMeta(index);
+			}
+
+			// 若包含此槽的任意一组都不曾被占满，则此前的查找都不会越过此槽，可以直接标记为空槽，否则需标记为已删除
+			void EraseMeta(size_t index) noexcept
+			{
+				--m_Size;
+
+				const auto emptyBefore = FlatGroup{ m_Ctrl + ((index - FlatGroupWidth) & m_Capacity) }.MatchEmpty();
+				const auto emptyAfter = FlatGroup{ m_Ctrl + index }.MatchEmpty();
+				const auto wasNeverFull = emptyBefore && emptyAfter &&
+					CountTrailingZeros(emptyAfter) + CountLeadingZeros(emptyBefore) - (64 - FlatGroupWidth) < FlatGroupWidth;
+
+				SetCtrl(index, wasNeverFull ? FlatCtrlEmpty : FlatCtrlDeleted);
+				m_GrowthLeft += wasNeverFull;
+			}
+
+			///	@note	元素的移动构造不应抛出异常
+			void Resize(size_t newCapacity)
+			{
+				const auto oldCtrl = m_Ctrl;
+				const auto oldSlots = m_Slots;
+				const auto oldCapacity = m_Capacity;
+
+				m_Slots = std::allocator<value_type>{}.allocate(newCapacity);
+				try
+				{
+					m_Ctrl = std::allocator<nSByte>{}.allocate(newCapacity + FlatGroupWidth);
+				}
+				catch (...)
+				{
+					std::allocator<value_type>{}.deallocate(m_Slots, newCapacity);
+					m_Slots = oldSlots;
+					throw;
+				}
+
+				m_Capacity = newCapacity;
+				m_GrowthLeft = CapacityToGrowth(newCapacity) - m_Size;
+				ResetCtrl();
+
+				for (size_t i = 0; i < oldCapacity; ++i)
+				{
+					if (oldCtrl[i] >= 0)
+					{
+						const auto hash = HashKey(Policy_t::GetKey(oldSlots[i]));
+						const auto index = FindFirstNonFull(hash);
+						SetCtrl(index, H2(hash));
+						Policy_t::Relocate(m_Slots + index, oldSlots + i);
+					}
+				}
+
+				if (oldCapacity)
+				{
+					std::allocator<nSByte>{}.deallocate(oldCtrl, oldCapacity + FlatGroupWidth);
+					std::allocator<value_type>{}.deallocate(oldSlots, oldCapacity);
+				}
+			}
+
+			void DestroyAll() noexcept
+			{
+				if constexpr (!std::is_trivially_destructible<value_type>::value)
+				{
+					for (size_t i = 0; i < m_Capacity; ++i)
+					{
+						if (m_Ctrl[i] >= 0)
+						{
+							m_Slots[i].~value_type();
+						}
+					}
+				}
+			}
+
+			void DestroyAndDeallocate() noexcept
+			{
+				if (m_Capacity)
+				{
+					DestroyAll();
+					std::allocator<nSByte>{}.deallocate(m_Ctrl, m_Capacity + FlatGroupWidth);
+					std::allocator<value_type>{}.deallocate(m_Slots, m_Capacity);
+				}
+			}
+		};
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	开放寻址的平坦哈希映射
+	///	@remark	接口与 std::unordered_map 基本一致，哈希函数及相等比较均透明时支持异构查找
+	///	@note	插入元素可能使所有迭代器及元素的引用失效，删除元素只会使被删除元素的迭代器失效
+	////////////////////////////////////////////////////////////////////////////////
+	template <typename Key_t, typename Value_t, typename Hash_t = FlatHash<Key_t>, typename Equal_t = FlatEqualTo<Key_t>>
+	class FlatHashMap
+		: public detail_::FlatHashTable<detail_::FlatMapPolicy<Key_t, Value_t>, Hash_t, Equal_t>
+	{
+		typedef detail_::FlatHashTable<detail_::FlatMapPolicy<Key_t, Value_t>, Hash_t, Equal_t> Base;
+
+	public:
+		typedef Value_t mapped_type;
+		using typename Base::key_type;
+		using typename Base::value_type;
+		using typename Base::iterator;
+		using typename Base::const_iterator;
+
+		using Base::Base;
+
+		///	@brief	键不存在时以 args 构造值并插入
+		///	@remark	键已存在时不会构造值
+		template <typename... Args>
+		std::pair<iterator, nBool> try_emplace(key_type const& key, Args&&... args)
+		{
+			return this->EmplaceWithKey(key, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+		}
+
+		template <typename... Args>
+		std::pair<iterator, nBool> try_emplace(key_type&& key, Args&&... args)
+		{
+			return this->EmplaceWithKey(key, std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+		}
+
+		template <typename Value>
+		std::pair<iterator, nBool> insert_or_assign(key_type const& key, Value&& value)
+		{
+			auto ret = try_emplace(key, std::forward<Value>(value));
+			if (!ret.second)
+			{
+				ret.first->second = std::forward<Value>(value);
+			}
+			return ret;
+		}
+
+		template <typename Value>
+		std::pair<iterator, nBool> insert_or_assign(key_type&& key, Value&& value)
+		{
+			auto ret = try_emplace(std::move(key), std::forward<Value>(value));
+			if (!ret.second)
+			{
+				ret.first->second = std::forward<Value>(value);
+			}
+			return ret;
+		}
+
+		mapped_type& operator[](key_type const& key)
+		{
+			return try_emplace(key).first->second;
+		}
+
+		mapped_type& operator[](key_type&& key)
+		{
+			return try_emplace(std::move(key)).first->second;
+		}
+
+		template <typename K = key_type>
+		mapped_type& at(typename Base::template KeyArg<K> const& key)
+		{
+			const auto iter = this->find(key);
+			if (iter == this->end())
+			{
+				nat_Throw(natErrException, NatErr_OutOfRange, "Key not found."_nv);
+			}
+			return iter->second;
+		}
+
+		template <typename K = key_type>
+		mapped_type const& at(typename Base::template KeyArg<K> const& key) const
+		{
+			return const_cast<FlatHashMap*>(this)->at(key);
+		}
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	开放寻址的平坦哈希集合
+	///	@remark	接口与 std::unordered_set 基本一致，哈希函数及相等比较均透明时支持异构查找
+	///	@note	插入元素可能使所有迭代器及元素的引用失效，删除元素只会使被删除元素的迭代器失效
+	////////////////////////////////////////////////////////////////////////////////
+	template <typename Key_t, typename Hash_t = FlatHash<Key_t>, typename Equal_t = FlatEqualTo<Key_t>>
+	class FlatHashSet
+		: public detail_::FlatHashTable<detail_::FlatSetPolicy<Key_t>, Hash_t, Equal_t>
+	{
+		typedef detail_::FlatHashTable<detail_::FlatSetPolicy<Key_t>, Hash_t, Equal_t> Base;
+
+	public:
+		using Base::Base;
+	};
+}
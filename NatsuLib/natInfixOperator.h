@@ -26,7 +26,7 @@ namespace NatsuLib
 	template <typename T, typename Op>
 	constexpr auto operator<(T&& lhs, InfixOp<Op>) noexcept
 	{
-		return InfixOp<Op>::template LhsStorage<T&&>{ std::forward<T>(lhs) };
+		return typename InfixOp<Op>::template LhsStorage<T&&>{ std::forward<T>(lhs) };
 	}
 
 	template <typename Op, typename T, typename U>
@@ -0,0 +1,510 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+///	@file	natLineIndex.h
+///	@brief	文本文件的行索引
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "natStream.h"
+#include "natStreamHelper.h"
+#include "natBinary.h"
+#include "natMultiThread.h"
+
+namespace NatsuLib
+{
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	文本文件的行索引
+	///	@remark	扫描一次文件并记录每一行的起始位置，之后可随机访问任意一行，或将所有行分批交由线程池并行处理
+	///			文件可被映射到内存，此时行以 StringView 的形式直接引用映射的内存；否则按需从文件中读取
+	///	@note	换行符的处理与 TextReader::SetNewLine 一致，文件末尾的换行符不会产生额外的空行
+	////////////////////////////////////////////////////////////////////////////////
+	template <StringType encoding>
+	class natLineIndex final
+		: public natRefObjImpl<natLineIndex<encoding>, natRefObj>
+	{
+	public:
+		typedef typename StringEncodingTrait<encoding>::CharType CharType;
+		typedef StringView<encoding> View;
+
+		enum : size_t
+		{
+			DefaultBatchSize = 4096,	///< @brief	并行处理时每个任务默认处理的行数
+			ScanBlockSize = 1 << 20,	///< @brief	未映射时扫描文件使用的缓冲区大小
+			MaxPendingBatches = 16,		///< @brief	未映射时最多同时持有的批次数
+		};
+
+		///	@brief	建立行索引
+		///	@param[in]	file			要索引的文件
+		///	@param[in]	newLine			换行符
+		///	@param[in]	useMapping		是否将文件映射到内存
+		///	@param[in]	sidecarFilename	索引文件名，若不为空则优先从此文件载入索引，载入失败时建立索引并写入此文件
+		natLineIndex(natRefPointer<natFileStream> file, View const& newLine, nBool useMapping = true, nStrView sidecarFilename = {})
+			: m_File{ std::move(file) }, m_Data{}, m_FileSize{ m_File->GetSize() }, m_LastLineTerminated{}
+		{
+			detail_::NewLineCodePoints codePoints;
+			detail_::DecodeNewLine(newLine, codePoints);
+			Init(codePoints, useMapping, sidecarFilename);
+		}
+
+		///	@brief	以 TextReader 的换行符建立行索引
+		natLineIndex(natRefPointer<natFileStream> file, TextReader<encoding> const& reader, nBool useMapping = true, nStrView sidecarFilename = {})
+			: m_File{ std::move(file) }, m_Data{}, m_FileSize{ m_File->GetSize() }, m_LastLineTerminated{}
+		{
+			Init(reader.GetNewLine(), useMapping, sidecarFilename);
+		}
+
+		///	@brief	以当前环境的换行符建立行索引
+		explicit natLineIndex(natRefPointer<natFileStream> file, nBool useMapping = true, nStrView sidecarFilename = {})
+			: natLineIndex(std::move(file), String<encoding>{ Environment::GetNewLine() }.GetView(), useMapping, sidecarFilename)
+		{
+		}
+
+		~natLineIndex()
+		{
+		}
+
+		size_t GetLineCount() const noexcept
+		{
+			return m_LineStarts.size();
+		}
+
+		nBool IsMapped() const noexcept
+		{
+			return m_Data != nullptr;
+		}
+
+		natRefPointer<natFileStream> GetFile() const noexcept
+		{
+			return m_File;
+		}
+
+		///	@brief	获得行在文件中的字节范围，不包括换行符
+		std::pair<nLen, nLen> GetLineRange(size_t line) const
+		{
+			if (line >= m_LineStarts.size())
+			{
+				nat_Throw(natErrException, NatErr_OutOfRange, "line {0} is out of range."_nv, line);
+			}
+
+			const auto newLineBytes = m_NewLine.size() * sizeof(CharType);
+			const auto begin = m_LineStarts[line];
+			nLen end;
+			if (line + 1 < m_LineStarts.size())
+			{
+				end = m_LineStarts[line + 1] - newLineBytes;
+			}
+			else
+			{
+				end = GetContentSize() - (m_LastLineTerminated ? newLineBytes : 0);
+			}
+
+			return { begin, end };
+		}
+
+		///	@brief	获得指定行的视图
+		///	@note	仅在文件已映射时可用
+		View GetLineView(size_t line) const
+		{
+			if (!m_Data)
+			{
+				nat_Throw(natErrException, NatErr_IllegalState, "File is not mapped."_nv);
+			}
+
+			const auto range = GetLineRange(line);
+			return { m_Data + range.first / sizeof(CharType), static_cast<size_t>(range.second - range.first) / sizeof(CharType) };
+		}
+
+		///	@brief	获得指定行的内容
+		String<encoding> GetLine(size_t line) const
+		{
+			if (m_Data)
+			{
+				return GetLineView(line);
+			}
+
+			const auto range = GetLineRange(line);
+			String<encoding> result;
+			ReadRange(range.first, range.second, result.ResizeMore(static_cast<size_t>(range.second - range.first) / sizeof(CharType)));
+			return result;
+		}
+
+		///	@brief	按顺序处理所有行
+		///	@param[in]	callableObject	可被调用的对象，接受参数为行号及 StringView
+		template <typename CallableObject>
+		void ForEachLine(CallableObject callableObject) const
+		{
+			std::vector<CharType> buffer;
+			for (size_t first = 0; first < GetLineCount(); first += DefaultBatchSize)
+			{
+				const auto last = std::min(first + DefaultBatchSize, GetLineCount());
+				const auto batch = LoadBatch(first, last, buffer);
+				for (auto i = first; i < last; ++i)
+				{
+					callableObject(i, GetLineView(i, batch));
+				}
+			}
+		}
+
+		///	@brief	以线程池并行处理所有行
+		///	@param[in]	pool			线程池
+		///	@param[in]	callableObject	可被调用的对象，接受参数为行号及 StringView，将会在多个线程中同时被调用
+		///	@param[in]	batchSize		每个任务处理的行数
+		///	@note	返回时所有已提交的任务均已结束，首个抛出的异常（包括任务中抛出的异常）将会在此重新抛出，出现异常后不再提交新的任务
+		template <typename CallableObject>
+		void ParallelForEachLine(natThreadPool& pool, CallableObject const& callableObject, size_t batchSize = DefaultBatchSize) const
+		{
+			if (!batchSize)
+			{
+				nat_Throw(natErrException, NatErr_InvalidArg, "batchSize cannot be 0."_nv);
+			}
+
+			std::deque<std::future<natThreadPool::WorkToken>> pendingWorks;
+			std::exception_ptr firstException;
+			// 任务引用了 this 及 callableObject，因此即使出现异常也必须等待所有已提交的任务完成后才能返回
+			const auto waitOne = [&pendingWorks, &firstException]
+			{
+				auto work = std::move(pendingWorks.front());
+				pendingWorks.pop_front();
+				try
+				{
+					work.get().GetResult().get();
+				}
+				catch (...)
+				{
+					if (!firstException)
+					{
+						firstException = std::current_exception();
+					}
+				}
+			};
+
+			try
+			{
+				for (size_t first = 0; first < GetLineCount() && !firstException; first += batchSize)
+				{
+					const auto last = std::min(first + batchSize, GetLineCount());
+					// 未映射时由当前线程顺序读取每一批的内容，需限制同时持有的批次数
+					if (!m_Data && pendingWorks.size() >= MaxPendingBatches)
+					{
+						waitOne();
+					}
+
+					auto buffer = std::make_shared<std::vector<CharType>>();
+					const auto batch = LoadBatch(first, last, *buffer);
+					pendingWorks.emplace_back(pool.QueueWork([this, &callableObject, first, last, batch, buffer](void*) -> nuInt
+					{
+						for (auto i = first; i < last; ++i)
+						{
+							callableObject(i, GetLineView(i, batch));
+						}
+						return 0;
+					}));
+				}
+			}
+			catch (...)
+			{
+				firstException = std::current_exception();
+			}
+
+			while (!pendingWorks.empty())
+			{
+				waitOne();
+			}
+
+			if (firstException)
+			{
+				std::rethrow_exception(firstException);
+			}
+		}
+
+		///	@brief	将索引写入流
+		void Save(natRefPointer<natStream> stream) const
+		{
+			natBinaryWriter writer{ std::move(stream) };
+			writer.WritePod(SidecarMagic);
+			writer.WritePod(SidecarVersion);
+			writer.WritePod(static_cast<nuInt>(encoding));
+			writer.WritePod(static_cast<nuInt>(m_NewLine.size()));
+			for (auto&& unit : m_NewLine)
+			{
+				writer.WritePod(unit);
+			}
+			writer.WritePod(m_FileSize);
+			writer.WritePod(static_cast<nByte>(m_LastLineTerminated));
+			writer.WritePod(static_cast<nuLong>(m_LineStarts.size()));
+			writer.GetUnderlyingStream()->WriteBytes(reinterpret_cast<ncData>(m_LineStarts.data()), m_LineStarts.size() * sizeof(nLen));
+		}
+
+		///	@brief	从流中载入索引
+		///	@return	若索引有效且与当前文件及换行符相符则载入并返回 true，否则不做任何修改并返回 false
+		nBool Load(natRefPointer<natStream> stream)
+		{
+			try
+			{
+				natBinaryReader reader{ std::move(stream) };
+				if (reader.ReadPod<nuInt>() != SidecarMagic || reader.ReadPod<nuInt>() != SidecarVersion || reader.ReadPod<nuInt>() != static_cast<nuInt>(encoding))
+				{
+					return false;
+				}
+
+				const auto newLineSize = reader.ReadPod<nuInt>();
+				if (newLineSize != m_NewLine.size())
+				{
+					return false;
+				}
+				for (auto&& unit : m_NewLine)
+				{
+					if (reader.ReadPod<CharType>() != unit)
+					{
+						return false;
+					}
+				}
+
+				if (reader.ReadPod<nLen>() != m_FileSize)
+				{
+					return false;
+				}
+
+				const auto lastLineTerminated = reader.ReadPod<nByte>() != 0;
+				const auto lineCount = static_cast<size_t>(reader.ReadPod<nuLong>());
+				if (lineCount > m_FileSize / (sizeof(CharType) * std::max<size_t>(m_NewLine.size(), 1)) + 1)
+				{
+					return false;
+				}
+
+				std::vector<nLen> lineStarts(lineCount);
+				const auto bytes = lineCount * sizeof(nLen);
+				if (reader.GetUnderlyingStream()->ReadBytes(reinterpret_cast<nData>(lineStarts.data()), bytes) != bytes)
+				{
+					return false;
+				}
+
+				if (!ValidateLineStarts(lineStarts, lastLineTerminated))
+				{
+					return false;
+				}
+
+				m_LineStarts = std::move(lineStarts);
+				m_LastLineTerminated = lastLineTerminated;
+				return true;
+			}
+			catch (natException&)
+			{
+				return false;
+			}
+		}
+
+	private:
+		static constexpr nuInt SidecarMagic = 0x58494C4E;	// "NLIX"
+		static constexpr nuInt SidecarVersion = 1;
+
+		natRefPointer<natFileStream> m_File;
+		natRefPointer<natExternMemoryStream> m_MappedFile;
+		const CharType* m_Data;
+		const nLen m_FileSize;
+		String<encoding> m_NewLine;
+		std::vector<nLen> m_LineStarts;
+		nBool m_LastLineTerminated;
+		mutable std::mutex m_FileMutex;
+
+		void Init(detail_::NewLineCodePoints const& newLine, nBool useMapping, nStrView sidecarFilename)
+		{
+			m_NewLine = detail_::EncodeNewLine<encoding>(newLine);
+			if (m_NewLine.empty())
+			{
+				nat_Throw(natErrException, NatErr_InvalidArg, "newLine cannot be empty."_nv);
+			}
+
+			if (useMapping && GetContentSize())
+			{
+				m_MappedFile = m_File->MapToMemoryStream();
+				m_Data = reinterpret_cast<const CharType*>(m_MappedFile->GetExternData());
+			}
+
+			if (!sidecarFilename.empty())
+			{
+				nBool loaded;
+				try
+				{
+					loaded = Load(make_ref<natFileStream>(sidecarFilename, true, false));
+				}
+				catch (natException&)
+				{
+					loaded = false;
+				}
+
+				if (loaded)
+				{
+					return;
+				}
+			}
+
+			Build();
+
+			if (!sidecarFilename.empty())
+			{
+				Save(make_ref<natFileStream>(sidecarFilename, false, true, true));
+			}
+		}
+
+		// 文件大小不是编码单元的整数倍时忽略末尾不完整的编码单元
+		nLen GetContentSize() const noexcept
+		{
+			return m_FileSize / sizeof(CharType) * sizeof(CharType);
+		}
+
+		///	@brief	检查载入的行起始位置是否可以安全使用
+		///	@note	要求首行从 0 开始，各行起始位置按编码单元对齐且相邻两行至少相隔一个换行符，末行不超出文件内容
+		nBool ValidateLineStarts(std::vector<nLen> const& lineStarts, nBool lastLineTerminated) const noexcept
+		{
+			const auto contentSize = GetContentSize();
+			if (lineStarts.empty())
+			{
+				return !contentSize && !lastLineTerminated;
+			}
+
+			const auto newLineBytes = static_cast<nLen>(m_NewLine.size() * sizeof(CharType));
+			if (lineStarts.front() != 0)
+			{
+				return false;
+			}
+
+			for (size_t i = 1; i < lineStarts.size(); ++i)
+			{
+				if (lineStarts[i] % sizeof(CharType) || lineStarts[i] > contentSize || lineStarts[i] < lineStarts[i - 1] + newLineBytes)
+				{
+					return false;
+				}
+			}
+
+			// 末行的结束位置为文件内容末尾（若末行以换行符结束则不包括该换行符）
+			if (lastLineTerminated)
+			{
+				return lineStarts.back() + newLineBytes <= contentSize;
+			}
+
+			return lineStarts.back() < contentSize;
+		}
+
+		void Build()
+		{
+			m_LineStarts.clear();
+			m_LastLineTerminated = false;
+
+			const auto totalUnits = static_cast<size_t>(GetContentSize() / sizeof(CharType));
+			if (!totalUnits)
+			{
+				return;
+			}
+
+			m_LineStarts.push_back(0);
+			if (m_Data)
+			{
+				Scan(m_Data, totalUnits, 0);
+			}
+			else
+			{
+				// 保留上一块末尾未能确定是否为换行符的部分以匹配跨越两块的换行符
+				std::vector<CharType> buffer(ScanBlockSize / sizeof(CharType) + m_NewLine.size() - 1);
+				size_t base{}, buffered{};
+
+				std::lock_guard<std::mutex> lock{ m_FileMutex };
+				m_File->SetPositionFromBegin(0);
+				while (base + buffered < totalUnits)
+				{
+					const auto toRead = std::min(buffer.size() - buffered, totalUnits - base - buffered);
+					const auto readBytes = m_File->ReadBytes(reinterpret_cast<nData>(buffer.data() + buffered), toRead * sizeof(CharType));
+					if (readBytes != toRead * sizeof(CharType))
+					{
+						nat_Throw(natErrException, NatErr_InternalErr, "Cannot read file."_nv);
+					}
+					buffered += toRead;
+
+					const auto nextScan = Scan(buffer.data(), buffered, base);
+					std::copy(buffer.begin() + static_cast<std::ptrdiff_t>(nextScan - base), buffer.begin() + static_cast<std::ptrdiff_t>(buffered), buffer.begin());
+					buffered -= nextScan - base;
+					base = nextScan;
+				}
+			}
+
+			if (m_LineStarts.back() == GetContentSize())
+			{
+				m_LineStarts.pop_back();
+				m_LastLineTerminated = true;
+			}
+		}
+
+		///	@brief	在 data 中查找换行符并记录行的起始位置
+		///	@param[in]	data	要查找的内容
+		///	@param[in]	length	内容的长度
+		///	@param[in]	base	data 在文件中的位置（以编码单元计）
+		///	@return	下一次查找应开始的位置（以编码单元计，相对于文件），此位置之后的内容不足以判断是否为换行符
+		size_t Scan(const CharType* data, size_t length, size_t base)
+		{
+			const auto newLineFirst = m_NewLine[0];
+			const auto newLineLength = m_NewLine.size();
+			size_t pos{};
+			while (true)
+			{
+				const auto found = pos + detail_::FindCodeUnit(data + pos, length - pos, newLineFirst);
+				if (found + newLineLength > length)
+				{
+					return base + std::max(pos, std::min(found, length + 1 - newLineLength));
+				}
+
+				if (std::equal(m_NewLine.cbegin(), m_NewLine.cend(), data + found))
+				{
+					pos = found + newLineLength;
+					m_LineStarts.push_back(static_cast<nLen>(base + pos) * sizeof(CharType));
+				}
+				else
+				{
+					pos = found + 1;
+				}
+			}
+		}
+
+		void ReadRange(nLen begin, nLen end, CharType* output) const
+		{
+			std::lock_guard<std::mutex> lock{ m_FileMutex };
+			m_File->SetPositionFromBegin(begin);
+			const auto size = end - begin;
+			if (m_File->ReadBytes(reinterpret_cast<nData>(output), size) != size)
+			{
+				nat_Throw(natErrException, NatErr_InternalErr, "Cannot read file."_nv);
+			}
+		}
+
+		// 批次的内容及其首个编码单元在文件中的位置
+		typedef std::pair<const CharType*, size_t> Batch;
+
+		///	@brief	准备 [first, last) 行的内容
+		///	@note	映射时直接引用映射的内存，否则读入 buffer
+		Batch LoadBatch(size_t first, size_t last, std::vector<CharType>& buffer) const
+		{
+			if (m_Data)
+			{
+				return { m_Data, 0 };
+			}
+
+			const auto begin = GetLineRange(first).first;
+			const auto end = GetLineRange(last - 1).second;
+			buffer.resize(static_cast<size_t>(end - begin) / sizeof(CharType));
+			if (!buffer.empty())
+			{
+				ReadRange(begin, end, buffer.data());
+			}
+
+			return { buffer.data(), static_cast<size_t>(begin / sizeof(CharType)) };
+		}
+
+		View GetLineView(size_t line, Batch const& batch) const
+		{
+			const auto range = GetLineRange(line);
+			return { batch.first + (static_cast<size_t>(range.first / sizeof(CharType)) - batch.second), static_cast<size_t>(range.second - range.first) / sizeof(CharType) };
+		}
+	};
+}
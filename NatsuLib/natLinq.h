@@ -5,11 +5,16 @@
 #pragma once
 #include "natMisc.h"
 #include "natException.h"
+#include "natFlatHash.h"
+#include <algorithm>
+#include <deque>
+#include <list>
 #include <memory>
 #include <utility>
 #include <vector>
 #include <set>
 #include <map>
+#include <mutex>
 #include <optional>
 
 #ifdef _MSC_VER
@@ -243,6 +248,42 @@ namespace NatsuLib
 			}
 		};
 
+		template <typename Container_t>
+		class StorageIterator;
+
+		// 可以分块预读的迭代器：解引用没有副作用，元素的地址在迭代器前进后仍然有效，并且至少是双向迭代器
+		// 其他迭代器（例如 memoize 或从流中拉取元素的迭代器）的引用可能在前进后失效，预读也会破坏惰性求值，因此只能逐个读取
+		template <typename Iter_t, typename Value_t>
+		struct IsChunkableIteratorImpl
+			: std::bool_constant<std::is_pointer_v<Iter_t> ||
+				std::is_same_v<Iter_t, typename std::vector<Value_t>::iterator> || std::is_same_v<Iter_t, typename std::vector<Value_t>::const_iterator> ||
+				std::is_same_v<Iter_t, typename std::deque<Value_t>::iterator> || std::is_same_v<Iter_t, typename std::deque<Value_t>::const_iterator> ||
+				std::is_same_v<Iter_t, typename std::list<Value_t>::iterator> || std::is_same_v<Iter_t, typename std::list<Value_t>::const_iterator>>
+		{
+		};
+
+		template <typename Iter_t, typename = void>
+		struct IsChunkableIterator
+			: std::false_type
+		{
+		};
+
+		template <typename Iter_t>
+		struct IsChunkableIterator<Iter_t, std::enable_if_t<std::is_object_v<typename std::iterator_traits<Iter_t>::value_type>>>
+			: IsChunkableIteratorImpl<Iter_t, std::remove_cv_t<typename std::iterator_traits<Iter_t>::value_type>>
+		{
+		};
+
+		template <typename Container_t, typename Value_t>
+		struct IsChunkableIteratorImpl<StorageIterator<Container_t>, Value_t>
+			: IsChunkableIterator<decltype(std::begin(std::declval<Container_t>()))>
+		{
+		};
+
+		// 类型擦除的迭代器，迭代器对象较小时直接存储于内部的缓冲区中而不分配内存
+		// 同时给出结尾时（由 Linq 构造）会成为有界迭代器，有界迭代器与结尾哨兵比较时只需判断是否已到达结尾
+		// 若原迭代器满足 IsChunkableIterator，有界迭代器会以块为单位预读元素，每块只需一次虚函数调用，其他迭代器逐个读取
+		// 迭代器之间按逻辑位置比较，预读的元素不影响比较的结果
 		template <typename T, typename Category = std::input_iterator_tag>
 		class CommonIterator final
 		{
@@ -253,31 +294,99 @@ namespace NatsuLib
 			typedef std::conditional_t<IsValued<T>::value, value_type, std::add_lvalue_reference_t<value_type>> reference;
 			typedef std::add_pointer_t<value_type> pointer;
 
+			enum : size_t
+			{
+				InlineSize = 64,	///< @brief	内部缓冲区的大小，不超过此大小的迭代器不会分配内存
+				ChunkSize = 16,		///< @brief	有界迭代器每次预读的元素数
+			};
+
 		private:
+			// 返回值的迭代器需要保存值，只有平凡且较小的值会被预读，否则只保存元素的地址
+			static constexpr nBool CanBufferChunk = !IsValued<T>::value || (std::is_trivial_v<value_type> && sizeof(value_type) <= sizeof(void*) * 2);
+			typedef std::conditional_t<IsValued<T>::value && CanBufferChunk, value_type, pointer> Slot_t;
+
 			// TODO: 针对可能的不同 Category 提供不同的接口
 			struct IteratorInterface
 			{
+				// 用于判断两个迭代器是否包装同一种类型，以避免 dynamic_cast
+				const void* const TypeTag;
+
+				explicit IteratorInterface(const void* typeTag) noexcept
+					: TypeTag{ typeTag }
+				{
+				}
+
 				virtual ~IteratorInterface() = default;
 
-				virtual std::unique_ptr<IteratorInterface> Clone() const = 0;
+				virtual IteratorInterface* CloneTo(void* storage) const = 0;
+				virtual IteratorInterface* MoveTo(void* storage) noexcept = 0;
 				virtual void MoveNext() = 0;
 				virtual reference Deref() const = 0;
-				virtual nBool Equals(IteratorInterface const& other) const = 0;
+				// ahead 为已预读但尚未读取的元素数，比较的是回退后的逻辑位置
+				virtual nBool Equals(IteratorInterface const& other, difference_type selfAhead, difference_type otherAhead) const = 0;
+				virtual nBool IsEnd() const = 0;
+				virtual size_t NextChunk(Slot_t* chunk) = 0;
 			};
 
+			template <typename Impl_t>
+			static constexpr nBool IsInlineStorable = sizeof(Impl_t) <= InlineSize && alignof(Impl_t) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<Impl_t>;
+
 			template <typename Iter_t>
 			class IteratorImpl final : public IteratorInterface
 			{
+				static constexpr char Tag{};
+
 				Iter_t m_Iterator;
+				std::optional<Iter_t> m_End;
+
 			public:
-				explicit IteratorImpl(Iter_t iterator)
-					: m_Iterator(std::move(iterator))
+				static constexpr nBool IsChunkable = IsChunkableIterator<Iter_t>::value && CanBufferChunk;
+
+				static constexpr const void* GetTypeTag() noexcept
+				{
+					return &Tag;
+				}
+
+				explicit IteratorImpl(Iter_t iterator, std::optional<Iter_t> end = {})
+					: IteratorInterface{ GetTypeTag() }, m_Iterator(std::move(iterator)), m_End(std::move(end))
 				{
 				}
 
-				std::unique_ptr<IteratorInterface> Clone() const override
+				IteratorImpl(IteratorImpl const& other)
+					: IteratorInterface{ GetTypeTag() }, m_Iterator(other.m_Iterator), m_End(other.m_End)
 				{
-					return std::make_unique<IteratorImpl>(m_Iterator);
+				}
+
+				IteratorImpl(IteratorImpl&& other) noexcept(std::is_nothrow_move_constructible_v<Iter_t>)
+					: IteratorInterface{ GetTypeTag() }, m_Iterator(std::move(other.m_Iterator)), m_End(std::move(other.m_End))
+				{
+				}
+
+				IteratorInterface* CloneTo(void* storage) const override
+				{
+					if constexpr (IsInlineStorable<IteratorImpl>)
+					{
+						return new(storage) IteratorImpl(*this);
+					}
+					else
+					{
+						static_cast<void>(storage);
+						return new IteratorImpl(*this);
+					}
+				}
+
+				IteratorInterface* MoveTo(void* storage) noexcept override
+				{
+					if constexpr (IsInlineStorable<IteratorImpl>)
+					{
+						return new(storage) IteratorImpl(std::move(*this));
+					}
+					else
+					{
+						// 不会被调用，分配于堆上的迭代器直接转移所有权
+						static_cast<void>(storage);
+						std::terminate();
+					}
 				}
 
 				void MoveNext() override
@@ -290,83 +399,305 @@ namespace NatsuLib
 					return *m_Iterator;
 				}
 
-				nBool Equals(IteratorInterface const& other) const override
+				nBool Equals(IteratorInterface const& other, difference_type selfAhead, difference_type otherAhead) const override
 				{
-					if (const auto realOther = dynamic_cast<IteratorImpl const*>(std::addressof(other)))
+					if (other.TypeTag != GetTypeTag())
 					{
-						return m_Iterator == realOther->m_Iterator;
+						return false;
 					}
 
-					return false;
+					return GetIterator(selfAhead) == static_cast<IteratorImpl const&>(other).GetIterator(otherAhead);
+				}
+
+				nBool IsEnd() const override
+				{
+					return m_End && m_Iterator == *m_End;
+				}
+
+				size_t NextChunk(Slot_t* chunk) override
+				{
+					if constexpr (IsChunkable)
+					{
+						auto&& end = m_End.value();
+						size_t count = 0;
+						for (; count < ChunkSize && m_Iterator != end; ++count, ++m_Iterator)
+						{
+							if constexpr (IsValued<T>::value)
+							{
+								chunk[count] = *m_Iterator;
+							}
+							else
+							{
+								chunk[count] = std::addressof(*m_Iterator);
+							}
+						}
+						return count;
+					}
+					else
+					{
+						// 不会被调用，不可分块的迭代器总是逐个读取
+						static_cast<void>(chunk);
+						std::terminate();
+					}
 				}
 
-				Iter_t GetIterator() const noexcept
+				Iter_t GetIterator(difference_type ahead = 0) const
 				{
+					if constexpr (IsChunkable)
+					{
+						if (ahead)
+						{
+							return std::prev(m_Iterator, ahead);
+						}
+					}
+					else
+					{
+						assert(!ahead);
+					}
+
 					return m_Iterator;
 				}
 			};
 
 			typedef CommonIterator Self_t;
 
-			std::unique_ptr<IteratorInterface> m_Iterator;
+			enum class Mode : nByte
+			{
+				Unbounded,
+				Bounded,
+				Chunked,
+				EndSentinel,
+			};
+
+			alignas(std::max_align_t) unsigned char m_Storage[InlineSize];
+			IteratorInterface* m_Iterator;
+			nBool m_IsInline;
+			Mode m_Mode;
+			// 仅用于 Chunked 模式，[m_ChunkPos, m_ChunkCount) 为已预读但尚未读取的元素，为空时表示已到达结尾
+			nByte m_ChunkPos;
+			nByte m_ChunkCount;
+			Slot_t m_Chunk[ChunkSize];
+
+			template <typename Iter_t, typename... Args>
+			void Emplace(Args&&... args)
+			{
+				typedef IteratorImpl<Iter_t> Impl_t;
+				if constexpr (IsInlineStorable<Impl_t>)
+				{
+					m_Iterator = new(m_Storage) Impl_t(std::forward<Args>(args)...);
+					m_IsInline = true;
+				}
+				else
+				{
+					m_Iterator = new Impl_t(std::forward<Args>(args)...);
+					m_IsInline = false;
+				}
+			}
+
+			void CopyChunkFrom(Self_t const& other) noexcept
+			{
+				std::copy(other.m_Chunk + other.m_ChunkPos, other.m_Chunk + other.m_ChunkCount, m_Chunk);
+				m_ChunkPos = 0;
+				m_ChunkCount = static_cast<nByte>(other.m_ChunkCount - other.m_ChunkPos);
+			}
+
+			void CopyFrom(Self_t const& other)
+			{
+				m_Iterator = other.m_Iterator ? other.m_Iterator->CloneTo(m_Storage) : nullptr;
+				m_IsInline = other.m_IsInline;
+				m_Mode = other.m_Mode;
+				CopyChunkFrom(other);
+			}
+
+			void MoveFrom(Self_t& other) noexcept
+			{
+				if (other.m_IsInline && other.m_Iterator)
+				{
+					m_Iterator = other.m_Iterator->MoveTo(m_Storage);
+					other.Reset();
+				}
+				else
+				{
+					m_Iterator = std::exchange(other.m_Iterator, nullptr);
+				}
+				m_IsInline = other.m_IsInline;
+				m_Mode = other.m_Mode;
+				CopyChunkFrom(other);
+				other.m_ChunkPos = other.m_ChunkCount = 0;
+			}
+
+			void Reset() noexcept
+			{
+				if (!m_Iterator)
+				{
+					return;
+				}
+
+				if (m_IsInline)
+				{
+					m_Iterator->~IteratorInterface();
+				}
+				else
+				{
+					delete m_Iterator;
+				}
+				m_Iterator = nullptr;
+			}
+
+			// 当前块已读完时立即读取下一块，因此块为空当且仅当已到达结尾
+			void NextChunk()
+			{
+				m_ChunkPos = 0;
+				m_ChunkCount = static_cast<nByte>(m_Iterator->NextChunk(m_Chunk));
+			}
+
+			difference_type Ahead() const noexcept
+			{
+				return static_cast<difference_type>(m_ChunkCount - m_ChunkPos);
+			}
+
+			nBool IsBounded() const noexcept
+			{
+				return m_Mode == Mode::Bounded || m_Mode == Mode::Chunked;
+			}
+
+			nBool IsAtEnd() const
+			{
+				return m_Mode == Mode::Chunked ? m_ChunkPos == m_ChunkCount : m_Iterator->IsEnd();
+			}
 
 		public:
 			// 要包装的迭代器的 difference_type 不能比 std::ptrdiff_t 还大，否则可能出现问题
 			template <typename Iter_t, std::enable_if_t<sizeof(typename std::iterator_traits<Iter_t>::difference_type) <= sizeof(difference_type), int> = 0>
 			CommonIterator(Iter_t iterator)
-				: m_Iterator(std::make_unique<IteratorImpl<Iter_t>>(std::move(iterator)))
+				: m_Mode{ Mode::Unbounded }, m_ChunkPos{}, m_ChunkCount{}
+			{
+				Emplace<Iter_t>(std::move(iterator));
+			}
+
+			///	@brief	构造有界迭代器
+			template <typename Iter_t, std::enable_if_t<sizeof(typename std::iterator_traits<Iter_t>::difference_type) <= sizeof(difference_type), int> = 0>
+			CommonIterator(Iter_t iterator, Iter_t end)
+				: m_Mode{ IteratorImpl<Iter_t>::IsChunkable ? Mode::Chunked : Mode::Bounded }, m_ChunkPos{}, m_ChunkCount{}
+			{
+				Emplace<Iter_t>(std::move(iterator), std::optional<Iter_t>{ std::move(end) });
+				if (m_Mode == Mode::Chunked)
+				{
+					try
+					{
+						NextChunk();
+					}
+					catch (...)
+					{
+						Reset();
+						throw;
+					}
+				}
+			}
+
+			///	@brief	构造结尾哨兵
+			template <typename Iter_t, std::enable_if_t<sizeof(typename std::iterator_traits<Iter_t>::difference_type) <= sizeof(difference_type), int> = 0>
+			CommonIterator(Iter_t end, EndIteratorTagType)
+				: m_Mode{ Mode::EndSentinel }, m_ChunkPos{}, m_ChunkCount{}
 			{
+				Emplace<Iter_t>(std::move(end));
 			}
 
 			CommonIterator(Self_t const& other)
-				: m_Iterator(other.m_Iterator->Clone())
 			{
+				CopyFrom(other);
 			}
 
 			CommonIterator(Self_t&& other) noexcept
-				: m_Iterator(std::move(other.m_Iterator))
 			{
+				MoveFrom(other);
+			}
+
+			~CommonIterator()
+			{
+				Reset();
 			}
 
 			Self_t& operator=(Self_t const& other)
 			{
-				m_Iterator = other.m_Iterator->Clone();
+				if (this != &other)
+				{
+					Reset();
+					CopyFrom(other);
+				}
 				return *this;
 			}
 
 			Self_t& operator=(Self_t&& other) noexcept
 			{
-				m_Iterator = std::move(other.m_Iterator);
+				if (this != &other)
+				{
+					Reset();
+					MoveFrom(other);
+				}
 				return *this;
 			}
 
 			template <typename Iter_t>
 			Iter_t GetOriginalIterator() const
 			{
-				auto iter = dynamic_cast<IteratorImpl<Iter_t>*>(m_Iterator.get());
-				if (iter)
+				if (m_Iterator && m_Iterator->TypeTag == IteratorImpl<Iter_t>::GetTypeTag())
 				{
-					return iter->GetIterator();
+					return static_cast<IteratorImpl<Iter_t> const*>(m_Iterator)->GetIterator(Ahead());
 				}
 
-				nat_Throw(natErrException, NatErr_InvalidArg, "Original iterator is not a Iter_t.");
+				nat_Throw(natErrException, NatErr_InvalidArg, "Original iterator is not a Iter_t."_nv);
 			}
 
 			Self_t& operator++()
 			{
-				m_Iterator->MoveNext();
+				if (m_Mode == Mode::Chunked)
+				{
+					assert(m_ChunkPos != m_ChunkCount && "Iterator is at end.");
+					if (++m_ChunkPos == m_ChunkCount)
+					{
+						NextChunk();
+					}
+				}
+				else
+				{
+					m_Iterator->MoveNext();
+				}
 
 				return *this;
 			}
 
-			decltype(auto) operator*() const
+			reference operator*() const
 			{
+				if (m_Mode == Mode::Chunked)
+				{
+					assert(m_ChunkPos != m_ChunkCount && "Iterator is at end.");
+					if constexpr (IsValued<T>::value && CanBufferChunk)
+					{
+						return m_Chunk[m_ChunkPos];
+					}
+					else
+					{
+						return *m_Chunk[m_ChunkPos];
+					}
+				}
+
 				return m_Iterator->Deref();
 			}
 
 			nBool operator==(CommonIterator const& other) const
 			{
-				return m_Iterator->Equals(*other.m_Iterator);
+				if (IsBounded() && other.m_Mode == Mode::EndSentinel)
+				{
+					return IsAtEnd();
+				}
+
+				if (m_Mode == Mode::EndSentinel && other.IsBounded())
+				{
+					return other.IsAtEnd();
+				}
+
+				return m_Iterator->Equals(*other.m_Iterator, Ahead(), other.Ahead());
 			}
 
 			nBool operator!=(CommonIterator const& other) const
@@ -375,14 +706,26 @@ namespace NatsuLib
 			}
 		};
 
+		// 容器的所有权由 LinqEnumerable 持有，迭代器只保存容器的地址，因此复制迭代器不需要修改引用计数
+		// 迭代器（包括由其构造的 Linq 中的迭代器）不能比持有容器的 LinqEnumerable 及其副本存活得更久，调试版本中会检查这一点
 		template <typename Container_t>
 		class StorageIterator final
 		{
 			typedef StorageIterator<Container_t> Self_t;
 			typedef decltype(std::begin(std::declval<Container_t>())) IteratorType;
 
-			std::shared_ptr<Container_t> m_pContainer;
+			const Container_t* m_pContainer;
 			IteratorType m_Iterator;
+#ifndef NDEBUG
+			std::weak_ptr<const Container_t> m_pOwnerCheck;
+#endif
+
+			void CheckOwner() const noexcept
+			{
+#ifndef NDEBUG
+				assert(!m_pOwnerCheck.expired() && "Container has been released, iterator outlived its LinqEnumerable.");
+#endif
+			}
 
 		public:
 			typedef typename std::iterator_traits<IteratorType>::iterator_category iterator_category;
@@ -391,26 +734,43 @@ namespace NatsuLib
 			typedef typename std::iterator_traits<IteratorType>::reference reference;
 			typedef typename std::iterator_traits<IteratorType>::pointer pointer;
 
+			///	@brief	构造迭代器
+			///	@param	pContainer	持有容器的指针，调用者需保证其所有权由产生的 LinqEnumerable 持有
+			///	@param	iterator	容器中的位置
 			StorageIterator(std::shared_ptr<Container_t> const& pContainer, IteratorType const& iterator)
-				: m_pContainer(pContainer), m_Iterator(iterator)
+				: m_pContainer(pContainer.get()), m_Iterator(iterator)
+#ifndef NDEBUG
+				, m_pOwnerCheck(pContainer)
+#endif
 			{
 			}
 
 			Self_t& operator++() &
 			{
+				CheckOwner();
 				++m_Iterator;
 				return *this;
 			}
 
+			template <typename IterCate = iterator_category, std::enable_if_t<std::is_base_of_v<std::bidirectional_iterator_tag, IterCate>, int> = 0>
+			Self_t& operator--() &
+			{
+				CheckOwner();
+				--m_Iterator;
+				return *this;
+			}
+
 			template <typename IterCate = iterator_category, std::enable_if_t<std::is_base_of_v<std::random_access_iterator_tag, IterCate>, int> = 0>
 			Self_t& operator+=(difference_type diff) & noexcept(noexcept(m_Iterator += diff))
 			{
+				CheckOwner();
 				m_Iterator += diff;
 				return *this;
 			}
 
 			decltype(auto) operator*() const
 			{
+				CheckOwner();
 				return *m_Iterator;
 			}
 
@@ -463,6 +823,44 @@ namespace NatsuLib
 			}
 		};
 
+		// lambda 不可赋值，迭代器被赋值时需要重新构造其持有的可调用对象
+		template <typename CallableObj_t>
+		class CallableStorage
+			: public std::optional<CallableObj_t>
+		{
+		public:
+			using std::optional<CallableObj_t>::optional;
+
+			CallableStorage(CallableStorage const&) = default;
+			CallableStorage(CallableStorage&&) = default;
+
+			CallableStorage& operator=(CallableStorage const& other)
+			{
+				if (this != &other)
+				{
+					this->reset();
+					if (other)
+					{
+						this->emplace(*other);
+					}
+				}
+				return *this;
+			}
+
+			CallableStorage& operator=(CallableStorage&& other) noexcept(std::is_nothrow_move_constructible_v<CallableObj_t>)
+			{
+				if (this != &other)
+				{
+					this->reset();
+					if (other)
+					{
+						this->emplace(std::move(*other));
+					}
+				}
+				return *this;
+			}
+		};
+
 		// TODO: 尝试从 CallableObj_t 的类型入手使 end 迭代器不需要拥有 callableObj，需要将 LinqEnumerable 改造成 begin end 迭代器可以是不同类型的
 		template <typename Iter_t, typename CallableObj_t>
 		class SelectIterator final
@@ -470,7 +868,7 @@ namespace NatsuLib
 			typedef SelectIterator<Iter_t, CallableObj_t> Self_t;
 
 			Iter_t m_Iterator;
-			std::optional<CallableObj_t> m_CallableObj;
+			CallableStorage<CallableObj_t> m_CallableObj;
 
 		public:
 			typedef typename std::iterator_traits<Iter_t>::iterator_category iterator_category;
@@ -531,7 +929,7 @@ namespace NatsuLib
 			typedef WhereIterator<Iter_t, CallableObj_t> Self_t;
 
 			Iter_t m_Iterator, m_End;
-			std::optional<CallableObj_t> m_CallableObj;
+			CallableStorage<CallableObj_t> m_CallableObj;
 		public:
 			typedef Min<std::forward_iterator_tag, typename std::iterator_traits<Iter_t>::iterator_category> iterator_category;
 			typedef typename std::iterator_traits<Iter_t>::value_type value_type;
@@ -739,7 +1137,7 @@ namespace NatsuLib
 			typedef TakeWhileIterator<Iter_t, CallableObj_t> Self_t;
 
 			Iter_t m_Iterator, m_End;
-			std::optional<CallableObj_t> m_CallableObj;
+			CallableStorage<CallableObj_t> m_CallableObj;
 		public:
 			typedef Min<std::forward_iterator_tag, typename std::iterator_traits<Iter_t>::iterator_category> iterator_category;
 			typedef typename std::iterator_traits<Iter_t>::value_type value_type;
@@ -951,9 +1349,9 @@ namespace NatsuLib
 			typedef typename std::iterator_traits<RealIter>::reference reference;
 			typedef typename std::iterator_traits<RealIter>::pointer pointer;
 
-			// 与另一形式保持一致，但不使用第二个参数
-			ReverseIterator(Iter_t const& cur, Iter_t const&) noexcept(std::is_nothrow_constructible_v<RealIter, Iter_t const&>)
-				: m_Current{ cur }
+			// 与另一形式保持一致，但不使用第一个参数，std::reverse_iterator 以 end 构造时指向最后一个元素
+			ReverseIterator(Iter_t const&, Iter_t const& end) noexcept(std::is_nothrow_constructible_v<RealIter, Iter_t const&>)
+				: m_Current{ end }
 			{
 			}
 
@@ -1074,72 +1472,784 @@ namespace NatsuLib
 					static_cast<difference_type>(m_Current2 - other.m_Current2));
 			}
 		};
-	}
-
-	template <typename Iter_t>
-	class LinqEnumerable;
-
-	template <typename T>
-	class Linq;
-
-	template <typename Container>
-	LinqEnumerable<detail_::StorageIterator<Container>> from_container(Container container);
-
-	template <typename T>
-	LinqEnumerable<detail_::EmptyIterator<T>> from_empty();
-
-	template <typename Iter_t>
-	class LinqEnumerable
-	{
-		typedef std::decay_t<decltype(*std::declval<Iter_t>())> Element_t;
-
-	public:
-		typedef Iter_t iterator;
-		typedef typename std::iterator_traits<Iter_t>::value_type value_type;
-		typedef typename std::iterator_traits<Iter_t>::difference_type difference_type;
-		typedef typename std::iterator_traits<Iter_t>::reference reference;
-		typedef std::make_unsigned_t<difference_type> size_type;
 
-		typedef LinqEnumerable<Iter_t> Self_t;
+		template <typename T, typename = void>
+		struct IsHashable
+			: std::false_type
+		{
+		};
 
-	private:
-		Range<Iter_t> m_Range;
-		mutable Optional<size_t> m_Size;
+		template <typename T>
+		struct IsHashable<T, std::void_t<decltype(std::declval<std::hash<T> const&>()(std::declval<T const&>()))>>
+			: std::conjunction<std::is_default_constructible<std::hash<T>>, CanEqual<T const&>>
+		{
+		};
 
-	public:
-		constexpr LinqEnumerable(Iter_t begin, Iter_t end)
-			: m_Range(std::move(begin), std::move(end))
+		// 将键映射到按首次出现的顺序编号的组
+		// 键按编号顺序存放于 m_Keys 中，FlatHashSet 中只保存编号，哈希及比较时通过编号访问键及预先计算的哈希值
+		// 哈希函数及相等比较持有指向自身的指针，因此不可移动
+		template <typename Key_t>
+		class FlatHashIndex final
+			: public nonmovable
 		{
-		}
+		public:
+			static constexpr nBool Ordered = false;
+			static constexpr size_t npos = size_t(-1);
 
-		constexpr LinqEnumerable(LinqEnumerable const& other) = default;
-		constexpr LinqEnumerable(LinqEnumerable&& other) = default;
+			FlatHashIndex()
+				: m_Ids{ 0, IdHash{ this }, IdEqual{ this } }
+			{
+			}
 
-		LinqEnumerable& operator=(LinqEnumerable const& other) = default;
-		LinqEnumerable& operator=(LinqEnumerable && other) = default;
+			void Reserve(size_t count)
+			{
+				m_Keys.reserve(count);
+				m_Hashes.reserve(count);
+				m_Ids.reserve(count);
+			}
 
-		constexpr Iter_t begin() const
-		{
-			return m_Range.begin();
-		}
+			///	@brief	插入键
+			///	@return	键所在组的编号及是否为新插入的键
+			template <typename K>
+			std::pair<size_t, nBool> Insert(K&& key)
+			{
+				const auto hash = std::hash<Key_t>{}(key);
+				const auto iter = m_Ids.template find<KeyRef>(KeyRef{ key, hash });
+				if (iter != m_Ids.end())
+				{
+					return { *iter, false };
+				}
 
-		constexpr Iter_t end() const
-		{
-			return m_Range.end();
-		}
+				m_Keys.emplace_back(std::forward<K>(key));
+				m_Hashes.emplace_back(hash);
+				m_Ids.insert(m_Keys.size() - 1);
+				return { m_Keys.size() - 1, true };
+			}
 
-		size_type size() const
-		{
-			if (!m_Size)
+			///	@return	键所在组的编号，不存在时返回 npos
+			size_t Find(Key_t const& key) const
 			{
-				m_Size.emplace(static_cast<size_t>(std::distance(m_Range.begin(), m_Range.end())));
+				const auto iter = m_Ids.template find<KeyRef>(KeyRef{ key, std::hash<Key_t>{}(key) });
+				return iter == m_Ids.end() ? npos : *iter;
 			}
 
-			return m_Size.value();
-		}
+			size_t size() const noexcept
+			{
+				return m_Keys.size();
+			}
 
-		size_type count() const
-		{
+			Key_t const& GetKey(size_t id) const
+			{
+				return m_Keys[id];
+			}
+
+			///	@brief	按输出顺序返回各组的编号
+			std::vector<size_t> GetOrder() const
+			{
+				std::vector<size_t> order(m_Keys.size());
+				for (size_t i = 0; i < order.size(); ++i)
+				{
+					order[i] = i;
+				}
+				return order;
+			}
+
+			///	@brief	按输出顺序取出所有键，之后不可再使用此对象
+			std::vector<Key_t> ReleaseKeys()
+			{
+				m_Ids.clear();
+				return std::move(m_Keys);
+			}
+
+		private:
+			struct KeyRef
+			{
+				Key_t const& Key;
+				size_t Hash;
+			};
+
+			struct IdHash
+			{
+				typedef void is_transparent;
+
+				FlatHashIndex const* Index;
+
+				size_t operator()(size_t id) const noexcept
+				{
+					return Index->m_Hashes[id];
+				}
+
+				size_t operator()(KeyRef const& key) const noexcept
+				{
+					return key.Hash;
+				}
+			};
+
+			struct IdEqual
+			{
+				typedef void is_transparent;
+
+				FlatHashIndex const* Index;
+
+				nBool operator()(size_t id, size_t other) const noexcept
+				{
+					return id == other;
+				}
+
+				nBool operator()(size_t id, KeyRef const& key) const
+				{
+					return Index->m_Hashes[id] == key.Hash && Index->m_Keys[id] == key.Key;
+				}
+			};
+
+			std::vector<Key_t> m_Keys;
+			std::vector<size_t> m_Hashes;
+			FlatHashSet<size_t, IdHash, IdEqual> m_Ids;
+		};
+
+		// 与 FlatHashIndex 接口相同，但以键的顺序输出各组，用于不可哈希的键或需要有序结果的情况
+		template <typename Key_t>
+		class OrderedIndex final
+		{
+		public:
+			static constexpr nBool Ordered = true;
+			static constexpr size_t npos = size_t(-1);
+
+			void Reserve(size_t)
+			{
+			}
+
+			template <typename K>
+			std::pair<size_t, nBool> Insert(K&& key)
+			{
+				const auto result = m_Map.try_emplace(std::forward<K>(key), m_Entries.size());
+				if (result.second)
+				{
+					m_Entries.emplace_back(result.first);
+				}
+				return { result.first->second, result.second };
+			}
+
+			size_t Find(Key_t const& key) const
+			{
+				const auto iter = m_Map.find(key);
+				return iter == m_Map.end() ? npos : iter->second;
+			}
+
+			size_t size() const noexcept
+			{
+				return m_Entries.size();
+			}
+
+			Key_t const& GetKey(size_t id) const
+			{
+				return m_Entries[id]->first;
+			}
+
+			std::vector<size_t> GetOrder() const
+			{
+				std::vector<size_t> order;
+				order.reserve(m_Map.size());
+				for (auto&& item : m_Map)
+				{
+					order.emplace_back(item.second);
+				}
+				return order;
+			}
+
+			std::vector<Key_t> ReleaseKeys()
+			{
+				std::vector<Key_t> keys;
+				keys.reserve(m_Map.size());
+				while (!m_Map.empty())
+				{
+					keys.emplace_back(std::move(m_Map.extract(m_Map.begin()).key()));
+				}
+				m_Entries.clear();
+				return keys;
+			}
+
+		private:
+			std::map<Key_t, size_t> m_Map;
+			std::vector<typename std::map<Key_t, size_t>::const_iterator> m_Entries;
+		};
+
+		template <typename Key_t>
+		using DefaultIndex = std::conditional_t<IsHashable<Key_t>::value, FlatHashIndex<Key_t>, OrderedIndex<Key_t>>;
+
+		template <typename CallableObj_t, nBool IsDescending>
+		struct OrderByKey
+		{
+			static constexpr nBool Descending = IsDescending;
+
+			template <typename Element_t>
+			using KeyType = std::remove_cv_t<std::remove_reference_t<std::invoke_result_t<CallableObj_t const&, Element_t const&>>>;
+
+			CallableObj_t CallableObj;
+		};
+
+		// 排序所需的全部状态，在第一次访问元素时才读取源并排序
+		// 每一级的键只提取一次，存放于与元素平行的缓冲区中，排序的对象是元素的下标
+		template <typename Iter_t, typename... Keys_t>
+		class OrderByState final
+		{
+		public:
+			typedef std::decay_t<decltype(*std::declval<Iter_t>())> Element_t;
+
+			OrderByState(Iter_t begin, Iter_t end, std::shared_ptr<const void> pOwner, std::tuple<Keys_t...> keys)
+				: m_Begin{ std::move(begin) }, m_End{ std::move(end) }, m_pOwner{ std::move(pOwner) }, m_Keys{ std::move(keys) }
+			{
+			}
+
+			template <nBool Descending, typename CallableObj>
+			auto ThenBy(CallableObj&& callableObj) const
+			{
+				typedef OrderByState<Iter_t, Keys_t..., OrderByKey<std::decay_t<CallableObj>, Descending>> NextState_t;
+				return std::make_shared<NextState_t>(m_Begin, m_End, m_pOwner, std::tuple_cat(m_Keys, std::make_tuple(OrderByKey<std::decay_t<CallableObj>, Descending>{ std::forward<CallableObj>(callableObj) })));
+			}
+
+			size_t size()
+			{
+				Sort();
+				return m_Order.size();
+			}
+
+			Element_t const& Get(size_t position)
+			{
+				Sort();
+				return m_Elements[m_Order[position]];
+			}
+
+		private:
+			typedef std::tuple<std::vector<typename Keys_t::template KeyType<Element_t>>...> KeyBuffers_t;
+
+			enum : size_t
+			{
+				RadixBits = 8,
+				RadixSize = size_t(1) << RadixBits,
+			};
+
+			Iter_t m_Begin, m_End;
+			std::shared_ptr<const void> m_pOwner;
+			std::tuple<Keys_t...> m_Keys;
+			std::once_flag m_SortFlag;
+			std::vector<Element_t> m_Elements;
+			std::vector<size_t> m_Order;
+
+			template <typename Key_t>
+			using IsRadixKey = std::conjunction<std::is_integral<Key_t>, std::negation<std::is_same<Key_t, bool>>>;
+
+			// 复制得到的迭代器共享同一状态，可能在多个线程中同时首次访问，因此以 std::call_once 保证只排序一次
+			// 排序时抛出异常则状态不变，下一次访问时将重新排序
+			void Sort()
+			{
+				std::call_once(m_SortFlag, [this]
+				{
+					SortImpl();
+				});
+			}
+
+			void SortImpl()
+			{
+				m_Elements.assign(m_Begin, m_End);
+				const auto count = m_Elements.size();
+				KeyBuffers_t keyBuffers;
+				ExtractKeys(keyBuffers, std::index_sequence_for<Keys_t...>{});
+
+				m_Order.resize(count);
+				for (size_t i = 0; i < count; ++i)
+				{
+					m_Order[i] = i;
+				}
+
+				if constexpr (std::conjunction_v<IsRadixKey<typename Keys_t::template KeyType<Element_t>>...>)
+				{
+					std::vector<size_t> buffer(count);
+					RadixSortLevels<sizeof...(Keys_t)>(keyBuffers, buffer);
+				}
+				else
+				{
+					std::stable_sort(m_Order.begin(), m_Order.end(), [&keyBuffers](size_t a, size_t b)
+					{
+						return Less(keyBuffers, a, b);
+					});
+				}
+			}
+
+			template <size_t... I>
+			void ExtractKeys(KeyBuffers_t& keyBuffers, std::index_sequence<I...>) const
+			{
+				(ExtractKey(std::get<I>(keyBuffers), std::get<I>(m_Keys)), ...);
+			}
+
+			template <typename Buffer_t, typename Key_t>
+			void ExtractKey(Buffer_t& buffer, Key_t const& key) const
+			{
+				buffer.reserve(m_Elements.size());
+				for (auto&& element : m_Elements)
+				{
+					buffer.emplace_back(key.CallableObj(element));
+				}
+			}
+
+			template <size_t I = 0>
+			static nBool Less(KeyBuffers_t const& keyBuffers, size_t a, size_t b)
+			{
+				if constexpr (I == sizeof...(Keys_t))
+				{
+					return false;
+				}
+				else
+				{
+					auto&& keys = std::get<I>(keyBuffers);
+					auto&& lhs = std::tuple_element_t<I, std::tuple<Keys_t...>>::Descending ? keys[b] : keys[a];
+					auto&& rhs = std::tuple_element_t<I, std::tuple<Keys_t...>>::Descending ? keys[a] : keys[b];
+					if (lhs < rhs)
+					{
+						return true;
+					}
+					if (rhs < lhs)
+					{
+						return false;
+					}
+					return Less<I + 1>(keyBuffers, a, b);
+				}
+			}
+
+			// 所有键都是整数时使用 LSD 基数排序，从最后一级键开始逐级进行稳定的排序
+			template <size_t Level>
+			void RadixSortLevels(KeyBuffers_t const& keyBuffers, std::vector<size_t>& buffer)
+			{
+				if constexpr (Level > 0)
+				{
+					RadixSort<std::tuple_element_t<Level - 1, std::tuple<Keys_t...>>::Descending>(std::get<Level - 1>(keyBuffers), buffer);
+					RadixSortLevels<Level - 1>(keyBuffers, buffer);
+				}
+			}
+
+			template <nBool Descending, typename Key_t>
+			void RadixSort(std::vector<Key_t> const& keys, std::vector<size_t>& buffer)
+			{
+				typedef std::make_unsigned_t<Key_t> Unsigned_t;
+				const auto toRadix = [](Key_t key) noexcept
+				{
+					auto value = static_cast<Unsigned_t>(key);
+					if constexpr (std::is_signed_v<Key_t>)
+					{
+						value ^= Unsigned_t(1) << (sizeof(Unsigned_t) * 8 - 1);
+					}
+					return Descending ? static_cast<Unsigned_t>(~value) : value;
+				};
+
+				std::vector<size_t> counts(RadixSize);
+				for (size_t shift = 0; shift < sizeof(Unsigned_t) * 8; shift += RadixBits)
+				{
+					std::fill(counts.begin(), counts.end(), 0);
+					for (auto index : m_Order)
+					{
+						++counts[(toRadix(keys[index]) >> shift) & (RadixSize - 1)];
+					}
+
+					// 所有元素的这一位都相同时跳过
+					if (std::find(counts.begin(), counts.end(), m_Order.size()) != counts.end())
+					{
+						continue;
+					}
+
+					size_t offset = 0;
+					for (auto& count : counts)
+					{
+						const auto current = count;
+						count = offset;
+						offset += current;
+					}
+					for (auto index : m_Order)
+					{
+						buffer[counts[(toRadix(keys[index]) >> shift) & (RadixSize - 1)]++] = index;
+					}
+					m_Order.swap(buffer);
+				}
+			}
+		};
+
+		template <typename State_t>
+		class OrderByIterator final
+		{
+			typedef OrderByIterator<State_t> Self_t;
+
+			std::shared_ptr<State_t> m_pState;
+			size_t m_Position;
+			nBool m_IsEnd;
+
+			size_t GetPosition() const
+			{
+				return m_IsEnd ? m_pState->size() : m_Position;
+			}
+
+		public:
+			typedef std::random_access_iterator_tag iterator_category;
+			typedef typename State_t::Element_t value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef value_type const& reference;
+			typedef value_type const* pointer;
+
+			explicit OrderByIterator(std::shared_ptr<State_t> pState) noexcept
+				: m_pState{ std::move(pState) }, m_Position{}, m_IsEnd{ false }
+			{
+			}
+
+			OrderByIterator(std::shared_ptr<State_t> pState, EndIteratorTagType) noexcept
+				: m_pState{ std::move(pState) }, m_Position{}, m_IsEnd{ true }
+			{
+			}
+
+			std::shared_ptr<State_t> const& GetState() const noexcept
+			{
+				return m_pState;
+			}
+
+			Self_t& operator++() &
+			{
+				++m_Position;
+				return *this;
+			}
+
+			Self_t& operator--() &
+			{
+				m_Position = GetPosition() - 1;
+				m_IsEnd = false;
+				return *this;
+			}
+
+			Self_t& operator+=(difference_type diff) &
+			{
+				m_Position = GetPosition() + diff;
+				m_IsEnd = false;
+				return *this;
+			}
+
+			reference operator*() const
+			{
+				return m_pState->Get(m_Position);
+			}
+
+			nBool operator==(Self_t const& other) const
+			{
+				if (m_IsEnd && other.m_IsEnd)
+				{
+					return m_pState == other.m_pState;
+				}
+
+				return m_pState == other.m_pState && GetPosition() == other.GetPosition();
+			}
+
+			nBool operator!=(Self_t const& other) const
+			{
+				return !(*this == other);
+			}
+
+			difference_type operator-(Self_t const& other) const
+			{
+				return static_cast<difference_type>(GetPosition()) - static_cast<difference_type>(other.GetPosition());
+			}
+		};
+
+		template <typename Iter_t>
+		struct IsOrderByIterator
+			: std::false_type
+		{
+		};
+
+		template <typename State_t>
+		struct IsOrderByIterator<OrderByIterator<State_t>>
+			: std::true_type
+		{
+		};
+	}
+
+	class natThreadPool;
+
+	namespace detail_
+	{
+		// 推送式的处理阶段，每个阶段将输入的元素处理后交给下一个阶段，sink 返回 false 表示停止处理
+		// 连续的 select 和 where 可以融合为一个阶段，用于并行查询及增量视图
+		template <typename Input_t>
+		struct PushIdentityStage
+		{
+			typedef Input_t input_type;
+			typedef Input_t reference;
+
+			template <typename Sink>
+			nBool Push(input_type item, Sink& sink) const
+			{
+				return sink(std::forward<input_type>(item));
+			}
+		};
+
+		template <typename Prev_t, typename CallableObj_t>
+		struct PushSelectStage
+		{
+			typedef typename Prev_t::input_type input_type;
+			typedef std::invoke_result_t<CallableObj_t const&, typename Prev_t::reference> reference;
+
+			Prev_t m_Prev;
+			CallableObj_t m_CallableObj;
+
+			template <typename Sink>
+			nBool Push(input_type item, Sink& sink) const
+			{
+				auto next = [this, &sink](typename Prev_t::reference value) -> nBool
+				{
+					return sink(m_CallableObj(std::forward<typename Prev_t::reference>(value)));
+				};
+				return m_Prev.Push(std::forward<input_type>(item), next);
+			}
+		};
+
+		template <typename Prev_t, typename CallableObj_t>
+		struct PushWhereStage
+		{
+			typedef typename Prev_t::input_type input_type;
+			typedef typename Prev_t::reference reference;
+
+			Prev_t m_Prev;
+			CallableObj_t m_CallableObj;
+
+			template <typename Sink>
+			nBool Push(input_type item, Sink& sink) const
+			{
+				auto next = [this, &sink](reference value) -> nBool
+				{
+					return !m_CallableObj(value) || sink(std::forward<reference>(value));
+				};
+				return m_Prev.Push(std::forward<input_type>(item), next);
+			}
+		};
+
+		///	@brief	从状态对象中按序号拉取元素的迭代器
+		///	@remark	状态对象需提供 Ensure(index) 及 Get(index)，Ensure 在 index 处不存在元素时返回 false，
+		///			迭代器的类别由状态对象决定，为输入迭代器时迭代器之间共享状态，只保证正在遍历的位置有效
+		template <typename State_t>
+		class PullIterator final
+		{
+			typedef PullIterator<State_t> Self_t;
+
+			State_t* m_pState;
+			size_t m_Index;
+
+		public:
+			typedef typename State_t::iterator_category iterator_category;
+			typedef typename State_t::value_type value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef typename State_t::reference reference;
+			typedef std::add_pointer_t<std::remove_reference_t<reference>> pointer;
+
+			///	@brief	创建 end 迭代器
+			constexpr PullIterator() noexcept
+				: m_pState{}, m_Index{}
+			{
+			}
+
+			explicit PullIterator(State_t* pState) noexcept
+				: m_pState{ pState }, m_Index{}
+			{
+			}
+
+			Self_t& operator++() & noexcept
+			{
+				++m_Index;
+				return *this;
+			}
+
+			reference operator*() const
+			{
+				m_pState->Ensure(m_Index);
+				return m_pState->Get(m_Index);
+			}
+
+			nBool operator==(Self_t const& other) const
+			{
+				const auto isEnd = IsEnd(), otherIsEnd = other.IsEnd();
+				if (isEnd || otherIsEnd)
+				{
+					return isEnd == otherIsEnd;
+				}
+
+				return m_pState == other.m_pState && m_Index == other.m_Index;
+			}
+
+			nBool operator!=(Self_t const& other) const
+			{
+				return !(*this == other);
+			}
+
+		private:
+			nBool IsEnd() const
+			{
+				return !m_pState || !m_pState->Ensure(m_Index);
+			}
+		};
+
+		///	@brief	缓存查询结果的状态
+		///	@remark	元素在首次被访问时才从源中求值，以 std::deque 保存，已缓存元素的引用不会因缓存增长而失效；
+		///			源被遍历完后释放源所持有的数据；状态由各副本共享，访问时加锁，因此可以在多个线程中同时遍历
+		template <typename Iter_t>
+		class MemoizeState
+		{
+		public:
+			typedef std::forward_iterator_tag iterator_category;
+			typedef std::remove_cv_t<std::remove_reference_t<typename std::iterator_traits<Iter_t>::reference>> value_type;
+			typedef value_type const& reference;
+
+			MemoizeState(Iter_t begin, Iter_t end, std::shared_ptr<const void> pOwner)
+				: m_Current(std::move(begin)), m_End(std::move(end)), m_pOwner{ std::move(pOwner) }, m_IsComplete{}
+			{
+			}
+
+			nBool Ensure(size_t index)
+			{
+				std::lock_guard<std::mutex> lock{ m_Mutex };
+				while (index >= m_Elements.size())
+				{
+					if (m_IsComplete)
+					{
+						return false;
+					}
+
+					if (m_Current == m_End)
+					{
+						m_IsComplete = true;
+						m_pOwner.reset();
+						return false;
+					}
+
+					m_Elements.emplace_back(*m_Current);
+					++m_Current;
+				}
+
+				return true;
+			}
+
+			// 其他线程可能正在向 m_Elements 追加元素，因此读取时同样需要加锁
+			value_type const& Get(size_t index) const
+			{
+				std::lock_guard<std::mutex> lock{ m_Mutex };
+				return m_Elements[index];
+			}
+
+		private:
+			mutable std::mutex m_Mutex;
+			Iter_t m_Current, m_End;
+			std::shared_ptr<const void> m_pOwner;
+			std::deque<value_type> m_Elements;
+			nBool m_IsComplete;
+		};
+
+		template <typename Iter_t, typename CallableObj_t, nBool Descending>
+		class ExternalSortState;
+	}
+
+	template <typename Iter_t>
+	class LinqEnumerable;
+
+	template <typename Iter_t, typename Stage_t>
+	class ParallelLinqEnumerable;
+
+	template <typename T>
+	class Linq;
+
+	template <typename Container>
+	LinqEnumerable<detail_::StorageIterator<Container>> from_container(Container container);
+
+	template <typename T>
+	LinqEnumerable<detail_::EmptyIterator<T>> from_empty();
+
+	template <typename Iter_t>
+	class LinqEnumerable
+	{
+		typedef std::decay_t<decltype(*std::declval<Iter_t>())> Element_t;
+
+	public:
+		typedef Iter_t iterator;
+		typedef typename std::iterator_traits<Iter_t>::value_type value_type;
+		typedef typename std::iterator_traits<Iter_t>::difference_type difference_type;
+		typedef typename std::iterator_traits<Iter_t>::reference reference;
+		typedef std::make_unsigned_t<difference_type> size_type;
+
+		typedef LinqEnumerable<Iter_t> Self_t;
+
+	private:
+		Range<Iter_t> m_Range;
+		mutable Optional<size_t> m_Size;
+		// 持有迭代器所引用的数据，迭代器本身不持有所有权，因此迭代器不能比产生它的 LinqEnumerable 存活得更久
+		std::shared_ptr<const void> m_pOwner;
+
+		static std::shared_ptr<const void> CombineOwners(std::shared_ptr<const void> const& a, std::shared_ptr<const void> const& b)
+		{
+			if (!a || a == b)
+			{
+				return b;
+			}
+			if (!b)
+			{
+				return a;
+			}
+			return std::make_shared<std::pair<std::shared_ptr<const void>, std::shared_ptr<const void>>>(a, b);
+		}
+
+	public:
+		constexpr LinqEnumerable(Iter_t begin, Iter_t end)
+			: m_Range(std::move(begin), std::move(end))
+		{
+		}
+
+		LinqEnumerable(Iter_t begin, Iter_t end, std::shared_ptr<const void> pOwner)
+			: m_Range(std::move(begin), std::move(end)), m_pOwner(std::move(pOwner))
+		{
+		}
+
+		constexpr LinqEnumerable(LinqEnumerable const& other) = default;
+		constexpr LinqEnumerable(LinqEnumerable&& other) = default;
+
+		LinqEnumerable& operator=(LinqEnumerable const& other) = default;
+		LinqEnumerable& operator=(LinqEnumerable && other) = default;
+
+		constexpr Iter_t begin() const
+		{
+			return m_Range.begin();
+		}
+
+		constexpr Iter_t end() const
+		{
+			return m_Range.end();
+		}
+
+		///	@brief	获得持有数据所有权的对象
+		std::shared_ptr<const void> const& GetOwner() const noexcept
+		{
+			return m_pOwner;
+		}
+
+		///	@brief	获得连续存储的数据的首地址
+		///	@note	仅当迭代器为指针时可用，如由 from_span 或 from_view 创建的 LinqEnumerable
+		template <typename I = Iter_t, std::enable_if_t<std::is_pointer_v<I>, int> = 0>
+		constexpr Iter_t data() const noexcept
+		{
+			return m_Range.begin();
+		}
+
+		size_type size() const
+		{
+			if (!m_Size)
+			{
+				m_Size.emplace(static_cast<size_t>(std::distance(m_Range.begin(), m_Range.end())));
+			}
+
+			return m_Size.value();
+		}
+
+		size_type count() const
+		{
 			return size();
 		}
 
@@ -1152,7 +2262,7 @@ namespace NatsuLib
 		LinqEnumerable<detail_::SelectIterator<Iter_t, CallableObj>> select(CallableObj&& callableObj) const
 		{
 			return LinqEnumerable<detail_::SelectIterator<Iter_t, CallableObj>>(detail_::SelectIterator<Iter_t, CallableObj>(m_Range.begin(), std::forward<CallableObj>(callableObj)),
-				detail_::SelectIterator<Iter_t, CallableObj>(m_Range.end(), detail_::EndIteratorTag));
+				detail_::SelectIterator<Iter_t, CallableObj>(m_Range.end(), detail_::EndIteratorTag), m_pOwner);
 		}
 
 		template <typename T>
@@ -1168,13 +2278,22 @@ namespace NatsuLib
 		LinqEnumerable<detail_::WhereIterator<Iter_t, CallableObj>> where(CallableObj&& callableObj) const
 		{
 			return LinqEnumerable<detail_::WhereIterator<Iter_t, CallableObj>>(detail_::WhereIterator<Iter_t, CallableObj>(m_Range.begin(), m_Range.end(), std::forward<CallableObj>(callableObj)),
-				detail_::WhereIterator<Iter_t, CallableObj>(m_Range.end()));
+				detail_::WhereIterator<Iter_t, CallableObj>(m_Range.end()), m_pOwner);
 		}
 
 		LinqEnumerable skip(difference_type count) const
 		{
 			LinqEnumerable ret(*this);
-			ret.m_Range.pop_front(count);
+			ret.m_Size.reset();
+			if constexpr (std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<Iter_t>::iterator_category>)
+			{
+				// 随机访问时直接移动到目标位置，并且不会越过结尾
+				ret.m_Range.pop_front(std::min(std::max(count, difference_type{}), static_cast<difference_type>(size())));
+			}
+			else
+			{
+				ret.m_Range.pop_front(count);
+			}
 			return ret;
 		}
 
@@ -1182,27 +2301,27 @@ namespace NatsuLib
 		LinqEnumerable<detail_::SkipWhileIterator<Iter_t>> skip_while(CallableObj&& callableObj) const
 		{
 			return LinqEnumerable<detail_::SkipWhileIterator<Iter_t>>(detail_::SkipWhileIterator<Iter_t>(m_Range.begin(), m_Range.end(), std::forward<CallableObj>(callableObj)),
-				detail_::SkipWhileIterator<Iter_t>(m_Range.end()));
+				detail_::SkipWhileIterator<Iter_t>(m_Range.end()), m_pOwner);
 		}
 
 		LinqEnumerable<detail_::TakeIterator<Iter_t>> take(difference_type count) const
 		{
 			return LinqEnumerable<detail_::TakeIterator<Iter_t>>(detail_::TakeIterator<Iter_t>(m_Range.begin(), m_Range.end(), count),
-				detail_::TakeIterator<Iter_t>(m_Range.end(), m_Range.end(), count));
+				detail_::TakeIterator<Iter_t>(m_Range.end(), m_Range.end(), count), m_pOwner);
 		}
 
 		template <typename CallableObj>
 		LinqEnumerable<detail_::TakeWhileIterator<Iter_t, CallableObj>> take_while(CallableObj&& callableObj) const
 		{
 			return LinqEnumerable<detail_::TakeWhileIterator<Iter_t, CallableObj>>(detail_::TakeWhileIterator<Iter_t, CallableObj>(m_Range.begin(), m_Range.end(), std::forward<CallableObj>(callableObj)),
-				detail_::TakeWhileIterator<Iter_t, CallableObj>(m_Range.end()));
+				detail_::TakeWhileIterator<Iter_t, CallableObj>(m_Range.end()), m_pOwner);
 		}
 
 		template <typename Iter2_t>
 		LinqEnumerable<detail_::ConcatIterator<Iter_t, Iter2_t>> concat(LinqEnumerable<Iter2_t> const& other) const
 		{
 			return LinqEnumerable<detail_::ConcatIterator<Iter_t, Iter2_t>>(detail_::ConcatIterator<Iter_t, Iter2_t>(m_Range.begin(), m_Range.end(), other.begin(), other.end()),
-				detail_::ConcatIterator<Iter_t, Iter2_t>(m_Range.end(), m_Range.end(), other.end(), other.end()));
+				detail_::ConcatIterator<Iter_t, Iter2_t>(m_Range.end(), m_Range.end(), other.end(), other.end()), CombineOwners(m_pOwner, other.GetOwner()));
 		}
 
 		template <typename T>
@@ -1221,10 +2340,17 @@ namespace NatsuLib
 			return *std::next(m_Range.begin(), index);
 		}
 
+		///	@brief	去除重复的元素
+		///	@remark	元素可哈希时使用哈希表，结果按元素首次出现的顺序排列，否则同 distinct_ordered
 		auto distinct() const
 		{
-			std::set<Element_t> tmpSet(m_Range.begin(), m_Range.end());
-			return from_container(std::move(tmpSet));
+			return DistinctImpl<detail_::DefaultIndex<Element_t>>();
+		}
+
+		///	@brief	去除重复的元素，结果按元素从小到大排列
+		auto distinct_ordered() const
+		{
+			return DistinctImpl<detail_::OrderedIndex<Element_t>>();
 		}
 
 		template <typename Iter2_t>
@@ -1394,7 +2520,7 @@ namespace NatsuLib
 		{
 			if constexpr (detail_::CanGreater<Element_t>::value)
 			{
-				return aggregate([](const Element_t& a, const Element_t& b) { return a > b ? a : b; });
+				return ReduceFromFirst([](const Element_t& a, const Element_t& b) { return a > b ? a : b; });
 			}
 			else
 			{
@@ -1406,7 +2532,7 @@ namespace NatsuLib
 		{
 			if constexpr (detail_::CanLesser<Element_t>::value)
 			{
-				return aggregate([](const Element_t& a, const Element_t& b) { return a < b ? a : b; });
+				return ReduceFromFirst([](const Element_t& a, const Element_t& b) { return a < b ? a : b; });
 			}
 			else
 			{
@@ -1449,147 +2575,69 @@ namespace NatsuLib
 			});
 		}
 
+		///	@brief	按键分组
+		///	@remark	键可哈希时使用哈希表，各组按键首次出现的顺序排列，否则同 group_by_ordered
+		///			所有组的元素存储在同一块连续的内存中，组内元素保持原有的顺序
+		///	@return	由键及对应的元素组成的 std::pair 的序列
 		template <typename CallableObj>
 		auto group_by(CallableObj&& keySelector) const
 		{
-			typedef decltype(std::forward<CallableObj>(keySelector)(std::declval<Element_t>())) Key_t;
-			std::map<Key_t, std::vector<Element_t>> tmpMap;
-			for (auto&& item : *this)
-			{
-				auto&& key = std::forward<CallableObj>(keySelector)(item);
-				tmpMap[key].emplace_back(item);
-			}
-
-			std::vector<std::pair<Key_t, Linq<Element_t>>> result;
-			for (auto&& item : tmpMap)
-			{
-				result.emplace_back(std::make_pair<Key_t, Linq<Element_t>>(item.first, from_container(std::move(item.second))));
-			}
+			return GroupByImpl<detail_::DefaultIndex<KeyOf<CallableObj, Iter_t>>>(keySelector);
+		}
 
-			return from_container(std::move(result));
+		///	@brief	按键分组，各组按键从小到大排列
+		template <typename CallableObj>
+		auto group_by_ordered(CallableObj&& keySelector) const
+		{
+			return GroupByImpl<detail_::OrderedIndex<KeyOf<CallableObj, Iter_t>>>(keySelector);
 		}
 
+		///	@brief	全连接
+		///	@remark	键可哈希时使用哈希表，结果按键首次出现的顺序排列（先本序列后 e），否则同 full_join_ordered
+		///	@return	由键、本序列中具有此键的元素及 e 中具有此键的元素组成的 std::tuple 的序列，两侧均包含仅在一侧出现的键
 		template <typename Iter2_t, typename CallableObj1, typename CallableObj2>
 		auto full_join(LinqEnumerable<Iter2_t> const& e, CallableObj1&& keySelector1, CallableObj2&& keySelector2) const
 		{
-			typedef std::remove_reference_t<decltype(std::forward<CallableObj1>(keySelector1)(std::declval<Element_t>()))> Key1_t;
-			typedef std::remove_reference_t<decltype(std::forward<CallableObj2>(keySelector2)(std::declval<Element_t>()))> Key2_t;
-			static_assert(std::is_same<Key1_t, Key2_t>::value, "Key1_t and Key2_t should be same.");
-			typedef std::common_type_t<Key1_t, Key2_t> Key_t;
-			typedef std::remove_cv_t<std::remove_reference_t<decltype(*std::declval<Iter_t>())>> Value1_t;
-			typedef std::remove_cv_t<std::remove_reference_t<decltype(*std::declval<Iter2_t>())>> Value2_t;
-			typedef std::tuple<Key_t, Linq<Element_t>, Linq<Element_t>> FullJoinResult_t;
-
-			std::multimap<Key_t, Value1_t> map1;
-			std::multimap<Key_t, Value2_t> map2;
-
-			for (auto&& item : *this)
-			{
-				map1.insert(std::make_pair(std::forward<CallableObj1>(keySelector1)(item), item));
-			}
-
-			for (auto&& item : e)
-			{
-				map2.insert(std::make_pair(std::forward<CallableObj2>(keySelector2)(item), item));
-			}
-
-			std::vector<FullJoinResult_t> result;
-			auto lower1 = map1.begin();
-			auto lower2 = map2.begin();
-			while (lower1 != map1.end() && lower2 != map2.end())
-			{
-				auto key1 = lower1->first;
-				auto key2 = lower2->first;
-				auto upper1 = map1.upper_bound(key1);
-				auto upper2 = map2.upper_bound(key2);
-
-				if (key1 < key2)
-				{
-					std::vector<Value1_t> outers;
-					outers.reserve(std::distance(lower1, upper1));
-					for (auto iter = lower1; iter != upper1; ++iter)
-					{
-						outers.emplace_back(iter->second);
-					}
-					result.emplace_back(std::make_tuple(key1, from_container(std::move(outers)), from_empty<Value2_t>()));
-					lower1 = upper1;
-				}
-				else if (key1 > key2)
-				{
-					std::vector<Value2_t> inners;
-					inners.reserve(std::distance(lower2, upper2));
-					for (auto iter = lower2; iter != upper2; ++iter)
-					{
-						inners.emplace_back(iter->second);
-					}
-					result.emplace_back(std::make_tuple(key2, from_empty<Value1_t>(), from_container(std::move(inners))));
-					lower2 = upper2;
-				}
-				else
-				{
-					std::vector<Value1_t> outers;
-					outers.reserve(std::distance(lower1, upper1));
-					for (auto iter = lower1; iter != upper1; ++iter)
-					{
-						outers.emplace_back(iter->second);
-					}
-					std::vector<Value2_t> inners;
-					inners.reserve(std::distance(lower2, upper2));
-					for (auto iter = lower2; iter != upper2; ++iter)
-					{
-						inners.emplace_back(iter->second);
-					}
-					result.emplace_back(std::make_tuple(key1, from_container(std::move(outers)), from_container(std::move(inners))));
-					lower1 = upper1;
-					lower2 = upper2;
-				}
-			}
+			return FullJoinImpl<detail_::DefaultIndex<JoinKeyOf<CallableObj1, CallableObj2, Iter2_t>>>(e, keySelector1, keySelector2);
+		}
 
-			return from_container(std::move(result));
+		///	@brief	全连接，结果按键从小到大排列
+		template <typename Iter2_t, typename CallableObj1, typename CallableObj2>
+		auto full_join_ordered(LinqEnumerable<Iter2_t> const& e, CallableObj1&& keySelector1, CallableObj2&& keySelector2) const
+		{
+			return FullJoinImpl<detail_::OrderedIndex<JoinKeyOf<CallableObj1, CallableObj2, Iter2_t>>>(e, keySelector1, keySelector2);
 		}
 
+		///	@brief	分组连接
+		///	@remark	键可哈希时使用哈希表，结果按本序列的顺序排列，否则同 group_join_ordered
+		///	@return	由键、本序列的每个元素及 e 中具有相同键的元素组成的 std::tuple 的序列
 		template <typename Iter2_t, typename CallableObj1, typename CallableObj2>
 		auto group_join(LinqEnumerable<Iter2_t> const& e, CallableObj1&& keySelector1, CallableObj2&& keySelector2) const
 		{
-			typedef std::remove_reference_t<decltype(std::forward<CallableObj1>(keySelector1)(std::declval<Element_t>()))> Key1_t;
-			typedef std::remove_reference_t<decltype(std::forward<CallableObj2>(keySelector2)(std::declval<Element_t>()))> Key2_t;
-			static_assert(std::is_same<Key1_t, Key2_t>::value, "Key1_t and Key2_t should be same.");
-			typedef std::common_type_t<Key1_t, Key2_t> Key_t;
-			typedef std::remove_cv_t<std::remove_reference_t<decltype(*std::declval<Iter_t>())>> Value1_t;
-			typedef std::remove_cv_t<std::remove_reference_t<decltype(*std::declval<Iter2_t>())>> Value2_t;
-			typedef std::tuple<Key_t, Linq<Element_t>, Linq<Element_t>> FullJoinResult_t;
-			typedef std::tuple<Key_t, Value1_t, Linq<Value2_t>> GroupJoinResult_t;
+			return GroupJoinImpl<detail_::DefaultIndex<JoinKeyOf<CallableObj1, CallableObj2, Iter2_t>>>(e, keySelector1, keySelector2);
+		}
 
-			return full_join(e, std::forward<CallableObj1>(keySelector1), std::forward<CallableObj2>(keySelector2)).select_many([](const FullJoinResult_t& item)
-			{
-				Linq<Value1_t> outers = item.second.first;
-				return outers.select([&item](const Value1_t& outer)
-				{
-					return GroupJoinResult_t{ item.first, outer, item.second.second };
-				});
-			});
+		///	@brief	分组连接，结果按键从小到大排列，键相同时保持本序列的顺序
+		template <typename Iter2_t, typename CallableObj1, typename CallableObj2>
+		auto group_join_ordered(LinqEnumerable<Iter2_t> const& e, CallableObj1&& keySelector1, CallableObj2&& keySelector2) const
+		{
+			return GroupJoinImpl<detail_::OrderedIndex<JoinKeyOf<CallableObj1, CallableObj2, Iter2_t>>>(e, keySelector1, keySelector2);
 		}
 
+		///	@brief	内连接
+		///	@remark	键可哈希时使用哈希表，结果按本序列的顺序排列，否则同 join_ordered
+		///	@return	由键及两侧具有此键的元素组成的 std::tuple 的序列
 		template <typename Iter2_t, typename CallableObj1, typename CallableObj2>
 		auto join(LinqEnumerable<Iter2_t> const& e, CallableObj1&& keySelector1, CallableObj2&& keySelector2) const
 		{
-			typedef std::remove_reference_t<decltype(std::forward<CallableObj1>(keySelector1)(std::declval<Element_t>()))> Key1_t;
-			typedef std::remove_reference_t<decltype(std::forward<CallableObj2>(keySelector2)(std::declval<Element_t>()))> Key2_t;
-			static_assert(std::is_same<Key1_t, Key2_t>::value, "Key1_t and Key2_t should be same.");
-			typedef std::common_type_t<Key1_t, Key2_t> Key_t;
-			typedef std::remove_cv_t<std::remove_reference_t<decltype(*std::declval<Iter_t>())>> Value1_t;
-			typedef std::remove_cv_t<std::remove_reference_t<decltype(*std::declval<Iter2_t>())>> Value2_t;
-			typedef std::tuple<Key_t, Value1_t, Linq<Value2_t>> GroupJoinResult_t;
-			typedef std::tuple<Key_t, Value1_t, Value2_t> JoinResult_t;
+			return JoinImpl<detail_::DefaultIndex<JoinKeyOf<CallableObj1, CallableObj2, Iter2_t>>>(e, keySelector1, keySelector2);
+		}
 
-			return group_join(e, std::forward<CallableObj1>(keySelector1), std::forward<CallableObj2>(keySelector2)).select_many([](const GroupJoinResult_t& item)
-			{
-				Linq<Value2_t> inners = item.second.second;
-				return inners.select([&item](const Value2_t& inner)
-				{
-					return JoinResult_t{ item.first, item.second.first, inner };
-				});
-			});
+		///	@brief	内连接，结果按键从小到大排列，键相同时保持本序列的顺序
+		template <typename Iter2_t, typename CallableObj1, typename CallableObj2>
+		auto join_ordered(LinqEnumerable<Iter2_t> const& e, CallableObj1&& keySelector1, CallableObj2&& keySelector2) const
+		{
+			return JoinImpl<detail_::OrderedIndex<JoinKeyOf<CallableObj1, CallableObj2, Iter2_t>>>(e, keySelector1, keySelector2);
 		}
 
 		template <typename CallableObj>
@@ -1597,38 +2645,95 @@ namespace NatsuLib
 		{
 			typedef std::remove_reference_t<decltype(std::forward<CallableObj>(keySelector)(std::declval<Element_t>()))> Key_t;
 
-			return group_by(std::forward<CallableObj>(keySelector)).select([](std::pair<Key_t, Linq<Element_t>> const& p)
+			return group_by_ordered(std::forward<CallableObj>(keySelector)).select([](std::pair<Key_t, Linq<const Element_t>> const& p)
 			{
 				return p.second;
 			});
 		}
 
+		///	@brief	按键进行稳定的排序
+		///	@remark	排序在第一次访问结果时才进行，每个元素的键只计算一次，所有键都是整数时使用基数排序
+		///			可继续以 then_order_by 及 then_order_by_descending 追加次级的键
+		template <typename CallableObj>
+		auto order_by(CallableObj&& keySelector) const
+		{
+			return OrderByImpl<false>(std::forward<CallableObj>(keySelector));
+		}
+
+		///	@brief	按键进行稳定的降序排序
+		template <typename CallableObj>
+		auto order_by_descending(CallableObj&& keySelector) const
+		{
+			return OrderByImpl<true>(std::forward<CallableObj>(keySelector));
+		}
+
+		///	@brief	追加次级的排序键
+		///	@note	必须紧跟在 order_by、order_by_descending 或其他 then_order_by 之后
 		template <typename CallableObj>
 		auto then_order_by(CallableObj&& keySelector) const
 		{
-			return select_many([&keySelector](Element_t const& values)
-			{
-				return values.first_order_by(std::forward<CallableObj>(keySelector));
-			});
+			static_assert(detail_::IsOrderByIterator<Iter_t>::value, "then_order_by must follow order_by.");
+			return MakeOrdered(m_Range.begin().GetState()->template ThenBy<false>(std::forward<CallableObj>(keySelector)));
 		}
 
+		///	@brief	追加次级的降序排序键
 		template <typename CallableObj>
-		auto order_by(CallableObj&& keySelector) const
+		auto then_order_by_descending(CallableObj&& keySelector) const
+		{
+			static_assert(detail_::IsOrderByIterator<Iter_t>::value, "then_order_by_descending must follow order_by.");
+			return MakeOrdered(m_Range.begin().GetState()->template ThenBy<true>(std::forward<CallableObj>(keySelector)));
+		}
+
+		///	@brief	以外部排序按键进行稳定的升序排序
+		///	@param[in]	keySelector		键选择器
+		///	@param[in]	memoryBudget	排序时在内存中保存的元素的估计大小上限，以字节计，超过时将已排序的分段写入临时文件
+		///	@note	元素需可由 LinqSpillCodec 写入流，结果为只能顺序遍历的输入序列，使用前需包含 natLinqStream.h
+		template <typename CallableObj>
+		auto order_by_external(CallableObj&& keySelector, size_t memoryBudget) const
+		{
+			return ExternalOrderByImpl<false>(std::forward<CallableObj>(keySelector), memoryBudget);
+		}
+
+		///	@brief	以外部排序按键进行稳定的降序排序
+		template <typename CallableObj>
+		auto order_by_descending_external(CallableObj&& keySelector, size_t memoryBudget) const
 		{
-			return first_order_by(std::forward<CallableObj>(keySelector)).select_many([](const Linq<Element_t>& values) { return values; });
+			return ExternalOrderByImpl<true>(std::forward<CallableObj>(keySelector), memoryBudget);
 		}
 
 		template <typename Iter2_t>
 		auto zip(LinqEnumerable<Iter2_t> const& e) const
 		{
 			return LinqEnumerable<detail_::ZipIterator<Iter_t, Iter2_t>>(detail_::ZipIterator<Iter_t, Iter2_t>(m_Range.begin(), m_Range.end(), e.begin(), e.end()),
-				detail_::ZipIterator<Iter_t, Iter2_t>(m_Range.end(), m_Range.end(), e.end(), e.end()));
+				detail_::ZipIterator<Iter_t, Iter2_t>(m_Range.end(), m_Range.end(), e.end(), e.end()), CombineOwners(m_pOwner, e.GetOwner()));
 		}
 
 		auto reverse() const
 		{
 			return LinqEnumerable<detail_::ReverseIterator<Iter_t>>(detail_::ReverseIterator<Iter_t>(m_Range.begin(), m_Range.end()),
-				detail_::ReverseIterator<Iter_t>(m_Range.begin(), m_Range.begin()));
+				detail_::ReverseIterator<Iter_t>(m_Range.begin(), m_Range.begin()), m_pOwner);
+		}
+
+		///	@brief	缓存查询的结果
+		///	@remark	元素在首次被遍历到时求值并保存，之后的遍历及此 LinqEnumerable 的所有副本共享缓存而不会重新执行之前的操作，
+		///			源被遍历完后即被释放，适用于需要多次遍历的查询及只能遍历一次的源
+		auto memoize() const
+		{
+			typedef detail_::MemoizeState<Iter_t> State_t;
+			typedef detail_::PullIterator<State_t> Iterator;
+			const auto pState = std::make_shared<State_t>(m_Range.begin(), m_Range.end(), m_pOwner);
+			return LinqEnumerable<Iterator>(Iterator(pState.get()), Iterator(), pState);
+		}
+
+		///	@brief	创建以 pool 并行执行的查询
+		///	@param[in]	pool			执行查询的线程池
+		///	@param[in]	partitionCount	分区数，为 0 时根据硬件线程数及元素数决定
+		///	@note	仅支持随机访问的源，使用前需包含 natParallelLinq.h
+		auto as_parallel(natThreadPool& pool, size_t partitionCount = 0) const
+		{
+			static_assert(std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<Iter_t>::iterator_category>, "as_parallel requires a random access source.");
+			typedef detail_::PushIdentityStage<reference> Stage_t;
+			return ParallelLinqEnumerable<Iter_t, Stage_t>(pool, m_Range.begin(), m_Range.end(), Stage_t{}, partitionCount, false, m_pOwner);
 		}
 
 		template <typename Container>
@@ -1636,6 +2741,234 @@ namespace NatsuLib
 		{
 			return Container{ m_Range.begin(), m_Range.end() };
 		}
+
+	private:
+		// 以第一个元素为初始值进行聚合，用于不存在单位元的操作
+		template <typename CallableObj>
+		Element_t ReduceFromFirst(CallableObj&& callableObj) const
+		{
+			if (m_Range.empty())
+			{
+				nat_Throw(natErrException, NatErr_OutOfRange, "No element."_nv);
+			}
+
+			auto iter = m_Range.begin();
+			Element_t result = *iter;
+			while (++iter != m_Range.end())
+			{
+				result = callableObj(std::move(result), *iter);
+			}
+			return result;
+		}
+
+		template <typename CallableObj, typename Iter2_t>
+		using KeyOf = std::remove_cv_t<std::remove_reference_t<std::invoke_result_t<CallableObj&, typename std::iterator_traits<Iter2_t>::reference>>>;
+
+		template <typename CallableObj1, typename CallableObj2, typename Iter2_t>
+		using JoinKeyOf = std::enable_if_t<std::is_same_v<KeyOf<CallableObj1, Iter_t>, KeyOf<CallableObj2, Iter2_t>>, KeyOf<CallableObj1, Iter_t>>;
+
+		// 所有组的元素按组编号稳定地重排到同一块连续的存储中，第 i 组的元素位于 [Offsets[i], Offsets[i + 1])
+		template <typename Value_t>
+		struct Grouping
+		{
+			std::shared_ptr<std::vector<Value_t>> Values;
+			std::vector<size_t> Offsets;
+
+			// 编号不属于任何组时返回空范围
+			std::pair<size_t, size_t> GetRange(size_t id) const noexcept
+			{
+				return id < Offsets.size() - 1 ? std::make_pair(Offsets[id], Offsets[id + 1]) : std::make_pair(Values->size(), Values->size());
+			}
+
+			Linq<const Value_t> Get(size_t id) const
+			{
+				typedef detail_::StorageIterator<std::vector<Value_t>> Iterator;
+				const auto range = GetRange(id);
+				const auto begin = Values->begin();
+				return LinqEnumerable<Iterator>(Iterator(Values, begin + range.first), Iterator(Values, begin + range.second), Values);
+			}
+		};
+
+		template <typename Index_t, typename Range_t, typename CallableObj>
+		static auto Collect(Range_t const& range, CallableObj& keySelector, Index_t& index)
+		{
+			typedef std::remove_cv_t<std::remove_reference_t<decltype(*std::begin(range))>> Value_t;
+
+			std::pair<std::vector<Value_t>, std::vector<size_t>> result;
+			for (auto&& item : range)
+			{
+				result.second.emplace_back(index.Insert(keySelector(item)).first);
+				result.first.emplace_back(item);
+			}
+			return result;
+		}
+
+		template <typename Value_t>
+		static Grouping<Value_t> MakeGrouping(std::vector<Value_t> values, std::vector<size_t> const& ids, size_t groupCount)
+		{
+			Grouping<Value_t> grouping;
+			grouping.Offsets.assign(groupCount + 1, 0);
+			for (auto id : ids)
+			{
+				++grouping.Offsets[id + 1];
+			}
+			for (size_t i = 1; i <= groupCount; ++i)
+			{
+				grouping.Offsets[i] += grouping.Offsets[i - 1];
+			}
+
+			auto next = grouping.Offsets;
+			std::vector<size_t> order(ids.size());
+			for (size_t i = 0; i < ids.size(); ++i)
+			{
+				order[next[ids[i]]++] = i;
+			}
+
+			grouping.Values = std::make_shared<std::vector<Value_t>>();
+			grouping.Values->reserve(values.size());
+			for (auto i : order)
+			{
+				grouping.Values->emplace_back(std::move(values[i]));
+			}
+			return grouping;
+		}
+
+		template <nBool Descending, typename CallableObj>
+		auto OrderByImpl(CallableObj&& keySelector) const
+		{
+			typedef detail_::OrderByKey<std::decay_t<CallableObj>, Descending> Key_t;
+			return MakeOrdered(std::make_shared<detail_::OrderByState<Iter_t, Key_t>>(m_Range.begin(), m_Range.end(), m_pOwner, std::make_tuple(Key_t{ std::forward<CallableObj>(keySelector) })));
+		}
+
+		template <typename State_t>
+		static auto MakeOrdered(std::shared_ptr<State_t> pState)
+		{
+			typedef detail_::OrderByIterator<State_t> Iterator;
+			return LinqEnumerable<Iterator>(Iterator(pState), Iterator(pState, detail_::EndIteratorTag));
+		}
+
+		template <nBool Descending, typename CallableObj>
+		auto ExternalOrderByImpl(CallableObj&& keySelector, size_t memoryBudget) const
+		{
+			typedef detail_::ExternalSortState<Iter_t, std::decay_t<CallableObj>, Descending> State_t;
+			typedef detail_::PullIterator<State_t> Iterator;
+			const auto pState = std::make_shared<State_t>(m_Range.begin(), m_Range.end(), m_pOwner, std::forward<CallableObj>(keySelector), memoryBudget);
+			return LinqEnumerable<Iterator>(Iterator(pState.get()), Iterator(), pState);
+		}
+
+		template <typename Index_t>
+		auto DistinctImpl() const
+		{
+			Index_t index;
+			for (auto&& item : *this)
+			{
+				index.Insert(item);
+			}
+			return from_container(index.ReleaseKeys());
+		}
+
+		template <typename Index_t, typename CallableObj>
+		auto GroupByImpl(CallableObj& keySelector) const
+		{
+			typedef KeyOf<CallableObj, Iter_t> Key_t;
+
+			Index_t index;
+			auto collected = Collect(*this, keySelector, index);
+			const auto grouping = MakeGrouping(std::move(collected.first), collected.second, index.size());
+
+			std::vector<std::pair<Key_t, Linq<const Element_t>>> result;
+			result.reserve(index.size());
+			for (auto id : index.GetOrder())
+			{
+				result.emplace_back(index.GetKey(id), grouping.Get(id));
+			}
+			return from_container(std::move(result));
+		}
+
+		template <typename Index_t, typename Iter2_t, typename CallableObj1, typename CallableObj2>
+		auto FullJoinImpl(LinqEnumerable<Iter2_t> const& e, CallableObj1& keySelector1, CallableObj2& keySelector2) const
+		{
+			typedef KeyOf<CallableObj1, Iter_t> Key_t;
+			typedef std::decay_t<decltype(*std::declval<Iter2_t>())> Value2_t;
+
+			Index_t index;
+			auto collected1 = Collect(*this, keySelector1, index);
+			auto collected2 = Collect(e, keySelector2, index);
+			const auto outers = MakeGrouping(std::move(collected1.first), collected1.second, index.size());
+			const auto inners = MakeGrouping(std::move(collected2.first), collected2.second, index.size());
+
+			std::vector<std::tuple<Key_t, Linq<const Element_t>, Linq<const Value2_t>>> result;
+			result.reserve(index.size());
+			for (auto id : index.GetOrder())
+			{
+				result.emplace_back(index.GetKey(id), outers.Get(id), inners.Get(id));
+			}
+			return from_container(std::move(result));
+		}
+
+		// 对本序列的每个元素调用 callableObj(key, outer, inners, innerId)
+		// 使用哈希表时按本序列的顺序，否则按键的顺序
+		template <typename Index_t, typename Iter2_t, typename CallableObj1, typename CallableObj2, typename CallableObj>
+		void ForEachJoined(LinqEnumerable<Iter2_t> const& e, CallableObj1& keySelector1, CallableObj2& keySelector2, CallableObj&& callableObj) const
+		{
+			Index_t index;
+			auto collected2 = Collect(e, keySelector2, index);
+			const auto inners = MakeGrouping(std::move(collected2.first), collected2.second, index.size());
+
+			if constexpr (Index_t::Ordered)
+			{
+				auto collected1 = Collect(*this, keySelector1, index);
+				const auto outers = MakeGrouping(std::move(collected1.first), collected1.second, index.size());
+				for (auto id : index.GetOrder())
+				{
+					const auto range = outers.GetRange(id);
+					for (auto i = range.first; i < range.second; ++i)
+					{
+						callableObj(index.GetKey(id), (*outers.Values)[i], inners, id);
+					}
+				}
+			}
+			else
+			{
+				for (auto&& item : *this)
+				{
+					const auto key = keySelector1(item);
+					callableObj(key, item, inners, index.Find(key));
+				}
+			}
+		}
+
+		template <typename Index_t, typename Iter2_t, typename CallableObj1, typename CallableObj2>
+		auto GroupJoinImpl(LinqEnumerable<Iter2_t> const& e, CallableObj1& keySelector1, CallableObj2& keySelector2) const
+		{
+			typedef KeyOf<CallableObj1, Iter_t> Key_t;
+			typedef std::decay_t<decltype(*std::declval<Iter2_t>())> Value2_t;
+
+			std::vector<std::tuple<Key_t, Element_t, Linq<const Value2_t>>> result;
+			ForEachJoined<Index_t>(e, keySelector1, keySelector2, [&result](Key_t const& key, Element_t const& outer, Grouping<Value2_t> const& inners, size_t id)
+			{
+				result.emplace_back(key, outer, inners.Get(id));
+			});
+			return from_container(std::move(result));
+		}
+
+		template <typename Index_t, typename Iter2_t, typename CallableObj1, typename CallableObj2>
+		auto JoinImpl(LinqEnumerable<Iter2_t> const& e, CallableObj1& keySelector1, CallableObj2& keySelector2) const
+		{
+			typedef KeyOf<CallableObj1, Iter_t> Key_t;
+			typedef std::decay_t<decltype(*std::declval<Iter2_t>())> Value2_t;
+
+			std::vector<std::tuple<Key_t, Element_t, Value2_t>> result;
+			ForEachJoined<Index_t>(e, keySelector1, keySelector2, [&result](Key_t const& key, Element_t const& outer, Grouping<Value2_t> const& inners, size_t id)
+			{
+				const auto range = inners.GetRange(id);
+				for (auto i = range.first; i < range.second; ++i)
+				{
+					result.emplace_back(key, outer, (*inners.Values)[i]);
+				}
+			});
+			return from_container(std::move(result));
+		}
 	};
 
 	template <typename T>
@@ -1646,8 +2979,8 @@ namespace NatsuLib
 	public:
 		template <typename Iter_t>
 		Linq(LinqEnumerable<Iter_t> const& linqEnumerable)
-			: Base(detail_::CommonIterator<T>(linqEnumerable.begin()),
-				detail_::CommonIterator<T>(linqEnumerable.end()))
+			: Base(detail_::CommonIterator<T>(linqEnumerable.begin(), linqEnumerable.end()),
+				detail_::CommonIterator<T>(linqEnumerable.end(), detail_::EndIteratorTag), linqEnumerable.GetOwner())
 		{
 		}
 	};
@@ -1656,7 +2989,7 @@ namespace NatsuLib
 	LinqEnumerable<detail_::StorageIterator<Container>> from_pointertocontainer(std::shared_ptr<Container> const& pContainer)
 	{
 		return LinqEnumerable<detail_::StorageIterator<Container>>(detail_::StorageIterator<Container>(pContainer, std::begin(*pContainer)),
-			detail_::StorageIterator<Container>(pContainer, std::end(*pContainer)));
+			detail_::StorageIterator<Container>(pContainer, std::end(*pContainer)), pContainer);
 	}
 
 	template <typename Container>
@@ -1705,6 +3038,28 @@ namespace NatsuLib
 	{
 		return from(range.begin(), range.end());
 	}
+
+	///	@brief	以连续存储的数据创建 LinqEnumerable
+	///	@remark	不持有数据的所有权，迭代器为指针，因此 size、element_at 及 skip 均为常数时间
+	template <typename T>
+	LinqEnumerable<T*> from_span(T* data, size_t size)
+	{
+		return LinqEnumerable<T*>(data, data + size);
+	}
+
+	///	@brief	以具有 data 及 size 方法的连续容器（如 std::vector、std::array 及 StringView）创建 LinqEnumerable
+	///	@remark	不持有容器的所有权
+	template <typename Container>
+	auto from_view(Container& container) -> LinqEnumerable<std::remove_reference_t<decltype(*std::data(container))>*>
+	{
+		return from_span(std::data(container), std::size(container));
+	}
+
+	template <typename T, size_t size>
+	LinqEnumerable<T*> from_view(T (&array)[size])
+	{
+		return from_span(array, size);
+	}
 }
 
 #ifdef _MSC_VER
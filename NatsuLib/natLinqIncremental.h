@@ -0,0 +1,356 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+///	@file	natLinqIncremental.h
+///	@brief	可增量更新的语言集成查询视图
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "natLinq.h"
+
+namespace NatsuLib
+{
+	namespace detail_
+	{
+		template <typename T>
+		struct IncrementalSlot
+		{
+			std::optional<T> Value;
+			nBool IsAlive;
+		};
+
+		struct IncrementalSlotHasValue
+		{
+			template <typename T>
+			nBool operator()(IncrementalSlot<T> const& slot) const noexcept
+			{
+				return slot.Value.has_value();
+			}
+		};
+
+		struct IncrementalSlotValue
+		{
+			template <typename T>
+			T const& operator()(IncrementalSlot<T> const& slot) const noexcept
+			{
+				return *slot.Value;
+			}
+		};
+
+		template <typename View_t>
+		struct IncrementalHandleValue
+		{
+			const View_t* m_pView;
+
+			typename View_t::value_type const& operator()(typename View_t::Handle handle) const noexcept
+			{
+				return *m_pView->get(handle);
+			}
+		};
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	可增量更新的查询视图
+	///	@remark	每个插入的源元素只经过一次融合后的 where 及 select 阶段，结果按句柄保存，
+	///			移除源元素时只需按句柄删除对应的结果，不需要重新计算其他元素
+	///	@note	查询阶段需在插入元素之前构建，可调用对象应当是无副作用的
+	////////////////////////////////////////////////////////////////////////////////
+	template <typename Source_t, typename Stage_t = detail_::PushIdentityStage<Source_t const&>>
+	class IncrementalLinq
+	{
+	public:
+		typedef Source_t source_type;
+		typedef std::remove_cv_t<std::remove_reference_t<typename Stage_t::reference>> value_type;
+		typedef size_t Handle;
+
+		IncrementalLinq()
+			: m_Stage{}, m_Count{}, m_AliveCount{}
+		{
+		}
+
+		explicit IncrementalLinq(Stage_t stage)
+			: m_Stage(std::move(stage)), m_Count{}, m_AliveCount{}
+		{
+		}
+
+		template <typename CallableObj>
+		auto where(CallableObj&& callableObj) const
+		{
+			typedef detail_::PushWhereStage<Stage_t, std::decay_t<CallableObj>> NextStage_t;
+			CheckNoElement();
+			return IncrementalLinq<Source_t, NextStage_t>(NextStage_t{ m_Stage, std::forward<CallableObj>(callableObj) });
+		}
+
+		template <typename CallableObj>
+		auto select(CallableObj&& callableObj) const
+		{
+			typedef detail_::PushSelectStage<Stage_t, std::decay_t<CallableObj>> NextStage_t;
+			CheckNoElement();
+			return IncrementalLinq<Source_t, NextStage_t>(NextStage_t{ m_Stage, std::forward<CallableObj>(callableObj) });
+		}
+
+		///	@brief	以结果的键分组
+		///	@remark	分组随插入及移除增量维护
+		template <typename CallableObj>
+		auto group_by(CallableObj&& keySelector) const;
+
+		///	@brief	插入源元素
+		///	@return	用于移除此元素的句柄，被 where 过滤的元素同样会获得句柄
+		Handle insert(Source_t const& value)
+		{
+			std::optional<value_type> result;
+			auto sink = [&result](typename Stage_t::reference item) -> nBool
+			{
+				result.emplace(std::forward<typename Stage_t::reference>(item));
+				return false;
+			};
+			m_Stage.Push(value, sink);
+
+			Handle handle;
+			if (m_FreeHandles.empty())
+			{
+				handle = m_Slots.size();
+				m_Slots.emplace_back();
+			}
+			else
+			{
+				handle = m_FreeHandles.back();
+				m_FreeHandles.pop_back();
+			}
+
+			auto& slot = m_Slots[handle];
+			slot.Value = std::move(result);
+			slot.IsAlive = true;
+			if (slot.Value)
+			{
+				++m_Count;
+			}
+			++m_AliveCount;
+
+			return handle;
+		}
+
+		///	@brief	移除之前插入的源元素
+		void erase(Handle handle)
+		{
+			if (!contains(handle))
+			{
+				nat_Throw(natErrException, NatErr_InvalidArg, "Invalid handle."_nv);
+			}
+
+			auto& slot = m_Slots[handle];
+			if (slot.Value)
+			{
+				slot.Value.reset();
+				--m_Count;
+			}
+			slot.IsAlive = false;
+			--m_AliveCount;
+			m_FreeHandles.emplace_back(handle);
+		}
+
+		nBool contains(Handle handle) const noexcept
+		{
+			return handle < m_Slots.size() && m_Slots[handle].IsAlive;
+		}
+
+		///	@brief	获得源元素对应的结果
+		///	@return	元素被 where 过滤时返回 nullptr
+		value_type const* get(Handle handle) const
+		{
+			if (!contains(handle))
+			{
+				nat_Throw(natErrException, NatErr_InvalidArg, "Invalid handle."_nv);
+			}
+
+			auto const& value = m_Slots[handle].Value;
+			return value ? std::addressof(*value) : nullptr;
+		}
+
+		///	@brief	结果的数量
+		size_t size() const noexcept
+		{
+			return m_Count;
+		}
+
+		nBool empty() const noexcept
+		{
+			return !m_Count;
+		}
+
+		void clear() noexcept
+		{
+			m_Slots.clear();
+			m_FreeHandles.clear();
+			m_Count = 0;
+			m_AliveCount = 0;
+		}
+
+		///	@brief	以当前的结果创建 LinqEnumerable
+		///	@note	返回的 LinqEnumerable 不持有结果，插入元素后失效
+		auto results() const
+		{
+			return from_view(m_Slots).where(detail_::IncrementalSlotHasValue{}).select(detail_::IncrementalSlotValue{});
+		}
+
+	private:
+		Stage_t m_Stage;
+		std::vector<detail_::IncrementalSlot<value_type>> m_Slots;
+		std::vector<Handle> m_FreeHandles;
+		size_t m_Count;
+		size_t m_AliveCount;
+
+		void CheckNoElement() const
+		{
+			if (m_AliveCount)
+			{
+				nat_Throw(natErrException, NatErr_IllegalState, "Stages should be added before inserting any element."_nv);
+			}
+		}
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	可增量更新的分组
+	///	@remark	每个组以句柄数组保存，并记录每个句柄在组内的位置，插入及移除均为常数时间
+	///	@note	移除元素会改变组内元素的顺序
+	////////////////////////////////////////////////////////////////////////////////
+	template <typename View_t, typename KeySelector_t>
+	class IncrementalGroupBy
+	{
+	public:
+		typedef typename View_t::source_type source_type;
+		typedef typename View_t::value_type value_type;
+		typedef typename View_t::Handle Handle;
+		typedef std::decay_t<std::invoke_result_t<KeySelector_t const&, value_type const&>> key_type;
+
+		IncrementalGroupBy(View_t view, KeySelector_t keySelector)
+			: m_View(std::move(view)), m_KeySelector(std::move(keySelector))
+		{
+		}
+
+		Handle insert(source_type const& value)
+		{
+			const auto handle = m_View.insert(value);
+			if (const auto pValue = m_View.get(handle))
+			{
+				try
+				{
+					auto& group = m_Groups[m_KeySelector(*pValue)];
+					if (m_Positions.size() <= handle)
+					{
+						m_Positions.resize(handle + 1);
+					}
+					m_Positions[handle] = group.size();
+					group.emplace_back(handle);
+				}
+				catch (...)
+				{
+					m_View.erase(handle);
+					throw;
+				}
+			}
+			return handle;
+		}
+
+		void erase(Handle handle)
+		{
+			if (const auto pValue = m_View.get(handle))
+			{
+				const auto iter = m_Groups.find(m_KeySelector(*pValue));
+				assert(iter != m_Groups.end() && "Group not found.");
+
+				auto& group = iter->second;
+				const auto position = m_Positions[handle];
+				const auto last = group.back();
+				group[position] = last;
+				m_Positions[last] = position;
+				group.pop_back();
+				if (group.empty())
+				{
+					m_Groups.erase(iter);
+				}
+			}
+
+			m_View.erase(handle);
+		}
+
+		nBool contains(Handle handle) const noexcept
+		{
+			return m_View.contains(handle);
+		}
+
+		///	@brief	结果的数量
+		size_t size() const noexcept
+		{
+			return m_View.size();
+		}
+
+		size_t group_count() const noexcept
+		{
+			return m_Groups.size();
+		}
+
+		///	@brief	键为 key 的组中的元素数量
+		size_t count(key_type const& key) const
+		{
+			const auto iter = m_Groups.find(key);
+			return iter == m_Groups.end() ? 0 : iter->second.size();
+		}
+
+		///	@brief	当前所有组的键
+		///	@note	返回的 LinqEnumerable 不持有结果，插入或移除元素后失效
+		auto keys() const
+		{
+			return from(m_Groups).select(GroupKey{});
+		}
+
+		///	@brief	键为 key 的组中的元素，不存在时为空
+		///	@note	返回的 LinqEnumerable 不持有结果，插入或移除元素后失效
+		auto group(key_type const& key) const
+		{
+			const auto iter = m_Groups.find(key);
+			const auto handles = iter == m_Groups.end() ? from_span<const Handle>(nullptr, 0) : from_view(iter->second);
+			return handles.select(detail_::IncrementalHandleValue<View_t>{ &m_View });
+		}
+
+		View_t const& GetView() const noexcept
+		{
+			return m_View;
+		}
+
+	private:
+		typedef std::conditional_t<detail_::IsHashable<key_type>::value,
+			std::unordered_map<key_type, std::vector<Handle>>,
+			std::map<key_type, std::vector<Handle>>> GroupMap_t;
+
+		struct GroupKey
+		{
+			key_type const& operator()(typename GroupMap_t::value_type const& pair) const noexcept
+			{
+				return pair.first;
+			}
+		};
+
+		View_t m_View;
+		KeySelector_t m_KeySelector;
+		GroupMap_t m_Groups;
+		std::vector<size_t> m_Positions;
+	};
+
+	template <typename Source_t, typename Stage_t>
+	template <typename CallableObj>
+	auto IncrementalLinq<Source_t, Stage_t>::group_by(CallableObj&& keySelector) const
+	{
+		CheckNoElement();
+		return IncrementalGroupBy<IncrementalLinq, std::decay_t<CallableObj>>(*this, std::forward<CallableObj>(keySelector));
+	}
+
+	///	@brief	创建元素类型为 T 的增量视图
+	template <typename T>
+	IncrementalLinq<T> make_incremental()
+	{
+		return {};
+	}
+}
@@ -0,0 +1,790 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+///	@file	natLinqStream.h
+///	@brief	以流为源的语言集成查询及外部排序
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "natLinq.h"
+#include "natStream.h"
+#include "natStreamHelper.h"
+
+#ifdef _MSC_VER
+#	pragma push_macro("max")
+#	pragma push_macro("min")
+#endif
+
+#undef max
+#undef min
+
+namespace NatsuLib
+{
+	namespace detail_
+	{
+		///	@brief	读取直到读满 length 字节或到达流末尾
+		///	@return	实际读取的字节数
+		inline nLen ReadUpTo(natStream& stream, nData pData, nLen length)
+		{
+			nLen totalReadBytes{};
+			while (totalReadBytes < length)
+			{
+				const auto readBytes = stream.ReadBytes(pData + totalReadBytes, length - totalReadBytes);
+				if (!readBytes)
+				{
+					break;
+				}
+				totalReadBytes += readBytes;
+			}
+			return totalReadBytes;
+		}
+
+		///	@brief	读取一条完整的记录
+		///	@return	流在记录开始之前已结束时返回 false
+		///	@note	记录不完整时抛出异常
+		inline nBool ReadRecordBytes(natStream& stream, nData pData, nLen length)
+		{
+			const auto readBytes = ReadUpTo(stream, pData, length);
+			if (!readBytes && length)
+			{
+				return false;
+			}
+			if (readBytes < length)
+			{
+				nat_Throw(natErrException, NatErr_InternalErr, "Incomplete record ({0} bytes/{1} bytes requested) at the end of stream."_nv, readBytes, length);
+			}
+			return true;
+		}
+
+		///	@brief	带读缓冲的只读流
+		///	@remark	用于由解码器逐字段读取的场合，避免每次读取都访问内部流
+		class ReadBufferStream final
+			: public natRefObjImpl<ReadBufferStream, natWrappedStream>
+		{
+		public:
+			ReadBufferStream(natRefPointer<natStream> stream, size_t bufferSize)
+				: natRefObjImpl{ std::move(stream) }, m_Buffer(std::max(bufferSize, size_t{ 1 })), m_ReadPos{}, m_Count{}
+			{
+			}
+
+			nBool CanWrite() const override
+			{
+				return false;
+			}
+
+			nBool CanResize() const override
+			{
+				return false;
+			}
+
+			nBool IsEndOfStream() const override
+			{
+				return m_ReadPos == m_Count && m_InternalStream->IsEndOfStream();
+			}
+
+			void SetSize(nLen /*Size*/) override
+			{
+				nat_Throw(natErrException, NatErr_NotSupport, "This type of stream does not support SetSize."_nv);
+			}
+
+			nLen GetPosition() const override
+			{
+				return m_InternalStream->GetPosition() - (m_Count - m_ReadPos);
+			}
+
+			void SetPosition(NatSeek Origin, nLong Offset) override
+			{
+				if (Origin == NatSeek::Cur)
+				{
+					Offset -= static_cast<nLong>(m_Count - m_ReadPos);
+				}
+
+				m_ReadPos = m_Count = 0;
+				m_InternalStream->SetPosition(Origin, Offset);
+			}
+
+			nLen ReadBytes(nData pData, nLen Length) override
+			{
+				nLen totalReadBytes{};
+				while (totalReadBytes < Length)
+				{
+					if (m_ReadPos == m_Count)
+					{
+						// 大块的读取直接交给内部流
+						if (Length - totalReadBytes >= m_Buffer.size())
+						{
+							return totalReadBytes + m_InternalStream->ReadBytes(pData + totalReadBytes, Length - totalReadBytes);
+						}
+
+						m_ReadPos = 0;
+						m_Count = static_cast<size_t>(m_InternalStream->ReadBytes(m_Buffer.data(), m_Buffer.size()));
+						if (!m_Count)
+						{
+							break;
+						}
+					}
+
+					const auto copyBytes = static_cast<size_t>(std::min<nLen>(Length - totalReadBytes, m_Count - m_ReadPos));
+					std::memcpy(pData + totalReadBytes, m_Buffer.data() + m_ReadPos, copyBytes);
+					m_ReadPos += copyBytes;
+					totalReadBytes += copyBytes;
+				}
+
+				return totalReadBytes;
+			}
+
+			nLen WriteBytes(ncData /*pData*/, nLen /*Length*/) override
+			{
+				nat_Throw(natErrException, NatErr_NotSupport, "This stream cannot write."_nv);
+			}
+
+			void Flush() override
+			{
+			}
+
+		private:
+			std::vector<nByte> m_Buffer;
+			size_t m_ReadPos, m_Count;
+		};
+
+		///	@brief	带写缓冲的只写流
+		///	@note	析构时不会写出缓冲区中的内容，需显式调用 Flush
+		class WriteBufferStream final
+			: public natRefObjImpl<WriteBufferStream, natWrappedStream>
+		{
+		public:
+			WriteBufferStream(natRefPointer<natStream> stream, size_t bufferSize)
+				: natRefObjImpl{ std::move(stream) }, m_Buffer(std::max(bufferSize, size_t{ 1 })), m_Count{}
+			{
+			}
+
+			nBool CanRead() const override
+			{
+				return false;
+			}
+
+			nBool CanSeek() const override
+			{
+				return false;
+			}
+
+			nBool CanResize() const override
+			{
+				return false;
+			}
+
+			void SetSize(nLen /*Size*/) override
+			{
+				nat_Throw(natErrException, NatErr_NotSupport, "This type of stream does not support SetSize."_nv);
+			}
+
+			nLen GetPosition() const override
+			{
+				return m_InternalStream->GetPosition() + m_Count;
+			}
+
+			void SetPosition(NatSeek /*Origin*/, nLong /*Offset*/) override
+			{
+				nat_Throw(natErrException, NatErr_NotSupport, "This type of stream does not support SetPosition."_nv);
+			}
+
+			nLen ReadBytes(nData /*pData*/, nLen /*Length*/) override
+			{
+				nat_Throw(natErrException, NatErr_NotSupport, "This stream cannot read."_nv);
+			}
+
+			nLen WriteBytes(ncData pData, nLen Length) override
+			{
+				if (m_Count + Length > m_Buffer.size())
+				{
+					FlushBuffer();
+					if (Length >= m_Buffer.size())
+					{
+						m_InternalStream->ForceWriteBytes(pData, Length);
+						return Length;
+					}
+				}
+
+				std::memcpy(m_Buffer.data() + m_Count, pData, static_cast<size_t>(Length));
+				m_Count += static_cast<size_t>(Length);
+				return Length;
+			}
+
+			void Flush() override
+			{
+				FlushBuffer();
+				m_InternalStream->Flush();
+			}
+
+		private:
+			std::vector<nByte> m_Buffer;
+			size_t m_Count;
+
+			void FlushBuffer()
+			{
+				if (m_Count)
+				{
+					m_InternalStream->ForceWriteBytes(m_Buffer.data(), m_Count);
+					m_Count = 0;
+				}
+			}
+		};
+
+		template <typename T>
+		struct TrivialRecordDecoder
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "T should be trivially copyable.");
+
+			nBool operator()(natStream& stream, T& record) const
+			{
+				return ReadRecordBytes(stream, reinterpret_cast<nData>(std::addressof(record)), sizeof(T));
+			}
+		};
+
+		template <typename T, typename Decoder_t>
+		class StreamSourceState
+		{
+		public:
+			typedef std::input_iterator_tag iterator_category;
+			typedef T value_type;
+			typedef T& reference;
+
+			enum : size_t
+			{
+				DefaultBufferSize = 65536,
+			};
+
+			StreamSourceState(natRefPointer<natStream> pStream, Decoder_t decoder, size_t chunkSize)
+				: m_pStream{ std::move(pStream) }, m_Decoder(std::move(decoder)), m_ChunkSize{ std::max(chunkSize, size_t{ 1 }) },
+				m_StartPosition{ m_pStream->CanSeek() ? m_pStream->GetPosition() : 0 }, m_ChunkBase{}, m_IsExhausted{}
+			{
+				if constexpr (!IsTrivialDecoder)
+				{
+					m_pReader = make_ref<ReadBufferStream>(m_pStream, DefaultBufferSize);
+				}
+			}
+
+			nBool Ensure(size_t index)
+			{
+				if (index < m_ChunkBase)
+				{
+					Rewind();
+				}
+
+				while (index >= m_ChunkBase + m_Chunk.size())
+				{
+					if (m_IsExhausted)
+					{
+						return false;
+					}
+					Fill();
+				}
+
+				return true;
+			}
+
+			T& Get(size_t index) noexcept
+			{
+				return m_Chunk[index - m_ChunkBase];
+			}
+
+		private:
+			static constexpr nBool IsTrivialDecoder = std::is_same_v<Decoder_t, TrivialRecordDecoder<T>>;
+
+			natRefPointer<natStream> m_pStream;
+			natRefPointer<ReadBufferStream> m_pReader;
+			Decoder_t m_Decoder;
+			const size_t m_ChunkSize;
+			const nLen m_StartPosition;
+			std::vector<T> m_Chunk;
+			size_t m_ChunkBase;
+			nBool m_IsExhausted;
+
+			// 读取下一块记录，原有的记录将被丢弃
+			void Fill()
+			{
+				m_ChunkBase += m_Chunk.size();
+
+				if constexpr (IsTrivialDecoder)
+				{
+					// 平凡的记录可以直接整块读取
+					m_Chunk.resize(m_ChunkSize);
+					const auto length = static_cast<nLen>(m_ChunkSize * sizeof(T));
+					const auto readBytes = ReadUpTo(*m_pStream, reinterpret_cast<nData>(m_Chunk.data()), length);
+					if (readBytes % sizeof(T))
+					{
+						nat_Throw(natErrException, NatErr_InternalErr, "Incomplete record at the end of stream."_nv);
+					}
+					m_Chunk.resize(static_cast<size_t>(readBytes / sizeof(T)));
+					m_IsExhausted = readBytes < length;
+				}
+				else
+				{
+					m_Chunk.clear();
+					T record{};
+					while (m_Chunk.size() < m_ChunkSize)
+					{
+						if (!m_Decoder(static_cast<natStream&>(*m_pReader), record))
+						{
+							m_IsExhausted = true;
+							break;
+						}
+						m_Chunk.emplace_back(std::move(record));
+					}
+				}
+			}
+
+			void Rewind()
+			{
+				if (!m_pStream->CanSeek())
+				{
+					nat_Throw(natErrException, NatErr_IllegalState, "The stream cannot seek, the source can only be enumerated once."_nv);
+				}
+
+				if constexpr (IsTrivialDecoder)
+				{
+					m_pStream->SetPositionFromBegin(m_StartPosition);
+				}
+				else
+				{
+					m_pReader->SetPositionFromBegin(m_StartPosition);
+				}
+
+				m_Chunk.clear();
+				m_ChunkBase = 0;
+				m_IsExhausted = false;
+			}
+		};
+
+		template <StringType encoding>
+		class LineSourceState
+		{
+		public:
+			typedef std::input_iterator_tag iterator_category;
+			typedef String<encoding> value_type;
+			typedef String<encoding> const& reference;
+
+			LineSourceState(natStreamReader<encoding>* pReader, natRefPointer<natStreamReader<encoding>> pOwner) noexcept
+				: m_pReader{ pReader }, m_pOwner{ std::move(pOwner) }, m_ReadLines{}, m_IsExhausted{}
+			{
+			}
+
+			nBool Ensure(size_t index)
+			{
+				if (index + 1 < m_ReadLines)
+				{
+					nat_Throw(natErrException, NatErr_IllegalState, "Lines that have been read cannot be enumerated again."_nv);
+				}
+
+				while (m_ReadLines <= index)
+				{
+					if (m_IsExhausted || !m_pReader->TryReadLine(m_Line))
+					{
+						m_IsExhausted = true;
+						return false;
+					}
+					++m_ReadLines;
+				}
+
+				return true;
+			}
+
+			String<encoding> const& Get(size_t /*index*/) const noexcept
+			{
+				return m_Line;
+			}
+
+		private:
+			natStreamReader<encoding>* m_pReader;
+			natRefPointer<natStreamReader<encoding>> m_pOwner;
+			String<encoding> m_Line;
+			size_t m_ReadLines;
+			nBool m_IsExhausted;
+		};
+	}
+
+	///	@brief	元素写入临时流及从中读回的方式，用于外部排序
+	///	@remark	默认支持可平凡复制的类型及 String，其他类型可以特化此模板
+	template <typename T, typename = void>
+	struct LinqSpillCodec;
+
+	template <typename T>
+	struct LinqSpillCodec<T, std::enable_if_t<std::is_trivially_copyable_v<T>>>
+	{
+		///	@brief	元素在内存中占用的大小
+		static size_t GetSize(T const& /*value*/) noexcept
+		{
+			return sizeof(T);
+		}
+
+		static void Write(natStream& stream, T const& value)
+		{
+			stream.ForceWriteBytes(reinterpret_cast<ncData>(std::addressof(value)), sizeof(T));
+		}
+
+		///	@return	已到达流末尾时返回 false
+		static nBool Read(natStream& stream, T& value)
+		{
+			return detail_::ReadRecordBytes(stream, reinterpret_cast<nData>(std::addressof(value)), sizeof(T));
+		}
+	};
+
+	template <StringType encoding>
+	struct LinqSpillCodec<String<encoding>>
+	{
+		typedef typename StringEncodingTrait<encoding>::CharType CharType;
+
+		static size_t GetSize(String<encoding> const& value) noexcept
+		{
+			return sizeof(String<encoding>) + value.size() * sizeof(CharType);
+		}
+
+		static void Write(natStream& stream, String<encoding> const& value)
+		{
+			const auto length = static_cast<nuLong>(value.size());
+			stream.ForceWriteBytes(reinterpret_cast<ncData>(&length), sizeof length);
+			if (length)
+			{
+				stream.ForceWriteBytes(reinterpret_cast<ncData>(value.data()), length * sizeof(CharType));
+			}
+		}
+
+		static nBool Read(natStream& stream, String<encoding>& value)
+		{
+			nuLong length;
+			if (!detail_::ReadRecordBytes(stream, reinterpret_cast<nData>(&length), sizeof length))
+			{
+				return false;
+			}
+
+			value.Resize(static_cast<size_t>(length));
+			if (length && !detail_::ReadRecordBytes(stream, reinterpret_cast<nData>(value.data()), length * sizeof(CharType)))
+			{
+				nat_Throw(natErrException, NatErr_InternalErr, "Incomplete string at the end of stream."_nv);
+			}
+			return true;
+		}
+	};
+
+	namespace detail_
+	{
+		///	@brief	外部排序的状态
+		///	@remark	首次访问时读取源并排序：元素的估计大小累计超过内存预算时，将已读取的部分稳定排序后作为一个分段写入临时文件，
+		///			最后以堆对各分段进行多路归并，归并时每个分段只保留一个读缓冲区；未超过预算时直接在内存中排序
+		template <typename Iter_t, typename CallableObj_t, nBool Descending>
+		class ExternalSortState
+		{
+		public:
+			typedef std::input_iterator_tag iterator_category;
+			typedef typename std::iterator_traits<Iter_t>::value_type value_type;
+			typedef value_type const& reference;
+
+			enum : size_t
+			{
+				WriteBufferSize = 65536,
+				MinReadBufferSize = 4096,
+			};
+
+			ExternalSortState(Iter_t begin, Iter_t end, std::shared_ptr<const void> pOwner, CallableObj_t callableObj, size_t memoryBudget)
+				: m_Begin(std::move(begin)), m_End(std::move(end)), m_pOwner{ std::move(pOwner) }, m_CallableObj(std::move(callableObj)), m_MemoryBudget{ memoryBudget }, m_IsSorted{}, m_Merged{}
+			{
+			}
+
+			nBool Ensure(size_t index)
+			{
+				if (!m_IsSorted)
+				{
+					Sort();
+				}
+
+				if (m_Runs.empty())
+				{
+					return index < m_Elements.size();
+				}
+
+				// 归并结果只保留当前的元素，回到之前的位置时需要重新归并
+				if (index + 1 < m_Merged)
+				{
+					StartMerge();
+				}
+
+				while (m_Merged <= index)
+				{
+					if (!MergeNext())
+					{
+						return false;
+					}
+					++m_Merged;
+				}
+
+				return true;
+			}
+
+			value_type const& Get(size_t index) const noexcept
+			{
+				return m_Runs.empty() ? m_Elements[index] : m_Current;
+			}
+
+			///	@brief	写入临时文件的分段数，未溢出到磁盘时为 0
+			size_t GetRunCount() const noexcept
+			{
+				return m_Runs.size();
+			}
+
+		private:
+			typedef LinqSpillCodec<value_type> Codec;
+			typedef std::decay_t<std::invoke_result_t<CallableObj_t const&, value_type const&>> Key_t;
+
+			struct Run
+			{
+				nLen Begin, End;
+				natRefPointer<natStream> Reader;
+				value_type Current;
+				Key_t Key;
+			};
+
+			Iter_t m_Begin, m_End;
+			std::shared_ptr<const void> m_pOwner;
+			CallableObj_t m_CallableObj;
+			const size_t m_MemoryBudget;
+			nBool m_IsSorted;
+
+			std::vector<value_type> m_Elements;
+
+			natRefPointer<natStream> m_pSpillStream;
+			std::vector<Run> m_Runs;
+			std::vector<size_t> m_Heap;
+			value_type m_Current;
+			size_t m_Merged;
+
+			static nBool KeyLess(Key_t const& a, Key_t const& b)
+			{
+				if constexpr (Descending)
+				{
+					return b < a;
+				}
+				else
+				{
+					return a < b;
+				}
+			}
+
+			void Sort()
+			{
+				size_t usage{};
+				for (auto iter = m_Begin; iter != m_End; ++iter)
+				{
+					m_Elements.emplace_back(*iter);
+					usage += Codec::GetSize(m_Elements.back()) + sizeof(Key_t) + sizeof(size_t);
+					if (usage >= m_MemoryBudget)
+					{
+						SpillRun();
+						usage = 0;
+					}
+				}
+
+				if (m_Runs.empty())
+				{
+					m_Elements = SortElements();
+				}
+				else
+				{
+					if (!m_Elements.empty())
+					{
+						SpillRun();
+					}
+					m_Elements.clear();
+					m_Elements.shrink_to_fit();
+					StartMerge();
+				}
+
+				m_IsSorted = true;
+			}
+
+			std::vector<value_type> SortElements()
+			{
+				std::vector<Key_t> keys;
+				keys.reserve(m_Elements.size());
+				for (auto const& item : m_Elements)
+				{
+					keys.emplace_back(m_CallableObj(item));
+				}
+
+				std::vector<size_t> order(m_Elements.size());
+				for (size_t i = 0; i < order.size(); ++i)
+				{
+					order[i] = i;
+				}
+				std::stable_sort(order.begin(), order.end(), [&keys](size_t a, size_t b)
+				{
+					return KeyLess(keys[a], keys[b]);
+				});
+
+				std::vector<value_type> result;
+				result.reserve(m_Elements.size());
+				for (const auto index : order)
+				{
+					result.emplace_back(std::move(m_Elements[index]));
+				}
+				return result;
+			}
+
+			void SpillRun()
+			{
+				const auto sorted = SortElements();
+				m_Elements.clear();
+
+				if (!m_pSpillStream)
+				{
+					m_pSpillStream = natFileStream::CreateTemporary();
+				}
+
+				Run run{};
+				run.Begin = m_pSpillStream->GetPosition();
+				const auto writer = make_ref<WriteBufferStream>(m_pSpillStream, WriteBufferSize);
+				for (auto const& item : sorted)
+				{
+					Codec::Write(*writer, item);
+				}
+				writer->Flush();
+				run.End = m_pSpillStream->GetPosition();
+				m_Runs.emplace_back(std::move(run));
+			}
+
+			// 分段编号较小的元素在源中也较靠前，键相等时优先取出以保持稳定
+			nBool RunBefore(size_t a, size_t b) const
+			{
+				auto const& runA = m_Runs[a];
+				auto const& runB = m_Runs[b];
+				if (KeyLess(runA.Key, runB.Key))
+				{
+					return true;
+				}
+				if (KeyLess(runB.Key, runA.Key))
+				{
+					return false;
+				}
+				return a < b;
+			}
+
+			nBool AdvanceRun(size_t index)
+			{
+				auto& run = m_Runs[index];
+				if (!Codec::Read(*run.Reader, run.Current))
+				{
+					run.Reader = nullptr;
+					return false;
+				}
+				run.Key = m_CallableObj(static_cast<value_type const&>(run.Current));
+				return true;
+			}
+
+			void StartMerge()
+			{
+				const auto bufferSize = std::max(m_MemoryBudget / m_Runs.size(), static_cast<size_t>(MinReadBufferSize));
+				const auto heapCompare = [this](size_t a, size_t b)
+				{
+					return RunBefore(b, a);
+				};
+
+				m_Heap.clear();
+				for (size_t i = 0; i < m_Runs.size(); ++i)
+				{
+					auto& run = m_Runs[i];
+					run.Reader = make_ref<ReadBufferStream>(make_ref<natSubStream>(m_pSpillStream, run.Begin, run.End), bufferSize);
+					if (AdvanceRun(i))
+					{
+						m_Heap.emplace_back(i);
+					}
+				}
+				std::make_heap(m_Heap.begin(), m_Heap.end(), heapCompare);
+				m_Merged = 0;
+			}
+
+			nBool MergeNext()
+			{
+				if (m_Heap.empty())
+				{
+					return false;
+				}
+
+				const auto heapCompare = [this](size_t a, size_t b)
+				{
+					return RunBefore(b, a);
+				};
+
+				std::pop_heap(m_Heap.begin(), m_Heap.end(), heapCompare);
+				const auto index = m_Heap.back();
+				m_Current = std::move(m_Runs[index].Current);
+				if (AdvanceRun(index))
+				{
+					std::push_heap(m_Heap.begin(), m_Heap.end(), heapCompare);
+				}
+				else
+				{
+					m_Heap.pop_back();
+				}
+
+				return true;
+			}
+		};
+	}
+
+	///	@brief	以流中的记录创建 LinqEnumerable
+	///	@param[in]	pStream		源流，从当前位置开始读取
+	///	@param[in]	decoder		解码器，以 nBool(natStream&, T&) 的形式调用，到达流末尾时返回 false，默认将记录视为平凡的二进制数据
+	///	@param[in]	chunkSize	每次读入内存的记录数
+	///	@remark	记录按块延迟读取，take、first 等操作在得到结果后即停止读取；
+	///			可以查找的流在被再次遍历时会回到起始位置重新读取，否则只能遍历一次
+	///	@note	迭代器得到的引用只在遍历到下一块之前有效
+	template <typename T, typename Decoder = detail_::TrivialRecordDecoder<T>>
+	auto from_stream(natRefPointer<natStream> pStream, Decoder decoder = {}, size_t chunkSize = 1024)
+	{
+		typedef detail_::StreamSourceState<T, Decoder> State_t;
+		typedef detail_::PullIterator<State_t> Iterator_t;
+
+		if (!pStream || !pStream->CanRead())
+		{
+			nat_Throw(natErrException, NatErr_InvalidArg, "pStream should be a readable stream."_nv);
+		}
+
+		const auto pState = std::make_shared<State_t>(std::move(pStream), std::move(decoder), chunkSize);
+		return LinqEnumerable<Iterator_t>(Iterator_t{ pState.get() }, Iterator_t{}, pState);
+	}
+
+	///	@brief	以读取器中剩余的各行创建 LinqEnumerable
+	///	@remark	行按需读取，只能遍历一次
+	///	@note	不持有读取器的所有权
+	template <StringType encoding>
+	auto from_lines(natStreamReader<encoding>& reader)
+	{
+		typedef detail_::LineSourceState<encoding> State_t;
+		typedef detail_::PullIterator<State_t> Iterator_t;
+
+		const auto pState = std::make_shared<State_t>(&reader, nullptr);
+		return LinqEnumerable<Iterator_t>(Iterator_t{ pState.get() }, Iterator_t{}, pState);
+	}
+
+	template <StringType encoding>
+	auto from_lines(natRefPointer<natStreamReader<encoding>> pReader)
+	{
+		typedef detail_::LineSourceState<encoding> State_t;
+		typedef detail_::PullIterator<State_t> Iterator_t;
+
+		if (!pReader)
+		{
+			nat_Throw(natErrException, NatErr_InvalidArg, "pReader cannot be nullptr."_nv);
+		}
+
+		const auto pRawReader = pReader.Get();
+		const auto pState = std::make_shared<State_t>(pRawReader, std::move(pReader));
+		return LinqEnumerable<Iterator_t>(Iterator_t{ pState.get() }, Iterator_t{}, pState);
+	}
+}
+
+#ifdef _MSC_VER
+#	pragma pop_macro("min")
+#	pragma pop_macro("max")
+#endif
@@ -1,24 +1,48 @@
-#include "stdafx.h"
+﻿#include "stdafx.h"
 #include "natLog.h"
 
 using namespace NatsuLib;
 
 natLog::natLog(natEventBus& eventBus)
-	: m_EventBus(eventBus)
+	: m_EventBus(eventBus), m_Backend{}, m_Level{ LogLevel::Info }
 {
 	m_EventBus.RegisterEvent<EventLogUpdated>();
 }
 
+natLog::natLog(natEventBus& eventBus, natThreadPool& dispatcher, AsyncEventOptions const& options)
+	: m_EventBus(eventBus), m_Backend{}, m_Level{ LogLevel::Info }
+{
+	m_EventBus.RegisterEvent<EventLogUpdated>(dispatcher, options);
+}
+
 natLog::~natLog()
 {
+	m_EventBus.FlushAsyncEvent<EventLogUpdated>();
 }
 
 void natLog::UpdateLog(nuInt type, nString&& log)
 {
-	EventLogUpdated event(type, std::chrono::system_clock::now(), log);
+	EventLogUpdated event(type, std::chrono::system_clock::now(), std::move(log));
 	m_EventBus.Post(event);
 }
 
+void natLog::UseBackend(natAsyncLogBackend* backend) noexcept
+{
+	m_Backend = backend;
+}
+
+natRefPointer<natLogCategory> natLog::GetCategory(nStrView name)
+{
+	natRefScopeGuard<natCriticalSection> guard{ m_Section };
+	auto& category = m_Categories[name];
+	if (!category)
+	{
+		category = make_ref<natLogCategory>(*this, name, GetLevel());
+	}
+
+	return category;
+}
+
 nStrView natLog::GetDefaultLogTypeName(LogType logtype)
 {
 	switch (logtype)
@@ -29,6 +53,8 @@ nStrView natLog::GetDefaultLogTypeName(LogType logtype)
 		return "Error"_nv;
 	case Warn:
 		return "Warning"_nv;
+	case Debug:
+		return "Debug"_nv;
 	default:
 		return "Unknown"_nv;
 	}
@@ -38,3 +64,8 @@ void natLog::RegisterLogUpdateEventFunc(natEventBus::EventListenerDelegate func)
 {
 	m_EventBus.RegisterEventListener<EventLogUpdated>(func);
 }
+
+natLogCategory::natLogCategory(natLog& log, nStrView name, LogLevel level)
+	: m_Log(log), m_Name(name), m_Level{ level }
+{
+}
@@ -7,11 +7,28 @@
 #include <chrono>
 #include <iostream>
 
+#include "natConfig.h"
 #include "natEvent.h"
 #include "natConsole.h"
+#include "natLogBackend.h"
 
 namespace NatsuLib
 {
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	日志级别
+	///	@remark	级别低于阈值的日志在格式化之前即被丢弃
+	////////////////////////////////////////////////////////////////////////////////
+	enum class LogLevel : nuInt
+	{
+		Debug,		///< @brief	调试
+		Info,		///< @brief	信息
+		Warning,	///< @brief	警告
+		Error,		///< @brief	错误
+		Off,		///< @brief	不记录任何日志
+	};
+
+	class natLogCategory;
+
 	////////////////////////////////////////////////////////////////////////////////
 	///	@brief	日志类实现
 	////////////////////////////////////////////////////////////////////////////////
@@ -22,8 +39,8 @@ namespace NatsuLib
 			: public natEventBase
 		{
 		public:
-			EventLogUpdated(nuInt logType, std::chrono::system_clock::time_point const& time, nStrView data) noexcept
-				: m_LogType(logType), m_Time(time), m_Data(data)
+			EventLogUpdated(nuInt logType, std::chrono::system_clock::time_point const& time, nString data) noexcept
+				: m_LogType(logType), m_Time(time), m_Data(std::move(data))
 			{
 			}
 
@@ -50,48 +67,135 @@ namespace NatsuLib
 		private:
 			nuInt m_LogType;
 			std::chrono::system_clock::time_point m_Time;
-			nStrView m_Data;
+			nString m_Data;
 		};
 
 		///	@brief	预置日志类型
+		///	@remark	自定义的日志类型从 3 开始，Debug 使用最大值以免与已有的自定义类型冲突
 		enum LogType : nuInt
 		{
 			Msg,	///< @brief	消息
 			Err,	///< @brief	错误
-			Warn	///< @brief	警告
+			Warn,	///< @brief	警告
+
+			Debug = static_cast<nuInt>(-1),	///< @brief	调试
 		};
 
+		///	@brief	编译期的最低日志级别，由 NatLogMinLevel 指定
+		///	@remark	低于此级别的 LogDebug 等调用及 nat_LogDebug 等宏不生成代码
+		static constexpr LogLevel MinLogLevel = static_cast<LogLevel>(NatLogMinLevel);
+
+		///	@brief	获得日志类型对应的级别
+		///	@remark	自定义的日志类型视为 LogLevel::Info
+		static constexpr LogLevel GetLogLevel(nuInt type) noexcept
+		{
+			switch (type)
+			{
+			case Debug:
+				return LogLevel::Debug;
+			case Warn:
+				return LogLevel::Warning;
+			case Err:
+				return LogLevel::Error;
+			default:
+				return LogLevel::Info;
+			}
+		}
+
+		///	@brief	该级别的日志是否被编译
+		static constexpr nBool IsCompiledIn(LogLevel level) noexcept
+		{
+			return level != LogLevel::Off && level >= MinLogLevel;
+		}
+
 		explicit natLog(natEventBus& eventBus);
+
+		///	@brief	以异步方式分发日志更新事件
+		///	@remark	记录日志的线程仅将事件放入队列，由 dispatcher 中的线程调用日志更新事件处理函数
+		///	@note	析构时将等待已记录的日志处理完毕，处理函数引用的对象需比 natLog 存活更久
+		natLog(natEventBus& eventBus, natThreadPool& dispatcher, AsyncEventOptions const& options = {});
 		~natLog();
 
+		///	@brief	记录调试信息
+		template <typename... Arg>
+		void LogDebug(nStrView content, Arg &&... arg)
+		{
+			if constexpr (IsCompiledIn(LogLevel::Debug))
+			{
+				Log(Debug, content, std::forward<Arg>(arg)...);
+			}
+		}
+
 		///	@brief	记录信息
 		template <typename... Arg>
 		void LogMsg(nStrView content, Arg &&... arg)
 		{
-			Log(Msg, content, std::forward<Arg>(arg)...);
+			if constexpr (IsCompiledIn(LogLevel::Info))
+			{
+				Log(Msg, content, std::forward<Arg>(arg)...);
+			}
 		}
 
 		///	@brief	记录错误
 		template <typename... Arg>
 		void LogErr(nStrView content, Arg &&... arg)
 		{
-			Log(Err, content, std::forward<Arg>(arg)...);
+			if constexpr (IsCompiledIn(LogLevel::Error))
+			{
+				Log(Err, content, std::forward<Arg>(arg)...);
+			}
 		}
 
 		///	@brief	记录警告
 		template <typename... Arg>
 		void LogWarn(nStrView content, Arg &&... arg)
 		{
-			Log(Warn, content, std::forward<Arg>(arg)...);
+			if constexpr (IsCompiledIn(LogLevel::Warning))
+			{
+				Log(Warn, content, std::forward<Arg>(arg)...);
+			}
 		}
 
 		///	@brief	记录
+		///	@remark	级别低于阈值时不进行格式化，但参数仍会被求值，需要避免求值时请使用 nat_Log 等宏
 		template <typename... Arg>
 		void Log(nuInt type, nStrView content, Arg &&... arg)
 		{
-			UpdateLog(type, natUtil::FormatString(content, std::forward<Arg>(arg)...));
+			if (IsEnabled(type))
+			{
+				record(type, content, std::forward<Arg>(arg)...);
+			}
+		}
+
+		///	@brief	设置运行时的日志级别阈值，默认为 LogLevel::Info
+		///	@remark	仅影响直接通过本对象记录的日志，分类的阈值由 natLogCategory 单独设置
+		void SetLevel(LogLevel level) noexcept
+		{
+			m_Level.store(level, std::memory_order_relaxed);
+		}
+
+		LogLevel GetLevel() const noexcept
+		{
+			return m_Level.load(std::memory_order_relaxed);
+		}
+
+		///	@brief	该类型的日志是否会被记录
+		nBool IsEnabled(nuInt type) const noexcept
+		{
+			const auto level = GetLogLevel(type);
+			return IsCompiledIn(level) && level >= m_Level.load(std::memory_order_relaxed);
 		}
 
+		///	@brief	获得指定名称的日志分类
+		///	@remark	首次获得时创建，其阈值为当时本对象的阈值，之后返回同一对象，可缓存以避免查找
+		natRefPointer<natLogCategory> GetCategory(nStrView name);
+
+		///	@brief	使用异步日志后端
+		///	@remark	之后记录的日志不在当前线程格式化，而是交给 backend 格式化后写入其输出目标，
+		///			不再触发日志更新事件，传入 nullptr 以恢复原来的行为
+		///	@note	backend 需比 natLog 存活更久，不应在其他线程记录日志时调用
+		void UseBackend(natAsyncLogBackend* backend) noexcept;
+
 		///	@brief	注册日志更新事件处理函数
 		void RegisterLogUpdateEventFunc(natEventBus::EventListenerDelegate func);
 
@@ -137,6 +241,7 @@ namespace NatsuLib
 				{
 				case Msg:
 				case Warn:
+				case Debug:
 					console.WriteLine(logStr);
 					OutputToOStream::Impl(logStr, ostreams...);
 					break;
@@ -153,7 +258,117 @@ namespace NatsuLib
 		static nStrView GetDefaultLogTypeName(LogType logtype);
 
 	private:
+		friend class natLogCategory;
+
+		template <typename... Arg>
+		void record(nuInt type, nStrView content, Arg &&... arg)
+		{
+			if (m_Backend)
+			{
+				m_Backend->Record(type, content, std::forward<Arg>(arg)...);
+				return;
+			}
+
+			UpdateLog(type, natUtil::FormatString(content, std::forward<Arg>(arg)...));
+		}
+
 		void UpdateLog(nuInt type, nString&& log);
 		natEventBus& m_EventBus;
+		natAsyncLogBackend* m_Backend;
+		std::atomic<LogLevel> m_Level;
+		natCriticalSection m_Section;
+		FlatHashMap<nString, natRefPointer<natLogCategory>> m_Categories;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	日志分类
+	///	@remark	拥有独立的运行时阈值，记录的日志交给所属的 natLog 输出，
+	///			检查阈值仅需一次原子读取，被过滤的日志不会被格式化
+	///	@note	通过 natLog::GetCategory 获得，所属的 natLog 需比分类存活更久
+	////////////////////////////////////////////////////////////////////////////////
+	class natLogCategory final
+		: public natRefObjImpl<natLogCategory>
+	{
+	public:
+		natLogCategory(natLog& log, nStrView name, LogLevel level);
+
+		nStrView GetName() const noexcept
+		{
+			return m_Name;
+		}
+
+		void SetLevel(LogLevel level) noexcept
+		{
+			m_Level.store(level, std::memory_order_relaxed);
+		}
+
+		LogLevel GetLevel() const noexcept
+		{
+			return m_Level.load(std::memory_order_relaxed);
+		}
+
+		nBool IsEnabled(nuInt type) const noexcept
+		{
+			const auto level = natLog::GetLogLevel(type);
+			return natLog::IsCompiledIn(level) && level >= m_Level.load(std::memory_order_relaxed);
+		}
+
+		template <typename... Arg>
+		void LogDebug(nStrView content, Arg &&... arg)
+		{
+			if constexpr (natLog::IsCompiledIn(LogLevel::Debug))
+			{
+				Log(natLog::Debug, content, std::forward<Arg>(arg)...);
+			}
+		}
+
+		template <typename... Arg>
+		void LogMsg(nStrView content, Arg &&... arg)
+		{
+			if constexpr (natLog::IsCompiledIn(LogLevel::Info))
+			{
+				Log(natLog::Msg, content, std::forward<Arg>(arg)...);
+			}
+		}
+
+		template <typename... Arg>
+		void LogErr(nStrView content, Arg &&... arg)
+		{
+			if constexpr (natLog::IsCompiledIn(LogLevel::Error))
+			{
+				Log(natLog::Err, content, std::forward<Arg>(arg)...);
+			}
+		}
+
+		template <typename... Arg>
+		void LogWarn(nStrView content, Arg &&... arg)
+		{
+			if constexpr (natLog::IsCompiledIn(LogLevel::Warning))
+			{
+				Log(natLog::Warn, content, std::forward<Arg>(arg)...);
+			}
+		}
+
+		template <typename... Arg>
+		void Log(nuInt type, nStrView content, Arg &&... arg)
+		{
+			if (IsEnabled(type))
+			{
+				m_Log.record(type, content, std::forward<Arg>(arg)...);
+			}
+		}
+
+	private:
+		natLog& m_Log;
+		const nString m_Name;
+		std::atomic<LogLevel> m_Level;
 	};
 }
+
+///	@brief	仅在日志会被记录时才对参数求值的记录
+///	@remark	logger 可为 natLog 或 natLogCategory，type 为常量且低于 NatLogMinLevel 时不生成代码，logger 及 type 只求值一次
+#define nat_Log(logger, type, ...) do { const auto natLogType_ = (type); if (::NatsuLib::natLog::IsCompiledIn(::NatsuLib::natLog::GetLogLevel(natLogType_))) { auto&& natLogger_ = (logger); if (natLogger_.IsEnabled(natLogType_)) natLogger_.Log(natLogType_, __VA_ARGS__); } } while (false)
+#define nat_LogDebug(logger, ...) do { if constexpr (::NatsuLib::natLog::IsCompiledIn(::NatsuLib::LogLevel::Debug)) { auto&& natLogger_ = (logger); if (natLogger_.IsEnabled(::NatsuLib::natLog::Debug)) natLogger_.LogDebug(__VA_ARGS__); } } while (false)
+#define nat_LogMsg(logger, ...) do { if constexpr (::NatsuLib::natLog::IsCompiledIn(::NatsuLib::LogLevel::Info)) { auto&& natLogger_ = (logger); if (natLogger_.IsEnabled(::NatsuLib::natLog::Msg)) natLogger_.LogMsg(__VA_ARGS__); } } while (false)
+#define nat_LogWarn(logger, ...) do { if constexpr (::NatsuLib::natLog::IsCompiledIn(::NatsuLib::LogLevel::Warning)) { auto&& natLogger_ = (logger); if (natLogger_.IsEnabled(::NatsuLib::natLog::Warn)) natLogger_.LogWarn(__VA_ARGS__); } } while (false)
+#define nat_LogErr(logger, ...) do { if constexpr (::NatsuLib::natLog::IsCompiledIn(::NatsuLib::LogLevel::Error)) { auto&& natLogger_ = (logger); if (natLogger_.IsEnabled(::NatsuLib::natLog::Err)) natLogger_.LogErr(__VA_ARGS__); } } while (false)
@@ -0,0 +1,611 @@
+﻿#include "stdafx.h"
+#include "natLogBackend.h"
+#include "natConsole.h"
+#include "natCompression.h"
+#include "natLog.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <string_view>
+
+using namespace NatsuLib;
+
+namespace
+{
+	std::atomic<nuLong> s_NextBackendID{};
+
+	// 当前线程在各日志后端中的缓冲区，线程结束时通知后端在读取完毕后移除
+	struct ThreadLogBuffers
+	{
+		~ThreadLogBuffers()
+		{
+			for (auto&& item : Buffers)
+			{
+				item.second->Abandoned.store(true, std::memory_order_release);
+			}
+		}
+
+		std::vector<std::pair<nuLong, natRefPointer<detail_::LogRingBuffer>>> Buffers;
+	};
+
+	thread_local ThreadLogBuffers t_LogBuffers;
+
+	// 环形缓冲区的容量需为 2 的幂，不小于 4096
+	std::size_t RoundUpBufferSize(std::size_t bufferSize) noexcept
+	{
+		std::size_t size = 4096;
+		while (size < bufferSize)
+		{
+			size <<= 1;
+		}
+		return size;
+	}
+
+	std::filesystem::path ToPath(nStrView path)
+	{
+		return std::filesystem::u8path(path.begin(), path.end());
+	}
+
+	nString FromPath(std::filesystem::path const& path)
+	{
+		const auto u8Path = path.u8string();
+		return nStrView{ u8Path.data(), u8Path.size() };
+	}
+
+	natRefPointer<natStream> CreateFileForWrite(nStrView path)
+	{
+#ifdef _WIN32
+		auto file = make_ref<natFileStream>(path, false, true);
+		file->SetSize(0);
+		return file;
+#else
+		return make_ref<natFileStream>(path, false, true, true);
+#endif
+	}
+
+	// 将轮换出的文件压缩为 "文件名.zip"，成功后删除原文件
+	void CompressLogSegment(std::filesystem::path const& segment)
+	{
+		auto archivePath = segment;
+		archivePath += ".zip";
+		const auto archiveName = FromPath(archivePath);
+
+		try
+		{
+			const auto source = make_ref<natFileStream>(FromPath(segment), true, false);
+			{
+				natZipArchive archive{ CreateFileForWrite(archiveName), natZipArchive::ZipArchiveMode::Create };
+				const auto entry = archive.CreateEntry(FromPath(segment.filename()));
+				source->CopyTo(entry->Open());
+			}
+		}
+		catch (...)
+		{
+			// 保留未压缩的文件
+			std::error_code ec;
+			std::filesystem::remove(archivePath, ec);
+			return;
+		}
+
+		std::error_code ec;
+		std::filesystem::remove(segment, ec);
+	}
+
+	// 按修改时间从旧到新删除轮换出的文件，直到总大小不超过 maxTotalSize
+	// 判断文件名是否为轮换出的分段，即 "主文件名.YYYYmmdd-HHMMSS.序号扩展名"，压缩后再加上 ".zip"
+	nBool IsLogSegmentName(std::string_view name, std::string_view stem, std::string_view extension)
+	{
+		constexpr std::string_view archiveExtension = ".zip";
+		const auto removeSuffix = [&name](std::string_view suffix)
+		{
+			if (name.size() < suffix.size() || name.substr(name.size() - suffix.size()) != suffix)
+			{
+				return false;
+			}
+			name.remove_suffix(suffix.size());
+			return true;
+		};
+		const auto isDigits = [](std::string_view str)
+		{
+			return !str.empty() && std::all_of(str.begin(), str.end(), [](char c) { return c >= '0' && c <= '9'; });
+		};
+
+		removeSuffix(archiveExtension);
+		if (!removeSuffix(extension) || name.substr(0, stem.size()) != stem)
+		{
+			return false;
+		}
+		name.remove_prefix(stem.size());
+
+		// 剩余部分为 ".YYYYmmdd-HHMMSS.序号"
+		constexpr std::size_t TimeLength = 15;
+		return name.size() > TimeLength + 2 && name[0] == '.' && name[9] == '-' && name[TimeLength + 1] == '.' &&
+			isDigits(name.substr(1, 8)) && isDigits(name.substr(10, 6)) && isDigits(name.substr(TimeLength + 2));
+	}
+
+	void EnforceLogSizeLimit(std::filesystem::path const& activePath, nLen maxTotalSize)
+	{
+		if (!maxTotalSize)
+		{
+			return;
+		}
+
+		std::error_code ec;
+		auto directory = activePath.parent_path();
+		if (directory.empty())
+		{
+			directory = ".";
+		}
+
+		const auto stem = activePath.stem().u8string();
+		const auto extension = activePath.extension().u8string();
+
+		struct Segment
+		{
+			std::filesystem::path Path;
+			std::filesystem::file_time_type Time;
+			nLen Size;
+		};
+
+		std::vector<Segment> segments;
+		nLen totalSize = std::filesystem::file_size(activePath, ec);
+		if (ec)
+		{
+			totalSize = 0;
+		}
+
+		for (auto&& entry : std::filesystem::directory_iterator{ directory, ec })
+		{
+			const auto name = entry.path().filename().u8string();
+			// 只处理本输出目标轮换出的分段，不删除目录中的其他文件
+			if (!IsLogSegmentName(name, stem, extension) || !entry.is_regular_file(ec))
+			{
+				continue;
+			}
+
+			const auto size = entry.file_size(ec);
+			const auto time = entry.last_write_time(ec);
+			if (!ec)
+			{
+				segments.push_back({ entry.path(), time, size });
+				totalSize += size;
+			}
+		}
+
+		std::sort(segments.begin(), segments.end(), [](Segment const& a, Segment const& b)
+		{
+			return a.Time < b.Time;
+		});
+
+		for (auto&& segment : segments)
+		{
+			if (totalSize <= maxTotalSize)
+			{
+				break;
+			}
+
+			if (std::filesystem::remove(segment.Path, ec))
+			{
+				totalSize -= segment.Size;
+			}
+		}
+	}
+}
+
+natLogSink::~natLogSink()
+{
+}
+
+natLogLineFormatter::natLogLineFormatter() noexcept
+	: m_CachedTime{ -1 }
+{
+}
+
+void natLogLineFormatter::AppendLine(nString& buffer, nuInt logType, std::chrono::system_clock::time_point const& time, nStrView message)
+{
+	const auto timeValue = std::chrono::system_clock::to_time_t(time);
+	if (timeValue != m_CachedTime)
+	{
+		tm timeStruct;
+#ifdef _MSC_VER
+		localtime_s(&timeStruct, &timeValue);
+#else
+		localtime_r(&timeValue, &timeStruct);
+#endif
+		char timeString[32];
+		const auto length = std::strftime(timeString, sizeof timeString, "%Y-%m-%d %H:%M:%S", &timeStruct);
+		m_CachedTimeString = nStrView{ timeString, length };
+		m_CachedTime = timeValue;
+	}
+
+	buffer.Append('[');
+	buffer.Append(m_CachedTimeString);
+	buffer.Append("] ["_nv);
+	buffer.Append(natLog::GetDefaultLogTypeName(static_cast<natLog::LogType>(logType)));
+	buffer.Append("] "_nv);
+	buffer.Append(message);
+	buffer.Append('\n');
+}
+
+natStreamLogSink::natStreamLogSink(natRefPointer<natStream> stream)
+	: m_Stream{ std::move(stream) }
+{
+	if (!m_Stream || !m_Stream->CanWrite())
+	{
+		nat_Throw(natErrException, NatErr_InvalidArg, "stream should be writable."_nv);
+	}
+}
+
+natStreamLogSink::~natStreamLogSink()
+{
+}
+
+void natStreamLogSink::Write(nuInt logType, std::chrono::system_clock::time_point const& time, nStrView message)
+{
+	m_Formatter.AppendLine(m_Buffer, logType, time, message);
+}
+
+void natStreamLogSink::Flush()
+{
+	if (m_Buffer.IsEmpty())
+	{
+		return;
+	}
+
+	m_Stream->ForceWriteBytes(reinterpret_cast<ncData>(m_Buffer.data()), m_Buffer.size() * sizeof(nString::CharType));
+	m_Stream->Flush();
+	m_Buffer.Clear();
+}
+
+natConsoleLogSink::natConsoleLogSink(natConsole& console)
+	: m_Console(console)
+{
+}
+
+natConsoleLogSink::~natConsoleLogSink()
+{
+}
+
+void natConsoleLogSink::Write(nuInt logType, std::chrono::system_clock::time_point const& time, nStrView message)
+{
+	m_Formatter.AppendLine(logType == natLog::Err ? m_ErrBuffer : m_Buffer, logType, time, message);
+}
+
+void natConsoleLogSink::Flush()
+{
+	if (!m_Buffer.IsEmpty())
+	{
+		m_Console.Write(m_Buffer);
+		m_Buffer.Clear();
+	}
+	if (!m_ErrBuffer.IsEmpty())
+	{
+		m_Console.WriteErr(m_ErrBuffer);
+		m_ErrBuffer.Clear();
+	}
+}
+
+natRotatingFileLogSink::natRotatingFileLogSink(nStrView path, RotatingFileLogOptions const& options)
+	: m_Path(path), m_Options(options), m_FileSize{}, m_SegmentIndex{}, m_RotationRequested{ false }
+{
+	OpenFile();
+}
+
+natRotatingFileLogSink::~natRotatingFileLogSink()
+{
+	try
+	{
+		WriteBuffer();
+	}
+	catch (...)
+	{
+	}
+
+	m_File = nullptr;
+	if (m_Compression.valid())
+	{
+		m_Compression.wait();
+	}
+}
+
+void natRotatingFileLogSink::Write(nuInt logType, std::chrono::system_clock::time_point const& time, nStrView message)
+{
+	if (m_RotationRequested.exchange(false, std::memory_order_relaxed) || (m_Options.RotationInterval.count() && time >= m_NextRotationTime))
+	{
+		Rotate();
+	}
+
+	m_Formatter.AppendLine(m_Buffer, logType, time, message);
+
+	if (m_Options.MaxFileSize && m_FileSize + m_Buffer.size() >= m_Options.MaxFileSize)
+	{
+		WriteBuffer();
+		Rotate();
+	}
+	else if (m_Buffer.size() >= m_Options.BufferSize)
+	{
+		WriteBuffer();
+	}
+}
+
+void natRotatingFileLogSink::Flush()
+{
+	if (m_RotationRequested.exchange(false, std::memory_order_relaxed))
+	{
+		Rotate();
+	}
+
+	WriteBuffer();
+}
+
+void natRotatingFileLogSink::RequestRotation() noexcept
+{
+	m_RotationRequested.store(true, std::memory_order_relaxed);
+}
+
+nStrView natRotatingFileLogSink::GetPath() const noexcept
+{
+	return m_Path;
+}
+
+void natRotatingFileLogSink::OpenFile()
+{
+	m_File = make_ref<natFileStream>(m_Path, false, true);
+	m_File->SetPosition(NatSeek::End, 0);
+	m_FileSize = m_File->GetSize();
+	m_NextRotationTime = std::chrono::system_clock::now() + m_Options.RotationInterval;
+}
+
+void natRotatingFileLogSink::WriteBuffer()
+{
+	if (m_Buffer.IsEmpty())
+	{
+		return;
+	}
+
+	const auto size = m_Buffer.size() * sizeof(nString::CharType);
+	m_File->ForceWriteBytes(reinterpret_cast<ncData>(m_Buffer.data()), size);
+	m_FileSize += size;
+	m_Buffer.Clear();
+}
+
+void natRotatingFileLogSink::Rotate()
+{
+	WriteBuffer();
+	if (!m_FileSize)
+	{
+		m_NextRotationTime = std::chrono::system_clock::now() + m_Options.RotationInterval;
+		return;
+	}
+
+	const auto activePath = ToPath(m_Path);
+	const auto timeValue = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+	tm timeStruct;
+#ifdef _MSC_VER
+	localtime_s(&timeStruct, &timeValue);
+#else
+	localtime_r(&timeValue, &timeStruct);
+#endif
+	char timeString[32];
+	const auto timeLength = std::strftime(timeString, sizeof timeString, "%Y%m%d-%H%M%S", &timeStruct);
+
+	// 避免与之前（包括之前的进程）轮换出的文件重名
+	std::filesystem::path segment;
+	std::error_code ec;
+	do
+	{
+		segment = activePath;
+		segment.replace_filename(activePath.stem());
+		segment += ToPath(natUtil::FormatString(".{0}.{1}"_nv, nStrView{ timeString, timeLength }, m_SegmentIndex++));
+		segment += activePath.extension();
+	} while (std::filesystem::exists(segment, ec) || std::filesystem::exists(std::filesystem::path{ segment } += ".zip", ec));
+
+	m_File->Flush();
+	m_File = nullptr;
+	std::filesystem::rename(activePath, segment, ec);
+	OpenFile();
+	if (ec)
+	{
+		// 重命名失败（如文件被其他进程占用）时继续写入原文件，再写入 MaxFileSize 字节或经过 RotationInterval 后才重试，避免每次写入都尝试轮换
+		m_FileSize = 0;
+		return;
+	}
+
+	// 等待上一次压缩结束，同一时间至多有一个后台任务操作轮换出的文件
+	if (m_Compression.valid())
+	{
+		m_Compression.wait();
+	}
+
+	if (m_Options.Compress)
+	{
+		m_Compression = std::async(std::launch::async, [segment, activePath, maxTotalSize = m_Options.MaxTotalSize]
+		{
+			CompressLogSegment(segment);
+			EnforceLogSizeLimit(activePath, maxTotalSize);
+		});
+	}
+	else
+	{
+		EnforceLogSizeLimit(activePath, m_Options.MaxTotalSize);
+	}
+}
+
+detail_::LogRingBuffer::LogRingBuffer(std::size_t capacity)
+	: Abandoned{ false }, Detached{ false }, m_Capacity{ capacity }, m_Buffer{ std::make_unique<nByte[]>(capacity) }, m_Head{}, m_CachedTail{}, m_PendingSkip{}, m_Tail{}
+{
+	assert(capacity && !(capacity & (capacity - 1)) && "capacity should be a power of 2.");
+}
+
+detail_::LogRingBuffer::~LogRingBuffer()
+{
+}
+
+natAsyncLogBackend::natAsyncLogBackend(std::size_t bufferSize, std::chrono::milliseconds flushInterval)
+	: m_ID{ s_NextBackendID.fetch_add(1, std::memory_order_relaxed) }, m_BufferSize{ RoundUpBufferSize(bufferSize) }, m_FlushInterval{ flushInterval }, m_FlushRequested{}, m_FlushCompleted{}, m_Terminating{ false }
+{
+	m_Thread = std::thread{ &natAsyncLogBackend::ThreadJob, this };
+}
+
+natAsyncLogBackend::~natAsyncLogBackend()
+{
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_Terminating = true;
+	}
+	m_WakeUp.notify_one();
+	m_Thread.join();
+
+	for (auto&& buffer : m_Buffers)
+	{
+		buffer->Detached.store(true, std::memory_order_release);
+	}
+}
+
+void natAsyncLogBackend::AddSink(natRefPointer<natLogSink> sink)
+{
+	if (!sink)
+	{
+		nat_Throw(natErrException, NatErr_InvalidArg, "sink should not be nullptr."_nv);
+	}
+
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+	m_Sinks.emplace_back(std::move(sink));
+}
+
+void natAsyncLogBackend::Flush()
+{
+	std::unique_lock<std::mutex> lock{ m_Mutex };
+	const auto ticket = ++m_FlushRequested;
+	m_WakeUp.notify_one();
+	m_Flushed.wait(lock, [this, ticket]
+	{
+		return m_FlushCompleted >= ticket;
+	});
+}
+
+detail_::LogRingBuffer& natAsyncLogBackend::GetThreadBuffer()
+{
+	auto& buffers = t_LogBuffers.Buffers;
+	for (auto&& item : buffers)
+	{
+		if (item.first == m_ID)
+		{
+			return *item.second;
+		}
+	}
+
+	// 顺便移除已析构的日志后端的缓冲区
+	buffers.erase(std::remove_if(buffers.begin(), buffers.end(), [](auto const& item)
+	{
+		return item.second->Detached.load(std::memory_order_acquire);
+	}), buffers.end());
+
+	auto buffer = make_ref<detail_::LogRingBuffer>(m_BufferSize);
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_Buffers.emplace_back(buffer);
+	}
+	buffers.emplace_back(m_ID, buffer);
+	return *buffer;
+}
+
+void natAsyncLogBackend::WakeUp()
+{
+	m_WakeUp.notify_one();
+}
+
+void natAsyncLogBackend::ThreadJob()
+{
+	std::vector<natRefPointer<detail_::LogRingBuffer>> buffers;
+	std::vector<natRefPointer<natLogSink>> sinks;
+
+	const auto write = [&sinks](nuInt logType, std::chrono::system_clock::time_point const& time, nStrView message)
+	{
+		for (auto&& sink : sinks)
+		{
+			try
+			{
+				sink->Write(logType, time, message);
+			}
+			catch (...)
+			{
+			}
+		}
+	};
+
+	std::unique_lock<std::mutex> lock{ m_Mutex };
+	while (true)
+	{
+		// 记录在此之前请求的刷新及终止，本轮读取完毕后即可完成
+		const auto flushTicket = m_FlushRequested;
+		const auto terminating = m_Terminating;
+		buffers = m_Buffers;
+		sinks = m_Sinks;
+		lock.unlock();
+
+		std::size_t count{};
+		for (auto&& buffer : buffers)
+		{
+			count += buffer->Consume([&write](detail_::LogRecordHeader const& header, const nByte* payload)
+			{
+				nString message;
+				try
+				{
+					message = header.Format(payload);
+				}
+				catch (natException& e)
+				{
+					message = natUtil::FormatString("Failed to format log record: {0}"_nv, e.GetDesc());
+				}
+				catch (std::exception& e)
+				{
+					message = natUtil::FormatString("Failed to format log record: {0}"_nv, e.what());
+				}
+				catch (...)
+				{
+					message = "Failed to format log record: unknown exception"_nv;
+				}
+				write(header.LogType, header.Time, message);
+			});
+		}
+
+		if (count || flushTicket != m_FlushCompleted)
+		{
+			for (auto&& sink : sinks)
+			{
+				try
+				{
+					sink->Flush();
+				}
+				catch (...)
+				{
+				}
+			}
+		}
+		buffers.clear();
+		sinks.clear();
+
+		lock.lock();
+		m_Buffers.erase(std::remove_if(m_Buffers.begin(), m_Buffers.end(), [](natRefPointer<detail_::LogRingBuffer> const& buffer)
+		{
+			return buffer->Abandoned.load(std::memory_order_acquire) && buffer->IsEmpty();
+		}), m_Buffers.end());
+
+		if (m_FlushCompleted != flushTicket)
+		{
+			m_FlushCompleted = flushTicket;
+			m_Flushed.notify_all();
+		}
+
+		if (terminating)
+		{
+			break;
+		}
+
+		if (!count && m_FlushRequested == flushTicket && !m_Terminating)
+		{
+			m_WakeUp.wait_for(lock, m_FlushInterval);
+		}
+	}
+}
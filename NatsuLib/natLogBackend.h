@@ -0,0 +1,523 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+///	@file	natLogBackend.h
+///	@brief	异步日志后端及日志输出目标
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <ctime>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "natType.h"
+#include "natMisc.h"
+#include "natRefObj.h"
+#include "natString.h"
+#include "natStringUtil.h"
+#include "natStream.h"
+
+namespace NatsuLib
+{
+	class natConsole;
+
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	日志输出目标
+	///	@remark	仅由日志后端的线程调用，Write 可只写入缓冲区，每批日志写入后将调用 Flush
+	////////////////////////////////////////////////////////////////////////////////
+	struct natLogSink
+		: natRefObj
+	{
+		virtual ~natLogSink();
+
+		///	@brief	写入一条日志
+		virtual void Write(nuInt logType, std::chrono::system_clock::time_point const& time, nStrView message) = 0;
+
+		///	@brief	将缓冲的日志写入目标
+		virtual void Flush() = 0;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	将日志格式化为与 natLog::UseDefaultAction 相同的 "[时间] [类型] 内容" 形式
+	///	@remark	缓存最近一次格式化的时间，同一秒内的日志不再调用 localtime
+	////////////////////////////////////////////////////////////////////////////////
+	class natLogLineFormatter
+	{
+	public:
+		natLogLineFormatter() noexcept;
+
+		///	@brief	将格式化后的一行日志追加到 buffer 末尾，包括换行符
+		void AppendLine(nString& buffer, nuInt logType, std::chrono::system_clock::time_point const& time, nStrView message);
+
+	private:
+		std::time_t m_CachedTime;
+		nString m_CachedTimeString;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	写入流的日志输出目标
+	///	@remark	日志在缓冲区中累积，Flush 时一次写入流并刷新流
+	////////////////////////////////////////////////////////////////////////////////
+	class natStreamLogSink final
+		: public natRefObjImpl<natStreamLogSink, natLogSink>
+	{
+	public:
+		explicit natStreamLogSink(natRefPointer<natStream> stream);
+		~natStreamLogSink();
+
+		void Write(nuInt logType, std::chrono::system_clock::time_point const& time, nStrView message) override;
+		void Flush() override;
+
+	private:
+		natRefPointer<natStream> m_Stream;
+		natLogLineFormatter m_Formatter;
+		nString m_Buffer;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	写入控制台的日志输出目标
+	///	@remark	错误日志写入标准错误，其余写入标准输出，每批日志各调用一次 natConsole::Write
+	///	@note	控制台需比日志后端存活更久
+	////////////////////////////////////////////////////////////////////////////////
+	class natConsoleLogSink final
+		: public natRefObjImpl<natConsoleLogSink, natLogSink>
+	{
+	public:
+		explicit natConsoleLogSink(natConsole& console);
+		~natConsoleLogSink();
+
+		void Write(nuInt logType, std::chrono::system_clock::time_point const& time, nStrView message) override;
+		void Flush() override;
+
+	private:
+		natConsole& m_Console;
+		natLogLineFormatter m_Formatter;
+		nString m_Buffer, m_ErrBuffer;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	轮换日志文件的选项
+	////////////////////////////////////////////////////////////////////////////////
+	struct RotatingFileLogOptions
+	{
+		nLen MaxFileSize = 16 << 20;							///< @brief	当前文件达到此大小后轮换，为 0 时不按大小轮换
+		std::chrono::seconds RotationInterval{};				///< @brief	打开文件经过此时间后轮换，为 0 时不按时间轮换
+		std::size_t BufferSize = 1 << 20;						///< @brief	缓冲区达到此大小时立即写入文件
+		nBool Compress = true;									///< @brief	是否在后台将轮换出的文件压缩为 zip
+		nLen MaxTotalSize = 0;									///< @brief	当前文件与轮换出的文件的总大小上限，超出时删除最旧的文件，为 0 时不限制
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	按大小或时间轮换的日志文件输出目标
+	///	@remark	日志在缓冲区中累积，每批日志仅写入文件一次，不逐行刷新\n
+	///			轮换时当前文件被重命名为 "名称.时间.序号.扩展名"，之后在后台压缩为同名的 .zip 文件并删除原文件，
+	///			再按 MaxTotalSize 删除最旧的轮换文件
+	////////////////////////////////////////////////////////////////////////////////
+	class natRotatingFileLogSink final
+		: public natRefObjImpl<natRotatingFileLogSink, natLogSink>
+	{
+	public:
+		explicit natRotatingFileLogSink(nStrView path, RotatingFileLogOptions const& options = {});
+
+		///	@brief	写入缓冲的日志并等待正在进行的压缩结束
+		~natRotatingFileLogSink();
+
+		void Write(nuInt logType, std::chrono::system_clock::time_point const& time, nStrView message) override;
+		void Flush() override;
+
+		///	@brief	请求在下一次写入或刷新时轮换
+		///	@remark	可在任意线程中调用
+		void RequestRotation() noexcept;
+
+		///	@brief	获得当前文件的路径
+		nStrView GetPath() const noexcept;
+
+	private:
+		void OpenFile();
+		void WriteBuffer();
+		void Rotate();
+
+		const nString m_Path;
+		const RotatingFileLogOptions m_Options;
+		natLogLineFormatter m_Formatter;
+		natRefPointer<natStream> m_File;
+		nString m_Buffer;
+		nLen m_FileSize;
+		std::chrono::system_clock::time_point m_NextRotationTime;
+		nuInt m_SegmentIndex;
+		std::atomic<nBool> m_RotationRequested;
+		std::future<void> m_Compression;
+	};
+
+	namespace detail_
+	{
+		////////////////////////////////////////////////////////////////////////////////
+		///	@brief	二进制日志记录的头部
+		///	@remark	之后依次为格式字符串及参数，Format 为空时表示用于回绕的填充记录
+		////////////////////////////////////////////////////////////////////////////////
+		struct LogRecordHeader
+		{
+			std::size_t Size;
+			nString(*Format)(const nByte* payload);
+			nuInt LogType;
+			std::chrono::system_clock::time_point Time;
+		};
+
+		enum class LogArgumentKind
+		{
+			Raw,		///< @brief	算术类型、枚举及指针，直接复制
+			String,		///< @brief	可转换为 nStrView 的类型，复制其内容
+			Formatted,	///< @brief	其余类型，在记录日志的线程中格式化为字符串
+		};
+
+		template <typename T>
+		struct LogArgumentTraits
+		{
+			typedef std::decay_t<T> Type;
+
+			static constexpr LogArgumentKind Kind =
+				std::is_convertible<T, nStrView>::value ? LogArgumentKind::String :
+				std::is_arithmetic<Type>::value || std::is_enum<Type>::value || std::is_pointer<Type>::value ? LogArgumentKind::Raw :
+				LogArgumentKind::Formatted;
+
+			typedef std::conditional_t<Kind == LogArgumentKind::Raw, Type, nStrView> DecodedType;
+		};
+
+		template <typename T>
+		auto PrepareLogArgument(T&& arg)
+		{
+			typedef LogArgumentTraits<T> Traits;
+			if constexpr (Traits::Kind == LogArgumentKind::Raw)
+			{
+				return static_cast<typename Traits::Type>(arg);
+			}
+			else if constexpr (Traits::Kind == LogArgumentKind::String)
+			{
+				return nStrView{ std::forward<T>(arg) };
+			}
+			else
+			{
+				return natUtil::FormatString("{0}"_nv, std::forward<T>(arg));
+			}
+		}
+
+		template <typename T>
+		std::size_t GetEncodedLogArgumentSize(T const&) noexcept
+		{
+			return sizeof(T);
+		}
+
+		inline std::size_t GetEncodedLogArgumentSize(nStrView const& arg) noexcept
+		{
+			return sizeof(std::size_t) + arg.size();
+		}
+
+		inline std::size_t GetEncodedLogArgumentSize(nString const& arg) noexcept
+		{
+			return sizeof(std::size_t) + arg.size();
+		}
+
+		template <typename T>
+		nByte* EncodeLogArgument(nByte* dst, T const& arg) noexcept
+		{
+			std::memcpy(dst, &arg, sizeof(T));
+			return dst + sizeof(T);
+		}
+
+		inline nByte* EncodeLogArgument(nByte* dst, nStrView const& arg) noexcept
+		{
+			const auto size = arg.size();
+			std::memcpy(dst, &size, sizeof size);
+			std::memcpy(dst + sizeof size, arg.data(), size * sizeof(nStrView::CharType));
+			return dst + sizeof size + size;
+		}
+
+		inline nByte* EncodeLogArgument(nByte* dst, nString const& arg) noexcept
+		{
+			return EncodeLogArgument(dst, nStrView{ arg });
+		}
+
+		template <typename T>
+		T DecodeLogArgument(const nByte*& src) noexcept
+		{
+			if constexpr (std::is_same<T, nStrView>::value)
+			{
+				std::size_t size;
+				std::memcpy(&size, src, sizeof size);
+				const auto data = reinterpret_cast<nStrView::CharIterator>(src + sizeof size);
+				src += sizeof size + size;
+				return { data, size };
+			}
+			else
+			{
+				T value;
+				std::memcpy(&value, src, sizeof(T));
+				src += sizeof(T);
+				return value;
+			}
+		}
+
+		///	@brief	还原参数并格式化日志
+		///	@remark	格式字符串以空字符结尾，以满足 natUtil::FormatString 的要求
+		template <typename... Args>
+		nString FormatLogRecord(const nByte* payload)
+		{
+			const auto content = DecodeLogArgument<nStrView>(payload);
+			++payload;
+			const std::tuple<typename LogArgumentTraits<Args>::DecodedType...> args{ DecodeLogArgument<typename LogArgumentTraits<Args>::DecodedType>(payload)... };
+			return std::apply([&content](auto const&... decodedArgs)
+			{
+				return natUtil::FormatString(content, decodedArgs...);
+			}, args);
+		}
+
+		///	@brief	取出在记录日志的线程中已格式化的日志
+		///	@remark	用于过大的记录，payload 中仅保存在堆上分配的 nString 的指针
+		inline nString TakeFormattedLogRecord(const nByte* payload)
+		{
+			nString* message;
+			std::memcpy(&message, payload, sizeof message);
+			const std::unique_ptr<nString> owner{ message };
+			return std::move(*owner);
+		}
+
+		////////////////////////////////////////////////////////////////////////////////
+		///	@brief	单生产者单消费者的日志记录环形缓冲区
+		///	@remark	每个记录日志的线程拥有独立的缓冲区，写入及读取均不加锁，
+		///			记录在缓冲区中连续存放，末尾不足以容纳记录时回绕到开头
+		////////////////////////////////////////////////////////////////////////////////
+		class LogRingBuffer final
+			: public natRefObjImpl<LogRingBuffer>
+		{
+		public:
+			enum : std::size_t
+			{
+				RecordAlignment = alignof(LogRecordHeader),
+			};
+
+			///	@param[in]	capacity	缓冲区大小，须为 2 的幂
+			explicit LogRingBuffer(std::size_t capacity);
+			~LogRingBuffer();
+
+			std::size_t GetCapacity() const noexcept
+			{
+				return m_Capacity;
+			}
+
+			///	@brief	为大小为 size 的记录预留空间
+			///	@remark	size 须为 RecordAlignment 的倍数且不超过容量的一半
+			///	@return	空间不足时返回 nullptr
+			nByte* Reserve(std::size_t size) noexcept
+			{
+				const auto head = m_Head.load(std::memory_order_relaxed);
+				const auto position = head & (m_Capacity - 1);
+				const auto remaining = m_Capacity - position;
+				const auto skip = remaining < size ? remaining : 0;
+
+				if (m_Capacity - (head - m_CachedTail) < skip + size)
+				{
+					m_CachedTail = m_Tail.load(std::memory_order_acquire);
+					if (m_Capacity - (head - m_CachedTail) < skip + size)
+					{
+						return nullptr;
+					}
+				}
+
+				m_PendingSkip = skip;
+				if (!skip)
+				{
+					return m_Buffer.get() + position;
+				}
+
+				// 不足以容纳头部时读取方将隐式跳过
+				if (skip >= sizeof(LogRecordHeader))
+				{
+					const auto padding = ::new(static_cast<void*>(m_Buffer.get() + position)) LogRecordHeader;
+					padding->Size = skip;
+					padding->Format = nullptr;
+				}
+				return m_Buffer.get();
+			}
+
+			///	@brief	提交之前预留的记录
+			void Commit(std::size_t size) noexcept
+			{
+				m_Head.store(m_Head.load(std::memory_order_relaxed) + m_PendingSkip + size, std::memory_order_release);
+			}
+
+			///	@brief	读取所有已提交的记录
+			///	@return	读取的记录数
+			template <typename Func>
+			std::size_t Consume(Func&& func)
+			{
+				const auto head = m_Head.load(std::memory_order_acquire);
+				auto tail = m_Tail.load(std::memory_order_relaxed);
+				std::size_t count{};
+
+				while (tail != head)
+				{
+					const auto position = tail & (m_Capacity - 1);
+					const auto remaining = m_Capacity - position;
+					if (remaining < sizeof(LogRecordHeader))
+					{
+						tail += remaining;
+						continue;
+					}
+
+					const auto header = std::launder(reinterpret_cast<const LogRecordHeader*>(m_Buffer.get() + position));
+					const auto size = header->Size;
+					if (header->Format)
+					{
+						func(*header, reinterpret_cast<const nByte*>(header + 1));
+						++count;
+					}
+
+					tail += size;
+					m_Tail.store(tail, std::memory_order_release);
+				}
+
+				return count;
+			}
+
+			nBool IsEmpty() const noexcept
+			{
+				return m_Head.load(std::memory_order_acquire) == m_Tail.load(std::memory_order_acquire);
+			}
+
+			///	@brief	所属线程已结束，读取完毕后可移除
+			std::atomic<nBool> Abandoned;
+
+			///	@brief	所属的日志后端已析构
+			std::atomic<nBool> Detached;
+
+		private:
+			const std::size_t m_Capacity;
+			const std::unique_ptr<nByte[]> m_Buffer;
+			alignas(64) std::atomic<std::size_t> m_Head;
+			std::size_t m_CachedTail;
+			std::size_t m_PendingSkip;
+			alignas(64) std::atomic<std::size_t> m_Tail;
+		};
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	异步日志后端
+	///	@remark	记录日志的线程仅将格式字符串及参数以二进制形式写入本线程的环形缓冲区，
+	///			不进行格式化，也不加锁；后端的线程成批读取各缓冲区中的记录，格式化后写入输出目标，
+	///			每批仅刷新一次输出目标\n
+	///			算术类型、枚举及指针参数直接复制，可转换为 nStrView 的参数复制其内容，
+	///			其余参数在记录日志的线程中先格式化为字符串
+	///	@note	同一线程记录的日志按顺序写入，不同线程之间的顺序不保证\n
+	///			缓冲区已满时记录日志的线程将等待后端读取
+	////////////////////////////////////////////////////////////////////////////////
+	class natAsyncLogBackend final
+		: public nonmovable
+	{
+	public:
+		enum : std::size_t
+		{
+			DefaultBufferSize = 1 << 16,	///< @brief	每个线程的缓冲区大小
+		};
+
+		///	@param[in]	bufferSize		每个线程的缓冲区大小，将向上取整为 2 的幂
+		///	@param[in]	flushInterval	没有新的日志时后端线程检查缓冲区的间隔
+		explicit natAsyncLogBackend(std::size_t bufferSize = DefaultBufferSize, std::chrono::milliseconds flushInterval = std::chrono::milliseconds{ 10 });
+
+		///	@brief	写入所有已记录的日志后结束后端线程
+		~natAsyncLogBackend();
+
+		///	@brief	添加输出目标
+		void AddSink(natRefPointer<natLogSink> sink);
+
+		///	@brief	记录日志
+		template <typename... Args>
+		void Record(nuInt logType, nStrView content, Args&&... args)
+		{
+			const auto time = std::chrono::system_clock::now();
+			const auto preparedArgs = std::make_tuple(detail_::PrepareLogArgument(std::forward<Args>(args))...);
+			const auto argsSize = std::apply([](auto const&... preparedArg)
+			{
+				return (std::size_t{} + ... + detail_::GetEncodedLogArgumentSize(preparedArg));
+			}, preparedArgs);
+			const auto size = AlignRecordSize(sizeof(detail_::LogRecordHeader) + sizeof(std::size_t) + content.size() + 1 + argsSize);
+			auto& buffer = GetThreadBuffer();
+
+			// 过大的记录在当前线程格式化，仍经由缓冲区传递以保持顺序
+			if (size > buffer.GetCapacity() / 2)
+			{
+				auto message = std::make_unique<nString>(std::apply([&content](auto const&... preparedArg)
+				{
+					return natUtil::FormatString(content, preparedArg...);
+				}, preparedArgs));
+
+				constexpr auto formattedSize = AlignRecordSize(sizeof(detail_::LogRecordHeader) + sizeof(nString*));
+				const auto payload = BeginRecord(buffer, formattedSize, &detail_::TakeFormattedLogRecord, logType, time);
+				const auto pointer = message.release();
+				std::memcpy(payload, &pointer, sizeof pointer);
+				buffer.Commit(formattedSize);
+				return;
+			}
+
+			auto payload = BeginRecord(buffer, size, &detail_::FormatLogRecord<typename detail_::LogArgumentTraits<Args>::Type...>, logType, time);
+			payload = detail_::EncodeLogArgument(payload, content);
+			*payload++ = 0;
+			std::apply([&payload](auto const&... preparedArg)
+			{
+				static_cast<void>(((payload = detail_::EncodeLogArgument(payload, preparedArg)), ...));
+			}, preparedArgs);
+
+			buffer.Commit(size);
+		}
+
+		///	@brief	等待调用之前记录的日志全部写入输出目标
+		void Flush();
+
+	private:
+		static constexpr std::size_t AlignRecordSize(std::size_t size) noexcept
+		{
+			return (size + detail_::LogRingBuffer::RecordAlignment - 1) & ~(detail_::LogRingBuffer::RecordAlignment - 1);
+		}
+
+		///	@brief	在缓冲区中预留记录并写入头部，缓冲区已满时等待
+		///	@return	记录中头部之后的位置
+		nByte* BeginRecord(detail_::LogRingBuffer& buffer, std::size_t size, nString(*format)(const nByte*), nuInt logType, std::chrono::system_clock::time_point const& time)
+		{
+			nByte* record;
+			while (!(record = buffer.Reserve(size)))
+			{
+				WakeUp();
+				std::this_thread::yield();
+			}
+
+			const auto header = ::new(static_cast<void*>(record)) detail_::LogRecordHeader;
+			header->Size = size;
+			header->Format = format;
+			header->LogType = logType;
+			header->Time = time;
+			return record + sizeof(detail_::LogRecordHeader);
+		}
+
+		detail_::LogRingBuffer& GetThreadBuffer();
+		void WakeUp();
+		void ThreadJob();
+
+		const nuLong m_ID;
+		const std::size_t m_BufferSize;
+		const std::chrono::milliseconds m_FlushInterval;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_WakeUp, m_Flushed;
+		std::vector<natRefPointer<detail_::LogRingBuffer>> m_Buffers;
+		std::vector<natRefPointer<natLogSink>> m_Sinks;
+		nuLong m_FlushRequested, m_FlushCompleted;
+		nBool m_Terminating;
+
+		std::thread m_Thread;
+	};
+}
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "natMisc.h"
+#include "natSmallVector.h"
 #include "natException.h"
 
 using namespace NatsuLib;
@@ -13,3 +14,13 @@ void detail_::ValueNotAvailable()
 {
 	nat_Throw(natException, "There is no available value."_nv);
 }
+
+void detail_::InlineVectorOutOfRange()
+{
+	nat_Throw(natErrException, NatErr_OutOfRange, "pos is out of range."_nv);
+}
+
+void detail_::StaticVectorCapacityExceeded()
+{
+	nat_Throw(natErrException, NatErr_OutOfRange, "StaticVector capacity exceeded."_nv);
+}
@@ -7,6 +7,11 @@
 #include <functional>
 #include <cassert>
 #include <tuple>
+#include <exception>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#	include <intrin.h>
+#endif
 
 #define MAKE_ENUM_CLASS_BITMASK_TYPE(enumName) static_assert(std::is_enum<enumName>::value, "enumName is not a enum.");\
 	constexpr enumName operator|(enumName a, enumName b) noexcept\
@@ -253,6 +258,72 @@ namespace NatsuLib
 		};
 
 		constexpr OnlyFail_t OnlyFail{};
+
+		inline size_t PopCount(nuLong value) noexcept
+		{
+#if defined(__GNUC__) || defined(__clang__)
+			return static_cast<size_t>(__builtin_popcountll(value));
+#else
+			value = value - ((value >> 1) & 0x5555555555555555ull);
+			value = (value & 0x3333333333333333ull) + ((value >> 2) & 0x3333333333333333ull);
+			value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+			return static_cast<size_t>((value * 0x0101010101010101ull) >> 56);
+#endif
+		}
+
+		///	@brief	返回最低的置位位的序号
+		///	@note	value 不可为 0
+		inline size_t CountTrailingZeros(nuLong value) noexcept
+		{
+#if defined(__GNUC__) || defined(__clang__)
+			return static_cast<size_t>(__builtin_ctzll(value));
+#elif defined(_MSC_VER) && defined(_M_X64)
+			unsigned long index;
+			_BitScanForward64(&index, value);
+			return static_cast<size_t>(index);
+#else
+			size_t index{};
+			while (!(value & 1))
+			{
+				value >>= 1;
+				++index;
+			}
+			return index;
+#endif
+		}
+
+
+		///	@brief	打散哈希值的各位
+		///	@remark	std::hash 对整数可能是恒等映射，以哈希值的部分位寻址前需先打散
+		inline size_t MixHash(size_t hash) noexcept
+		{
+			auto h = static_cast<nuLong>(hash);
+			h ^= h >> 33;
+			h *= 0xff51afd7ed558ccdull;
+			h ^= h >> 33;
+			return static_cast<size_t>(h);
+		}
+
+		///	@brief	返回最高的置位位之前的 0 的数量
+		///	@note	value 不可为 0
+		inline size_t CountLeadingZeros(nuLong value) noexcept
+		{
+#if defined(__GNUC__) || defined(__clang__)
+			return static_cast<size_t>(__builtin_clzll(value));
+#elif defined(_MSC_VER) && defined(_M_X64)
+			unsigned long index;
+			_BitScanReverse64(&index, value);
+			return static_cast<size_t>(63 - index);
+#else
+			size_t count{};
+			while (!(value & (1ull << 63)))
+			{
+				value <<= 1;
+				++count;
+			}
+			return count;
+#endif
+		}
 	}
 
 	using detail_::OnlyFail_t;
@@ -31,7 +31,15 @@ natThread::natThread(nBool Pause)
 
 natThread::~natThread()
 {
-	m_Thread.join();
+	Join();
+}
+
+void natThread::Join()
+{
+	if (m_Thread.joinable())
+	{
+		m_Thread.join();
+	}
 }
 
 natThread::UnsafeHandle natThread::GetHandle() noexcept
@@ -138,10 +146,17 @@ natThreadPool::natThreadPool(nuInt InitialThreadCount, nuInt MaxThreadCount)
 
 natThreadPool::~natThreadPool()
 {
+	KillAllThreads();
+	for (auto&& thread : m_Threads)
+	{
+		thread.second->Join();
+	}
 }
 
 void natThreadPool::KillIdleThreads()
 {
+	natRefScopeGuard<natCriticalSection> guard{ m_Section };
+
 	for (auto&& thread : m_Threads)
 	{
 		if (thread.second->IsIdle())
@@ -153,6 +168,8 @@ void natThreadPool::KillIdleThreads()
 
 void natThreadPool::KillAllThreads()
 {
+	natRefScopeGuard<natCriticalSection> guard{ m_Section };
+
 	for (auto&& thread : m_Threads)
 	{
 		thread.second->RequestTerminate();
@@ -161,6 +178,8 @@ void natThreadPool::KillAllThreads()
 
 std::future<natThreadPool::WorkToken> natThreadPool::QueueWork(WorkFunc workFunc, void* param)
 {
+	natRefScopeGuard<natCriticalSection> guard{ m_Section };
+
 	auto Index = getIdleThreadIndex();
 	if (Index == std::numeric_limits<nuInt>::max() && m_Threads.size() < m_MaxThreadCount)
 	{
@@ -223,17 +242,35 @@ natThreadPool::WorkerThread::WorkerThread(natThreadPool& pool, nuInt Index,WorkF
 	SetWork(CallableObj, Param);
 }
 
+natThreadPool::WorkerThread::~WorkerThread()
+{
+	RequestTerminate();
+	Join();
+}
+
 nBool natThreadPool::WorkerThread::IsIdle() const
 {
 	return m_Idle;
 }
 
+void natThreadPool::WorkerThread::MarkIdle()
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+	m_Idle = true;
+}
+
 std::future<nuInt> natThreadPool::WorkerThread::SetWork(WorkFunc CallableObj, void* Param)
 {
-	m_CallableObj = std::move(CallableObj);
-	m_Arg = Param;
-	m_Idle = false;
-	m_LastResult = std::promise<nuInt>{};
+	std::future<nuInt> result;
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_CallableObj = std::move(CallableObj);
+		m_Arg = Param;
+		m_Idle = false;
+		m_LastResult = std::promise<nuInt>{};
+		result = m_LastResult.get_future();
+	}
+
 	if (m_First)
 	{
 		Resume();
@@ -243,7 +280,7 @@ std::future<nuInt> natThreadPool::WorkerThread::SetWork(WorkFunc CallableObj, vo
 	{
 		m_Cond.notify_one();
 	}
-	return m_LastResult.get_future();
+	return result;
 }
 
 void natThreadPool::WorkerThread::RequestTerminate()
@@ -253,17 +290,17 @@ void natThreadPool::WorkerThread::RequestTerminate()
 		return;
 	}
 
-	m_ShouldTerminate.store(true, std::memory_order_release);
-	
-	if (m_Idle)
 	{
-		if (m_First)
-		{
-			Resume();
-			m_First = false;
-		}
-		m_Cond.notify_one();
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_ShouldTerminate.store(true, std::memory_order_release);
 	}
+
+	if (m_First)
+	{
+		Resume();
+		m_First = false;
+	}
+	m_Cond.notify_one();
 }
 
 natThread::ResultType natThreadPool::WorkerThread::ThreadJob()
@@ -276,7 +313,6 @@ natThread::ResultType natThreadPool::WorkerThread::ThreadJob()
 			break;
 		}
 
-		m_Idle = false;
 		try
 		{
 			m_LastResult.set_value(m_CallableObj(m_Arg));
@@ -285,15 +321,14 @@ natThread::ResultType natThreadPool::WorkerThread::ThreadJob()
 		{
 			m_LastResult.set_exception(std::current_exception());
 		}
-		m_Idle = true;
-		m_Pool.onWorkerThreadIdle(m_Index, value);
+		m_Pool.onWorkerThreadIdle(m_Index, m_ShouldTerminate.load(std::memory_order_acquire));
 
 		{
 			std::unique_lock<std::mutex> lock{ m_Mutex };
-			if (!value && m_Idle)
+			m_Cond.wait(lock, [this]
 			{
-				m_Cond.wait(lock);
-			}
+				return !m_Idle || m_ShouldTerminate.load(std::memory_order_acquire);
+			});
 		}
 	}
 	
@@ -345,4 +380,9 @@ void natThreadPool::onWorkerThreadIdle(nuInt Index, nBool isTerminating)
 		std::get<2>(work).set_value(WorkToken(Index, std::move(ret)));
 		m_WorkQueue.pop();
 	}
+	else
+	{
+		// ڱΪУ QueueWork ڹ߳ȡеĹ֮ǰΪ
+		m_Threads[Index]->MarkIdle();
+	}
 }
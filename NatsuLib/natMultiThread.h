@@ -8,12 +8,12 @@
 #ifdef _WIN32
 #	include <Windows.h>
 #endif
-#include <unordered_map>
 #include <memory>
 #include <atomic>
 #include <queue>
 #include <future>
 #include "natMisc.h"
+#include "natFlatHash.h"
 
 #ifdef _MSC_VER
 #	pragma push_macro("max")
@@ -72,6 +72,10 @@ namespace NatsuLib
 		///	@brief	д˷ʵ̹߳
 		virtual ResultType ThreadJob();
 
+		///	@brief	ȴ߳̽
+		///	@note	Ӧȷ߳ѽ̷߳ĳԱ
+		void Join();
+
 	private:
 		std::atomic_bool m_Paused;
 		std::promise<void> m_Pause;
@@ -286,13 +290,16 @@ namespace NatsuLib
 		public:
 			WorkerThread(natThreadPool& pool, nuInt Index);
 			WorkerThread(natThreadPool& pool, nuInt Index, WorkFunc CallableObj, void* Param = nullptr);
-			~WorkerThread() = default;
+			~WorkerThread();
 
 			nBool IsIdle() const;
+			void MarkIdle();
 			std::future<nuInt> SetWork(WorkFunc CallableObj, void* Param = nullptr);
 
 			void RequestTerminate();
 
+			using natThread::Join;
+
 		private:
 			ResultType ThreadJob() override;
 
@@ -313,7 +320,7 @@ namespace NatsuLib
 		void onWorkerThreadIdle(nuInt Index, nBool isTerminating);
 
 		const nuInt m_MaxThreadCount;
-		std::unordered_map<nuInt, std::unique_ptr<WorkerThread>> m_Threads;
+		FlatHashMap<nuInt, std::unique_ptr<WorkerThread>> m_Threads;
 		std::queue<std::tuple<WorkFunc, void*, std::promise<WorkToken>>> m_WorkQueue;
 		natCriticalSection m_Section;
 	};
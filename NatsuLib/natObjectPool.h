@@ -0,0 +1,127 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+///	@file	natObjectPool.h
+///	@brief	固定大小的引用计数对象池
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "natType.h"
+#include "natMisc.h"
+#include "natRefObj.h"
+
+namespace NatsuLib
+{
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	T 类型引用计数对象的对象池
+	///	@remark	按块预先分配槽位，销毁对象时槽位回到空闲链表以供复用，
+	///			大小或对齐与槽位不符的请求直接交给全局的 operator new
+	///	@note	非线程安全，对象池必须比从其中创建的对象存活更久
+	////////////////////////////////////////////////////////////////////////////////
+	template <typename T>
+	class natObjectPool final
+		: public nonmovable
+	{
+		typedef detail_::AllocatedRefObjLayout<T, true> Layout;
+
+	public:
+		enum : std::size_t
+		{
+			DefaultObjectsPerBlock = 64,
+		};
+
+		static constexpr std::size_t SlotSize = Layout::Size;
+		static constexpr std::size_t SlotAlignment = Layout::Alignment;
+
+		explicit natObjectPool(std::size_t objectsPerBlock = DefaultObjectsPerBlock)
+			: m_ObjectsPerBlock{ objectsPerBlock ? objectsPerBlock : static_cast<std::size_t>(DefaultObjectsPerBlock) }, m_FreeList{}, m_LiveCount{}
+		{
+		}
+
+		~natObjectPool()
+		{
+			assert(!m_LiveCount && "Objects created from this pool are still alive.");
+		}
+
+		///	@brief	创建对象
+		template <typename... Args>
+		natRefPointer<T> Create(Args&&... args)
+		{
+			return allocate_ref<T>(*this, std::forward<Args>(args)...);
+		}
+
+		///	@brief	分配内存
+		///	@remark	供 allocate_ref 使用，不超过槽位大小的请求从空闲链表中获得
+		void* Allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t))
+		{
+			if (size > SlotSize || alignment > alignof(Slot))
+			{
+				return ::operator new(size, std::align_val_t{ alignment });
+			}
+
+			if (!m_FreeList)
+			{
+				AllocateBlock();
+			}
+
+			const auto slot = m_FreeList;
+			m_FreeList = slot->Next;
+			++m_LiveCount;
+			return slot;
+		}
+
+		///	@brief	归还之前分配的内存
+		void Deallocate(void* ptr, std::size_t size, std::size_t alignment = alignof(std::max_align_t)) noexcept
+		{
+			if (size > SlotSize || alignment > alignof(Slot))
+			{
+				::operator delete(ptr, std::align_val_t{ alignment });
+				return;
+			}
+
+			assert(m_LiveCount && "Deallocating more slots than allocated.");
+			const auto slot = static_cast<Slot*>(ptr);
+			slot->Next = m_FreeList;
+			m_FreeList = slot;
+			--m_LiveCount;
+		}
+
+		///	@brief	获得正在使用的槽位数
+		std::size_t GetLiveCount() const noexcept
+		{
+			return m_LiveCount;
+		}
+
+		///	@brief	获得已分配的槽位总数
+		std::size_t GetReservedCount() const noexcept
+		{
+			return m_Blocks.size() * m_ObjectsPerBlock;
+		}
+
+	private:
+		union Slot
+		{
+			Slot* Next;
+			alignas(SlotAlignment) nByte Storage[SlotSize];
+		};
+
+		void AllocateBlock()
+		{
+			m_Blocks.emplace_back(std::make_unique<Slot[]>(m_ObjectsPerBlock));
+			const auto block = m_Blocks.back().get();
+			for (std::size_t i = m_ObjectsPerBlock; i > 0; --i)
+			{
+				block[i - 1].Next = m_FreeList;
+				m_FreeList = &block[i - 1];
+			}
+		}
+
+		std::size_t m_ObjectsPerBlock;
+		std::vector<std::unique_ptr<Slot[]>> m_Blocks;
+		Slot* m_FreeList;
+		std::size_t m_LiveCount;
+	};
+}
@@ -0,0 +1,502 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+///	@file	natParallelLinq.h
+///	@brief	并行语言集成查询
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "natLinq.h"
+#include "natMultiThread.h"
+
+#ifdef _MSC_VER
+#	pragma push_macro("max")
+#	pragma push_macro("min")
+#endif
+
+#undef max
+#undef min
+
+namespace NatsuLib
+{
+	namespace detail_
+	{
+		// 按分区顺序两两合并部分结果，空的部分结果会被跳过
+		template <typename T, typename CallableObj>
+		std::optional<T> TreeReduce(std::vector<std::optional<T>>& partials, CallableObj const& combine)
+		{
+			const auto count = partials.size();
+			for (size_t stride = 1; stride < count; stride *= 2)
+			{
+				for (size_t i = 0; i + stride < count; i += stride * 2)
+				{
+					auto& lhs = partials[i];
+					auto& rhs = partials[i + stride];
+					if (!rhs)
+					{
+						continue;
+					}
+					if (lhs)
+					{
+						lhs.emplace(combine(std::move(*lhs), std::move(*rhs)));
+					}
+					else
+					{
+						lhs.swap(rhs);
+					}
+				}
+			}
+
+			return count ? std::move(partials.front()) : std::nullopt;
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	并行查询
+	///	@remark	由 LinqEnumerable::as_parallel 创建，将随机访问的源划分为若干分区并交由线程池处理
+	///			连续的 select 和 where 会被融合为一个处理阶段，在每个分区内逐元素执行而不产生中间结果
+	///			聚合操作先在每个分区内进行，再按分区顺序以树状方式合并各分区的结果
+	///	@note	传入的可调用对象会被多个线程同时以 const 方式调用
+	///			聚合操作要求合并函数满足结合律，并且传入的初始值是合并函数的单位元
+	////////////////////////////////////////////////////////////////////////////////
+	template <typename Iter_t, typename Stage_t>
+	class ParallelLinqEnumerable
+	{
+	public:
+		typedef typename Stage_t::reference reference;
+		typedef std::remove_cv_t<std::remove_reference_t<reference>> value_type;
+		typedef ParallelLinqEnumerable<Iter_t, Stage_t> Self_t;
+
+		enum : size_t
+		{
+			DefaultPartitionsPerThread = 4,		///< @brief	未指定分区数时每个硬件线程对应的分区数
+			MinPartitionSize = 1024,			///< @brief	未指定分区数时每个分区的最少元素数
+		};
+
+		ParallelLinqEnumerable(natThreadPool& pool, Iter_t begin, Iter_t end, Stage_t stage, size_t partitionCount = 0, nBool ordered = false, std::shared_ptr<const void> pOwner = {})
+			: m_Pool{ &pool }, m_Begin{ std::move(begin) }, m_End{ std::move(end) }, m_Stage{ std::move(stage) }, m_PartitionCount{ partitionCount }, m_Ordered{ ordered }, m_pOwner{ std::move(pOwner) }
+		{
+		}
+
+		///	@brief	使 to_vector 等操作保留源中元素的顺序
+		Self_t as_ordered() const
+		{
+			auto ret{ *this };
+			ret.m_Ordered = true;
+			return ret;
+		}
+
+		///	@brief	允许 to_vector 等操作以任意顺序返回元素
+		Self_t as_unordered() const
+		{
+			auto ret{ *this };
+			ret.m_Ordered = false;
+			return ret;
+		}
+
+		nBool is_ordered() const noexcept
+		{
+			return m_Ordered;
+		}
+
+		///	@brief	指定分区数
+		///	@param[in]	partitionCount	分区数，为 0 时根据硬件线程数及元素数决定
+		Self_t with_partition_count(size_t partitionCount) const
+		{
+			auto ret{ *this };
+			ret.m_PartitionCount = partitionCount;
+			return ret;
+		}
+
+		template <typename CallableObj>
+		auto select(CallableObj&& callableObj) const
+		{
+			typedef detail_::PushSelectStage<Stage_t, std::decay_t<CallableObj>> NextStage_t;
+			return ParallelLinqEnumerable<Iter_t, NextStage_t>(*m_Pool, m_Begin, m_End, NextStage_t{ m_Stage, std::forward<CallableObj>(callableObj) }, m_PartitionCount, m_Ordered, m_pOwner);
+		}
+
+		template <typename CallableObj>
+		auto where(CallableObj&& callableObj) const
+		{
+			typedef detail_::PushWhereStage<Stage_t, std::decay_t<CallableObj>> NextStage_t;
+			return ParallelLinqEnumerable<Iter_t, NextStage_t>(*m_Pool, m_Begin, m_End, NextStage_t{ m_Stage, std::forward<CallableObj>(callableObj) }, m_PartitionCount, m_Ordered, m_pOwner);
+		}
+
+		///	@brief	对每个元素调用 callableObj
+		///	@note	调用的顺序是不确定的
+		template <typename CallableObj>
+		void for_each(CallableObj const& callableObj) const
+		{
+			ForEachPartition([this, &callableObj](size_t, Iter_t first, Iter_t last)
+			{
+				auto sink = [&callableObj](reference value) -> nBool
+				{
+					callableObj(std::forward<reference>(value));
+					return true;
+				};
+				RunPartition(std::move(first), std::move(last), sink);
+			});
+		}
+
+		///	@brief	将结果收集到 std::vector 中
+		///	@remark	若调用过 as_ordered 则按源中的顺序合并各分区的结果，否则按各分区完成的顺序合并
+		std::vector<value_type> to_vector() const
+		{
+			std::vector<value_type> result;
+
+			if (m_Ordered)
+			{
+				std::vector<std::vector<value_type>> partials(GetPartitionCount());
+				ForEachPartition([this, &partials](size_t index, Iter_t first, Iter_t last)
+				{
+					auto& partial = partials[index];
+					auto sink = [&partial](reference value) -> nBool
+					{
+						partial.emplace_back(std::forward<reference>(value));
+						return true;
+					};
+					RunPartition(std::move(first), std::move(last), sink);
+				});
+
+				size_t totalSize{};
+				for (auto&& partial : partials)
+				{
+					totalSize += partial.size();
+				}
+				result.reserve(totalSize);
+				for (auto&& partial : partials)
+				{
+					std::move(partial.begin(), partial.end(), std::back_inserter(result));
+				}
+			}
+			else
+			{
+				std::mutex resultMutex;
+				ForEachPartition([this, &result, &resultMutex](size_t, Iter_t first, Iter_t last)
+				{
+					std::vector<value_type> partial;
+					auto sink = [&partial](reference value) -> nBool
+					{
+						partial.emplace_back(std::forward<reference>(value));
+						return true;
+					};
+					RunPartition(std::move(first), std::move(last), sink);
+
+					std::lock_guard<std::mutex> lock{ resultMutex };
+					if (result.empty())
+					{
+						result = std::move(partial);
+					}
+					else
+					{
+						std::move(partial.begin(), partial.end(), std::back_inserter(result));
+					}
+				});
+			}
+
+			return result;
+		}
+
+		///	@brief	收集结果并返回一个顺序执行的 LinqEnumerable，以便继续进行其他操作
+		auto as_sequential() const
+		{
+			return from_container(to_vector());
+		}
+
+		///	@brief	聚合
+		///	@param[in]	seed		初始值，每个分区都会从此值开始聚合，因此应为 combine 的单位元
+		///	@param[in]	func		将元素累加到分区的结果上
+		///	@param[in]	combine		合并两个分区的结果
+		template <typename Result_t, typename CallableObj, typename CombineObj>
+		Result_t aggregate(Result_t const& seed, CallableObj const& func, CombineObj const& combine) const
+		{
+			std::vector<std::optional<Result_t>> partials(GetPartitionCount());
+			ForEachPartition([this, &partials, &seed, &func](size_t index, Iter_t first, Iter_t last)
+			{
+				Result_t result = seed;
+				auto sink = [&result, &func](reference value) -> nBool
+				{
+					result = func(std::move(result), std::forward<reference>(value));
+					return true;
+				};
+				RunPartition(std::move(first), std::move(last), sink);
+				partials[index].emplace(std::move(result));
+			});
+
+			auto result = detail_::TreeReduce(partials, combine);
+			return result ? std::move(*result) : seed;
+		}
+
+		///	@brief	聚合
+		///	@param[in]	func	同时用于累加元素及合并分区的结果
+		///	@exception	natErrException	没有元素
+		template <typename CallableObj>
+		value_type aggregate(CallableObj const& func) const
+		{
+			auto result = Reduce(func);
+			if (!result)
+			{
+				nat_Throw(natErrException, NatErr_OutOfRange, "No element."_nv);
+			}
+
+			return std::move(*result);
+		}
+
+		size_t count() const
+		{
+			return aggregate(size_t{}, [](size_t count, reference) { return count + 1; }, std::plus<size_t>{});
+		}
+
+		template <typename CallableObj>
+		size_t count(CallableObj&& callableObj) const
+		{
+			return where(std::forward<CallableObj>(callableObj)).count();
+		}
+
+		auto sum() const
+		{
+			if constexpr (detail_::Addable<value_type>::value)
+			{
+				auto result = Reduce(std::plus<value_type>{});
+				if constexpr (std::is_default_constructible_v<value_type>)
+				{
+					return result ? std::move(*result) : value_type{};
+				}
+				else
+				{
+					if (!result)
+					{
+						nat_Throw(natException, "Range is empty and there is no default constructor for this type."_nv);
+					}
+
+					return std::move(*result);
+				}
+			}
+			else
+			{
+				nat_Throw(natException, "Cannot apply such operation to this type."_nv);
+			}
+		}
+
+		auto max() const
+		{
+			if constexpr (detail_::CanGreater<value_type>::value)
+			{
+				return aggregate([](value_type const& a, value_type const& b) { return b > a ? b : a; });
+			}
+			else
+			{
+				nat_Throw(natException, "Cannot apply such operation to this type."_nv);
+			}
+		}
+
+		auto min() const
+		{
+			if constexpr (detail_::CanLesser<value_type>::value)
+			{
+				return aggregate([](value_type const& a, value_type const& b) { return b < a ? b : a; });
+			}
+			else
+			{
+				nat_Throw(natException, "Cannot apply such operation to this type."_nv);
+			}
+		}
+
+		///	@exception	natErrException	没有元素
+		template <typename Result_t = value_type>
+		auto average() const
+		{
+			if constexpr (std::conjunction<detail_::Addable<Result_t, value_type>, detail_::Dividable<Result_t>>::value)
+			{
+				typedef std::pair<Result_t, size_t> Partial_t;
+				const auto result = aggregate(Partial_t{}, [](Partial_t partial, reference value)
+				{
+					partial.first = partial.first + std::forward<reference>(value);
+					++partial.second;
+					return partial;
+				}, [](Partial_t const& a, Partial_t const& b)
+				{
+					return Partial_t{ a.first + b.first, a.second + b.second };
+				});
+
+				if (!result.second)
+				{
+					nat_Throw(natErrException, NatErr_OutOfRange, "No element."_nv);
+				}
+
+				return result.first / static_cast<Result_t>(result.second);
+			}
+			else
+			{
+				nat_Throw(natException, "Cannot apply such operation to this type."_nv);
+			}
+		}
+
+		///	@brief	判断是否存在元素
+		///	@remark	任一分区找到元素后其他分区会尽快停止
+		nBool any() const
+		{
+			std::atomic<nBool> found{ false };
+			ForEachPartition([this, &found](size_t, Iter_t first, Iter_t last)
+			{
+				auto sink = [&found](reference) -> nBool
+				{
+					found.store(true, std::memory_order_relaxed);
+					return false;
+				};
+				RunPartition(std::move(first), std::move(last), sink, &found);
+			});
+
+			return found.load(std::memory_order_relaxed);
+		}
+
+		template <typename CallableObj>
+		nBool any(CallableObj&& callableObj) const
+		{
+			return where(std::forward<CallableObj>(callableObj)).any();
+		}
+
+		template <typename CallableObj>
+		nBool all(CallableObj&& callableObj) const
+		{
+			return !where([callableObj = std::forward<CallableObj>(callableObj)](auto&& value) -> nBool
+			{
+				return !callableObj(value);
+			}).any();
+		}
+
+	private:
+		natThreadPool* m_Pool;
+		Iter_t m_Begin, m_End;
+		Stage_t m_Stage;
+		size_t m_PartitionCount;
+		nBool m_Ordered;
+		std::shared_ptr<const void> m_pOwner;
+
+		size_t GetSourceSize() const
+		{
+			return static_cast<size_t>(std::distance(m_Begin, m_End));
+		}
+
+		size_t GetPartitionCount() const
+		{
+			const auto size = GetSourceSize();
+			if (m_PartitionCount)
+			{
+				return std::max(std::min(m_PartitionCount, size), size_t{ 1 });
+			}
+
+			const size_t threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+			return std::max(std::min(threadCount * DefaultPartitionsPerThread, size / MinPartitionSize), size_t{ 1 });
+		}
+
+		template <typename Sink>
+		void RunPartition(Iter_t first, Iter_t const& last, Sink& sink, std::atomic<nBool> const* stopFlag = nullptr) const
+		{
+			for (; first != last; ++first)
+			{
+				if ((stopFlag && stopFlag->load(std::memory_order_relaxed)) || !m_Stage.Push(*first, sink))
+				{
+					break;
+				}
+			}
+		}
+
+		template <typename CallableObj>
+		std::optional<value_type> Reduce(CallableObj const& func) const
+		{
+			std::vector<std::optional<value_type>> partials(GetPartitionCount());
+			ForEachPartition([this, &partials, &func](size_t index, Iter_t first, Iter_t last)
+			{
+				auto& partial = partials[index];
+				auto sink = [&partial, &func](reference value) -> nBool
+				{
+					if (partial)
+					{
+						partial.emplace(func(std::move(*partial), std::forward<reference>(value)));
+					}
+					else
+					{
+						partial.emplace(std::forward<reference>(value));
+					}
+					return true;
+				};
+				RunPartition(std::move(first), std::move(last), sink);
+			});
+
+			return detail_::TreeReduce(partials, func);
+		}
+
+		// 第一个分区由当前线程处理，其余分区交由线程池处理，所有分区完成后才返回
+		template <typename CallableObj>
+		void ForEachPartition(CallableObj const& body) const
+		{
+			const auto size = GetSourceSize();
+			const auto partitionCount = GetPartitionCount();
+			const auto partitionSize = size / partitionCount, remainder = size % partitionCount;
+
+			std::vector<std::exception_ptr> exceptions(partitionCount);
+			std::vector<std::future<natThreadPool::WorkToken>> pendingWorks;
+			pendingWorks.reserve(partitionCount - 1);
+
+			const auto waitAll = [&pendingWorks]
+			{
+				for (auto&& work : pendingWorks)
+				{
+					work.get().GetResult().get();
+				}
+			};
+
+			auto first = m_Begin;
+			const auto firstLast = std::next(first, static_cast<std::ptrdiff_t>(partitionSize + (remainder ? 1 : 0)));
+
+			try
+			{
+				auto partitionFirst = firstLast;
+				for (size_t i = 1; i < partitionCount; ++i)
+				{
+					auto partitionLast = std::next(partitionFirst, static_cast<std::ptrdiff_t>(partitionSize + (i < remainder ? 1 : 0)));
+					pendingWorks.emplace_back(m_Pool->QueueWork([&body, &exceptions, i, partitionFirst, partitionLast](void*) -> nuInt
+					{
+						try
+						{
+							body(i, partitionFirst, partitionLast);
+						}
+						catch (...)
+						{
+							exceptions[i] = std::current_exception();
+						}
+						return 0;
+					}));
+					partitionFirst = std::move(partitionLast);
+				}
+
+				body(0, std::move(first), firstLast);
+			}
+			catch (...)
+			{
+				waitAll();
+				throw;
+			}
+
+			waitAll();
+
+			for (auto&& exception : exceptions)
+			{
+				if (exception)
+				{
+					std::rethrow_exception(exception);
+				}
+			}
+		}
+	};
+}
+
+#ifdef _MSC_VER
+#pragma pop_macro("min")
+#pragma pop_macro("max")
+#endif
@@ -7,9 +7,11 @@
 #include <cassert>
 
 #include <mutex>
+#include <thread>
 #include <atomic>
 #include <memory>
 #include <functional>
+#include <utility>
 
 #ifdef TraceRefObj
 #include "natUtil.h"
@@ -40,6 +42,83 @@ namespace NatsuLib
 		virtual nBool Release() const volatile = 0;
 	};
 
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	引用计数策略
+	///	@remark	作为 natRefObjImpl 的模板参数，决定引用计数的存储及增减方式
+	////////////////////////////////////////////////////////////////////////////////
+	namespace RefCountPolicy
+	{
+		///	@brief	原子的引用计数，可在线程间共享，默认的策略
+		struct Atomic
+		{
+			typedef std::atomic<size_t> CounterType;
+
+			static size_t Load(CounterType const volatile& counter) noexcept
+			{
+				return counter.load(std::memory_order_relaxed);
+			}
+
+			static void Increment(CounterType volatile& counter) noexcept
+			{
+				counter.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			///	@return	引用计数是否已为0
+			static nBool Decrement(CounterType volatile& counter) noexcept
+			{
+				return counter.fetch_sub(1, std::memory_order_acq_rel) == 1;
+			}
+
+			static nBool TryIncrement(CounterType volatile& counter) noexcept
+			{
+				auto oldValue = counter.load(std::memory_order_relaxed);
+				do
+				{
+					if (oldValue == 0)
+					{
+						return false;
+					}
+				} while (!counter.compare_exchange_weak(oldValue, oldValue + 1, std::memory_order_relaxed, std::memory_order_relaxed));
+				return true;
+			}
+		};
+
+		///	@brief	非原子的引用计数
+		///	@warning	仅能用于只在一个线程中使用的对象，包括对其弱引用的升级
+		struct NonAtomic
+		{
+			typedef size_t CounterType;
+
+			static size_t Load(CounterType const volatile& counter) noexcept
+			{
+				return counter;
+			}
+
+			static void Increment(CounterType volatile& counter) noexcept
+			{
+				counter = counter + 1;
+			}
+
+			static nBool Decrement(CounterType volatile& counter) noexcept
+			{
+				const auto newValue = counter - 1;
+				counter = newValue;
+				return newValue == 0;
+			}
+
+			static nBool TryIncrement(CounterType volatile& counter) noexcept
+			{
+				const auto oldValue = counter;
+				if (oldValue == 0)
+				{
+					return false;
+				}
+				counter = oldValue + 1;
+				return true;
+			}
+		};
+	}
+
 	template <typename T>
 	class natRefPointer;
 
@@ -73,11 +152,121 @@ namespace NatsuLib
 			return static_cast_or_dynamic_cast_helper<Dst, Src>::Do(src);
 		}
 
-		template <typename BaseClass = natRefObj>
+		struct AdoptRef_t
+		{
+			constexpr AdoptRef_t() = default;
+		};
+
+		constexpr AdoptRef_t AdoptRef{};
+
+		////////////////////////////////////////////////////////////////////////////////
+		///	@brief	弱引用的控制块
+		///	@remark	控制字的低 32 位为弱引用计数（本体持有其中 1 个），其余位为正在升级的弱引用数及本体存活标记，
+		///			升级时先以 CAS 在本体存活时登记，再以 CAS 尝试增加本体的强引用计数，全程不需要加锁
+		///	@note	本体的强引用计数归零时清除存活标记，并等待已登记的升级完成后才会销毁本体
+		////////////////////////////////////////////////////////////////////////////////
+		template <typename Owner>
+		class WeakRefView final
+		{
+			static constexpr nuLong WeakCountMask = 0xFFFFFFFFull;
+			static constexpr nuLong LockerUnit = 0x100000000ull;
+			static constexpr nuLong LockerMask = 0x7FFFFFFF00000000ull;
+			static constexpr nuLong OwnerAliveFlag = 0x8000000000000000ull;
+
+		public:
+			constexpr explicit WeakRefView(std::add_pointer_t<Owner> owner) noexcept
+				: m_Owner{ owner }, m_Control{ OwnerAliveFlag | 1 }
+			{
+			}
+
+			///	@brief	增加弱引用计数
+			void AddRef() const noexcept
+			{
+				m_Control.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			///	@brief	减少弱引用计数，归零时销毁自身
+			void Release() const noexcept
+			{
+				if ((m_Control.fetch_sub(1, std::memory_order_acq_rel) & WeakCountMask) == 1)
+				{
+					delete this;
+				}
+			}
+
+			///	@brief	获得除本体以外持有此控制块的弱引用数
+			size_t GetWeakCount() const noexcept
+			{
+				const auto control = m_Control.load(std::memory_order_relaxed);
+				return static_cast<size_t>((control & WeakCountMask) - ((control & OwnerAliveFlag) ? 1 : 0));
+			}
+
+			nBool IsOwnerAlive() const noexcept
+			{
+				return m_Control.load(std::memory_order_acquire) & OwnerAliveFlag;
+			}
+
+			///	@brief	使弱引用失效
+			///	@remark	由本体在强引用计数归零时调用，返回时不再有弱引用正在访问本体，可重复调用
+			void ClearOwner() const noexcept
+			{
+				auto control = m_Control.fetch_and(~OwnerAliveFlag, std::memory_order_acq_rel);
+				while (control & LockerMask)
+				{
+					std::this_thread::yield();
+					control = m_Control.load(std::memory_order_acquire);
+				}
+			}
+
+			template <typename T>
+			natRefPointer<T> LockOwner() const
+			{
+				auto control = m_Control.load(std::memory_order_relaxed);
+				do
+				{
+					if (!(control & OwnerAliveFlag))
+					{
+						return {};
+					}
+				} while (!m_Control.compare_exchange_weak(control, control + LockerUnit, std::memory_order_acquire, std::memory_order_relaxed));
+
+				// 已登记，本体在离开之前不会被销毁
+				const auto other = static_cast_or_dynamic_cast<std::add_pointer_t<T>>(m_Owner);
+				const auto succeeded = other && static_cast<std::add_pointer_t<std::add_cv_t<Owner>>>(m_Owner)->TryAddRef();
+				m_Control.fetch_sub(LockerUnit, std::memory_order_release);
+
+				if (!succeeded)
+				{
+					return {};
+				}
+
+				return natRefPointer<T>{ AdoptRef, other };
+			}
+
+		private:
+			const std::add_pointer_t<Owner> m_Owner;
+			mutable std::atomic<nuLong> m_Control;
+		};
+
+		template <typename T, typename = void>
+		struct HasRefCountImpl
+			: std::false_type
+		{
+		};
+
+		template <typename T>
+		struct HasRefCountImpl<T, std::void_t<typename T::RefCountImpl>>
+			: std::true_type
+		{
+		};
+
+		template <typename BaseClass = natRefObj, typename Policy = RefCountPolicy::Atomic, nBool = HasRefCountImpl<BaseClass>::value>
 		class RefCountBase
 			: public BaseClass
 		{
 		public:
+			typedef Policy CounterPolicy;
+
 			nBool IsUnique() const volatile noexcept
 			{
 				return GetRefCount() == 1;
@@ -85,43 +274,34 @@ namespace NatsuLib
 
 			virtual size_t GetRefCount() const volatile noexcept
 			{
-				return m_RefCount.load(std::memory_order_relaxed);
+				return Policy::Load(m_RefCount);
 			}
 
 			virtual nBool TryAddRef() const volatile
 			{
-				auto oldValue = m_RefCount.load(std::memory_order_relaxed);
-				assert(static_cast<std::ptrdiff_t>(oldValue) >= 0);
-				do
-				{
-					if (oldValue == 0)
-					{
-						return false;
-					}
-				} while (!m_RefCount.compare_exchange_strong(oldValue, oldValue + 1, std::memory_order_relaxed, std::memory_order_relaxed));
-				return true;
+				assert(static_cast<std::ptrdiff_t>(Policy::Load(m_RefCount)) >= 0);
+				return Policy::TryIncrement(m_RefCount);
 			}
 
 			virtual void AddRef() const volatile
 			{
-				assert(static_cast<std::ptrdiff_t>(m_RefCount.load(std::memory_order_relaxed)) > 0);
-				m_RefCount.fetch_add(1, std::memory_order_relaxed);
+				assert(static_cast<std::ptrdiff_t>(Policy::Load(m_RefCount)) > 0);
+				Policy::Increment(m_RefCount);
 			}
 
 			virtual nBool Release() const volatile
 			{
-				assert(static_cast<std::ptrdiff_t>(m_RefCount.load(std::memory_order_relaxed)) > 0);
-				return m_RefCount.fetch_sub(1, std::memory_order_relaxed) == 1;
+				return RefCountBase::DecrementRef();
 			}
 
 			template <typename... Args>
 			constexpr RefCountBase(Args&&... args) //noexcept(std::is_nothrow_constructible_v<BaseClass, decltype(args)...>)
-				: BaseClass(std::forward<Args>(args)...), m_RefCount(1)
+				: BaseClass(std::forward<Args>(args)...), m_RefCount(1), m_View{ nullptr }
 			{
 			}
 
 			constexpr RefCountBase(RefCountBase const& other) //noexcept(std::is_nothrow_copy_constructible_v<BaseClass>)
-				: BaseClass(static_cast<BaseClass const&>(other)), m_RefCount(1)
+				: BaseClass(static_cast<BaseClass const&>(other)), m_RefCount(1), m_View{ nullptr }
 			{
 			}
 
@@ -132,7 +312,7 @@ namespace NatsuLib
 			}
 
 			constexpr RefCountBase(RefCountBase&& other) //noexcept(std::is_nothrow_move_constructible_v<BaseClass>)
-				: BaseClass(static_cast<BaseClass&&>(other)), m_RefCount(1)
+				: BaseClass(static_cast<BaseClass&&>(other)), m_RefCount(1), m_View{ nullptr }
 			{
 			}
 
@@ -145,56 +325,89 @@ namespace NatsuLib
 			~RefCountBase()
 			{
 				assert(RefCountBase::GetRefCount() <= 1);
+				if (const auto view = m_View.load(std::memory_order_acquire))
+				{
+					view->ClearOwner();
+					view->Release();
+				}
+			}
+
+		protected:
+			///	@brief	减少引用计数，返回是否已归零
+			nBool DecrementRef() const volatile noexcept
+			{
+				assert(static_cast<std::ptrdiff_t>(Policy::Load(m_RefCount)) > 0);
+				return Policy::Decrement(m_RefCount);
+			}
+
+			///	@brief	获得弱引用的控制块，尚未创建时创建
+			WeakRefView<natRefObj>* CreateWeakRefView() const volatile
+			{
+				auto view = m_View.load(std::memory_order_consume);
+				if (!view)
+				{
+					const auto newView = new WeakRefView<natRefObj>(const_cast<RefCountBase*>(this));
+					if (m_View.compare_exchange_strong(view, newView, std::memory_order_release, std::memory_order_consume))
+					{
+						view = newView;
+					}
+					else
+					{
+						delete newView;
+					}
+				}
+				return view;
+			}
+
+			///	@brief	使弱引用失效，返回时不再有弱引用正在访问本体
+			void ClearWeakRefView() const volatile noexcept
+			{
+				if (const auto view = m_View.load(std::memory_order_acquire))
+				{
+					view->ClearOwner();
+				}
 			}
 
 		private:
-			mutable std::atomic<size_t> m_RefCount;
+			mutable typename Policy::CounterType m_RefCount;
+			mutable std::atomic<WeakRefView<natRefObj>*> m_View;
 		};
 
-		template <typename Owner>
-		class WeakRefView final
-			: public RefCountBase<natRefObj>
+		///	@brief	基类已实现引用计数时沿用基类的引用计数及弱引用的控制块，保证每个对象仅有一个引用计数及控制块
+		template <typename BaseClass, typename Policy>
+		class RefCountBase<BaseClass, Policy, true>
+			: public BaseClass
 		{
+			static_assert(std::is_same<Policy, typename BaseClass::CounterPolicy>::value, "Policy should be the same as the one used by BaseClass.");
+
 		public:
-			constexpr explicit WeakRefView(std::add_pointer_t<Owner> owner) noexcept
-				: m_Owner{ owner }
+			template <typename... Args>
+			constexpr RefCountBase(Args&&... args)
+				: BaseClass(std::forward<Args>(args)...)
 			{
 			}
 
-			nBool IsOwnerAlive() const
+			constexpr RefCountBase(RefCountBase const& other)
+				: BaseClass(static_cast<BaseClass const&>(other))
 			{
-				const std::lock_guard<std::mutex> lock{ m_Mutex };
-				const auto owner = m_Owner;
-				return owner && static_cast<const volatile RefCountBase*>(owner)->GetRefCount() > 0;
 			}
 
-			void ClearOwner()
+			RefCountBase& operator=(RefCountBase const& other)
 			{
-				const std::lock_guard<std::mutex> lock{ m_Mutex };
-				m_Owner = nullptr;
+				static_cast<BaseClass&>(*this) = static_cast<BaseClass const&>(other);
+				return *this;
 			}
 
-			template <typename T>
-			natRefPointer<T> LockOwner() const
+			constexpr RefCountBase(RefCountBase&& other)
+				: BaseClass(static_cast<BaseClass&&>(other))
 			{
-				const std::lock_guard<std::mutex> lock{ m_Mutex };
-				const auto other = static_cast_or_dynamic_cast<std::add_pointer_t<T>>(m_Owner);
-				if (!other)
-				{
-					return {};
-				}
-
-				if (!static_cast<std::add_pointer_t<std::add_cv_t<Owner>>>(m_Owner)->TryAddRef())
-				{
-					return {};
-				}
-
-				return natRefPointer<T>{ other };
 			}
 
-		private:
-			mutable std::mutex m_Mutex;
-			std::add_pointer_t<Owner> m_Owner;
+			RefCountBase& operator=(RefCountBase&& other)
+			{
+				static_cast<BaseClass&>(*this) = static_cast<BaseClass&&>(other);
+				return *this;
+			}
 		};
 
 		struct SpecifySelfDeleter_t
@@ -203,6 +416,75 @@ namespace NatsuLib
 		};
 
 		constexpr SpecifySelfDeleter_t SpecifySelfDeleter{};
+
+		template <typename Allocator, typename = void>
+		struct HasDeallocate
+			: std::false_type
+		{
+		};
+
+		template <typename Allocator>
+		struct HasDeallocate<Allocator, std::void_t<decltype(std::declval<Allocator&>().Deallocate(std::declval<void*>(), size_t{}, size_t{}))>>
+			: std::true_type
+		{
+		};
+
+		///	@brief	由 allocate_ref 分配的对象的内存布局
+		///	@remark	需要归还内存时在对象之前保存指向分配器的指针
+		template <typename TRefObj, nBool StoreAllocator>
+		struct AllocatedRefObjLayout
+		{
+			static constexpr size_t Alignment = alignof(TRefObj) > alignof(void*) ? alignof(TRefObj) : alignof(void*);
+			static constexpr size_t HeaderSize = StoreAllocator ? (sizeof(void*) + Alignment - 1) / Alignment * Alignment : 0;
+			static constexpr size_t Size = HeaderSize + sizeof(TRefObj);
+		};
+
+		template <typename TRefObj, typename Allocator>
+		struct AllocatedRefObj
+			: AllocatedRefObjLayout<TRefObj, HasDeallocate<Allocator>::value>
+		{
+			typedef AllocatedRefObjLayout<TRefObj, HasDeallocate<Allocator>::value> Layout;
+
+			template <typename... Args>
+			static TRefObj* Create(Allocator& allocator, Args&&... args)
+			{
+				const auto memory = static_cast<nByte*>(allocator.Allocate(Layout::Size, Layout::Alignment));
+				if constexpr (HasDeallocate<Allocator>::value)
+				{
+					*reinterpret_cast<Allocator**>(memory) = std::addressof(allocator);
+					try
+					{
+						return ::new(static_cast<void*>(memory + Layout::HeaderSize)) TRefObj(std::forward<Args>(args)...);
+					}
+					catch (...)
+					{
+						allocator.Deallocate(memory, Layout::Size, Layout::Alignment);
+						throw;
+					}
+				}
+				else
+				{
+					return ::new(static_cast<void*>(memory)) TRefObj(std::forward<Args>(args)...);
+				}
+			}
+
+			template <typename T>
+			static void Delete(T* ptr) noexcept
+			{
+				const auto pRefObj = static_cast<TRefObj*>(ptr);
+				if constexpr (HasDeallocate<Allocator>::value)
+				{
+					const auto memory = reinterpret_cast<nByte*>(pRefObj) - Layout::HeaderSize;
+					const auto allocator = *reinterpret_cast<Allocator**>(memory);
+					pRefObj->~TRefObj();
+					allocator->Deallocate(memory, Layout::Size, Layout::Alignment);
+				}
+				else
+				{
+					pRefObj->~TRefObj();
+				}
+			}
+		};
 	}
 
 	using detail_::SpecifySelfDeleter_t;
@@ -211,28 +493,29 @@ namespace NatsuLib
 	////////////////////////////////////////////////////////////////////////////////
 	///	@brief	引用计数实现
 	///	@note	使用模板防止菱形继承
+	///	@remark	静态类型为本类派生类的 natRefPointer 以非虚调用增减引用计数，以便内联，
+	///			因此派生类不应再重写 AddRef 及 Release，
+	///			嵌套的 natRefObjImpl 共用最内层的引用计数及弱引用的控制块，计数归零后由最终派生的一层销毁对象
+	///	@tparam	Policy	引用计数策略，参见 RefCountPolicy
 	////////////////////////////////////////////////////////////////////////////////
-	template <typename T, typename B = natRefObj>
+	template <typename T, typename B = natRefObj, typename Policy = RefCountPolicy::Atomic>
 	class natRefObjImpl
-		: public detail_::RefCountBase<B>
+		: public detail_::RefCountBase<B, Policy>
 	{
 		static_assert(std::is_base_of<natRefObj, B>::value, "B should inherit natRefObj.");
 
 		template <typename T_>
 		friend class natWeakRefPointer;
 
-		typedef detail_::RefCountBase<B> RefCountBase;
+		typedef detail_::RefCountBase<B, Policy> RefCountBase;
 
 		template <typename TRefObj, typename... Args>
 		friend natRefPointer<TRefObj> make_ref(Args&&... args);
 
-		struct DefaultDeleter
+		static void DefaultDelete(T* ptr) noexcept
 		{
-			void operator()(T* ptr) const noexcept
-			{
-				delete ptr;
-			}
-		};
+			delete ptr;
+		}
 
 	protected:
 		typedef natRefObjImpl RefObjImpl;
@@ -248,12 +531,17 @@ namespace NatsuLib
 		}
 
 	public:
-		typedef std::function<void(T*)> SelfDeleter;
+		///	@brief	引用计数归零时用于销毁自身的函数
+		///	@remark	为空时不销毁对象，用于并非由 make_ref 或 allocate_ref 创建的对象
+		typedef void(*SelfDeleter)(T*);
 		typedef detail_::WeakRefView<natRefObj> WeakRefView;
 
 		typedef natRefPointer<T> RefPointer;
 		typedef natWeakRefPointer<T> WeakRefPointer;
 
+		///	@brief	实现引用计数的类型，供 natRefPointer 进行非虚调用
+		typedef natRefObjImpl RefCountImpl;
+
 		template <typename... Args>
 		constexpr natRefObjImpl(Args&&... args) //noexcept(std::is_nothrow_constructible_v<natRefObjImpl, SpecifySelfDeleter_t, SelfDeleter, decltype(args)...>)
 			: natRefObjImpl(SpecifySelfDeleter, {}, std::forward<Args>(args)...)
@@ -262,7 +550,7 @@ namespace NatsuLib
 
 		template <typename... Args>
 		constexpr natRefObjImpl(SpecifySelfDeleter_t, SelfDeleter deleter, Args&&... args) //noexcept(std::is_nothrow_constructible_v<RefCountBase, decltype(args)...>)
-			: RefCountBase(std::forward<Args>(args)...), m_View{ nullptr }, m_Deleter{ std::move(deleter) }
+			: RefCountBase(std::forward<Args>(args)...), m_Deleter{ deleter }
 		{
 #ifdef TraceRefObj
 			OutputDebugString(natUtil::FormatString("Type %s created at (%p)\n"_nv, nStringView{ typeid(*this).name() }, this).c_str());
@@ -270,7 +558,7 @@ namespace NatsuLib
 		}
 
 		constexpr natRefObjImpl(natRefObjImpl const& other) noexcept(std::is_nothrow_copy_constructible_v<RefCountBase>)
-			: RefCountBase(static_cast<RefCountBase const&>(other)), m_View{ nullptr }
+			: RefCountBase(static_cast<RefCountBase const&>(other)), m_Deleter{ nullptr }
 		{
 		}
 
@@ -281,7 +569,7 @@ namespace NatsuLib
 		}
 
 		constexpr natRefObjImpl(natRefObjImpl&& other) noexcept(std::is_nothrow_move_constructible_v<RefCountBase>)
-			: RefCountBase(static_cast<RefCountBase&&>(other)), m_View{ nullptr }
+			: RefCountBase(static_cast<RefCountBase&&>(other)), m_Deleter{ nullptr }
 		{
 		}
 
@@ -296,34 +584,21 @@ namespace NatsuLib
 #ifdef TraceRefObj
 			OutputDebugString(natUtil::FormatString("Type %s destroyed at (%p)\n"_nv, nStringView{ typeid(*this).name() }, this).c_str());
 #endif
-			const auto view = m_View.load(std::memory_order_consume);
-			if (view)
-			{
-				if (static_cast<const volatile detail_::RefCountBase<natRefObj>*>(view)->Release())
-				{
-					delete view;
-				}
-				else
-				{
-					view->ClearOwner();
-				}
-			}
 		}
 
 		nBool Release() const volatile override
 		{
-			const auto result = RefCountBase::Release();
-			const SelfDeleter& deleter = const_cast<const SelfDeleter&>(m_Deleter);
-			if (result && deleter)
+			const auto result = RefCountBase::DecrementRef();
+			if (result)
 			{
-				deleter(static_cast<T*>(const_cast<natRefObjImpl*>(this)));
+				destroySelf();
 			}
 			return result;
 		}
 
-		void SetDeleter(SelfDeleter deleter = DefaultDeleter{})
+		void SetDeleter(SelfDeleter deleter = &DefaultDelete) noexcept
 		{
-			m_Deleter = std::move(deleter);
+			m_Deleter = deleter;
 		}
 
 		template <typename U = T>
@@ -375,6 +650,19 @@ namespace NatsuLib
 		}
 
 	private:
+		// 引用计数归零时调用，由最终派生的一层进行销毁
+		virtual void destroySelf() const volatile noexcept
+		{
+			// 在销毁之前使弱引用失效，之后不会再有弱引用访问本体
+			RefCountBase::ClearWeakRefView();
+
+			const auto deleter = const_cast<const SelfDeleter&>(m_Deleter);
+			if (deleter)
+			{
+				deleter(static_cast<T*>(const_cast<natRefObjImpl*>(this)));
+			}
+		}
+
 		template <typename CVU, typename CVT>
 		static natRefPointer<CVU> forkRefImpl(CVT* pThis)
 		{
@@ -401,26 +689,59 @@ namespace NatsuLib
 
 		WeakRefView* createWeakRefView() const volatile
 		{
-			auto view = m_View.load(std::memory_order_consume);
-			if (!view)
-			{
-				const auto newView = new WeakRefView(const_cast<natRefObjImpl*>(this));
-				if (m_View.compare_exchange_strong(view, newView, std::memory_order_release, std::memory_order_consume))
-				{
-					view = newView;
-				}
-				else
-				{
-					delete newView;
-				}
-			}
-			return view;
+			return RefCountBase::CreateWeakRefView();
 		}
 
-		mutable std::atomic<WeakRefView*> m_View;
 		SelfDeleter m_Deleter;
 	};
 
+	namespace detail_
+	{
+		///	@brief	增加引用计数
+		///	@remark	若静态类型已知引用计数的实现则进行非虚调用，否则通过 natRefObj 接口调用
+		template <typename T>
+		void RefPointerAddRef(T* ptr) noexcept
+		{
+			if constexpr (HasRefCountImpl<std::remove_cv_t<T>>::value)
+			{
+				typedef typename std::remove_cv_t<T>::RefCountImpl Impl;
+				static_cast<const volatile Impl*>(ptr)->Impl::AddRef();
+			}
+			else
+			{
+				static_cast<const volatile natRefObj*>(ptr)->AddRef();
+			}
+		}
+
+		template <typename T>
+		void RefPointerRelease(T* ptr) noexcept
+		{
+			if constexpr (HasRefCountImpl<std::remove_cv_t<T>>::value)
+			{
+				typedef typename std::remove_cv_t<T>::RefCountImpl Impl;
+				static_cast<void>(static_cast<const volatile Impl*>(ptr)->Impl::Release());
+			}
+			else
+			{
+				static_cast<void>(static_cast<const volatile natRefObj*>(ptr)->Release());
+			}
+		}
+
+		template <typename T>
+		size_t RefPointerGetRefCount(T* ptr) noexcept
+		{
+			if constexpr (HasRefCountImpl<std::remove_cv_t<T>>::value)
+			{
+				typedef typename std::remove_cv_t<T>::RefCountImpl Impl;
+				return static_cast<const volatile Impl*>(ptr)->Impl::GetRefCount();
+			}
+			else
+			{
+				return static_cast<const volatile natRefObj*>(ptr)->GetRefCount();
+			}
+		}
+	}
+
 	////////////////////////////////////////////////////////////////////////////////
 	///	@brief	强引用指针实现
 	///	@note	仅能用于引用计数对象
@@ -430,6 +751,16 @@ namespace NatsuLib
 	{
 		template <typename>
 		friend class natRefPointer;
+
+		template <typename>
+		friend class detail_::WeakRefView;
+
+		// 接管已增加的引用计数
+		constexpr natRefPointer(detail_::AdoptRef_t, T* ptr) noexcept
+			: m_pPointer(ptr)
+		{
+		}
+
 	public:
 		typedef std::add_pointer_t<T> pointer;
 
@@ -443,7 +774,7 @@ namespace NatsuLib
 		{
 			if (m_pPointer)
 			{
-				static_cast<const volatile natRefObj*>(m_pPointer)->AddRef();
+				detail_::RefPointerAddRef(m_pPointer);
 			}
 		}
 
@@ -452,7 +783,7 @@ namespace NatsuLib
 		{
 			if (m_pPointer)
 			{
-				static_cast<const volatile natRefObj*>(m_pPointer)->AddRef();
+				detail_::RefPointerAddRef(m_pPointer);
 			}
 		}
 
@@ -468,7 +799,7 @@ namespace NatsuLib
 		{
 			if (m_pPointer)
 			{
-				static_cast<const volatile natRefObj*>(m_pPointer)->AddRef();
+				detail_::RefPointerAddRef(m_pPointer);
 			}
 		}
 
@@ -489,7 +820,7 @@ namespace NatsuLib
 		{
 			if (m_pPointer)
 			{
-				static_cast<void>(static_cast<const volatile natRefObj*>(m_pPointer)->Release());
+				detail_::RefPointerRelease(m_pPointer);
 			}
 		}
 
@@ -619,7 +950,7 @@ namespace NatsuLib
 		{
 			if (m_pPointer)
 			{
-				static_cast<void>(static_cast<const volatile natRefObj*>(m_pPointer)->Release());
+				detail_::RefPointerRelease(m_pPointer);
 				m_pPointer = nullptr;
 			}
 
@@ -666,7 +997,7 @@ namespace NatsuLib
 			{
 				return 0;
 			}
-			return static_cast<const volatile natRefObj*>(ptr)->GetRefCount();
+			return detail_::RefPointerGetRefCount(ptr);
 		}
 
 		void swap(natRefPointer& other) noexcept
@@ -690,6 +1021,21 @@ namespace NatsuLib
 		return ret;
 	}
 
+	///	@brief	使用分配器创建引用计数对象
+	///	@param[in]	allocator	提供 Allocate(size, alignment) 的分配器，若同时提供 Deallocate(ptr, size, alignment) 则在对象销毁时归还内存
+	///	@note	分配器必须比所创建的对象存活更久，对于不提供 Deallocate 的分配器（如 natArena）仅调用析构函数，内存由分配器统一回收
+	template <typename TRefObj, typename Allocator, typename... Args>
+	natRefPointer<TRefObj> allocate_ref(Allocator& allocator, Args&&... args)
+	{
+		typedef detail_::AllocatedRefObj<TRefObj, Allocator> AllocatedRefObj;
+
+		const auto pRefObj = AllocatedRefObj::Create(allocator, std::forward<Args>(args)...);
+		pRefObj->SetDeleter(&AllocatedRefObj::Delete);
+		natRefPointer<TRefObj> ret(pRefObj);
+		pRefObj->Release();
+		return ret;
+	}
+
 	////////////////////////////////////////////////////////////////////////////////
 	///	@brief	弱引用指针实现
 	///	@note	仅能用于引用计数对象
@@ -788,7 +1134,7 @@ namespace NatsuLib
 			{
 				return 0;
 			}
-			return view->GetRefCount() - 1;	// 本体自带1个对WeakRefView的引用
+			return view->GetWeakCount();
 		}
 
 		template <typename U = T>
@@ -907,7 +1253,7 @@ namespace NatsuLib
 			const auto view = m_View;
 			if (view)
 			{
-				static_cast<const volatile natRefObj*>(m_View)->AddRef();
+				view->AddRef();
 			}
 			return view;
 		}
@@ -0,0 +1,794 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+///	@file	natRope.h
+///	@brief	适用于大文本的绳索（Rope）字符串
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <memory>
+#include <iterator>
+#include <algorithm>
+#include <utility>
+
+#include "natString.h"
+
+namespace NatsuLib
+{
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	绳索字符串
+	///	@remark	以 AVL 平衡的不可变二叉树存储若干分块，插入、删除、切片均为 O(log n)，
+	///			连接两个 Rope 为 O(log n)，复制 Rope 为 O(1) 且与原对象共享分块
+	///	@note	分块可在任意编码单元处切分，因此单个分块不保证以完整的字符开始或结束
+	////////////////////////////////////////////////////////////////////////////////
+	template <StringType stringType>
+	class Rope
+	{
+		struct Node;
+		typedef std::shared_ptr<const Node> NodePtr;
+
+	public:
+		static constexpr StringType UsingStringType = stringType;
+
+		typedef StringView<stringType> View;
+		typedef typename View::CharType CharType;
+		typedef CharType Element;
+
+		enum : std::size_t
+		{
+			npos = detail_::npos,
+			MaxLeafSize = 512,	///< @brief	相邻的分块总长度不超过此值时将会被合并为一个分块
+		};
+
+		class const_iterator
+		{
+		public:
+			typedef std::bidirectional_iterator_tag iterator_category;
+			typedef CharType value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef const CharType* pointer;
+			typedef const CharType& reference;
+
+			const_iterator() noexcept
+				: m_Rope{}, m_Pos{}, m_ChunkBegin{}
+			{
+			}
+
+			reference operator*() const noexcept
+			{
+				return m_Chunk[m_Pos - m_ChunkBegin];
+			}
+
+			pointer operator->() const noexcept
+			{
+				return &**this;
+			}
+
+			const_iterator& operator++() noexcept
+			{
+				++m_Pos;
+				if (m_Pos - m_ChunkBegin >= m_Chunk.size())
+				{
+					Locate();
+				}
+				return *this;
+			}
+
+			const_iterator operator++(int) noexcept
+			{
+				auto ret = *this;
+				++*this;
+				return ret;
+			}
+
+			const_iterator& operator--() noexcept
+			{
+				--m_Pos;
+				if (m_Pos < m_ChunkBegin || m_Pos - m_ChunkBegin >= m_Chunk.size())
+				{
+					Locate();
+				}
+				return *this;
+			}
+
+			const_iterator operator--(int) noexcept
+			{
+				auto ret = *this;
+				--*this;
+				return ret;
+			}
+
+			nBool operator==(const_iterator const& other) const noexcept
+			{
+				return m_Pos == other.m_Pos;
+			}
+
+			nBool operator!=(const_iterator const& other) const noexcept
+			{
+				return m_Pos != other.m_Pos;
+			}
+
+			///	@brief	获得当前位置在 Rope 中的下标
+			std::size_t GetPosition() const noexcept
+			{
+				return m_Pos;
+			}
+
+		private:
+			friend class Rope;
+
+			const_iterator(const Rope* rope, std::size_t pos) noexcept
+				: m_Rope{ rope }, m_Pos{ pos }, m_ChunkBegin{}
+			{
+				Locate();
+			}
+
+			void Locate() noexcept
+			{
+				if (m_Pos < m_Rope->size())
+				{
+					std::tie(m_Chunk, m_ChunkBegin) = m_Rope->GetChunkAt(m_Pos);
+				}
+				else
+				{
+					m_Chunk = {};
+					m_ChunkBegin = m_Pos;
+				}
+			}
+
+			const Rope* m_Rope;
+			std::size_t m_Pos;
+			View m_Chunk;
+			std::size_t m_ChunkBegin;
+		};
+
+		typedef const_iterator iterator;
+
+		Rope() = default;
+
+		Rope(View const& view)
+			: m_Root{ MakeLeaf(view) }
+		{
+		}
+
+		Rope(String<stringType> const& str)
+			: Rope{ str.GetView() }
+		{
+		}
+
+		///	@brief	以字符串构造，不会复制字符串内容
+		Rope(String<stringType>&& str)
+			: m_Root{ MakeLeaf(std::move(str)) }
+		{
+		}
+
+		Rope(const CharType* str)
+			: Rope{ View{ str } }
+		{
+		}
+
+		std::size_t size() const noexcept
+		{
+			return GetSize();
+		}
+
+		std::size_t GetSize() const noexcept
+		{
+			return m_Root ? m_Root->Size : 0;
+		}
+
+		nBool empty() const noexcept
+		{
+			return !m_Root;
+		}
+
+		nBool IsEmpty() const noexcept
+		{
+			return !m_Root;
+		}
+
+		void Clear() noexcept
+		{
+			m_Root.reset();
+		}
+
+		const_iterator begin() const noexcept
+		{
+			return { this, 0 };
+		}
+
+		const_iterator end() const noexcept
+		{
+			return { this, size() };
+		}
+
+		const_iterator cbegin() const noexcept
+		{
+			return begin();
+		}
+
+		const_iterator cend() const noexcept
+		{
+			return end();
+		}
+
+		const CharType& operator[](std::size_t pos) const noexcept
+		{
+			return UncheckGet(pos);
+		}
+
+		const CharType& Get(std::size_t index) const
+		{
+			if (index >= GetSize())
+			{
+				detail_::IndexOutOfRange();
+			}
+
+			return UncheckGet(index);
+		}
+
+		const CharType& UncheckGet(std::size_t pos) const noexcept
+		{
+			assert(pos < GetSize());
+
+			const auto chunk = GetChunkAt(pos);
+			return chunk.first[pos - chunk.second];
+		}
+
+		///	@brief	获得子串，参数的语义与 StringView::Slice 相同
+		Rope Slice(std::ptrdiff_t begin, std::ptrdiff_t end) const
+		{
+			const auto size = GetSize();
+			const auto realBegin = ApplyOffset(begin, size), realEnd = ApplyOffset(end, size);
+			if (realBegin >= realEnd)
+			{
+				return {};
+			}
+
+			return Rope{ Split(Split(m_Root, realEnd).first, realBegin).second };
+		}
+
+		Rope& Append(View const& view)
+		{
+			return Append(Rope{ view });
+		}
+
+		Rope& Append(String<stringType>&& str)
+		{
+			return Append(Rope{ std::move(str) });
+		}
+
+		Rope& Append(Rope const& other)
+		{
+			m_Root = Join(m_Root, other.m_Root);
+			return *this;
+		}
+
+		Rope& operator+=(View const& view)
+		{
+			return Append(view);
+		}
+
+		Rope& operator+=(Rope const& other)
+		{
+			return Append(other);
+		}
+
+		void Insert(std::size_t pos, Rope const& other)
+		{
+			if (pos > GetSize())
+			{
+				detail_::IndexOutOfRange();
+			}
+
+			auto parts = Split(m_Root, pos);
+			m_Root = Join(Join(parts.first, other.m_Root), parts.second);
+		}
+
+		void Insert(std::size_t pos, View const& view)
+		{
+			Insert(pos, Rope{ view });
+		}
+
+		void Erase(std::size_t pos, std::size_t length = npos)
+		{
+			const auto size = GetSize();
+			if (pos > size)
+			{
+				detail_::IndexOutOfRange();
+			}
+
+			length = std::min(length, size - pos);
+			auto head = Split(m_Root, pos);
+			m_Root = Join(head.first, Split(head.second, length).second);
+		}
+
+		///	@brief	按顺序遍历所有分块
+		///	@param[in]	callableObject	可被调用的对象，接受参数为 StringView
+		template <typename CallableObject>
+		void ForEachChunk(CallableObject callableObject) const
+		{
+			VisitChunks(m_Root, [&callableObject](View const& chunk)
+			{
+				callableObject(chunk);
+				return true;
+			});
+		}
+
+		std::size_t GetChunkCount() const noexcept
+		{
+			std::size_t count{};
+			VisitChunks(m_Root, [&count](View const&)
+			{
+				++count;
+				return true;
+			});
+			return count;
+		}
+
+		std::size_t Find(View const& pattern, std::ptrdiff_t nBegin = 0) const
+		{
+			const auto length = GetSize();
+			const auto realBegin = ApplyOffset(nBegin, length);
+			const auto patternLength = pattern.size();
+			if (patternLength == 0)
+			{
+				return realBegin;
+			}
+			if (realBegin + patternLength > length)
+			{
+				return npos;
+			}
+
+			// 逐个分块查找，并将上一个分块末尾的 patternLength - 1 个字符与当前分块开头拼接以处理跨越分块的匹配
+			String<stringType> window;
+			std::size_t chunkBegin = realBegin, result = npos;
+			VisitChunks(Split(m_Root, realBegin).second, [&](View const& chunk)
+			{
+				const auto carried = window.size();
+				if (carried)
+				{
+					window.Append(chunk.Slice(0, static_cast<std::ptrdiff_t>(std::min(chunk.size(), patternLength - 1))));
+					const auto pos = window.GetView().Find(pattern);
+					if (pos != npos && pos < carried)
+					{
+						result = chunkBegin - carried + pos;
+						return false;
+					}
+				}
+
+				const auto pos = chunk.Find(pattern);
+				if (pos != npos)
+				{
+					result = chunkBegin + pos;
+					return false;
+				}
+
+				if (chunk.size() >= patternLength - 1)
+				{
+					window = chunk.Slice(static_cast<std::ptrdiff_t>(chunk.size() - (patternLength - 1)), -1);
+				}
+				else
+				{
+					// 分块较短时 window 中已包含完整的分块，仅需截取末尾部分
+					if (!carried)
+					{
+						window = chunk;
+					}
+					if (window.size() > patternLength - 1)
+					{
+						window = String<stringType>{ window.GetView().Slice(static_cast<std::ptrdiff_t>(window.size() - (patternLength - 1)), -1) };
+					}
+				}
+
+				chunkBegin += chunk.size();
+				return true;
+			});
+
+			return result;
+		}
+
+		std::size_t Find(CharType findChar, std::ptrdiff_t nBegin = 0) const
+		{
+			const auto realBegin = ApplyOffset(nBegin, GetSize());
+			std::size_t chunkBegin = realBegin, result = npos;
+			VisitChunks(Split(m_Root, realBegin).second, [&](View const& chunk)
+			{
+				const auto pos = chunk.Find(findChar);
+				if (pos != npos)
+				{
+					result = chunkBegin + pos;
+					return false;
+				}
+
+				chunkBegin += chunk.size();
+				return true;
+			});
+
+			return result;
+		}
+
+		std::size_t FindBackward(View const& pattern, std::ptrdiff_t nEnd = -1) const
+		{
+			const auto realEnd = ApplyOffset(nEnd, GetSize());
+			if (pattern.empty())
+			{
+				return realEnd;
+			}
+
+			const auto part = Slice(0, static_cast<std::ptrdiff_t>(realEnd));
+			std::size_t result = npos;
+			for (auto pos = part.Find(pattern); pos != npos; pos = part.Find(pattern, static_cast<std::ptrdiff_t>(pos + 1)))
+			{
+				result = pos;
+			}
+
+			return result;
+		}
+
+		std::size_t FindBackward(CharType findChar, std::ptrdiff_t nEnd = -1) const
+		{
+			auto realEnd = ApplyOffset(nEnd, GetSize());
+			std::size_t result = npos;
+			VisitChunksBackward(Split(m_Root, realEnd).first, [&](View const& chunk)
+			{
+				realEnd -= chunk.size();
+				const auto pos = chunk.FindBackward(findChar);
+				if (pos != npos)
+				{
+					result = realEnd + pos;
+					return false;
+				}
+
+				return true;
+			});
+
+			return result;
+		}
+
+		nBool StartWith(View const& other) const
+		{
+			return size() >= other.size() && Slice(0, static_cast<std::ptrdiff_t>(other.size())).Compare(other) == 0;
+		}
+
+		nBool EndWith(View const& other) const
+		{
+			return size() >= other.size() && Slice(static_cast<std::ptrdiff_t>(size() - other.size()), -1).Compare(other) == 0;
+		}
+
+		nInt Compare(Rope const& other) const
+		{
+			return CompareRange(other.begin(), other.end());
+		}
+
+		nInt Compare(View const& other) const
+		{
+			return CompareRange(other.begin(), other.end());
+		}
+
+		nBool operator==(Rope const& other) const
+		{
+			return size() == other.size() && (m_Root == other.m_Root || Compare(other) == 0);
+		}
+
+		nBool operator!=(Rope const& other) const
+		{
+			return !(*this == other);
+		}
+
+		nBool operator<(Rope const& other) const
+		{
+			return Compare(other) < 0;
+		}
+
+		///	@brief	字符串分割函数
+		///	@param[in]	pattern		分割字符
+		///	@param[in]	callableObject	可被调用的对象，接受参数为 Rope
+		template <typename CallableObject>
+		void Split(View const& pattern, CallableObject callableObject) const
+		{
+			std::size_t pos{}, i{};
+			const auto strLen = size();
+
+			ForEachChunk([&](View const& chunk)
+			{
+				for (auto&& currentChar : chunk)
+				{
+					if (std::find(pattern.cbegin(), pattern.cend(), currentChar) != pattern.cend())
+					{
+						callableObject(Slice(static_cast<std::ptrdiff_t>(pos), static_cast<std::ptrdiff_t>(i)));
+						pos = i + 1;
+					}
+					++i;
+				}
+			});
+
+			if (pos != strLen)
+			{
+				callableObject(Slice(static_cast<std::ptrdiff_t>(pos), -1));
+			}
+		}
+
+		///	@brief	将所有分块复制到连续的字符串
+		String<stringType> ToString() const
+		{
+			String<stringType> result;
+			result.Reserve(size());
+			ForEachChunk([&result](View const& chunk)
+			{
+				result.Append(chunk);
+			});
+			return result;
+		}
+
+		///	@brief	将自身合并为单一分块，之后的访问及查找不再需要跨越分块
+		void Flatten()
+		{
+			if (m_Root && m_Root->Height > 1)
+			{
+				m_Root = MakeLeaf(ToString());
+			}
+		}
+
+	private:
+		struct Node
+		{
+			NodePtr Left, Right;
+			std::shared_ptr<const String<stringType>> Buffer;
+			std::size_t Offset;
+			std::size_t Size;
+			std::size_t Height;
+
+			nBool IsLeaf() const noexcept
+			{
+				return !Left;
+			}
+
+			View GetView() const noexcept
+			{
+				return { Buffer->data() + Offset, Size };
+			}
+		};
+
+		NodePtr m_Root;
+
+		explicit Rope(NodePtr root) noexcept
+			: m_Root{ std::move(root) }
+		{
+		}
+
+		static std::size_t ApplyOffset(std::ptrdiff_t offset, std::size_t size) noexcept
+		{
+			auto ret = static_cast<std::size_t>(offset);
+			if (offset < 0)
+			{
+				ret += size + 1;
+			}
+
+			assert(ret <= size);
+			return ret;
+		}
+
+		static std::size_t HeightOf(NodePtr const& node) noexcept
+		{
+			return node ? node->Height : 0;
+		}
+
+		static NodePtr MakeLeaf(std::shared_ptr<const String<stringType>> buffer, std::size_t offset, std::size_t size)
+		{
+			if (!size)
+			{
+				return {};
+			}
+
+			return std::make_shared<const Node>(Node{ {}, {}, std::move(buffer), offset, size, 1 });
+		}
+
+		static NodePtr MakeLeaf(String<stringType>&& str)
+		{
+			const auto size = str.size();
+			return MakeLeaf(std::make_shared<const String<stringType>>(std::move(str)), 0, size);
+		}
+
+		static NodePtr MakeLeaf(View const& view)
+		{
+			return view.empty() ? NodePtr{} : MakeLeaf(String<stringType>{ view });
+		}
+
+		static NodePtr MakeConcat(NodePtr left, NodePtr right)
+		{
+			const auto size = left->Size + right->Size;
+			const auto height = std::max(left->Height, right->Height) + 1;
+			return std::make_shared<const Node>(Node{ std::move(left), std::move(right), {}, 0, size, height });
+		}
+
+		static NodePtr RotateLeft(NodePtr const& node)
+		{
+			auto const& right = node->Right;
+			return MakeConcat(MakeConcat(node->Left, right->Left), right->Right);
+		}
+
+		static NodePtr RotateRight(NodePtr const& node)
+		{
+			auto const& left = node->Left;
+			return MakeConcat(left->Left, MakeConcat(left->Right, node->Right));
+		}
+
+		static NodePtr Balance(NodePtr const& left, NodePtr const& right)
+		{
+			const auto leftHeight = HeightOf(left), rightHeight = HeightOf(right);
+			if (leftHeight > rightHeight + 1)
+			{
+				if (HeightOf(left->Right) > HeightOf(left->Left))
+				{
+					return RotateRight(MakeConcat(RotateLeft(left), right));
+				}
+				return RotateRight(MakeConcat(left, right));
+			}
+			if (rightHeight > leftHeight + 1)
+			{
+				if (HeightOf(right->Left) > HeightOf(right->Right))
+				{
+					return RotateLeft(MakeConcat(left, RotateRight(right)));
+				}
+				return RotateLeft(MakeConcat(left, right));
+			}
+			return MakeConcat(left, right);
+		}
+
+		static NodePtr Join(NodePtr const& left, NodePtr const& right)
+		{
+			if (!left)
+			{
+				return right;
+			}
+			if (!right)
+			{
+				return left;
+			}
+
+			if (left->IsLeaf() && right->IsLeaf() && left->Size + right->Size <= MaxLeafSize)
+			{
+				String<stringType> merged;
+				merged.Reserve(left->Size + right->Size);
+				merged.Append(left->GetView());
+				merged.Append(right->GetView());
+				return MakeLeaf(std::move(merged));
+			}
+
+			const auto leftHeight = left->Height, rightHeight = right->Height;
+			if (leftHeight > rightHeight + 1)
+			{
+				return Balance(left->Left, Join(left->Right, right));
+			}
+			if (rightHeight > leftHeight + 1)
+			{
+				return Balance(Join(left, right->Left), right->Right);
+			}
+			return MakeConcat(left, right);
+		}
+
+		static std::pair<NodePtr, NodePtr> Split(NodePtr const& node, std::size_t pos)
+		{
+			if (!node || pos == 0)
+			{
+				return { {}, node };
+			}
+			if (pos >= node->Size)
+			{
+				return { node, {} };
+			}
+
+			if (node->IsLeaf())
+			{
+				return { MakeLeaf(node->Buffer, node->Offset, pos), MakeLeaf(node->Buffer, node->Offset + pos, node->Size - pos) };
+			}
+
+			const auto leftSize = node->Left->Size;
+			if (pos <= leftSize)
+			{
+				auto parts = Split(node->Left, pos);
+				return { std::move(parts.first), Join(parts.second, node->Right) };
+			}
+
+			auto parts = Split(node->Right, pos - leftSize);
+			return { Join(node->Left, parts.first), std::move(parts.second) };
+		}
+
+		template <typename Iter>
+		nInt CompareRange(Iter otherRead, Iter otherEnd) const
+		{
+			typedef std::make_unsigned_t<CharType> UChar;
+
+			auto read = begin();
+			const auto readEnd = end();
+
+			while (read != readEnd && otherRead != otherEnd)
+			{
+				const auto elem = static_cast<UChar>(*read);
+				const auto otherElem = static_cast<UChar>(*otherRead);
+				if (elem != otherElem)
+				{
+					return elem > otherElem ? 1 : -1;
+				}
+				++read; ++otherRead;
+			}
+
+			if (read != readEnd)
+			{
+				return 1;
+			}
+
+			return otherRead != otherEnd ? -1 : 0;
+		}
+
+		///	@brief	获得包含指定位置的分块及其起始位置
+		std::pair<View, std::size_t> GetChunkAt(std::size_t pos) const noexcept
+		{
+			assert(pos < GetSize());
+
+			auto node = m_Root.get();
+			std::size_t chunkBegin{};
+			while (!node->IsLeaf())
+			{
+				const auto leftSize = node->Left->Size;
+				if (pos < leftSize)
+				{
+					node = node->Left.get();
+				}
+				else
+				{
+					pos -= leftSize;
+					chunkBegin += leftSize;
+					node = node->Right.get();
+				}
+			}
+
+			return { node->GetView(), chunkBegin };
+		}
+
+		// visitor 返回 false 时停止遍历
+		template <typename Visitor>
+		static nBool VisitChunks(NodePtr const& node, Visitor&& visitor)
+		{
+			if (!node)
+			{
+				return true;
+			}
+			if (node->IsLeaf())
+			{
+				return visitor(node->GetView());
+			}
+			return VisitChunks(node->Left, visitor) && VisitChunks(node->Right, visitor);
+		}
+
+		template <typename Visitor>
+		static nBool VisitChunksBackward(NodePtr const& node, Visitor&& visitor)
+		{
+			if (!node)
+			{
+				return true;
+			}
+			if (node->IsLeaf())
+			{
+				return visitor(node->GetView());
+			}
+			return VisitChunksBackward(node->Right, visitor) && VisitChunksBackward(node->Left, visitor);
+		}
+	};
+
+	template <StringType stringType>
+	Rope<stringType> operator+(Rope<stringType> left, Rope<stringType> const& right)
+	{
+		left.Append(right);
+		return left;
+	}
+
+	typedef Rope<StringType::Utf8> U8Rope;
+	typedef Rope<StringType::Utf16> U16Rope;
+	typedef Rope<StringType::Utf32> U32Rope;
+
+#ifdef _WIN32
+	typedef Rope<StringType::Ansi> AnsiRope;
+	typedef Rope<StringType::Wide> WideRope;
+#endif
+
+	typedef U8Rope nRope;
+}
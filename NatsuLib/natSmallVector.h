@@ -0,0 +1,866 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+///	@file	natSmallVector.h
+///	@brief	带内联存储的顺序容器
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "natConfig.h"
+#include "natType.h"
+
+#ifdef _MSC_VER
+#	pragma push_macro("max")
+#endif
+#undef max
+
+namespace NatsuLib
+{
+	namespace detail_
+	{
+		// 异常在源文件中抛出，以便 natStackWalker 等被 natException.h 包含的头文件也可以使用这些容器
+		[[noreturn]] void InlineVectorOutOfRange();
+		[[noreturn]] void StaticVectorCapacityExceeded();
+
+		// 可以直接按字节复制后丢弃原对象的类型，搬移时不需要逐个调用移动构造及析构
+		template <typename T>
+		struct IsTriviallyRelocatable
+			: std::is_trivially_copyable<T>
+		{
+		};
+
+		template <typename T>
+		void DestroyRange(T* first, T* last) noexcept
+		{
+			if constexpr (!std::is_trivially_destructible<T>::value)
+			{
+				for (; first != last; ++first)
+				{
+					first->~T();
+				}
+			}
+		}
+
+		///	@brief	将 [first, last) 中的元素搬移到未初始化的 dest，搬移后原位置不再有对象
+		///	@remark	所有元素都构造完成后才析构原元素，构造时抛出异常则析构已构造的元素，原区间保持不变
+		///	@note	区间不能重叠
+		template <typename T>
+		void UninitializedRelocate(T* first, T* last, T* dest) noexcept(IsTriviallyRelocatable<T>::value || std::is_nothrow_move_constructible<T>::value)
+		{
+			if constexpr (IsTriviallyRelocatable<T>::value)
+			{
+				if (first != last)
+				{
+					std::memcpy(static_cast<void*>(dest), static_cast<const void*>(first), static_cast<size_t>(last - first) * sizeof(T));
+				}
+			}
+			else if constexpr (std::is_nothrow_move_constructible<T>::value)
+			{
+				for (auto p = first; p != last; ++p, ++dest)
+				{
+					::new (static_cast<void*>(dest)) T(std::move(*p));
+				}
+				DestroyRange(first, last);
+			}
+			else
+			{
+				auto current = dest;
+				try
+				{
+					for (auto p = first; p != last; ++p, ++current)
+					{
+						::new (static_cast<void*>(current)) T(std::move_if_noexcept(*p));
+					}
+				}
+				catch (...)
+				{
+					DestroyRange(dest, current);
+					throw;
+				}
+				DestroyRange(first, last);
+			}
+		}
+
+		////////////////////////////////////////////////////////////////////////////////
+		///	@brief	SmallVector 及 StaticVector 的公共实现
+		///	@remark	Derived 需提供 data()、capacity() 以及 Grow(size_type)，后者保证容量不小于参数且不改变元素，
+		///			StaticVector 的 Grow 在超出容量时抛出异常，SmallVector 的 Grow 将元素搬移到堆上
+		////////////////////////////////////////////////////////////////////////////////
+		template <typename Derived, typename T>
+		class InlineVectorBase
+		{
+		public:
+			typedef T value_type;
+			typedef size_t size_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef T& reference;
+			typedef T const& const_reference;
+			typedef T* pointer;
+			typedef T const* const_pointer;
+			typedef T* iterator;
+			typedef T const* const_iterator;
+			typedef std::reverse_iterator<iterator> reverse_iterator;
+			typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+			iterator begin() noexcept
+			{
+				return Data();
+			}
+
+			const_iterator begin() const noexcept
+			{
+				return Data();
+			}
+
+			const_iterator cbegin() const noexcept
+			{
+				return Data();
+			}
+
+			iterator end() noexcept
+			{
+				return Data() + m_Size;
+			}
+
+			const_iterator end() const noexcept
+			{
+				return Data() + m_Size;
+			}
+
+			const_iterator cend() const noexcept
+			{
+				return Data() + m_Size;
+			}
+
+			reverse_iterator rbegin() noexcept
+			{
+				return reverse_iterator{ end() };
+			}
+
+			const_reverse_iterator rbegin() const noexcept
+			{
+				return const_reverse_iterator{ end() };
+			}
+
+			const_reverse_iterator crbegin() const noexcept
+			{
+				return const_reverse_iterator{ end() };
+			}
+
+			reverse_iterator rend() noexcept
+			{
+				return reverse_iterator{ begin() };
+			}
+
+			const_reverse_iterator rend() const noexcept
+			{
+				return const_reverse_iterator{ begin() };
+			}
+
+			const_reverse_iterator crend() const noexcept
+			{
+				return const_reverse_iterator{ begin() };
+			}
+
+			nBool empty() const noexcept
+			{
+				return !m_Size;
+			}
+
+			size_type size() const noexcept
+			{
+				return m_Size;
+			}
+
+			size_type max_size() const noexcept
+			{
+				return std::numeric_limits<size_type>::max() / sizeof(T);
+			}
+
+			reference operator[](size_type pos) noexcept
+			{
+				assert(pos < m_Size && "pos is out of range.");
+				return Data()[pos];
+			}
+
+			const_reference operator[](size_type pos) const noexcept
+			{
+				assert(pos < m_Size && "pos is out of range.");
+				return Data()[pos];
+			}
+
+			reference at(size_type pos)
+			{
+				CheckPosition(pos);
+				return Data()[pos];
+			}
+
+			const_reference at(size_type pos) const
+			{
+				CheckPosition(pos);
+				return Data()[pos];
+			}
+
+			reference front() noexcept
+			{
+				assert(m_Size && "Container is empty.");
+				return Data()[0];
+			}
+
+			const_reference front() const noexcept
+			{
+				assert(m_Size && "Container is empty.");
+				return Data()[0];
+			}
+
+			reference back() noexcept
+			{
+				assert(m_Size && "Container is empty.");
+				return Data()[m_Size - 1];
+			}
+
+			const_reference back() const noexcept
+			{
+				assert(m_Size && "Container is empty.");
+				return Data()[m_Size - 1];
+			}
+
+			void push_back(T const& value)
+			{
+				emplace_back(value);
+			}
+
+			void push_back(T&& value)
+			{
+				emplace_back(std::move(value));
+			}
+
+			///	@note	参数可以引用容器内的元素
+			template <typename... Args>
+			reference emplace_back(Args&&... args)
+			{
+				if (m_Size == Capacity())
+				{
+					// 参数可能引用容器内的元素，需先构造新元素再搬移原有的元素
+					T value(std::forward<Args>(args)...);
+					Self().Grow(m_Size + 1);
+					::new (static_cast<void*>(Data() + m_Size)) T(std::move(value));
+				}
+				else
+				{
+					::new (static_cast<void*>(Data() + m_Size)) T(std::forward<Args>(args)...);
+				}
+
+				return Data()[m_Size++];
+			}
+
+			void pop_back() noexcept
+			{
+				assert(m_Size && "Container is empty.");
+				Data()[--m_Size].~T();
+			}
+
+			template <typename... Args>
+			iterator emplace(const_iterator pos, Args&&... args)
+			{
+				const auto index = static_cast<size_type>(pos - cbegin());
+				assert(index <= m_Size && "pos is out of range.");
+				if (index == m_Size)
+				{
+					emplace_back(std::forward<Args>(args)...);
+					return begin() + index;
+				}
+
+				T value(std::forward<Args>(args)...);
+				if (m_Size == Capacity())
+				{
+					Self().Grow(m_Size + 1);
+				}
+
+				const auto data = Data();
+				::new (static_cast<void*>(data + m_Size)) T(std::move(data[m_Size - 1]));
+				++m_Size;
+				std::move_backward(data + index, data + m_Size - 2, data + m_Size - 1);
+				data[index] = std::move(value);
+				return begin() + index;
+			}
+
+			iterator insert(const_iterator pos, T const& value)
+			{
+				return emplace(pos, value);
+			}
+
+			iterator insert(const_iterator pos, T&& value)
+			{
+				return emplace(pos, std::move(value));
+			}
+
+			iterator insert(const_iterator pos, size_type count, T const& value)
+			{
+				const auto index = static_cast<size_type>(pos - cbegin());
+				if (count)
+				{
+					const T copy(value);
+					if (m_Size + count > Capacity())
+					{
+						Self().Grow(m_Size + count);
+					}
+
+					const auto oldSize = m_Size;
+					for (size_type i = 0; i < count; ++i)
+					{
+						emplace_back(copy);
+					}
+					std::rotate(begin() + index, begin() + oldSize, end());
+				}
+				return begin() + index;
+			}
+
+			///	@note	[first, last) 不能是本容器中的元素
+			template <typename InputIterator, std::enable_if_t<!std::is_integral<InputIterator>::value, int> = 0>
+			iterator insert(const_iterator pos, InputIterator first, InputIterator last)
+			{
+				const auto index = static_cast<size_type>(pos - cbegin());
+				if constexpr (std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<InputIterator>::iterator_category>::value)
+				{
+					const auto count = static_cast<size_type>(std::distance(first, last));
+					if (m_Size + count > Capacity())
+					{
+						Self().Grow(m_Size + count);
+					}
+				}
+
+				// 先追加到末尾再旋转到插入位置，不要求元素可以默认构造
+				const auto oldSize = m_Size;
+				for (; first != last; ++first)
+				{
+					emplace_back(*first);
+				}
+				std::rotate(begin() + index, begin() + oldSize, end());
+				return begin() + index;
+			}
+
+			iterator insert(const_iterator pos, std::initializer_list<T> il)
+			{
+				return insert(pos, il.begin(), il.end());
+			}
+
+			iterator erase(const_iterator pos)
+			{
+				return erase(pos, pos + 1);
+			}
+
+			iterator erase(const_iterator first, const_iterator last)
+			{
+				const auto index = static_cast<size_type>(first - cbegin());
+				const auto count = static_cast<size_type>(last - first);
+				if (count)
+				{
+					const auto newEnd = std::move(begin() + index + count, end(), begin() + index);
+					DestroyRange(newEnd, end());
+					m_Size -= count;
+				}
+				return begin() + index;
+			}
+
+			void clear() noexcept
+			{
+				DestroyRange(begin(), end());
+				m_Size = 0;
+			}
+
+			void resize(size_type count)
+			{
+				ResizeImpl(count, [](T* p) { ::new (static_cast<void*>(p)) T(); });
+			}
+
+			void resize(size_type count, T const& value)
+			{
+				ResizeImpl(count, [&value](T* p) { ::new (static_cast<void*>(p)) T(value); });
+			}
+
+			void assign(size_type count, T const& value)
+			{
+				const T copy(value);
+				clear();
+				insert(cend(), count, copy);
+			}
+
+			template <typename InputIterator, std::enable_if_t<!std::is_integral<InputIterator>::value, int> = 0>
+			void assign(InputIterator first, InputIterator last)
+			{
+				clear();
+				insert(cend(), first, last);
+			}
+
+			void assign(std::initializer_list<T> il)
+			{
+				assign(il.begin(), il.end());
+			}
+
+			friend nBool operator==(Derived const& a, Derived const& b)
+			{
+				return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+			}
+
+			friend nBool operator!=(Derived const& a, Derived const& b)
+			{
+				return !(a == b);
+			}
+
+			friend nBool operator<(Derived const& a, Derived const& b)
+			{
+				return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+			}
+
+		protected:
+			size_type m_Size;
+
+			InlineVectorBase() noexcept
+				: m_Size{}
+			{
+			}
+
+			InlineVectorBase(InlineVectorBase const&) = default;
+			InlineVectorBase& operator=(InlineVectorBase const&) = default;
+
+			Derived& Self() noexcept
+			{
+				return static_cast<Derived&>(*this);
+			}
+
+			T* Data() noexcept
+			{
+				return Self().data();
+			}
+
+			const T* Data() const noexcept
+			{
+				return static_cast<Derived const&>(*this).data();
+			}
+
+			size_type Capacity() const noexcept
+			{
+				return static_cast<Derived const&>(*this).capacity();
+			}
+
+			template <typename Construct_t>
+			void ResizeImpl(size_type count, Construct_t construct)
+			{
+				if (count <= m_Size)
+				{
+					DestroyRange(begin() + count, end());
+					m_Size = count;
+					return;
+				}
+
+				if (count > Capacity())
+				{
+					Self().Grow(count);
+				}
+
+				for (auto p = end(); m_Size < count; ++p)
+				{
+					construct(p);
+					++m_Size;
+				}
+			}
+
+			void CheckPosition(size_type pos) const
+			{
+				if (pos >= m_Size)
+				{
+					InlineVectorOutOfRange();
+				}
+			}
+		};
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	带内联存储的顺序容器
+	///	@remark	元素数量不超过 InlineCount 时保存在对象内部，不分配堆内存，超出后搬移到堆上，
+	///			适用于元素数量通常很少的场合，接口与 std::vector 基本一致
+	///	@note	可以平凡复制的元素以 memcpy 搬移
+	////////////////////////////////////////////////////////////////////////////////
+	template <typename T, size_t InlineCount>
+	class SmallVector
+		: public detail_::InlineVectorBase<SmallVector<T, InlineCount>, T>
+	{
+		typedef detail_::InlineVectorBase<SmallVector<T, InlineCount>, T> Base;
+		friend Base;
+
+	public:
+		using typename Base::size_type;
+		using typename Base::iterator;
+		using typename Base::const_iterator;
+
+		static constexpr size_type InlineCapacity = InlineCount;
+
+		SmallVector() noexcept
+			: m_Data{ InlineData() }, m_Capacity{ InlineCount }
+		{
+		}
+
+		explicit SmallVector(size_type count)
+			: SmallVector()
+		{
+			this->resize(count);
+		}
+
+		SmallVector(size_type count, T const& value)
+			: SmallVector()
+		{
+			this->assign(count, value);
+		}
+
+		template <typename InputIterator, std::enable_if_t<!std::is_integral<InputIterator>::value, int> = 0>
+		SmallVector(InputIterator first, InputIterator last)
+			: SmallVector()
+		{
+			this->assign(first, last);
+		}
+
+		SmallVector(std::initializer_list<T> il)
+			: SmallVector()
+		{
+			this->assign(il);
+		}
+
+		SmallVector(SmallVector const& other)
+			: SmallVector()
+		{
+			this->assign(other.begin(), other.end());
+		}
+
+		SmallVector(SmallVector&& other) noexcept(detail_::IsTriviallyRelocatable<T>::value || std::is_nothrow_move_constructible<T>::value)
+			: SmallVector()
+		{
+			MoveFrom(other);
+		}
+
+		~SmallVector()
+		{
+			this->clear();
+			Deallocate();
+		}
+
+		SmallVector& operator=(SmallVector const& other)
+		{
+			if (this != &other)
+			{
+				this->assign(other.begin(), other.end());
+			}
+			return *this;
+		}
+
+		SmallVector& operator=(SmallVector&& other) noexcept(detail_::IsTriviallyRelocatable<T>::value || std::is_nothrow_move_constructible<T>::value)
+		{
+			if (this != &other)
+			{
+				this->clear();
+				MoveFrom(other);
+			}
+			return *this;
+		}
+
+		SmallVector& operator=(std::initializer_list<T> il)
+		{
+			this->assign(il);
+			return *this;
+		}
+
+		T* data() noexcept
+		{
+			return m_Data;
+		}
+
+		const T* data() const noexcept
+		{
+			return m_Data;
+		}
+
+		size_type capacity() const noexcept
+		{
+			return m_Capacity;
+		}
+
+		///	@brief	元素是否保存在内联存储中
+		nBool IsInline() const noexcept
+		{
+			return m_Data == InlineData();
+		}
+
+		void reserve(size_type newCapacity)
+		{
+			if (newCapacity > m_Capacity)
+			{
+				Grow(newCapacity);
+			}
+		}
+
+		///	@brief	释放多余的堆内存，元素数量不超过 InlineCount 时移回内联存储
+		void shrink_to_fit()
+		{
+			if (IsInline() || this->m_Size == m_Capacity)
+			{
+				return;
+			}
+
+			if (this->m_Size <= InlineCount)
+			{
+				const auto oldData = m_Data;
+				const auto oldCapacity = m_Capacity;
+				detail_::UninitializedRelocate(oldData, oldData + this->m_Size, InlineData());
+				m_Data = InlineData();
+				m_Capacity = InlineCount;
+				std::allocator<T>{}.deallocate(oldData, oldCapacity);
+			}
+			else
+			{
+				Reallocate(this->m_Size);
+			}
+		}
+
+		void swap(SmallVector& other) noexcept(detail_::IsTriviallyRelocatable<T>::value || std::is_nothrow_move_constructible<T>::value)
+		{
+			if (!IsInline() && !other.IsInline())
+			{
+				std::swap(m_Data, other.m_Data);
+				std::swap(m_Capacity, other.m_Capacity);
+				std::swap(this->m_Size, other.m_Size);
+				return;
+			}
+
+			SmallVector temp(std::move(other));
+			other = std::move(*this);
+			*this = std::move(temp);
+		}
+
+		friend void swap(SmallVector& a, SmallVector& b) noexcept(noexcept(a.swap(b)))
+		{
+			a.swap(b);
+		}
+
+	private:
+		T* m_Data;
+		size_type m_Capacity;
+		alignas(T) nByte m_InlineStorage[sizeof(T) * (InlineCount ? InlineCount : 1)];
+
+		T* InlineData() noexcept
+		{
+			return reinterpret_cast<T*>(m_InlineStorage);
+		}
+
+		const T* InlineData() const noexcept
+		{
+			return reinterpret_cast<const T*>(m_InlineStorage);
+		}
+
+		void Grow(size_type minCapacity)
+		{
+			Reallocate(std::max(minCapacity, m_Capacity * 2));
+		}
+
+		void Reallocate(size_type newCapacity)
+		{
+			assert(newCapacity >= this->m_Size);
+			const auto newData = std::allocator<T>{}.allocate(newCapacity);
+			try
+			{
+				detail_::UninitializedRelocate(m_Data, m_Data + this->m_Size, newData);
+			}
+			catch (...)
+			{
+				std::allocator<T>{}.deallocate(newData, newCapacity);
+				throw;
+			}
+			Deallocate();
+			m_Data = newData;
+			m_Capacity = newCapacity;
+		}
+
+		void Deallocate() noexcept
+		{
+			if (!IsInline())
+			{
+				std::allocator<T>{}.deallocate(m_Data, m_Capacity);
+			}
+		}
+
+		// 调用前本对象必须为空，堆上的元素直接接管，内联的元素逐个搬移
+		void MoveFrom(SmallVector& other)
+		{
+			assert(this->empty());
+			if (other.IsInline())
+			{
+				if (this->m_Capacity < other.m_Size)
+				{
+					Grow(other.m_Size);
+				}
+				detail_::UninitializedRelocate(other.m_Data, other.m_Data + other.m_Size, m_Data);
+			}
+			else
+			{
+				Deallocate();
+				m_Data = other.m_Data;
+				m_Capacity = other.m_Capacity;
+				other.m_Data = other.InlineData();
+				other.m_Capacity = InlineCount;
+			}
+			this->m_Size = other.m_Size;
+			other.m_Size = 0;
+		}
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	容量固定的顺序容器
+	///	@remark	元素总是保存在对象内部，不会分配堆内存，超出容量时抛出 NatErr_OutOfRange 异常
+	////////////////////////////////////////////////////////////////////////////////
+	template <typename T, size_t Capacity_v>
+	class StaticVector
+		: public detail_::InlineVectorBase<StaticVector<T, Capacity_v>, T>
+	{
+		typedef detail_::InlineVectorBase<StaticVector<T, Capacity_v>, T> Base;
+		friend Base;
+
+	public:
+		using typename Base::size_type;
+		using typename Base::iterator;
+		using typename Base::const_iterator;
+
+		StaticVector() noexcept
+		{
+		}
+
+		explicit StaticVector(size_type count)
+		{
+			this->resize(count);
+		}
+
+		StaticVector(size_type count, T const& value)
+		{
+			this->assign(count, value);
+		}
+
+		template <typename InputIterator, std::enable_if_t<!std::is_integral<InputIterator>::value, int> = 0>
+		StaticVector(InputIterator first, InputIterator last)
+		{
+			this->assign(first, last);
+		}
+
+		StaticVector(std::initializer_list<T> il)
+		{
+			this->assign(il);
+		}
+
+		StaticVector(StaticVector const& other)
+			: Base()
+		{
+			this->assign(other.begin(), other.end());
+		}
+
+		StaticVector(StaticVector&& other) noexcept(std::is_nothrow_move_constructible<T>::value)
+			: Base()
+		{
+			std::uninitialized_move(other.begin(), other.end(), data());
+			this->m_Size = other.m_Size;
+			other.clear();
+		}
+
+		~StaticVector()
+		{
+			this->clear();
+		}
+
+		StaticVector& operator=(StaticVector const& other)
+		{
+			if (this != &other)
+			{
+				this->assign(other.begin(), other.end());
+			}
+			return *this;
+		}
+
+		StaticVector& operator=(StaticVector&& other) noexcept(std::is_nothrow_move_constructible<T>::value)
+		{
+			if (this != &other)
+			{
+				this->clear();
+				std::uninitialized_move(other.begin(), other.end(), data());
+				this->m_Size = other.m_Size;
+				other.clear();
+			}
+			return *this;
+		}
+
+		StaticVector& operator=(std::initializer_list<T> il)
+		{
+			this->assign(il);
+			return *this;
+		}
+
+		T* data() noexcept
+		{
+			return reinterpret_cast<T*>(m_Storage);
+		}
+
+		const T* data() const noexcept
+		{
+			return reinterpret_cast<const T*>(m_Storage);
+		}
+
+		static constexpr size_type capacity() noexcept
+		{
+			return Capacity_v;
+		}
+
+		static constexpr size_type max_size() noexcept
+		{
+			return Capacity_v;
+		}
+
+		void reserve(size_type newCapacity)
+		{
+			Grow(newCapacity);
+		}
+
+		void swap(StaticVector& other) noexcept(std::is_nothrow_move_constructible<T>::value && std::is_nothrow_swappable<T>::value)
+		{
+			auto& shorter = this->m_Size < other.m_Size ? *this : other;
+			auto& longer = this->m_Size < other.m_Size ? other : *this;
+			std::swap_ranges(shorter.begin(), shorter.end(), longer.begin());
+			std::uninitialized_move(longer.begin() + shorter.m_Size, longer.end(), shorter.end());
+			detail_::DestroyRange(longer.begin() + shorter.m_Size, longer.end());
+			std::swap(this->m_Size, other.m_Size);
+		}
+
+		friend void swap(StaticVector& a, StaticVector& b) noexcept(noexcept(a.swap(b)))
+		{
+			a.swap(b);
+		}
+
+	private:
+		alignas(T) nByte m_Storage[sizeof(T) * (Capacity_v ? Capacity_v : 1)];
+
+		// 容量固定，仅检查是否超出
+		static void Grow(size_type minCapacity)
+		{
+			if (minCapacity > Capacity_v)
+			{
+				detail_::StaticVectorCapacityExceeded();
+			}
+		}
+	};
+}
+
+#ifdef _MSC_VER
+#	pragma pop_macro("max")
+#endif
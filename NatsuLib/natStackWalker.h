@@ -1,7 +1,8 @@
-#pragma once
+﻿#pragma once
 #include "natConfig.h"
 #include "natType.h"
 #include "natString.h"
+#include "natSmallVector.h"
 
 #ifdef EnableStackWalker
 #ifdef _WIN32
@@ -66,6 +67,13 @@ namespace NatsuLib
 			nString SymbolInfo;
 		};
 #endif
+		// 调用栈不超过此深度时，符号数组保存在对象内部而不需要分配内存
+		// 每个异常对象都包含一个 natStackWalker，因此只内联少量的帧以免异常对象过大
+		enum
+		{
+			InlineFrames = 4,
+		};
+
 	public:
 #ifdef _WIN32
 		static nBool HasInitialized() noexcept;
@@ -87,9 +95,9 @@ namespace NatsuLib
 	private:
 #ifdef _WIN32
 		static std::atomic<nBool> s_Initialized;
-		std::vector<Symbol> m_StackSymbols;
+		SmallVector<Symbol, InlineFrames> m_StackSymbols;
 #else
-		std::vector<Symbol> m_StackSymbols;
+		SmallVector<Symbol, InlineFrames> m_StackSymbols;
 #endif
 	};
 }
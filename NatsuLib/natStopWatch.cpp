@@ -38,6 +38,7 @@ nDouble natStopWatch::GetElpased() const
 #else
 natStopWatch::natStopWatch()
 {
+	Reset();
 }
 
 void natStopWatch::Pause()
@@ -58,6 +59,6 @@ void natStopWatch::Reset()
 
 nDouble natStopWatch::GetElpased() const
 {
-	return static_cast<nDouble>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - m_Last - m_FixAll.time_since_epoch()).count());
+	return std::chrono::duration<nDouble>(std::chrono::high_resolution_clock::now() - m_Last - m_FixAll.time_since_epoch()).count();
 }
 #endif // _WIN32
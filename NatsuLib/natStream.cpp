@@ -2,11 +2,13 @@
 #include "natStream.h"
 #include "natException.h"
 #include <algorithm>
+#include <cstdlib>
 #include <cstring>
 
 #ifndef _WIN32
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #endif
 
 using namespace NatsuLib;
@@ -127,7 +129,7 @@ natRefPointer<natStream> natWrappedStream::GetUnderlyingStream() const noexcept
 	return m_InternalStream;
 }
 
-nBool natWrappedStream::EnumUnderlyingStream(std::function<nBool(natWrappedStream&)> const& enumerator) const
+nBool natWrappedStream::EnumUnderlyingStream(DelegateRef<nBool(natWrappedStream&)> enumerator) const
 {
 	auto pStream = m_InternalStream;
 
@@ -838,6 +840,31 @@ natFileStream::~natFileStream()
 	}
 }
 
+natRefPointer<natFileStream> natFileStream::CreateTemporary()
+{
+	TCHAR tempPath[MAX_PATH + 1];
+	if (!GetTempPath(static_cast<DWORD>(std::size(tempPath)), tempPath))
+	{
+		nat_Throw(natWinException, "GetTempPath failed."_nv);
+	}
+
+	TCHAR tempFileName[MAX_PATH];
+	if (!GetTempFileName(tempPath, TEXT("nat"), 0, tempFileName))
+	{
+		nat_Throw(natWinException, "GetTempFileName failed."_nv);
+	}
+
+	// 由系统在句柄关闭时删除文件
+	const auto hFile = CreateFile(tempFileName, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+	{
+		DeleteFile(tempFileName);
+		nat_Throw(natWinException, "Create temporary file failed."_nv);
+	}
+
+	return make_ref<natFileStream>(hFile, true, true, true);
+}
+
 natStdStream::natStdStream(StdStreamType stdStreamType)
 	: m_StdStreamType(stdStreamType)
 {
@@ -1044,7 +1071,7 @@ void natStdStream::Flush()
 }
 #else
 natFileStream::natFileStream(nStrView filename, nBool bReadable, nBool bWritable, nBool truncate)
-	: m_hFile{}, m_ShouldDispose{ true }, m_IsEndOfFile{},m_Filename(filename), m_bReadable(bReadable), m_bWritable(bWritable)
+	: m_hFile{}, m_ShouldDispose{ true }, m_IsEndOfFile{}, m_MappedAddress{ MAP_FAILED }, m_MappedSize{}, m_Filename(filename), m_bReadable(bReadable), m_bWritable(bWritable)
 {
 	int mode = 0;
 	if (bReadable && bWritable)
@@ -1066,14 +1093,14 @@ natFileStream::natFileStream(nStrView filename, nBool bReadable, nBool bWritable
 	}
 
 	m_hFile = open(filename.data(), mode, S_IRWXU | S_IRWXG | S_IRWXO);
-	if (!m_hFile)
+	if (m_hFile < 0)
 	{
 		nat_Throw(natErrException, NatErr_InternalErr, "Cannot open file \"{0}\" (errno = {1})."_nv, filename, errno);
 	}
 }
 
 natFileStream::natFileStream(UnsafeHandle hFile, nBool bReadable, nBool bWritable, nBool transferOwner)
-	: m_hFile{ hFile }, m_ShouldDispose{ transferOwner }, m_IsEndOfFile{}, m_bReadable(bReadable), m_bWritable(bWritable)
+	: m_hFile{ hFile }, m_ShouldDispose{ transferOwner }, m_IsEndOfFile{}, m_MappedAddress{ MAP_FAILED }, m_MappedSize{}, m_bReadable(bReadable), m_bWritable(bWritable)
 {
 	if (hFile < 0)
 	{
@@ -1155,6 +1182,7 @@ void natFileStream::SetPosition(NatSeek Origin, nLong Offset)
 	}
 
 	lseek(m_hFile, static_cast<off_t>(Offset), tOrigin);
+	m_IsEndOfFile = false;
 }
 
 nByte natFileStream::ReadByte()
@@ -1236,14 +1264,64 @@ natFileStream::UnsafeHandle natFileStream::GetUnsafeHandle() const noexcept
 	return m_hFile;
 }
 
+natRefPointer<natExternMemoryStream> natFileStream::MapToMemoryStream()
+{
+	if (m_pMappedFile)
+	{
+		return m_pMappedFile;
+	}
+
+	const auto size = GetSize();
+	const auto pFile = mmap(nullptr, static_cast<size_t>(size), (m_bReadable ? PROT_READ : 0) | (m_bWritable ? PROT_WRITE : 0), MAP_SHARED, m_hFile, 0);
+	if (pFile == MAP_FAILED)
+	{
+		nat_Throw(natErrException, NatErr_InternalErr, "mmap failed (errno = {0})."_nv, errno);
+	}
+
+	m_MappedAddress = pFile;
+	m_MappedSize = size;
+	m_pMappedFile = make_ref<natExternMemoryStream>(static_cast<nData>(pFile), size, m_bReadable, m_bWritable);
+
+	return m_pMappedFile;
+}
+
 natFileStream::~natFileStream()
 {
+	if (m_MappedAddress != MAP_FAILED)
+	{
+		munmap(m_MappedAddress, static_cast<size_t>(m_MappedSize));
+	}
 	if (m_ShouldDispose)
 	{
 		close(m_hFile);
 	}
 }
 
+natRefPointer<natFileStream> natFileStream::CreateTemporary()
+{
+	auto tempDir = std::getenv("TMPDIR");
+	if (!tempDir || !*tempDir)
+	{
+		tempDir = const_cast<char*>("/tmp");
+	}
+
+	const char pattern[] = "/natXXXXXX";
+	const auto dirLength = std::strlen(tempDir);
+	std::vector<char> tempFileName(dirLength + sizeof pattern);
+	std::memcpy(tempFileName.data(), tempDir, dirLength);
+	std::memcpy(tempFileName.data() + dirLength, pattern, sizeof pattern);
+
+	const auto fd = mkstemp(tempFileName.data());
+	if (fd < 0)
+	{
+		nat_Throw(natErrException, NatErr_InternalErr, "mkstemp failed (errno = {0})."_nv, errno);
+	}
+
+	// 已打开的文件在解除链接后仍可使用，并在关闭后被删除
+	unlink(tempFileName.data());
+	return make_ref<natFileStream>(fd, true, true, true);
+}
+
 natStdStream::natStdStream(StdStreamType stdStreamType)
 	: m_StdStreamType(stdStreamType)
 {
@@ -1408,7 +1486,7 @@ void natStdStream::Flush()
 #endif
 
 natMemoryStream::natMemoryStream(ncData pData, nLen Length, nBool bReadable, nBool bWritable, nBool autoResize)
-	: m_pData(nullptr), m_CurPos(0u), m_bReadable(bReadable), m_bWritable(bWritable), m_AutoResize(autoResize)
+	: m_pData(nullptr), m_Size(0u), m_Capacity(0u), m_CurPos(0u), m_bReadable(bReadable), m_bWritable(bWritable), m_AutoResize(autoResize)
 {
 	Reserve(Length);
 	m_Size = Length;
@@ -1457,12 +1535,13 @@ nBool natMemoryStream::CanSeek() const
 
 nBool natMemoryStream::IsEndOfStream() const
 {
-	return m_CurPos >= m_Capacity;
+	return m_CurPos >= m_Size;
 }
 
 nLen natMemoryStream::GetSize() const
 {
-	return m_Capacity;
+	// 自动扩容后容量可能大于已写入的数据，此处只报告有效数据大小
+	return m_Size;
 }
 
 void natMemoryStream::SetSize(nLen Size)
@@ -1482,19 +1561,19 @@ void natMemoryStream::SetPosition(NatSeek Origin, nLong Offset)
 	switch (Origin)
 	{
 	case NatSeek::Beg:
-		if (Offset < 0 || m_Capacity < static_cast<nLen>(Offset))
+		if (Offset < 0 || m_Size < static_cast<nLen>(Offset))
 			nat_Throw(natErrException, NatErr_OutOfRange, "Out of range."_nv);
 		m_CurPos = Offset;
 		break;
 	case NatSeek::Cur:
-		if ((Offset < 0 && m_CurPos < static_cast<nLen>(-Offset)) || m_Capacity > static_cast<nLen>(m_CurPos + Offset))
+		if ((Offset < 0 && m_CurPos < static_cast<nLen>(-Offset)) || (Offset > 0 && m_Size < static_cast<nLen>(m_CurPos + Offset)))
 			nat_Throw(natErrException, NatErr_OutOfRange, "Out of range."_nv);
 		m_CurPos += Offset;
 		break;
 	case NatSeek::End:
-		if (Offset > 0 || m_Capacity < static_cast<nLen>(-Offset))
+		if (Offset > 0 || m_Size < static_cast<nLen>(-Offset))
 			nat_Throw(natErrException, NatErr_OutOfRange, "Out of range."_nv);
-		m_CurPos = m_Capacity + Offset;
+		m_CurPos = m_Size + Offset;
 		break;
 	default:
 		nat_Throw(natErrException, NatErr_OutOfRange, "Out of range."_nv);
@@ -1577,7 +1656,7 @@ nLen natMemoryStream::WriteBytes(ncData pData, nLen Length)
 	{
 		if (m_AutoResize)
 		{
-			Reserve(static_cast<nLen>(detail_::Grow(static_cast<size_t>(Length))));
+			Reserve(static_cast<nLen>(detail_::Grow(static_cast<size_t>(m_CurPos + Length))));
 			tWriteBytes = Length;
 		}
 		else
@@ -146,7 +146,7 @@ namespace NatsuLib
 		///	@param	enumerator	öٺtrueֹͣö
 		///	@note	γɻĿܣʱܻѭ
 		///	@return	öǷenumeratortrueֹ
-		nBool EnumUnderlyingStream(std::function<nBool(natWrappedStream&)> const& enumerator) const;
+		nBool EnumUnderlyingStream(DelegateRef<nBool(natWrappedStream&)> enumerator) const;
 
 		///	@brief	ڲڲT򷵻޷͵ڲ򷵻nullptr
 		///	@tparam	T	Ҫõڲ
@@ -332,6 +332,10 @@ namespace NatsuLib
 
 		~natFileStream();
 
+		///	@brief	ɶдʱļ
+		///	@remark	ļϵͳʱĿ¼رպԶɾ
+		static natRefPointer<natFileStream> CreateTemporary();
+
 		nBool CanWrite() const override;
 		nBool CanRead() const override;
 		nBool CanResize() const override;
@@ -355,9 +359,7 @@ namespace NatsuLib
 		nStrView GetFilename() const noexcept;
 		UnsafeHandle GetUnsafeHandle() const noexcept;
 
-#ifdef _WIN32
 		natRefPointer<natExternMemoryStream> MapToMemoryStream();
-#endif
 
 	private:
 		UnsafeHandle m_hFile;
@@ -369,6 +371,9 @@ namespace NatsuLib
 		const nBool m_IsAsync;
 #else
 		nBool m_IsEndOfFile;
+		void* m_MappedAddress;
+		nLen m_MappedSize;
+		natRefPointer<natExternMemoryStream> m_pMappedFile;
 #endif
 
 		nString m_Filename;
@@ -2,6 +2,10 @@
 #include "natStream.h"
 #include "natText.h"
 
+#include <cstring>
+#include <iterator>
+#include <string>
+
 #ifdef _MSC_VER
 #	pragma push_macro("min")
 #	undef min
@@ -9,20 +13,82 @@
 
 namespace NatsuLib
 {
+	namespace detail_
+	{
+		///	@brief	在 [begin, begin + length) 中查找编码单元
+		///	@return	找到的位置，未找到时返回 length
+		template <typename CharType>
+		std::size_t FindCodeUnit(const CharType* begin, std::size_t length, CharType unit) noexcept
+		{
+			if constexpr (sizeof(CharType) == 1)
+			{
+				// memchr 通常由运行库以向量指令实现
+				const auto pos = std::memchr(begin, static_cast<unsigned char>(unit), length);
+				return pos ? static_cast<std::size_t>(static_cast<const CharType*>(pos) - begin) : length;
+			}
+			else
+			{
+				const auto pos = std::char_traits<CharType>::find(begin, length, unit);
+				return pos ? static_cast<std::size_t>(pos - begin) : length;
+			}
+		}
+
+		///	@brief	获得不截断最后一个字符的最大长度
+		template <StringType encoding>
+		std::size_t TrimIncompleteChar(const typename StringEncodingTrait<encoding>::CharType* begin, std::size_t length) noexcept
+		{
+			typedef StringEncodingTrait<encoding> Trait;
+			typedef typename Trait::CharType CharType;
+
+			if (!length)
+			{
+				return 0;
+			}
+
+			if constexpr (sizeof(CharType) == 2)
+			{
+				// 高位代理之后必定跟随低位代理
+				const auto last = static_cast<nuInt>(begin[length - 1]);
+				return last - 0xD800 < 0x400 ? length - 1 : length;
+			}
+			else
+			{
+				const auto maxCheck = std::min(length, static_cast<std::size_t>(Trait::MaxCharSize));
+				for (std::size_t i = 1; i <= maxCheck; ++i)
+				{
+					const auto charCount = Trait::GetCharCount(begin[length - i]);
+					if (charCount != std::size_t(-1))
+					{
+						return charCount > i ? length - i : length;
+					}
+				}
+
+				return length;
+			}
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	从流中读取文本
+	///	@remark	内部使用环形缓冲区，ReadLine、ReadUntil 及 ReadChunk 直接在缓冲区中查找并整段复制，而不需逐个字符解码
+	///	@note	批量读取的内容不会经过校验，流中的编码需与 encoding 一致
+	////////////////////////////////////////////////////////////////////////////////
 	template <StringType encoding>
 	class natStreamReader final
 		: public natRefObjImpl<natStreamReader<encoding>, TextReader<encoding>>
 	{
 	public:
 		typedef typename StringEncodingTrait<encoding>::CharType CharType;
+		typedef StringView<encoding> View;
 
 		enum
 		{
-			DefaultBufferSize = 128,
+			DefaultBufferSize = 4096,
+			MinBufferSize = 64,
 		};
 
 		explicit natStreamReader(natRefPointer<natStream> pStream, size_t bufferSize = DefaultBufferSize) noexcept
-			: m_InternalStream(pStream), m_BufferSize{ bufferSize }, m_CurrentPos{}, m_EndPos{}
+			: m_InternalStream(pStream), m_BufferSize{ (std::max(bufferSize, static_cast<size_t>(MinBufferSize)) + sizeof(CharType) - 1) / sizeof(CharType) * sizeof(CharType) }, m_ReadPos{}, m_Count{}
 		{
 		}
 
@@ -32,11 +98,10 @@ namespace NatsuLib
 
 		nBool Read(nuInt& codePoint) override
 		{
-			auto readChars = InternalPeek(codePoint);
+			const auto readChars = InternalPeek(codePoint);
 			if (readChars)
 			{
-				m_CurrentPos += readChars * sizeof(CharType);
-				assert(m_CurrentPos <= m_EndPos && "Buffer overflew.");
+				Consume(readChars);
 				return true;
 			}
 
@@ -48,9 +113,183 @@ namespace NatsuLib
 			return InternalPeek(codePoint) > 0;
 		}
 
+		String<encoding> ReadUntil(std::initializer_list<nuInt> terminatorChars) override
+		{
+			String<encoding> terminators;
+			for (auto&& item : terminatorChars)
+			{
+				const auto oldSize = terminators.size();
+				if (detail_::EncodingCodePoint<encoding>::Encode(terminators, item) != EncodingResult::Accept || terminators.size() - oldSize != 1)
+				{
+					return TextReader<encoding>::ReadUntil(terminatorChars);
+				}
+			}
+
+			if constexpr (encoding != StringType::Utf8 && encoding != StringType::Utf16 && encoding != StringType::Utf32)
+			{
+				// 其他编码中单个编码单元可能出现在多字节字符中间，无法直接查找
+				if (!terminators.empty())
+				{
+					return TextReader<encoding>::ReadUntil(terminatorChars);
+				}
+			}
+
+			String<encoding> result;
+			while (EnsureUnits(1))
+			{
+				const auto begin = GetReadPointer();
+				const auto contiguous = GetContiguousUnits();
+				std::size_t pos;
+				switch (terminators.size())
+				{
+				case 0:
+					pos = contiguous;
+					break;
+				case 1:
+					pos = detail_::FindCodeUnit(begin, contiguous, terminators[0]);
+					break;
+				default:
+					pos = static_cast<std::size_t>(std::find_first_of(begin, begin + contiguous, terminators.cbegin(), terminators.cend()) - begin);
+					break;
+				}
+
+				result.Append(View{ begin, pos });
+				if (pos != contiguous)
+				{
+					Consume(pos + 1);
+					break;
+				}
+				Consume(pos);
+			}
+
+			return result;
+		}
+
+		String<encoding> ReadLine() override
+		{
+			const auto newLine = detail_::EncodeNewLine<encoding>(this->m_NewLine);
+			String<encoding> result;
+			if (newLine.empty())
+			{
+				return result;
+			}
+
+			const auto newLineFirst = newLine[0];
+			while (EnsureUnits(1))
+			{
+				const auto begin = GetReadPointer();
+				const auto contiguous = GetContiguousUnits();
+				const auto pos = detail_::FindCodeUnit(begin, contiguous, newLineFirst);
+				result.Append(View{ begin, pos });
+				Consume(pos);
+				if (pos == contiguous)
+				{
+					continue;
+				}
+
+				// 换行符可能跨越缓冲区的边界
+				if (EnsureUnits(newLine.size()) && MatchUnits(newLine.GetView()))
+				{
+					Consume(newLine.size());
+					break;
+				}
+
+				result.Append(newLineFirst);
+				Consume(1);
+			}
+
+			return result;
+		}
+
+		///	@brief	读取一行
+		///	@param[out]	line	读取到的行，不包括换行符
+		///	@return	已到达流末尾而未能读取任何内容时返回 false
+		///	@remark	与 ReadLine 不同，可以区分末尾的空行与流的末尾
+		nBool TryReadLine(String<encoding>& line)
+		{
+			if (!EnsureUnits(1))
+			{
+				return false;
+			}
+
+			line = ReadLine();
+			return true;
+		}
+
+		String<encoding> ReadToEnd() override
+		{
+			return ReadUntil({});
+		}
+
+		Rope<encoding> ReadToEndAsRope() override
+		{
+			Rope<encoding> result;
+			while (true)
+			{
+				auto chunk = ReadChunk(TextReader<encoding>::RopeChunkSize);
+				if (chunk.empty())
+				{
+					break;
+				}
+				result.Append(std::move(chunk));
+			}
+			return result;
+		}
+
+		///	@brief	读取一段内容
+		///	@param[in]	maxLength	最多读取的编码单元数
+		///	@return	读取的内容，除非 maxLength 不足以容纳单个字符，否则不会截断字符，到达流末尾时返回空字符串
+		String<encoding> ReadChunk(size_t maxLength)
+		{
+			// 未到达流末尾时保留缓冲区末尾可能不完整的字符，留待之后截断时处理
+			constexpr size_t holdBack = sizeof(CharType) == 2 ? 1 : StringEncodingTrait<encoding>::MaxCharSize - 1;
+
+			String<encoding> result;
+			result.Reserve(maxLength);
+			while (result.size() < maxLength)
+			{
+				const auto remain = maxLength - result.size();
+				EnsureUnits(remain);
+				auto take = std::min(GetAvailableUnits(), remain);
+				if (!take)
+				{
+					break;
+				}
+
+				if (take == remain)
+				{
+					CharType tail[4];
+					const auto tailLength = std::min(take, std::size(tail));
+					for (size_t i = 0; i < tailLength; ++i)
+					{
+						tail[i] = GetUnit(take - tailLength + i);
+					}
+
+					const auto trimmed = take - (tailLength - detail_::TrimIncompleteChar<encoding>(tail, tailLength));
+					if (trimmed || !result.empty())
+					{
+						take = trimmed;
+					}
+				}
+				else if (!m_InternalStream->IsEndOfStream() && take > holdBack)
+				{
+					take -= holdBack;
+				}
+
+				if (!take)
+				{
+					break;
+				}
+
+				AppendUnits(result, take);
+			}
+
+			return result;
+		}
+
 		nBool IsEndOfStream() const
 		{
-			return m_InternalStream->IsEndOfStream();
+			return !m_Count && m_InternalStream->IsEndOfStream();
 		}
 
 		natRefPointer<natStream> GetInternalStream() const noexcept
@@ -60,70 +299,141 @@ namespace NatsuLib
 
 	private:
 		natRefPointer<natStream> m_InternalStream;
+		// 环形缓冲区，容量为 sizeof(CharType) 的整数倍，m_ReadPos 总是对齐到 sizeof(CharType)
 		std::vector<nByte> m_Buffer;
 		size_t m_BufferSize;
-		size_t m_CurrentPos, m_EndPos;
+		size_t m_ReadPos, m_Count;
 
-		// 清空缓冲区并重设位置，可选保留尾部的部分数据
-		void ReadBuffer(size_t size, size_t reserved = 0)
+		// 向缓冲区的空闲部分读取一次数据
+		nBool Fill()
 		{
-			if (!size)
+			if (m_Buffer.empty())
 			{
-				return;
+				m_Buffer.resize(m_BufferSize);
 			}
 
-			assert(size >= reserved);
-			assert(reserved <= m_Buffer.size());
-			if (reserved)
+			const auto capacity = m_Buffer.size();
+			if (m_Count == capacity || m_InternalStream->IsEndOfStream())
 			{
-				copy(prev(cend(m_Buffer), reserved), cend(m_Buffer), begin(m_Buffer));
+				return false;
 			}
-			m_Buffer.resize(size);
-			
-			const auto readBytes = m_InternalStream->ReadBytes(m_Buffer.data() + reserved, size - reserved);
-			m_CurrentPos = 0;
-			m_EndPos = static_cast<size_t>(reserved + readBytes);
+
+			const auto writePos = (m_ReadPos + m_Count) % capacity;
+			const auto writable = writePos >= m_ReadPos ? capacity - writePos : m_ReadPos - writePos;
+			const auto readBytes = static_cast<size_t>(m_InternalStream->ReadBytes(m_Buffer.data() + writePos, writable));
+			m_Count += readBytes;
+			return readBytes > 0;
 		}
 
-		size_t InternalPeek(nuInt& codePoint)
+		nBool EnsureUnits(size_t count)
 		{
-			typedef typename StringEncodingTrait<encoding>::CharType CharType;
-			assert(m_CurrentPos <= m_EndPos);
-			if (m_CurrentPos == m_EndPos)
+			while (GetAvailableUnits() < count)
 			{
-				if (m_InternalStream->IsEndOfStream())
+				if (!Fill())
 				{
-					return 0;
+					return false;
 				}
+			}
+
+			return true;
+		}
 
-				ReadBuffer(m_BufferSize);
-				if (m_CurrentPos == m_EndPos)
+		size_t GetAvailableUnits() const noexcept
+		{
+			return m_Count / sizeof(CharType);
+		}
+
+		size_t GetContiguousUnits() const noexcept
+		{
+			return std::min(m_Count, m_Buffer.size() - m_ReadPos) / sizeof(CharType);
+		}
+
+		const CharType* GetReadPointer() const noexcept
+		{
+			return reinterpret_cast<const CharType*>(m_Buffer.data() + m_ReadPos);
+		}
+
+		CharType GetUnit(size_t index) const noexcept
+		{
+			assert(index < GetAvailableUnits());
+			return *reinterpret_cast<const CharType*>(m_Buffer.data() + (m_ReadPos + index * sizeof(CharType)) % m_Buffer.size());
+		}
+
+		nBool MatchUnits(View const& units) const noexcept
+		{
+			if (GetAvailableUnits() < units.size())
+			{
+				return false;
+			}
+
+			for (size_t i = 0; i < units.size(); ++i)
+			{
+				if (GetUnit(i) != units[i])
 				{
-					return 0;
+					return false;
 				}
 			}
 
+			return true;
+		}
+
+		// 将缓冲区开头的 count 个编码单元移动到 str 的末尾
+		void AppendUnits(String<encoding>& str, size_t count)
+		{
+			const auto first = std::min(count, GetContiguousUnits());
+			str.Append(View{ GetReadPointer(), first });
+			Consume(first);
+			if (count > first)
+			{
+				str.Append(View{ GetReadPointer(), count - first });
+				Consume(count - first);
+			}
+		}
+
+		void Consume(size_t units) noexcept
+		{
+			const auto bytes = units * sizeof(CharType);
+			assert(bytes <= m_Count && "Buffer overflew.");
+			m_Count -= bytes;
+			m_ReadPos = m_Count ? (m_ReadPos + bytes) % m_Buffer.size() : 0;
+		}
+
+		size_t InternalPeek(nuInt& codePoint)
+		{
+			if (!EnsureUnits(1))
+			{
+				return 0;
+			}
+
 			EncodingResult result;
 			size_t readChars;
-			const ncData data = m_Buffer.data();
-			std::tie(result, readChars) = detail_::EncodingCodePoint<encoding>::Decode({ reinterpret_cast<const CharType*>(data + m_CurrentPos), reinterpret_cast<const CharType*>(data + std::min(m_EndPos, m_Buffer.size())) }, codePoint);
-			if (result == EncodingResult::Accept)
+			const auto begin = GetReadPointer();
+			std::tie(result, readChars) = detail_::EncodingCodePoint<encoding>::Decode({ begin, begin + GetContiguousUnits() }, codePoint);
+			if (result != EncodingResult::Incomplete)
 			{
-				return readChars;
+				return result == EncodingResult::Accept ? readChars : 0;
 			}
-			if (result == EncodingResult::Incomplete)
+
+			// 字符不完整或跨越了缓冲区的边界，复制到临时缓冲区后再解码
+			CharType units[4];
+			while (true)
 			{
-				ReadBuffer(m_BufferSize, m_EndPos - m_CurrentPos);
-				std::tie(result, readChars) = detail_::EncodingCodePoint<encoding>::Decode({ reinterpret_cast<const CharType*>(data + m_CurrentPos), reinterpret_cast<const CharType*>(data + std::min(m_EndPos, m_Buffer.size())) }, codePoint);
+				const auto available = std::min(GetAvailableUnits(), std::size(units));
+				for (size_t i = 0; i < available; ++i)
+				{
+					units[i] = GetUnit(i);
+				}
+
+				std::tie(result, readChars) = detail_::EncodingCodePoint<encoding>::Decode({ units, units + available }, codePoint);
 				if (result == EncodingResult::Accept)
 				{
 					return readChars;
 				}
-
-				return 0;
+				if (result != EncodingResult::Incomplete || available == std::size(units) || !Fill())
+				{
+					return 0;
+				}
 			}
-
-			return 0;
 		}
 	};
 
@@ -462,7 +462,13 @@ namespace NatsuLib
 				++read; ++otherRead;
 			}
 
-			return 0;
+			// 较短的字符串是另一字符串的前缀时较小
+			if (read != readEnd)
+			{
+				return 1;
+			}
+
+			return otherRead != otherEnd ? -1 : 0;
 		}
 
 		constexpr StringView Slice(std::ptrdiff_t begin, std::ptrdiff_t end) const noexcept
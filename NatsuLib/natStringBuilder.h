@@ -0,0 +1,296 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+///	@file	natStringBuilder.h
+///	@brief	基于 natArena 的字符串构造器及字符串驻留池
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_set>
+#include <utility>
+
+#include "natArena.h"
+#include "natString.h"
+
+namespace NatsuLib
+{
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	从 natArena 分配内存的字符串构造器
+	///	@remark	适用于大量构造生命周期较短的字符串的场景，构造过程中不会向全局分配器请求内存
+	///	@note	所有获得的视图在 natArena 被 Reset 或析构之前有效，但在继续追加内容后可能失效
+	////////////////////////////////////////////////////////////////////////////////
+	template <StringType stringType>
+	class StringBuilder final
+		: public noncopyable
+	{
+	public:
+		static constexpr StringType UsingStringType = stringType;
+
+		typedef StringView<stringType> View;
+		typedef typename View::CharType CharType;
+		typedef CharType Element;
+		typedef CharType* iterator;
+		typedef const CharType* const_iterator;
+
+		explicit StringBuilder(natArena& arena, std::size_t initialCapacity = 0)
+			: m_Arena{ &arena }, m_Data{}, m_Size{}, m_Capacity{}
+		{
+			Reserve(initialCapacity);
+		}
+
+		StringBuilder(StringBuilder&& other) noexcept
+			: m_Arena{ other.m_Arena }, m_Data{ std::exchange(other.m_Data, nullptr) }, m_Size{ std::exchange(other.m_Size, 0) }, m_Capacity{ std::exchange(other.m_Capacity, 0) }
+		{
+		}
+
+		StringBuilder& operator=(StringBuilder&& other) noexcept
+		{
+			m_Arena = other.m_Arena;
+			m_Data = std::exchange(other.m_Data, nullptr);
+			m_Size = std::exchange(other.m_Size, 0);
+			m_Capacity = std::exchange(other.m_Capacity, 0);
+			return *this;
+		}
+
+		void Reserve(std::size_t newCapacity)
+		{
+			if (newCapacity <= m_Capacity)
+			{
+				return;
+			}
+
+			// 若缓冲区是 natArena 中最近的一次分配则原地扩展，否则重新分配并复制，旧的缓冲区在 natArena 被 Reset 时回收
+			if (m_Arena->TryExtend(m_Data, m_Capacity * sizeof(CharType), newCapacity * sizeof(CharType)))
+			{
+				m_Capacity = newCapacity;
+				return;
+			}
+
+			const auto newData = m_Arena->AllocateArray<CharType>(newCapacity);
+			std::copy_n(m_Data, m_Size, newData);
+			m_Data = newData;
+			m_Capacity = newCapacity;
+		}
+
+		///	@brief	增加字符串长度
+		///	@param[in]	moreSize	增加的字符数
+		///	@return	新增部分的起始位置，内容未初始化
+		iterator ResizeMore(std::size_t moreSize)
+		{
+			const auto newSize = m_Size + moreSize;
+			if (newSize > m_Capacity)
+			{
+				Reserve(std::max(newSize, m_Capacity + m_Capacity / 2 + 16));
+			}
+
+			const auto result = m_Data + m_Size;
+			m_Size = newSize;
+			return result;
+		}
+
+		StringBuilder& Append(View const& view)
+		{
+			std::copy(view.cbegin(), view.cend(), ResizeMore(view.size()));
+			return *this;
+		}
+
+		StringBuilder& Append(CharType Char, std::size_t count = 1)
+		{
+			std::fill_n(ResizeMore(count), count, Char);
+			return *this;
+		}
+
+		StringBuilder& operator+=(View const& view)
+		{
+			return Append(view);
+		}
+
+		StringBuilder& operator+=(CharType Char)
+		{
+			return Append(Char);
+		}
+
+		void pop_back() noexcept
+		{
+			assert(m_Size > 0);
+			--m_Size;
+		}
+
+		void Clear() noexcept
+		{
+			m_Size = 0;
+		}
+
+		std::size_t size() const noexcept
+		{
+			return m_Size;
+		}
+
+		std::size_t GetCapacity() const noexcept
+		{
+			return m_Capacity;
+		}
+
+		nBool empty() const noexcept
+		{
+			return !m_Size;
+		}
+
+		CharType* data() noexcept
+		{
+			return m_Data;
+		}
+
+		const CharType* data() const noexcept
+		{
+			return m_Data;
+		}
+
+		iterator begin() noexcept
+		{
+			return m_Data;
+		}
+
+		iterator end() noexcept
+		{
+			return m_Data + m_Size;
+		}
+
+		const_iterator begin() const noexcept
+		{
+			return m_Data;
+		}
+
+		const_iterator end() const noexcept
+		{
+			return m_Data + m_Size;
+		}
+
+		const_iterator cbegin() const noexcept
+		{
+			return begin();
+		}
+
+		const_iterator cend() const noexcept
+		{
+			return end();
+		}
+
+		///	@brief	获得当前内容的视图
+		///	@note	视图在继续追加内容或 natArena 被 Reset 后失效
+		View GetView() const noexcept
+		{
+			return { m_Data, m_Size };
+		}
+
+		///	@brief	复制当前内容到独立的字符串
+		String<stringType> ToString() const
+		{
+			return GetView();
+		}
+
+		natArena& GetArena() const noexcept
+		{
+			return *m_Arena;
+		}
+
+	private:
+		natArena* m_Arena;
+		CharType* m_Data;
+		std::size_t m_Size;
+		std::size_t m_Capacity;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+	///	@brief	字符串驻留池
+	///	@remark	相同内容的字符串驻留后得到相同的视图，因此驻留后的字符串可以直接比较地址以判断相等
+	///	@note	线程安全，驻留得到的视图在池析构之前一直有效
+	////////////////////////////////////////////////////////////////////////////////
+	template <StringType stringType>
+	class StringPool final
+		: public nonmovable
+	{
+	public:
+		typedef StringView<stringType> View;
+		typedef typename View::CharType CharType;
+
+		explicit StringPool(std::size_t blockSize = natArena::DefaultBlockSize)
+			: m_Arena{ blockSize }
+		{
+		}
+
+		///	@brief	驻留字符串
+		///	@param[in]	str	要驻留的字符串
+		///	@return	池中与 str 内容相同的字符串的视图，以空字符结尾
+		View Intern(View const& str)
+		{
+			{
+				std::shared_lock<std::shared_mutex> lock{ m_Mutex };
+				const auto iter = m_Strings.find(str);
+				if (iter != m_Strings.end())
+				{
+					return *iter;
+				}
+			}
+
+			std::unique_lock<std::shared_mutex> lock{ m_Mutex };
+			const auto iter = m_Strings.find(str);
+			if (iter != m_Strings.end())
+			{
+				return *iter;
+			}
+
+			const auto size = str.size();
+			const auto data = m_Arena.AllocateArray<CharType>(size + 1);
+			std::copy(str.cbegin(), str.cend(), data);
+			data[size] = CharType{};
+
+			const View interned{ data, size };
+			m_Strings.emplace(interned);
+			return interned;
+		}
+
+		///	@brief	查找已驻留的字符串
+		///	@return	若已驻留则返回池中的视图，否则返回空的 Optional
+		Optional<View> Find(View const& str) const
+		{
+			std::shared_lock<std::shared_mutex> lock{ m_Mutex };
+			const auto iter = m_Strings.find(str);
+			if (iter != m_Strings.end())
+			{
+				return *iter;
+			}
+
+			return {};
+		}
+
+		///	@brief	判断视图是否由本池驻留得到
+		nBool Owns(View const& str) const
+		{
+			const auto result = Find(str);
+			return result && result->data() == str.data();
+		}
+
+		std::size_t size() const
+		{
+			std::shared_lock<std::shared_mutex> lock{ m_Mutex };
+			return m_Strings.size();
+		}
+
+	private:
+		mutable std::shared_mutex m_Mutex;
+		natArena m_Arena;
+		std::unordered_set<View> m_Strings;
+	};
+
+	typedef StringBuilder<StringType::Utf8> U8StringBuilder;
+	typedef StringBuilder<StringType::Utf16> U16StringBuilder;
+	typedef StringBuilder<StringType::Utf32> U32StringBuilder;
+	typedef StringPool<StringType::Utf8> U8StringPool;
+	typedef StringPool<StringType::Utf16> U16StringPool;
+	typedef StringPool<StringType::Utf32> U32StringPool;
+
+	typedef U8StringBuilder nStringBuilder;
+	typedef U8StringPool nStringPool;
+}
@@ -6,6 +6,8 @@
 #include <iomanip>
 #include <cctype>
 #include <typeinfo>
+#include <charconv>
+#include <cstring>
 
 namespace NatsuLib
 {
@@ -427,5 +429,300 @@ namespace NatsuLib
 		{
 			return Str;
 		}
+
+		namespace detail_
+		{
+			enum : std::size_t
+			{
+				MaxFloatStringLength = 1024,	///< @brief	浮点数字符串表示的最大长度，足以容纳 double 的完整十进制展开
+			};
+
+#if defined(_MSC_VER) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+			constexpr nBool IsLittleEndian = true;
+#else
+			constexpr nBool IsLittleEndian = false;
+#endif
+
+			template <typename CharType>
+			constexpr nuInt DigitValue(CharType ch) noexcept
+			{
+				const auto value = static_cast<nuInt>(static_cast<std::make_unsigned_t<CharType>>(ch));
+				if (value - '0' < 10)
+				{
+					return value - '0';
+				}
+				if (value - 'a' < 26)
+				{
+					return value - 'a' + 10;
+				}
+				if (value - 'A' < 26)
+				{
+					return value - 'A' + 10;
+				}
+				return std::numeric_limits<nuInt>::max();
+			}
+
+			// 一次判断并解析 8 个 ASCII 十进制数字（SWAR），要求以小端序读入
+			inline nBool IsEightDigits(nuLong chunk) noexcept
+			{
+				return ((chunk & 0xF0F0F0F0F0F0F0F0) | (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333;
+			}
+
+			inline nuInt ParseEightDigits(nuLong chunk) noexcept
+			{
+				constexpr nuLong mask = 0x000000FF000000FF;
+				constexpr nuLong mul1 = 0x000F424000000064;	// 100 + (1000000 << 32)
+				constexpr nuLong mul2 = 0x0000271000000001;	// 1 + (10000 << 32)
+
+				chunk -= 0x3030303030303030;
+				chunk = chunk * 10 + (chunk >> 8);
+				return static_cast<nuInt>(((chunk & mask) * mul1 + ((chunk >> 16) & mask) * mul2) >> 32);
+			}
+
+			///	@brief	解析无符号数字序列
+			///	@return	第一个未被解析的字符的位置，溢出时返回 nullptr
+			template <typename CharType>
+			const CharType* ParseUnsignedDigits(const CharType* begin, const CharType* end, nuInt radix, nuLong& value) noexcept
+			{
+				nuLong result{};
+				auto current = begin;
+
+				if constexpr (sizeof(CharType) == 1 && IsLittleEndian)
+				{
+					// result 小于 10^11 时再追加 8 位数字不会溢出
+					while (radix == 10 && end - current >= 8 && result < 100000000000)
+					{
+						nuLong chunk;
+						std::memcpy(&chunk, current, sizeof chunk);
+						if (!IsEightDigits(chunk))
+						{
+							break;
+						}
+
+						result = result * 100000000 + ParseEightDigits(chunk);
+						current += 8;
+					}
+				}
+
+				constexpr auto maxValue = std::numeric_limits<nuLong>::max();
+				for (; current != end; ++current)
+				{
+					const auto digit = DigitValue(*current);
+					if (digit >= radix)
+					{
+						break;
+					}
+					if (result > (maxValue - digit) / radix)
+					{
+						return nullptr;
+					}
+					result = result * radix + digit;
+				}
+
+				value = result;
+				return current;
+			}
+
+			template <typename T>
+			nBool FromChars(const char* begin, const char* end, T& result) noexcept
+			{
+				T value;
+				const auto parseResult = std::from_chars(begin, end, value);
+				if (parseResult.ec != std::errc{} || parseResult.ptr != end)
+				{
+					return false;
+				}
+
+				result = value;
+				return true;
+			}
+
+			template <StringType stringType>
+			void AppendAscii(String<stringType>& str, const char* begin, const char* end)
+			{
+				std::copy(begin, end, str.ResizeMore(static_cast<std::size_t>(end - begin)));
+			}
+		}
+
+		///	@brief	尝试将字符串解析为整数
+		///	@param[in]	str		要解析的字符串，需完整表示一个整数，允许前导的正负号，不允许空白
+		///	@param[out]	result	解析结果，仅在成功时被修改
+		///	@param[in]	radix	基数，范围为 [2, 36]
+		///	@return	是否成功解析
+		///	@note	不分配内存，解析失败、溢出均返回 false
+		template <typename T, StringType stringType>
+		std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, nBool>, nBool> TryParse(StringView<stringType> const& str, T& result, nuInt radix = 10) noexcept
+		{
+			if (radix < 2 || radix > 36)
+			{
+				return false;
+			}
+
+			auto current = str.cbegin();
+			const auto end = str.cend();
+			if (current == end)
+			{
+				return false;
+			}
+
+			auto negative = false;
+			if (*current == '-')
+			{
+				if (!std::is_signed_v<T>)
+				{
+					return false;
+				}
+				negative = true;
+				++current;
+			}
+			else if (*current == '+')
+			{
+				++current;
+			}
+
+			if (current == end)
+			{
+				return false;
+			}
+
+			nuLong magnitude;
+			if (detail_::ParseUnsignedDigits(current, end, radix, magnitude) != end)
+			{
+				return false;
+			}
+
+			constexpr auto maxValue = static_cast<nuLong>(std::numeric_limits<T>::max());
+			if (negative)
+			{
+				if (magnitude > maxValue + 1)
+				{
+					return false;
+				}
+				result = magnitude ? static_cast<T>(-static_cast<nLong>(magnitude - 1) - 1) : T{};
+			}
+			else
+			{
+				if (magnitude > maxValue)
+				{
+					return false;
+				}
+				result = static_cast<T>(magnitude);
+			}
+
+			return true;
+		}
+
+		///	@brief	尝试将字符串解析为浮点数
+		///	@param[in]	str		要解析的字符串，需完整表示一个浮点数，不允许空白
+		///	@param[out]	result	解析结果，仅在成功时被修改
+		///	@return	是否成功解析
+		///	@note	与 std::from_chars 相同，结果为最接近的可表示值，可与 AppendNumber 的输出往返转换
+		template <typename T, StringType stringType>
+		std::enable_if_t<std::is_floating_point_v<T>, nBool> TryParse(StringView<stringType> const& str, T& result) noexcept
+		{
+			typedef typename StringView<stringType>::CharType CharType;
+
+			auto begin = str.cbegin();
+			const auto end = str.cend();
+
+			// std::from_chars 不接受前导的正号
+			if (begin != end && *begin == '+')
+			{
+				++begin;
+				if (begin != end && (*begin == '+' || *begin == '-'))
+				{
+					return false;
+				}
+			}
+
+			if (begin == end)
+			{
+				return false;
+			}
+
+			if constexpr (sizeof(CharType) == 1)
+			{
+				return detail_::FromChars(reinterpret_cast<const char*>(begin), reinterpret_cast<const char*>(end), result);
+			}
+			else
+			{
+				// 有效的数值仅由 ASCII 字符构成，窄化到栈上的缓冲区后解析
+				char buffer[detail_::MaxFloatStringLength];
+				const auto length = static_cast<std::size_t>(end - begin);
+				if (length > sizeof buffer)
+				{
+					return false;
+				}
+
+				for (std::size_t i = 0; i < length; ++i)
+				{
+					const auto ch = static_cast<nuInt>(begin[i]);
+					if (ch >= 0x80)
+					{
+						return false;
+					}
+					buffer[i] = static_cast<char>(ch);
+				}
+
+				return detail_::FromChars(buffer, buffer + length, result);
+			}
+		}
+
+		template <typename T, StringType stringType>
+		nBool TryParse(String<stringType> const& str, T& result) noexcept
+		{
+			return TryParse(str.GetView(), result);
+		}
+
+		template <typename T, StringType stringType>
+		nBool TryParse(String<stringType> const& str, T& result, nuInt radix) noexcept
+		{
+			return TryParse(str.GetView(), result, radix);
+		}
+
+		///	@brief	将整数追加到字符串末尾
+		///	@param[in]	str		目标字符串
+		///	@param[in]	value	要追加的值
+		///	@param[in]	radix	基数，范围为 [2, 36]，大于 10 的数位使用小写字母
+		template <StringType stringType, typename T>
+		std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, nBool>> AppendNumber(String<stringType>& str, T value, nuInt radix = 10)
+		{
+			if (radix < 2 || radix > 36)
+			{
+				nat_Throw(natErrException, NatErr_InvalidArg, "radix should be in range [2, 36]."_nv);
+			}
+
+			char buffer[std::numeric_limits<T>::digits + 2]{};
+			const auto convertResult = std::to_chars(std::begin(buffer), std::end(buffer), value, static_cast<int>(radix));
+			assert(convertResult.ec == std::errc{});
+			detail_::AppendAscii(str, buffer, convertResult.ptr);
+		}
+
+		///	@brief	将浮点数以可往返的最短形式追加到字符串末尾
+		template <StringType stringType, typename T>
+		std::enable_if_t<std::is_floating_point_v<T>> AppendNumber(String<stringType>& str, T value)
+		{
+			char buffer[detail_::MaxFloatStringLength]{};
+			const auto convertResult = std::to_chars(std::begin(buffer), std::end(buffer), value);
+			assert(convertResult.ec == std::errc{});
+			detail_::AppendAscii(str, buffer, convertResult.ptr);
+		}
+
+		///	@brief	将浮点数以指定格式及精度追加到字符串末尾
+		///	@param[in]	str			目标字符串
+		///	@param[in]	value		要追加的值
+		///	@param[in]	format		格式，语义同 std::chars_format
+		///	@param[in]	precision	精度，语义同 printf
+		template <StringType stringType, typename T>
+		std::enable_if_t<std::is_floating_point_v<T>> AppendNumber(String<stringType>& str, T value, std::chars_format format, nInt precision)
+		{
+			char buffer[detail_::MaxFloatStringLength]{};
+			const auto convertResult = std::to_chars(std::begin(buffer), std::end(buffer), value, format, precision);
+			if (convertResult.ec != std::errc{})
+			{
+				nat_Throw(natErrException, NatErr_OutOfRange, "Precision is too large."_nv);
+			}
+			detail_::AppendAscii(str, buffer, convertResult.ptr);
+		}
 	}
 }
@@ -2,38 +2,66 @@
 #include "natConfig.h"
 #include "natEnvironment.h"
 #include "natRefObj.h"
+#include "natRope.h"
+#include "natSmallVector.h"
 
 namespace NatsuLib
 {
-	template <StringType encoding>
-	struct TextReader
-		: natRefObj
+	namespace detail_
 	{
-		typedef typename StringEncodingTrait<encoding>::CharType CharType;
+		///	@brief	换行符的码点序列
+		///	@remark	换行符通常只有 1 至 2 个码点，保存在内联存储中
+		typedef SmallVector<nuInt, 2> NewLineCodePoints;
 
-		// 我们假设一个nuInt可以容纳任何NatsuLib支持的编码的单个有效字符
-		// 注意：输出总是一个CodePoint，并非raw的字符组合
-		virtual nBool Read(nuInt& Char) = 0;
-		virtual nBool Peek(nuInt& Char) = 0;
-
-		virtual void SetNewLine(StringView<encoding> const& newLine)
+		///	@brief	将换行符解码为码点序列
+		template <StringType encoding>
+		void DecodeNewLine(StringView<encoding> const& newLine, NewLineCodePoints& codePoints)
 		{
-			m_NewLine.clear();
+			codePoints.clear();
 			EncodingResult result;
 			nuInt codePoint;
 			const auto charCount = newLine.GetCharCount();
 			for (size_t i = 0; i < charCount; ++i)
 			{
-				std::tie(result, std::ignore) = detail_::EncodingCodePoint<encoding>::Decode(newLine.Slice(i, -1), codePoint);
+				std::tie(result, std::ignore) = EncodingCodePoint<encoding>::Decode(newLine.Slice(i, -1), codePoint);
 				if (result != EncodingResult::Accept)
 				{
 					nat_Throw(natException, "Not an available new line string."_nv);
 				}
 
-				m_NewLine.push_back(codePoint);
+				codePoints.push_back(codePoint);
 			}
 		}
 
+		///	@brief	将码点序列编码为换行符
+		template <StringType encoding>
+		String<encoding> EncodeNewLine(NewLineCodePoints const& codePoints)
+		{
+			String<encoding> result;
+			for (auto&& item : codePoints)
+			{
+				EncodingCodePoint<encoding>::Encode(result, item);
+			}
+			return result;
+		}
+	}
+
+	template <StringType encoding>
+	struct TextReader
+		: natRefObj
+	{
+		typedef typename StringEncodingTrait<encoding>::CharType CharType;
+
+		// 我们假设一个nuInt可以容纳任何NatsuLib支持的编码的单个有效字符
+		// 注意：输出总是一个CodePoint，并非raw的字符组合
+		virtual nBool Read(nuInt& Char) = 0;
+		virtual nBool Peek(nuInt& Char) = 0;
+
+		virtual void SetNewLine(StringView<encoding> const& newLine)
+		{
+			detail_::DecodeNewLine(newLine, m_NewLine);
+		}
+
 		virtual String<encoding> ReadUntil(std::initializer_list<nuInt> terminatorChars)
 		{
 			nuInt currentChar;
@@ -81,13 +109,44 @@ namespace NatsuLib
 			return ReadUntil({});
 		}
 
+		detail_::NewLineCodePoints const& GetNewLine() const noexcept
+		{
+			return m_NewLine;
+		}
+
+		///	@brief	读取剩余的所有内容到 Rope
+		///	@remark	内容按固定大小分块读取，分块直接移入 Rope，适用于读取很大的文本，不会因增长而重复分配及复制
+		virtual Rope<encoding> ReadToEndAsRope()
+		{
+			nuInt currentChar;
+			Rope<encoding> result;
+			String<encoding> chunk;
+			chunk.Reserve(RopeChunkSize + 4);
+			while (Read(currentChar) && detail_::EncodingCodePoint<encoding>::Encode(chunk, currentChar) == EncodingResult::Accept)
+			{
+				if (chunk.size() >= RopeChunkSize)
+				{
+					result.Append(std::move(chunk));
+					chunk = String<encoding>{};
+					chunk.Reserve(RopeChunkSize + 4);
+				}
+			}
+			result.Append(std::move(chunk));
+			return result;
+		}
+
 	protected:
+		enum : std::size_t
+		{
+			RopeChunkSize = 4096,
+		};
+
 		TextReader()
 		{
 			TextReader::SetNewLine(String<encoding>{Environment::GetNewLine()});
 		}
 
-		std::vector<nuInt> m_NewLine;
+		detail_::NewLineCodePoints m_NewLine;
 	};
 
 	template <StringType encoding>
@@ -100,20 +159,7 @@ namespace NatsuLib
 
 		virtual void SetNewLine(StringView<encoding> const& newLine)
 		{
-			m_NewLine.clear();
-			EncodingResult result;
-			nuInt codePoint;
-			const auto charCount = newLine.GetCharCount();
-			for (size_t i = 0; i < charCount; ++i)
-			{
-				std::tie(result, std::ignore) = detail_::EncodingCodePoint<encoding>::Decode(newLine.Slice(i, -1), codePoint);
-				if (result != EncodingResult::Accept)
-				{
-					nat_Throw(natException, "Not an available new line string."_nv);
-				}
-
-				m_NewLine.push_back(codePoint);
-			}
+			detail_::DecodeNewLine(newLine, m_NewLine);
 		}
 
 		virtual size_t Write(StringView<encoding> const& str)
@@ -162,6 +208,6 @@ namespace NatsuLib
 			TextWriter::SetNewLine(String<encoding>{Environment::GetNewLine()});
 		}
 
-		std::vector<nuInt> m_NewLine;
+		detail_::NewLineCodePoints m_NewLine;
 	};
 }
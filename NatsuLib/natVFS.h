@@ -4,7 +4,7 @@
 #include "natMisc.h"
 #include "natRefObj.h"
 #include "natStream.h"
-#include <unordered_map>
+#include "natFlatHash.h"
 
 namespace NatsuLib
 {
@@ -115,7 +115,7 @@ namespace NatsuLib
 		natRefPointer<IRequest> CreateRequest(nStrView const& uriString);
 
 	private:
-		std::unordered_map<nStrView, natRefPointer<IScheme>> m_SchemeMap;
+		FlatHashMap<nStrView, natRefPointer<IScheme>> m_SchemeMap;
 	};
 }
 
@@ -0,0 +1,117 @@
+﻿#include "TestHarness.h"
+#include <natColumnar.h>
+#include <random>
+#include <tuple>
+#include <vector>
+
+using namespace NatsuLib;
+
+namespace
+{
+	struct Record
+	{
+		nInt Id;
+		nDouble Price;
+		nByte Flag;
+	};
+
+	std::vector<Record> MakeRecords(std::size_t count)
+	{
+		std::mt19937 random{ 36 };
+		std::vector<Record> records;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			records.push_back({ static_cast<nInt>(i), static_cast<nDouble>(random() % 200), static_cast<nByte>(random() % 2) });
+		}
+		return records;
+	}
+
+	typedef ColumnTable<nInt, nDouble, nByte> Table;
+}
+
+NatTestCase(ColumnTableFromRows)
+{
+	const auto records = MakeRecords(100);
+	const auto table = Table::FromRows(records, &Record::Id, &Record::Price, [](Record const& r) { return r.Flag; });
+	NatCheck(table.size() == records.size());
+	for (std::size_t i = 0; i < records.size(); ++i)
+	{
+		NatCheck(table.At<0>(i) == records[i].Id);
+		NatCheck(table.At<1>(i) == records[i].Price);
+		NatCheck(table.GetRow(i) == std::make_tuple(records[i].Id, records[i].Price, records[i].Flag));
+	}
+	NatCheckThrows(table.GetRow(records.size()));
+
+	Table other;
+	NatCheck(other.empty());
+	other.push_back(1, 2.0, nByte{ 1 });
+	other.push_back(std::make_tuple(3, 4.0, nByte{ 0 }));
+	NatCheck(other.size() == 2 && other.GetColumn<1>() == (std::vector<nDouble>{ 2.0, 4.0 }));
+	other.clear();
+	NatCheck(other.empty());
+}
+
+NatTestCase(ColumnQueryWhere)
+{
+	// 包括恰好在字的边界上及跨越边界的大小
+	for (const std::size_t size : { std::size_t{}, std::size_t{ 1 }, std::size_t{ 63 }, std::size_t{ 64 }, std::size_t{ 65 }, std::size_t{ 1000 } })
+	{
+		const auto records = MakeRecords(size);
+		const auto table = Table::FromRows(records, &Record::Id, &Record::Price, &Record::Flag);
+
+		std::vector<nInt> expected;
+		nDouble expectedSum{};
+		for (auto&& record : records)
+		{
+			if (record.Price < 100 && record.Flag)
+			{
+				expected.push_back(record.Id);
+				expectedSum += record.Price;
+			}
+		}
+
+		const auto query = from_columns(table).where<1>([](nDouble price) { return price < 100; }).where<2>([](nByte flag) { return flag != 0; });
+		NatCheck(query.count() == expected.size());
+		NatCheck(query.any() == !expected.empty());
+		NatCheck(query.select<0>().Cast<std::vector<nInt>>() == expected);
+		NatCheck(query.sum<1>() == expectedSum);
+
+		std::size_t index{};
+		for (auto&& row : query.select<0, 1>())
+		{
+			NatCheck(std::get<0>(row) == expected[index]);
+			NatCheck(std::get<1>(row) < 100);
+			++index;
+		}
+		NatCheck(index == expected.size());
+
+		const auto projected = query.select<0, 1>([](nInt id, nDouble price) { return id + static_cast<nInt>(price); }).Cast<std::vector<nInt>>();
+		NatCheck(projected.size() == expected.size());
+		for (std::size_t i = 0; i < projected.size(); ++i)
+		{
+			NatCheck(projected[i] == expected[i] + static_cast<nInt>(records[expected[i]].Price));
+		}
+
+		const auto multi = from_columns(table).where<1, 2>([](nDouble price, nByte flag) { return price < 100 && flag; });
+		NatCheck(multi.indices().Cast<std::vector<std::size_t>>() == query.indices().Cast<std::vector<std::size_t>>());
+	}
+}
+
+NatTestCase(ColumnQuerySelection)
+{
+	const auto table = Table::FromRows(MakeRecords(130), &Record::Id, &Record::Price, &Record::Flag);
+	NatCheckThrows(ColumnQuery<Table>(table, detail_::SelectionBitmap(129)));
+
+	detail_::SelectionBitmap selection(130, false);
+	NatCheck(!selection.Any() && selection.Count() == 0);
+	const auto none = ColumnQuery<Table>(table, selection).where<0>([](nInt) { return true; });
+	NatCheck(none.count() == 0 && none.select<0>().count() == 0);
+
+	nByte flags[detail_::SelectionBitmap::BitsPerWord]{};
+	flags[0] = flags[5] = flags[63] = 1;
+	NatCheck(detail_::SelectionBitmap::PackFlags(flags) == ((detail_::SelectionBitmap::Word_t{ 1 } << 63) | 0x21));
+
+	const detail_::SelectionBitmap all(130);
+	NatCheck(all.Count() == 130 && all.Test(129));
+	NatCheck(all.ToIndices().back() == 129);
+}
@@ -0,0 +1,275 @@
+﻿#include "TestHarness.h"
+#include <natDelegate.h>
+#include <utility>
+
+using namespace NatsuLib;
+
+namespace
+{
+	struct LifetimeCounter
+	{
+		nInt Constructed;
+		nInt Destroyed;
+
+		nInt Alive() const noexcept
+		{
+			return Constructed - Destroyed;
+		}
+	};
+
+	// 统计构造及析构次数的可调用对象，PaddingSize 决定其是否能放入内联存储
+	template <size_t PaddingSize>
+	struct CountedCallable
+	{
+		LifetimeCounter* Counter;
+		nInt Value;
+		nByte Padding[PaddingSize];
+
+		CountedCallable(LifetimeCounter& counter, nInt value) noexcept
+			: Counter{ &counter }, Value{ value }, Padding{}
+		{
+			++Counter->Constructed;
+		}
+
+		CountedCallable(CountedCallable const& other) noexcept
+			: Counter{ other.Counter }, Value{ other.Value }, Padding{}
+		{
+			++Counter->Constructed;
+		}
+
+		CountedCallable(CountedCallable&& other) noexcept
+			: CountedCallable(static_cast<CountedCallable const&>(other))
+		{
+		}
+
+		~CountedCallable()
+		{
+			++Counter->Destroyed;
+		}
+
+		nInt operator()(nInt x) const noexcept
+		{
+			return x + Value;
+		}
+	};
+
+	typedef CountedCallable<8> InlineCallable;
+	typedef CountedCallable<64> HeapCallable;
+
+	// 可平凡复制，复制及移动时直接复制内存
+	struct TrivialCallable
+	{
+		nInt Value;
+
+		nInt operator()(nInt x) const noexcept
+		{
+			return x + Value;
+		}
+	};
+
+	// 成员函数指针也可能指向虚函数
+	class Accumulator
+	{
+	public:
+		Accumulator() noexcept
+			: Sum{}
+		{
+		}
+
+		virtual ~Accumulator() = default;
+
+		void Add(nInt value) noexcept
+		{
+			Sum += value;
+		}
+
+		virtual nInt Get() const noexcept
+		{
+			return Sum;
+		}
+
+		nInt Sum;
+	};
+
+	nInt Triple(nInt x)
+	{
+		return x * 3;
+	}
+
+	// 依次进行复制、移动、赋值及交换，检查每一步后存活的可调用对象数
+	// heapMove 为 true 时移动仅转移堆上对象的所有权，不会构造新对象
+	template <typename Callable>
+	void CheckDelegateLifetime(nBool heapMove)
+	{
+		typedef Delegate<nInt(nInt)> Delegate_t;
+
+		LifetimeCounter counter{};
+		{
+			Delegate_t first{ Callable{ counter, 1 } };
+			NatCheck(first && first(1) == 2 && counter.Alive() == 1);
+
+			Delegate_t copy{ first };
+			NatCheck(copy(1) == 2 && counter.Alive() == 2);
+
+			const auto constructed = counter.Constructed;
+			Delegate_t moved{ std::move(copy) };
+			NatCheck(!copy && moved(1) == 2 && counter.Alive() == 2);
+			NatCheck(counter.Constructed == constructed + (heapMove ? 0 : 1));
+
+			Delegate_t other{ Callable{ counter, 10 } };
+			NatCheck(counter.Alive() == 3);
+
+			// 复制赋值销毁原有的可调用对象
+			other = first;
+			NatCheck(other(1) == 2 && counter.Alive() == 3);
+
+			auto& self = other;
+			other = self;
+			NatCheck(other(1) == 2 && counter.Alive() == 3);
+			other = std::move(self);
+			NatCheck(other(1) == 2 && counter.Alive() == 3);
+
+			copy = std::move(other);
+			NatCheck(!other && copy(1) == 2 && counter.Alive() == 3);
+
+			Delegate_t swapped{ Callable{ counter, 100 } };
+			swap(copy, swapped);
+			NatCheck(copy(1) == 101 && swapped(1) == 2 && counter.Alive() == 4);
+			copy.swap(other);
+			NatCheck(!copy && other(1) == 101 && counter.Alive() == 4);
+			other.swap(other);
+			NatCheck(other(1) == 101 && counter.Alive() == 4);
+
+			other = nullptr;
+			NatCheck(!other && counter.Alive() == 3);
+		}
+		NatCheck(counter.Alive() == 0);
+	}
+}
+
+NatTestCase(DelegateInlineLifetime)
+{
+	static_assert(sizeof(InlineCallable) <= DefaultDelegateInlineSize);
+	CheckDelegateLifetime<InlineCallable>(false);
+}
+
+NatTestCase(DelegateHeapLifetime)
+{
+	static_assert(sizeof(HeapCallable) > DefaultDelegateInlineSize);
+	CheckDelegateLifetime<HeapCallable>(true);
+
+	// 超过指定的内联存储大小时同样在堆上分配
+	LifetimeCounter counter{};
+	{
+		Delegate<nInt(nInt), sizeof(void*)> small{ InlineCallable{ counter, 2 } };
+		const auto copy = small;
+		const auto moved = std::move(small);
+		NatCheck(copy(1) == 3 && moved(1) == 3 && counter.Alive() == 2);
+	}
+	NatCheck(counter.Alive() == 0);
+}
+
+NatTestCase(DelegateTrivialCallable)
+{
+	Delegate<nInt(nInt)> first{ TrivialCallable{ 1 } };
+	Delegate<nInt(nInt)> second{ [](nInt x) { return x * 2; } };
+	auto copy = first;
+	NatCheck(copy(1) == 2 && first(1) == 2);
+
+	auto moved = std::move(copy);
+	NatCheck(!copy && moved(1) == 2);
+
+	swap(moved, second);
+	NatCheck(moved(3) == 6 && second(3) == 4);
+
+	copy = second;
+	second = nullptr;
+	NatCheck(copy(3) == 4 && !second);
+
+	Delegate<nInt(nInt)> function{ &Triple };
+	NatCheck(function(2) == 6);
+	function = moved;
+	NatCheck(function(2) == 4);
+}
+
+NatTestCase(DelegateEmpty)
+{
+	Delegate<void()> empty;
+	NatCheck(!empty && !static_cast<bool>(empty));
+	NatCheckThrows(empty());
+
+	const Delegate<nInt(nInt)> null{ nullptr };
+	NatCheckThrows(null(1));
+
+	// 由空的函数指针或成员函数指针构造时为空
+	nInt(*nullFunction)(nInt) = nullptr;
+	const Delegate<nInt(nInt)> fromNullFunction{ nullFunction };
+	NatCheck(!fromNullFunction);
+	NatCheckThrows(fromNullFunction(1));
+
+	nInt(Accumulator::*nullMethod)() const = nullptr;
+	const Delegate<nInt(Accumulator const&)> fromNullMethod{ nullMethod };
+	NatCheck(!fromNullMethod);
+	NatCheckThrows(fromNullMethod(Accumulator{}));
+
+	// 清空后再次调用同样抛出异常
+	Delegate<nInt(nInt)> reset{ &Triple };
+	NatCheck(reset(1) == 3);
+	reset = nullptr;
+	NatCheckThrows(reset(1));
+	const auto copy = reset;
+	NatCheckThrows(copy(1));
+}
+
+NatTestCase(DelegateMemberBinding)
+{
+	Accumulator accumulator{};
+
+	// Bind 仅保存对象的指针
+	static_assert(sizeof(detail_::BoundMethod<&Accumulator::Add, Accumulator>) == sizeof(void*));
+	const auto bound = Delegate<void(nInt)>::Bind<&Accumulator::Add>(accumulator);
+	bound(3);
+	bound(4);
+	NatCheck(accumulator.Sum == 7);
+
+	const auto boundGetter = Delegate<nInt()>::Bind<&Accumulator::Get>(std::as_const(accumulator));
+	NatCheck(boundGetter() == 7);
+
+	const Delegate<void(nInt)> method{ &Accumulator::Add, accumulator };
+	method(5);
+	NatCheck(accumulator.Sum == 12 && boundGetter() == 12);
+
+	// 未绑定对象的成员函数指针以第一个参数作为对象
+	const Delegate<nInt(Accumulator const&)> getter{ &Accumulator::Get };
+	NatCheck(getter(accumulator) == 12);
+}
+
+NatTestCase(DelegateRefCallable)
+{
+	NatCheck(DelegateRef<nInt(nInt)>{ &Triple }(2) == 6);
+	NatCheck(DelegateRef<nInt(nInt)>{ Triple }(3) == 9);
+
+	nInt captured = 1;
+	auto lambda = [&captured](nInt x) { return x + captured; };
+	const DelegateRef<nInt(nInt)> lambdaRef{ lambda };
+	captured = 5;
+	NatCheck(lambdaRef(1) == 6);
+
+	// 仅引用可调用对象，既不复制也不移动
+	LifetimeCounter counter{};
+	{
+		InlineCallable callable{ counter, 1 };
+		const DelegateRef<nInt(nInt)> ref{ callable };
+		const auto copy = ref;
+		callable.Value = 10;
+		NatCheck(ref(1) == 11 && copy(2) == 12);
+		NatCheck(counter.Constructed == 1);
+	}
+	NatCheck(counter.Alive() == 0);
+
+	Accumulator accumulator{};
+	const auto bound = Delegate<void(nInt)>::Bind<&Accumulator::Add>(accumulator);
+	const DelegateRef<void(nInt)> delegateRef{ bound };
+	delegateRef(2);
+	NatCheck(accumulator.Sum == 2);
+}
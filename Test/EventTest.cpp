@@ -0,0 +1,438 @@
+﻿#include "TestHarness.h"
+#include <natEvent.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace NatsuLib;
+
+namespace
+{
+	class ValueEvent
+		: public natEventBase
+	{
+	public:
+		explicit ValueEvent(nInt value = 0) noexcept
+			: Value{ value }
+		{
+		}
+
+		nBool operator==(ValueEvent const& other) const noexcept
+		{
+			return Value == other.Value;
+		}
+
+		nInt Value;
+	};
+
+	class CancelableEvent
+		: public natEventBase
+	{
+	public:
+		nBool CanCancel() const noexcept override
+		{
+			return true;
+		}
+	};
+
+	class UnregisteredEvent
+		: public natEventBase
+	{
+	};
+
+	// 打开之前阻塞调用 Wait 的线程
+	class Gate
+	{
+	public:
+		void Open()
+		{
+			std::lock_guard<std::mutex> lock{ m_Mutex };
+			m_Open = true;
+			m_Opened.notify_all();
+		}
+
+		void Wait()
+		{
+			std::unique_lock<std::mutex> lock{ m_Mutex };
+			m_Opened.wait(lock, [this] { return m_Open; });
+		}
+
+	private:
+		std::mutex m_Mutex;
+		std::condition_variable m_Opened;
+		nBool m_Open{};
+	};
+
+	template <typename Predicate>
+	void SpinUntil(Predicate predicate)
+	{
+		while (!predicate())
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	// 值为 0 的事件进入监听器后阻塞分发线程，在此期间依次发送 values 中的事件以填充队列，返回分发的所有事件的值
+	std::vector<nInt> PostWhileDispatcherBlocked(AsyncEventOptions const& options, std::vector<nInt> const& values)
+	{
+		natThreadPool dispatcher{ 1, 1 };
+		std::vector<nInt> received;
+		Gate gate;
+		std::atomic<nBool> entered{};
+
+		natEventBus bus;
+		bus.RegisterEvent<ValueEvent>(dispatcher, options);
+		bus.RegisterEventListener<ValueEvent>([&](natEventBase& e)
+		{
+			received.push_back(static_cast<ValueEvent&>(e).Value);
+			if (!entered.exchange(true))
+			{
+				gate.Wait();
+			}
+		});
+
+		ValueEvent first{ 0 };
+		bus.Post(first);
+		SpinUntil([&entered] { return entered.load(); });
+
+		for (const auto value : values)
+		{
+			ValueEvent event{ value };
+			bus.Post(event);
+		}
+
+		gate.Open();
+		bus.FlushAsyncEvent<ValueEvent>();
+		return received;
+	}
+}
+
+NatTestCase(EventBusPriorityAndID)
+{
+	natEventBus bus;
+	bus.RegisterEvent<CancelableEvent>();
+
+	std::string order;
+	const auto listener = [&order](char tag)
+	{
+		return [&order, tag](natEventBase&) { order += tag; };
+	};
+
+	// 同一优先级按注册顺序分发，ID 为同一优先级中最大的 ID 加 1
+	NatCheck(bus.RegisterEventListener<CancelableEvent>(listener('a')) == 0);
+	NatCheck(bus.RegisterEventListener<CancelableEvent>(listener('L'), Priority::Low) == 0);
+	NatCheck(bus.RegisterEventListener<CancelableEvent>(listener('b')) == 1);
+	NatCheck(bus.RegisterEventListener<CancelableEvent>(listener('H'), Priority::High) == 0);
+	NatCheck(bus.RegisterEventListener<CancelableEvent>(listener('c')) == 2);
+
+	CancelableEvent event;
+	NatCheck(!bus.Post(event));
+	NatCheck(order == "HabcL");
+
+	bus.UnregisterEventListener<CancelableEvent>(Priority::Normal, 1);
+	NatCheck(bus.RegisterEventListener<CancelableEvent>(listener('d')) == 3);
+	order.clear();
+	bus.Post(event);
+	NatCheck(order == "HacdL");
+
+	// 注销最大的 ID 后该 ID 会被再次使用
+	bus.UnregisterEventListener<CancelableEvent>(Priority::Normal, 3);
+	NatCheck(bus.RegisterEventListener<CancelableEvent>(listener('e')) == 3);
+
+	// 注销不存在的监听器不产生影响
+	bus.UnregisterEventListener<CancelableEvent>(Priority::Normal, 100);
+	bus.UnregisterEventListener<CancelableEvent>(Priority::High, 1);
+	order.clear();
+	bus.Post(event);
+	NatCheck(order == "HaceL");
+
+	// 取消事件不会中断分发
+	bus.RegisterEventListener<CancelableEvent>([](natEventBase& e) { e.SetCancel(true); }, Priority::High);
+	order.clear();
+	CancelableEvent canceled;
+	NatCheck(bus.Post(canceled));
+	NatCheck(order == "HaceL");
+
+	UnregisteredEvent unregistered;
+	NatCheckThrows(bus.Post(unregistered));
+	NatCheckThrows(bus.RegisterEventListener<UnregisteredEvent>([](natEventBase&) {}));
+	NatCheckThrows(bus.RegisterEvent<CancelableEvent>());
+}
+
+NatTestCase(EventBusRegisterInsideListener)
+{
+	natEventBus bus;
+	bus.RegisterEvent<ValueEvent>();
+
+	nInt addedCalls = 0, selfRemovingCalls = 0, otherCalls = 0;
+	nBool added = false;
+	natEventBus::ListenerIDType selfID;
+
+	bus.RegisterEventListener<ValueEvent>([&](natEventBase&)
+	{
+		if (!added)
+		{
+			added = true;
+			bus.RegisterEventListener<ValueEvent>([&addedCalls](natEventBase&) { ++addedCalls; }, Priority::Low);
+		}
+	}, Priority::High);
+	selfID = bus.RegisterEventListener<ValueEvent>([&](natEventBase&)
+	{
+		++selfRemovingCalls;
+		bus.UnregisterEventListener<ValueEvent>(Priority::Normal, selfID);
+	});
+	bus.RegisterEventListener<ValueEvent>([&otherCalls](natEventBase&) { ++otherCalls; });
+
+	// 在监听器中注册或注销的监听器在下一次 Post 时才生效
+	ValueEvent event;
+	bus.Post(event);
+	NatCheck(addedCalls == 0 && selfRemovingCalls == 1 && otherCalls == 1);
+
+	bus.Post(event);
+	NatCheck(addedCalls == 1 && selfRemovingCalls == 1 && otherCalls == 2);
+
+	bus.Post(event);
+	NatCheck(addedCalls == 2 && selfRemovingCalls == 1 && otherCalls == 3);
+}
+
+NatTestCase(EventBusConcurrentPostAndRegister)
+{
+	constexpr nInt PosterCount = 4;
+	constexpr nInt PostsPerThread = 2000;
+
+	natEventBus bus;
+	bus.RegisterEvent<ValueEvent>();
+
+	std::atomic<nInt> persistentCalls{}, transientCalls{}, sum{};
+	bus.RegisterEventListener<ValueEvent>([&](natEventBase& e)
+	{
+		++persistentCalls;
+		sum += static_cast<ValueEvent&>(e).Value;
+	});
+
+	std::atomic<nBool> stop{};
+	std::thread registrar{ [&]
+	{
+		while (!stop.load())
+		{
+			const auto priority = static_cast<natEventBus::PriorityType>(Priority::High + transientCalls.load() % 3);
+			const auto id = bus.RegisterEventListener<ValueEvent>([&transientCalls](natEventBase&) { ++transientCalls; }, priority);
+			std::this_thread::yield();
+			bus.UnregisterEventListener<ValueEvent>(priority, id);
+		}
+	} };
+
+	std::vector<std::thread> posters;
+	for (nInt i = 0; i < PosterCount; ++i)
+	{
+		posters.emplace_back([&bus]
+		{
+			for (nInt j = 0; j < PostsPerThread; ++j)
+			{
+				ValueEvent event{ 1 };
+				bus.Post(event);
+			}
+		});
+	}
+
+	for (auto& poster : posters)
+	{
+		poster.join();
+	}
+	stop.store(true);
+	registrar.join();
+
+	// 常驻的监听器收到每一个事件，临时的监听器不会被调用超过发送的事件数
+	NatCheck(persistentCalls.load() == PosterCount * PostsPerThread);
+	NatCheck(sum.load() == PosterCount * PostsPerThread);
+	NatCheck(transientCalls.load() <= PosterCount * PostsPerThread);
+
+	const auto before = transientCalls.load();
+	ValueEvent event{ 1 };
+	bus.Post(event);
+	NatCheck(transientCalls.load() == before && persistentCalls.load() == PosterCount * PostsPerThread + 1);
+}
+
+NatTestCase(EventBusChannel)
+{
+	natEventBus bus;
+
+	// 同一事件类型总是返回同一通道，不需要先注册事件
+	const auto channel = bus.GetChannel<ValueEvent>();
+	NatCheck(channel && bus.GetChannel<ValueEvent>() == channel);
+	NatCheck(static_cast<natRefObj*>(bus.GetChannel<CancelableEvent>().Get()) != static_cast<natRefObj*>(channel.Get()));
+	NatCheckThrows(bus.RegisterEventListener<ValueEvent>([](natEventBase&) {}));
+
+	nInt channelSum = 0, busSum = 0;
+	channel->RegisterEventListener([&channelSum](ValueEvent& e) { channelSum += e.Value; });
+	ValueEvent event{ 1 };
+	NatCheck(!bus.GetChannel<ValueEvent>()->Post(event));
+	NatCheck(channelSum == 1);
+
+	// 通道与以 RegisterEvent 注册的事件的监听器相互独立
+	bus.RegisterEvent<ValueEvent>();
+	bus.RegisterEventListener<ValueEvent>([&busSum](natEventBase& e) { busSum += static_cast<ValueEvent&>(e).Value; });
+	event.Value = 10;
+	bus.Post(event);
+	NatCheck(channelSum == 1 && busSum == 10);
+	event.Value = 100;
+	channel->Post(event);
+	NatCheck(channelSum == 101 && busSum == 10);
+
+	const auto id = channel->RegisterEventListener([](ValueEvent& e) { e.Value = 0; }, Priority::Low);
+	channel->Post(event);
+	NatCheck(channelSum == 201 && event.Value == 0);
+	channel->UnregisterEventListener(Priority::Low, id);
+	event.Value = 5;
+	channel->Post(event);
+	NatCheck(channelSum == 206 && event.Value == 5 && busSum == 10);
+}
+
+NatTestCase(AsyncEventBackpressure)
+{
+	AsyncEventOptions options;
+	options.Capacity = 2;
+
+	options.Policy = EventBackpressurePolicy::DropOldest;
+	NatCheck((PostWhileDispatcherBlocked(options, { 1, 2, 3, 4 }) == std::vector<nInt>{ 0, 3, 4 }));
+
+	options.Policy = EventBackpressurePolicy::DropNewest;
+	NatCheck((PostWhileDispatcherBlocked(options, { 1, 2, 3, 4 }) == std::vector<nInt>{ 0, 1, 2 }));
+
+	// 队列已满时阻塞发送方，直到分发线程取出事件
+	natThreadPool dispatcher{ 1, 1 };
+	std::vector<nInt> received;
+	Gate gate;
+	std::atomic<nBool> entered{}, posted{};
+
+	natEventBus bus;
+	options.Policy = EventBackpressurePolicy::Block;
+	bus.RegisterEvent<ValueEvent>(dispatcher, options);
+	bus.RegisterEventListener<ValueEvent>([&](natEventBase& e)
+	{
+		received.push_back(static_cast<ValueEvent&>(e).Value);
+		if (!entered.exchange(true))
+		{
+			gate.Wait();
+		}
+	});
+
+	for (nInt i = 0; i < 3; ++i)
+	{
+		ValueEvent event{ i };
+		bus.Post(event);
+		SpinUntil([&entered] { return entered.load(); });
+	}
+
+	std::thread poster{ [&]
+	{
+		ValueEvent event{ 3 };
+		bus.Post(event);
+		posted.store(true);
+	} };
+
+	std::this_thread::sleep_for(std::chrono::milliseconds{ 50 });
+	NatCheck(!posted.load());
+
+	gate.Open();
+	poster.join();
+	bus.FlushAsyncEvent<ValueEvent>();
+	NatCheck((received == std::vector<nInt>{ 0, 1, 2, 3 }));
+}
+
+NatTestCase(AsyncEventCoalesce)
+{
+	AsyncEventOptions options;
+	options.Coalesce = true;
+
+	// 仅与队尾尚未分发的事件合并
+	NatCheck((PostWhileDispatcherBlocked(options, { 1, 1, 2, 2, 1, 0 }) == std::vector<nInt>{ 0, 1, 2, 1, 0 }));
+
+	options.Coalesce = false;
+	NatCheck((PostWhileDispatcherBlocked(options, { 1, 1, 2 }) == std::vector<nInt>{ 0, 1, 1, 2 }));
+
+	natThreadPool dispatcher{ 1, 1 };
+	natEventBus bus;
+	options.Coalesce = true;
+	NatCheckThrows(bus.RegisterEvent<CancelableEvent>(dispatcher, options));
+	options.Capacity = 0;
+	NatCheckThrows(bus.RegisterEvent<ValueEvent>(dispatcher, options));
+}
+
+NatTestCase(AsyncEventFlushAndExceptions)
+{
+	constexpr nInt EventCount = 1000;
+
+	natThreadPool dispatcher{ 1, 1 };
+	std::atomic<nInt> received{}, thrown{};
+
+	natEventBus bus;
+	bus.RegisterEvent<ValueEvent>(dispatcher);
+	bus.RegisterEvent<CancelableEvent>();
+
+	// 监听器抛出的异常被忽略，不影响其他监听器及之后的事件
+	bus.RegisterEventListener<ValueEvent>([&thrown](natEventBase& e)
+	{
+		if (static_cast<ValueEvent&>(e).Value % 2)
+		{
+			++thrown;
+			throw std::runtime_error("listener failed");
+		}
+	}, Priority::High);
+	bus.RegisterEventListener<ValueEvent>([&received](natEventBase&) { ++received; });
+
+	for (nInt round = 0; round < 3; ++round)
+	{
+		for (nInt i = 0; i < EventCount; ++i)
+		{
+			ValueEvent event{ i };
+			NatCheck(!bus.Post(event));
+		}
+
+		bus.FlushAsyncEvent<ValueEvent>();
+		NatCheck(received.load() == EventCount * (round + 1));
+		NatCheck(thrown.load() == EventCount / 2 * (round + 1));
+
+		// 等待分发任务结束后再次发送
+		std::this_thread::sleep_for(std::chrono::milliseconds{ 5 });
+	}
+
+	// 同步事件立即返回，未注册的事件抛出异常
+	bus.FlushAsyncEvent<CancelableEvent>();
+	NatCheckThrows(bus.FlushAsyncEvent<UnregisteredEvent>());
+}
+
+NatTestCase(AsyncEventDestroyBusWithQueuedEvents)
+{
+	constexpr nInt EventCount = 100;
+
+	natThreadPool dispatcher{ 1, 1 };
+	std::atomic<nInt> received{};
+	{
+		natEventBus bus;
+		AsyncEventOptions options;
+		options.Capacity = EventCount;
+		bus.RegisterEvent<ValueEvent>(dispatcher, options);
+		bus.RegisterEventListener<ValueEvent>([&received](natEventBase&)
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds{ 100 });
+			++received;
+		});
+
+		for (nInt i = 0; i < EventCount; ++i)
+		{
+			ValueEvent event{ i };
+			bus.Post(event);
+		}
+	}
+
+	// 析构时分发已进入队列的事件，之后不再调用监听器
+	NatCheck(received.load() == EventCount);
+	std::this_thread::sleep_for(std::chrono::milliseconds{ 10 });
+	NatCheck(received.load() == EventCount);
+}
@@ -0,0 +1,204 @@
+﻿#include "TestHarness.h"
+#include <natFlatHash.h>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace NatsuLib;
+
+namespace
+{
+	// 只使用少数几个哈希值，使大量的键在同一组中冲突
+	struct PoorHash
+	{
+		std::size_t operator()(nInt key) const noexcept
+		{
+			return static_cast<std::size_t>(key % 7);
+		}
+	};
+
+	// 记录存活的实例数以检查元素是否被正确析构
+	struct Tracked
+	{
+		static nInt s_Alive;
+		nInt Value;
+
+		explicit Tracked(nInt value = 0) noexcept
+			: Value{ value }
+		{
+			++s_Alive;
+		}
+
+		Tracked(Tracked const& other) noexcept
+			: Value{ other.Value }
+		{
+			++s_Alive;
+		}
+
+		Tracked& operator=(Tracked const& other) = default;
+
+		~Tracked()
+		{
+			--s_Alive;
+		}
+	};
+
+	nInt Tracked::s_Alive{};
+
+	template <typename Map_t>
+	nBool SameAsModel(Map_t const& map, std::unordered_map<nInt, nInt> const& model)
+	{
+		if (map.size() != model.size())
+		{
+			return false;
+		}
+
+		std::size_t visited{};
+		for (auto&& item : map)
+		{
+			const auto iter = model.find(item.first);
+			if (iter == model.end() || iter->second != item.second.Value)
+			{
+				return false;
+			}
+			++visited;
+		}
+		return visited == model.size();
+	}
+}
+
+NatTestCase(FlatHashMapRandomOperations)
+{
+	{
+		FlatHashMap<nInt, Tracked, PoorHash> map;
+		std::unordered_map<nInt, nInt> model;
+		std::mt19937 random{ 39 };
+
+		for (int step = 0; step < 20000; ++step)
+		{
+			const auto key = static_cast<nInt>(random() % 500);
+			switch (random() % 5)
+			{
+			case 0:
+			{
+				const auto ret = map.try_emplace(key, step);
+				NatCheck(ret.second == !model.count(key));
+				model.emplace(key, step);
+				NatCheck(ret.first->first == key);
+				break;
+			}
+			case 1:
+				map.insert_or_assign(key, Tracked{ step });
+				model[key] = step;
+				break;
+			case 2:
+				map[key].Value = step;
+				model[key] = step;
+				break;
+			case 3:
+				NatCheck(map.erase(key) == model.erase(key));
+				break;
+			default:
+				NatCheck(map.contains(key) == (model.count(key) != 0));
+				if (model.count(key))
+				{
+					NatCheck(map.at(key).Value == model[key]);
+				}
+				else
+				{
+					NatCheckThrows(map.at(key));
+				}
+				break;
+			}
+		}
+		NatCheck(SameAsModel(map, model));
+		NatCheck(Tracked::s_Alive == static_cast<nInt>(map.size()));
+
+		// 遍历时删除元素
+		for (auto iter = map.begin(); iter != map.end();)
+		{
+			if (iter->first % 2)
+			{
+				model.erase(iter->first);
+				iter = map.erase(iter);
+			}
+			else
+			{
+				++iter;
+			}
+		}
+		NatCheck(SameAsModel(map, model));
+		NatCheck(map.load_factor() <= FlatHashMap<nInt, Tracked, PoorHash>::max_load_factor());
+
+		auto copy = map;
+		NatCheck(SameAsModel(copy, model));
+		map.rehash(0);
+		NatCheck(SameAsModel(map, model));
+		map.reserve(5000);
+		NatCheck(map.capacity() * 7 / 8 >= 5000);
+		NatCheck(SameAsModel(map, model));
+
+		auto moved = std::move(copy);
+		NatCheck(copy.empty() && SameAsModel(moved, model));
+		copy = moved;
+		NatCheck(SameAsModel(copy, model));
+		swap(copy, map);
+		NatCheck(SameAsModel(map, model));
+
+		moved.clear();
+		NatCheck(moved.empty() && moved.begin() == moved.end());
+	}
+	NatCheck(Tracked::s_Alive == 0);
+}
+
+NatTestCase(FlatHashSetOperations)
+{
+	FlatHashSet<nInt> set{};
+	std::unordered_set<nInt> model;
+	std::mt19937 random{ 390 };
+	for (int i = 0; i < 10000; ++i)
+	{
+		const auto key = static_cast<nInt>(random() % 3000);
+		if (random() % 3)
+		{
+			NatCheck(set.insert(key).second == model.insert(key).second);
+		}
+		else
+		{
+			NatCheck(set.erase(key) == model.erase(key));
+		}
+	}
+	NatCheck(set.size() == model.size());
+	for (auto key : set)
+	{
+		NatCheck(model.count(key) == 1);
+	}
+
+	set.insert({ -1, -2, -1 });
+	NatCheck(set.count(-1) == 1 && set.count(-2) == 1);
+	const auto found = set.find(-2);
+	NatCheck(found != set.end() && *found == -2);
+}
+
+NatTestCase(FlatHashStringKeys)
+{
+	FlatHashMap<nString, std::unique_ptr<nInt>> map;
+	for (nInt i = 0; i < 1000; ++i)
+	{
+		map.try_emplace(natUtil::FormatString("key{0}"_nv, i), std::make_unique<nInt>(i));
+	}
+	NatCheck(map.size() == 1000);
+
+	// 以字符串视图查找时不需要构造字符串
+	const auto iter = map.find("key42"_nv);
+	NatCheck(iter != map.end() && *iter->second == 42);
+	NatCheck(map.contains("key999"_nv) && !map.contains("key1000"_nv));
+	NatCheck(map.erase("key0"_nv) == 1 && !map.contains("key0"_nv));
+
+	FlatHashSet<nString> set;
+	set.emplace("a"_nv);
+	set.emplace("b"_nv);
+	NatCheck(!set.emplace("a"_nv).second);
+	NatCheck(set.size() == 2 && set.contains("b"_nv));
+}
@@ -0,0 +1,193 @@
+﻿#include "TestHarness.h"
+#include <natLineIndex.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace NatsuLib;
+
+namespace
+{
+	constexpr auto TestFile = "LineIndexTest.txt";
+	constexpr auto SidecarFile = "LineIndexTest.txt.idx";
+
+	std::vector<std::string> WriteTestFile(std::size_t lineCount, nBool terminated)
+	{
+		std::vector<std::string> lines;
+		std::ofstream file{ TestFile, std::ios::binary | std::ios::trunc };
+		for (std::size_t i = 0; i < lineCount; ++i)
+		{
+			lines.push_back(i % 5 ? "line " + std::to_string(i) : std::string{});
+			file << lines.back();
+			if (terminated || i + 1 < lineCount)
+			{
+				file << "\r\n";
+			}
+		}
+		return lines;
+	}
+
+	void RemoveTestFiles()
+	{
+		std::remove(TestFile);
+		std::remove(SidecarFile);
+	}
+
+	nBool CheckLines(natLineIndex<StringType::Utf8> const& index, std::vector<std::string> const& lines)
+	{
+		if (index.GetLineCount() != lines.size())
+		{
+			return false;
+		}
+
+		for (std::size_t i = 0; i < lines.size(); ++i)
+		{
+			if (index.GetLine(i) != nStrView{ lines[i].data(), lines[i].size() })
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+NatTestCase(LineIndexBuild)
+{
+	const auto cleanup = make_scope(&RemoveTestFiles);
+	for (auto terminated : { false, true })
+	{
+		const auto lines = WriteTestFile(1000, terminated);
+		for (auto useMapping : { false, true })
+		{
+			natLineIndex<StringType::Utf8> index{ make_ref<natFileStream>(TestFile, true, false), "\r\n"_nv, useMapping };
+			NatCheck(index.IsMapped() == useMapping);
+			NatCheck(CheckLines(index, lines));
+		}
+	}
+
+	WriteTestFile(0, false);
+	natLineIndex<StringType::Utf8> empty{ make_ref<natFileStream>(TestFile, true, false), "\r\n"_nv };
+	NatCheck(empty.GetLineCount() == 0);
+}
+
+NatTestCase(LineIndexSidecar)
+{
+	const auto cleanup = make_scope(&RemoveTestFiles);
+	const auto lines = WriteTestFile(300, true);
+	{
+		natLineIndex<StringType::Utf8> index{ make_ref<natFileStream>(TestFile, true, false), "\r\n"_nv, false, SidecarFile };
+		NatCheck(CheckLines(index, lines));
+	}
+
+	natLineIndex<StringType::Utf8> loaded{ make_ref<natFileStream>(TestFile, true, false), "\r\n"_nv, true, SidecarFile };
+	NatCheck(CheckLines(loaded, lines));
+
+	// 大小相符但行起始位置超出文件的索引不应被接受
+	std::string sidecar;
+	{
+		std::ifstream file{ SidecarFile, std::ios::binary };
+		sidecar.assign(std::istreambuf_iterator<char>{ file }, {});
+	}
+	const auto offsetsBegin = sidecar.size() - lines.size() * sizeof(nLen);
+	const auto corrupt = [&](std::size_t line, nLen value)
+	{
+		auto corrupted = sidecar;
+		std::memcpy(&corrupted[offsetsBegin + line * sizeof(nLen)], &value, sizeof value);
+		std::ofstream file{ SidecarFile, std::ios::binary | std::ios::trunc };
+		file << corrupted;
+	};
+
+	for (auto&& [line, value] : { std::pair<std::size_t, nLen>{ 10, 1 << 30 }, { 10, 0 }, { 0, 3 }, { lines.size() - 1, 1 << 30 } })
+	{
+		corrupt(line, value);
+		auto stream = make_ref<natFileStream>(SidecarFile, true, false);
+		NatCheck(!loaded.Load(stream));
+		NatCheck(CheckLines(loaded, lines));
+
+		natLineIndex<StringType::Utf8> rebuilt{ make_ref<natFileStream>(TestFile, true, false), "\r\n"_nv, true, SidecarFile };
+		NatCheck(CheckLines(rebuilt, lines));
+	}
+}
+
+NatTestCase(LineIndexParallelForEachLine)
+{
+	const auto cleanup = make_scope(&RemoveTestFiles);
+	const auto lines = WriteTestFile(5000, false);
+	natThreadPool pool{ 4 };
+	for (auto useMapping : { false, true })
+	{
+		natLineIndex<StringType::Utf8> index{ make_ref<natFileStream>(TestFile, true, false), "\r\n"_nv, useMapping };
+		std::vector<nuInt> visited(lines.size());
+		std::atomic<nBool> mismatch{ false };
+		index.ParallelForEachLine(pool, [&](std::size_t i, nStrView const& line)
+		{
+			++visited[i];
+			if (line != nStrView{ lines[i].data(), lines[i].size() })
+			{
+				mismatch = true;
+			}
+		}, 64);
+		NatCheck(!mismatch);
+		NatCheck(std::all_of(visited.begin(), visited.end(), [](nuInt count) { return count == 1; }));
+	}
+}
+
+NatTestCase(LineIndexParallelForEachLineException)
+{
+	const auto cleanup = make_scope(&RemoveTestFiles);
+	WriteTestFile(5000, false);
+	natThreadPool pool{ 4 };
+	natLineIndex<StringType::Utf8> index{ make_ref<natFileStream>(TestFile, true, false), "\r\n"_nv, false };
+	std::atomic<nuInt> running{};
+	NatCheckThrows(index.ParallelForEachLine(pool, [&](std::size_t i, nStrView const&)
+	{
+		++running;
+		std::this_thread::sleep_for(std::chrono::microseconds{ 10 });
+		--running;
+		if (i == 100)
+		{
+			throw std::runtime_error{ "failed" };
+		}
+	}, 16));
+	// 返回时不应有仍在执行的任务
+	NatCheck(running == 0);
+}
+
+NatTestCase(ThreadPoolRunsAllWork)
+{
+	std::atomic<nuInt> finished{};
+	{
+		natThreadPool pool{ 2, 4 };
+		std::vector<std::future<natThreadPool::WorkToken>> works;
+		for (nuInt i = 0; i < 1000; ++i)
+		{
+			works.emplace_back(pool.QueueWork([&finished](void* param) -> nuInt
+			{
+				++finished;
+				return static_cast<nuInt>(reinterpret_cast<std::uintptr_t>(param));
+			}, reinterpret_cast<void*>(static_cast<std::uintptr_t>(i))));
+		}
+
+		for (nuInt i = 0; i < works.size(); ++i)
+		{
+			NatCheck(works[i].get().GetResult().get() == i);
+		}
+
+		// 析构时仍有排队的任务也不应挂起
+		for (nuInt i = 0; i < 100; ++i)
+		{
+			pool.QueueWork([&finished](void*) -> nuInt
+			{
+				++finished;
+				return 0;
+			});
+		}
+	}
+	NatCheck(finished >= 1000);
+}
@@ -0,0 +1,137 @@
+﻿#include "TestHarness.h"
+#include <natLinq.h>
+#include <natLinqStream.h>
+#include <natStream.h>
+#include <natStreamHelper.h>
+#include <string>
+#include <vector>
+
+using namespace NatsuLib;
+
+namespace
+{
+	std::vector<nInt> MakeSequence(nInt count)
+	{
+		std::vector<nInt> result;
+		for (nInt i = 0; i < count; ++i)
+		{
+			result.push_back(i);
+		}
+		return result;
+	}
+}
+
+NatTestCase(CommonIteratorChunkedSource)
+{
+	const auto values = MakeSequence(100);
+	const Linq<const nInt> linq = from(values);
+
+	// 分块预读的元素仍然引用原容器中的元素
+	std::size_t index{};
+	for (auto&& value : linq)
+	{
+		NatCheck(index < values.size());
+		NatCheck(&value == &values[index]);
+		++index;
+	}
+	NatCheck(index == values.size());
+
+	// 预读不影响按逻辑位置的比较，即使两个迭代器的块边界不同
+	const Linq<const nInt> skipped = from(values).skip(1);
+	auto first = linq.begin();
+	auto second = skipped.begin();
+	NatCheck(first != second);
+	++first;
+	NatCheck(first == second);
+	for (int i = 0; i < 40; ++i)
+	{
+		++first;
+		++second;
+	}
+	NatCheck(first == second);
+	NatCheck(*first == 41);
+
+	// 复制的迭代器独立前进
+	auto copy = first;
+	++copy;
+	NatCheck(*copy == 42 && *first == 41);
+	NatCheck(copy != first);
+	++first;
+	NatCheck(copy == first);
+
+	NatCheck(linq.begin() != linq.end());
+	const Linq<const nInt> empty = from(std::vector<nInt>{});
+	NatCheck(empty.begin() == empty.end());
+}
+
+NatTestCase(CommonIteratorIsLazy)
+{
+	const auto values = MakeSequence(100);
+	std::size_t evaluated{};
+	const Linq<Valued<nInt>> linq = from(values).select([&evaluated](nInt i)
+	{
+		++evaluated;
+		return i * 2;
+	});
+
+	NatCheck(linq.take(3).Cast<std::vector<nInt>>() == (std::vector<nInt>{ 0, 2, 4 }));
+	NatCheck(evaluated == 3);
+
+	evaluated = 0;
+	NatCheck(linq.first() == 0);
+	NatCheck(evaluated == 1);
+
+	// 不可预读的迭代器同样按位置比较
+	auto it = linq.begin();
+	auto other = linq.begin();
+	NatCheck(it == other);
+	++it;
+	NatCheck(it != other);
+	++other;
+	NatCheck(it == other);
+}
+
+NatTestCase(CommonIteratorMemoizeSource)
+{
+	const auto values = MakeSequence(200);
+	const Linq<const nInt> linq = from(values).select([](nInt i) { return i + 1; }).memoize();
+
+	// memoize 的缓存在迭代时增长，元素的引用不能跨过前进保存
+	std::vector<nInt> result;
+	for (auto&& value : linq)
+	{
+		result.push_back(value);
+	}
+	NatCheck(result.size() == values.size());
+	for (std::size_t i = 0; i < result.size(); ++i)
+	{
+		NatCheck(result[i] == values[i] + 1);
+	}
+
+	NatCheck(linq.Cast<std::vector<nInt>>() == result);
+}
+
+NatTestCase(CommonIteratorPullSource)
+{
+	std::string content;
+	std::vector<std::string> lines;
+	for (int i = 0; i < 100; ++i)
+	{
+		lines.push_back(std::string(i % 13, 'x') + std::to_string(i));
+		content += lines.back() + "\n";
+	}
+
+	natStreamReader<StringType::Utf8> reader{ make_ref<natMemoryStream>(reinterpret_cast<ncData>(content.data()), content.size(), true, false, false) };
+	reader.SetNewLine("\n"_nv);
+	const Linq<const nString> linq = from_lines(reader);
+
+	// 当前行在前进时被覆盖，只有逐个读取才能得到正确的结果
+	std::size_t count{};
+	for (auto&& line : linq)
+	{
+		NatCheck(count < lines.size());
+		NatCheck(line == nStrView{ lines[count].data(), lines[count].size() });
+		++count;
+	}
+	NatCheck(count == lines.size());
+}
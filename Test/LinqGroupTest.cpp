@@ -0,0 +1,170 @@
+﻿#include "TestHarness.h"
+#include <natLinq.h>
+#include <map>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace NatsuLib;
+
+namespace
+{
+	std::vector<nInt> MakeRandomValues(std::size_t count, nInt range)
+	{
+		std::mt19937 random{ 233 };
+		std::vector<nInt> values(count);
+		for (auto& value : values)
+		{
+			value = static_cast<nInt>(random() % range);
+		}
+		return values;
+	}
+
+	template <typename T>
+	std::vector<T> ToVector(Linq<const T> const& linq)
+	{
+		return linq.template Cast<std::vector<T>>();
+	}
+}
+
+NatTestCase(LinqDistinct)
+{
+	const auto values = MakeRandomValues(5000, 300);
+	std::vector<nInt> expected;
+	for (auto value : values)
+	{
+		if (std::find(expected.begin(), expected.end(), value) == expected.end())
+		{
+			expected.push_back(value);
+		}
+	}
+
+	NatCheck(from(values).distinct().Cast<std::vector<nInt>>() == expected);
+
+	std::sort(expected.begin(), expected.end());
+	NatCheck(from(values).distinct_ordered().Cast<std::vector<nInt>>() == expected);
+	NatCheck(from_empty<nInt>().distinct().count() == 0);
+}
+
+NatTestCase(LinqGroupBy)
+{
+	const auto values = MakeRandomValues(5000, 1000);
+	const auto keySelector = [](nInt i) { return i % 37; };
+
+	std::vector<nInt> keyOrder;
+	std::map<nInt, std::vector<nInt>> expected;
+	for (auto value : values)
+	{
+		auto& group = expected[value % 37];
+		if (group.empty())
+		{
+			keyOrder.push_back(value % 37);
+		}
+		group.push_back(value);
+	}
+
+	std::vector<nInt> keys;
+	for (auto&& group : from(values).group_by(decltype(keySelector){ keySelector }))
+	{
+		keys.push_back(group.first);
+		NatCheck(ToVector(group.second) == expected[group.first]);
+	}
+	NatCheck(keys == keyOrder);
+
+	keys.clear();
+	for (auto&& group : from(values).group_by_ordered(decltype(keySelector){ keySelector }))
+	{
+		keys.push_back(group.first);
+		NatCheck(ToVector(group.second) == expected[group.first]);
+	}
+	NatCheck(std::is_sorted(keys.begin(), keys.end()) && keys.size() == expected.size());
+}
+
+NatTestCase(LinqGroupByStringKey)
+{
+	const std::vector<nString> words{ "apple"_nv, "avocado"_nv, "banana"_nv, "blueberry"_nv, "cherry"_nv, "apricot"_nv };
+	std::vector<std::pair<nString, std::size_t>> result;
+	for (auto&& group : from(words).group_by([](nString const& word) { return nString{ word.GetView().Slice(0, 1) }; }))
+	{
+		result.emplace_back(group.first, group.second.count());
+	}
+	NatCheck(result.size() == 3);
+	NatCheck(result[0].first == "a"_nv && result[0].second == 3);
+	NatCheck(result[1].first == "b"_nv && result[1].second == 2);
+	NatCheck(result[2].first == "c"_nv && result[2].second == 1);
+}
+
+NatTestCase(LinqJoin)
+{
+	const auto outer = MakeRandomValues(500, 100);
+	const auto inner = MakeRandomValues(300, 150);
+	const auto key = [](nInt i) { return i % 50; };
+
+	std::vector<std::tuple<nInt, nInt, nInt>> expected;
+	for (auto o : outer)
+	{
+		for (auto i : inner)
+		{
+			if (key(o) == key(i))
+			{
+				expected.emplace_back(key(o), o, i);
+			}
+		}
+	}
+
+	std::vector<std::tuple<nInt, nInt, nInt>> joined;
+	for (auto&& item : from(outer).join(from(inner), decltype(key){ key }, decltype(key){ key }))
+	{
+		joined.emplace_back(std::get<0>(item), std::get<1>(item), std::get<2>(item));
+	}
+	NatCheck(joined == expected);
+
+	std::size_t groupJoined{};
+	for (auto&& item : from(outer).group_join(from(inner), decltype(key){ key }, decltype(key){ key }))
+	{
+		const auto count = static_cast<std::size_t>(std::count_if(inner.begin(), inner.end(), [&](nInt i) { return key(i) == std::get<0>(item); }));
+		NatCheck(std::get<2>(item).count() == count);
+		++groupJoined;
+	}
+	NatCheck(groupJoined == outer.size());
+
+	std::size_t fullJoinedKeys{};
+	for (auto&& item : from(outer).full_join(from(inner), decltype(key){ key }, decltype(key){ key }))
+	{
+		NatCheck(std::get<1>(item).count() + std::get<2>(item).count() > 0);
+		++fullJoinedKeys;
+	}
+	NatCheck(fullJoinedKeys == 50);
+}
+
+NatTestCase(LinqStorageOwnership)
+{
+	// 组及 from_container 的结果持有存储，原 LinqEnumerable 销毁后仍可遍历
+	std::vector<std::pair<nInt, Linq<const nInt>>> groups;
+	{
+		const auto values = MakeRandomValues(1000, 100);
+		for (auto&& group : from(values).group_by([](nInt i) { return i % 3; }))
+		{
+			groups.emplace_back(group);
+		}
+	}
+	NatCheck(groups.size() == 3);
+	std::size_t total{};
+	for (auto&& group : groups)
+	{
+		for (auto value : group.second)
+		{
+			NatCheck(value % 3 == group.first);
+			++total;
+		}
+	}
+	NatCheck(total == 1000);
+
+	Optional<Linq<const nInt>> copy;
+	{
+		const auto owned = from_container(std::vector<nInt>{ 1, 2, 3 });
+		copy.emplace(owned);
+	}
+	NatCheck(copy->Cast<std::vector<nInt>>() == (std::vector<nInt>{ 1, 2, 3 }));
+}
@@ -0,0 +1,173 @@
+﻿#include "TestHarness.h"
+#include <natLinq.h>
+#include <natLinqIncremental.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace NatsuLib;
+
+NatTestCase(LinqMemoize)
+{
+	std::vector<nInt> values(1000);
+	for (std::size_t i = 0; i < values.size(); ++i)
+	{
+		values[i] = static_cast<nInt>(i);
+	}
+
+	std::size_t evaluated{};
+	const auto memoized = from(values).select([&evaluated](nInt i)
+	{
+		++evaluated;
+		return i * 3;
+	}).memoize();
+
+	// 只求值被访问到的元素，并且每个元素只求值一次
+	NatCheck(memoized.take(10).count() == 10);
+	NatCheck(evaluated == 10);
+	NatCheck(memoized.first() == 0);
+	NatCheck(evaluated == 10);
+
+	const auto all = memoized.Cast<std::vector<nInt>>();
+	NatCheck(all.size() == values.size() && all.back() == 2997);
+	NatCheck(evaluated == values.size());
+	NatCheck(memoized.Cast<std::vector<nInt>>() == all);
+	NatCheck(evaluated == values.size());
+}
+
+NatTestCase(LinqMemoizeConcurrent)
+{
+	std::vector<nInt> values(20000);
+	for (std::size_t i = 0; i < values.size(); ++i)
+	{
+		values[i] = static_cast<nInt>(i);
+	}
+
+	std::atomic<std::size_t> evaluated{};
+	const auto memoized = from(values).select([&evaluated](nInt i)
+	{
+		evaluated.fetch_add(1, std::memory_order_relaxed);
+		return i + 1;
+	}).memoize();
+
+	// 多个线程同时遍历同一个缓存，缓存在遍历过程中增长
+	std::vector<std::vector<nInt>> results(4);
+	std::vector<std::thread> threads;
+	for (auto& result : results)
+	{
+		threads.emplace_back([&memoized, &result]
+		{
+			for (auto value : memoized)
+			{
+				result.push_back(value);
+			}
+		});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	NatCheck(evaluated == values.size());
+	for (auto const& result : results)
+	{
+		NatCheck(result.size() == values.size());
+		NatCheck(result.front() == 1 && result.back() == static_cast<nInt>(values.size()));
+		NatCheck(std::is_sorted(result.begin(), result.end()));
+	}
+}
+
+NatTestCase(IncrementalLinqRandomEdits)
+{
+	auto view = make_incremental<nInt>().where([](nInt i) { return i % 3 != 0; }).select([](nInt i) { return i * 2; });
+	NatCheckThrows(make_incremental<nInt>().where([](nInt) { return true; }).select([](nInt i) { return i; }).erase(0));
+
+	std::mt19937 random{ 38 };
+	std::map<std::size_t, nInt> model;
+	for (int step = 0; step < 5000; ++step)
+	{
+		if (model.empty() || random() % 3)
+		{
+			const auto value = static_cast<nInt>(random() % 1000);
+			const auto handle = view.insert(value);
+			NatCheck(!model.count(handle));
+			model.emplace(handle, value);
+			const auto pResult = view.get(handle);
+			NatCheck(value % 3 ? pResult && *pResult == value * 2 : !pResult);
+		}
+		else
+		{
+			auto iter = model.begin();
+			std::advance(iter, random() % model.size());
+			view.erase(iter->first);
+			NatCheck(!view.contains(iter->first));
+			model.erase(iter);
+		}
+	}
+
+	std::vector<nInt> expected;
+	for (auto&& item : model)
+	{
+		if (item.second % 3)
+		{
+			expected.push_back(item.second * 2);
+		}
+	}
+	auto results = view.results().Cast<std::vector<nInt>>();
+	std::sort(expected.begin(), expected.end());
+	std::sort(results.begin(), results.end());
+	NatCheck(results == expected);
+	NatCheck(view.size() == expected.size());
+
+	// 已插入元素后不能再添加阶段
+	NatCheckThrows(view.where([](nInt) { return true; }));
+	view.clear();
+	NatCheck(view.empty() && view.results().count() == 0);
+}
+
+NatTestCase(IncrementalGroupBy)
+{
+	auto groups = make_incremental<nInt>().where([](nInt i) { return i >= 0; }).group_by([](nInt i) { return i % 10; });
+
+	std::mt19937 random{ 380 };
+	std::vector<std::pair<std::size_t, nInt>> inserted;
+	for (int i = 0; i < 2000; ++i)
+	{
+		const auto value = static_cast<nInt>(random() % 1000) - 100;
+		inserted.emplace_back(groups.insert(value), value);
+	}
+	for (std::size_t i = 0; i < inserted.size(); i += 3)
+	{
+		groups.erase(inserted[i].first);
+	}
+
+	std::map<nInt, std::vector<nInt>> expected;
+	for (std::size_t i = 0; i < inserted.size(); ++i)
+	{
+		if (i % 3 && inserted[i].second >= 0)
+		{
+			expected[inserted[i].second % 10].push_back(inserted[i].second);
+		}
+	}
+
+	NatCheck(groups.group_count() == expected.size());
+	for (auto&& group : expected)
+	{
+		NatCheck(groups.count(group.first) == group.second.size());
+		auto values = groups.group(group.first).Cast<std::vector<nInt>>();
+		std::sort(values.begin(), values.end());
+		std::sort(group.second.begin(), group.second.end());
+		NatCheck(values == group.second);
+	}
+
+	auto keys = groups.keys().Cast<std::vector<nInt>>();
+	std::sort(keys.begin(), keys.end());
+	NatCheck(keys.size() == expected.size() && keys.front() == expected.begin()->first);
+
+	// 不存在的组为空
+	NatCheck(groups.count(42) == 0);
+	NatCheck(groups.group(42).count() == 0);
+}
@@ -0,0 +1,122 @@
+﻿#include "TestHarness.h"
+#include <natLinq.h>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace NatsuLib;
+
+namespace
+{
+	struct Record
+	{
+		nInt Group;
+		nLong Value;
+		nString Name;
+		std::size_t Index;
+
+		nBool operator==(Record const& other) const noexcept
+		{
+			return Index == other.Index;
+		}
+	};
+
+	std::vector<Record> MakeRecords(std::size_t count)
+	{
+		std::mt19937 random{ 42 };
+		std::vector<Record> records;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			records.push_back({ static_cast<nInt>(random() % 20) - 10, static_cast<nLong>(random() % 1000) - 500, natUtil::FormatString("{0}"_nv, random() % 50), i });
+		}
+		return records;
+	}
+}
+
+NatTestCase(LinqOrderByIntegerKeys)
+{
+	const auto records = MakeRecords(3000);
+	auto expected = records;
+	std::stable_sort(expected.begin(), expected.end(), [](Record const& a, Record const& b)
+	{
+		return std::make_tuple(a.Group, -a.Value) < std::make_tuple(b.Group, -b.Value);
+	});
+
+	const auto result = from(records)
+		.order_by([](Record const& r) { return r.Group; })
+		.then_order_by_descending([](Record const& r) { return r.Value; })
+		.Cast<std::vector<Record>>();
+	NatCheck(result == expected);
+
+	std::vector<nInt> negatives{ 3, -1, std::numeric_limits<nInt>::min(), 0, std::numeric_limits<nInt>::max(), -7 };
+	auto sortedNegatives = negatives;
+	std::sort(sortedNegatives.begin(), sortedNegatives.end());
+	NatCheck(from(negatives).order_by([](nInt i) { return i; }).Cast<std::vector<nInt>>() == sortedNegatives);
+	std::reverse(sortedNegatives.begin(), sortedNegatives.end());
+	NatCheck(from(negatives).order_by_descending([](nInt i) { return i; }).Cast<std::vector<nInt>>() == sortedNegatives);
+}
+
+NatTestCase(LinqOrderByIsStable)
+{
+	const auto records = MakeRecords(3000);
+	auto expected = records;
+	std::stable_sort(expected.begin(), expected.end(), [](Record const& a, Record const& b)
+	{
+		return a.Name < b.Name;
+	});
+
+	// 非整数的键使用比较排序，键相同的元素保持原有的顺序
+	const auto result = from(records).order_by([](Record const& r) { return r.Name; }).Cast<std::vector<Record>>();
+	NatCheck(result == expected);
+
+	std::stable_sort(expected.begin(), expected.end(), [](Record const& a, Record const& b)
+	{
+		return std::make_tuple(b.Name, a.Group) < std::make_tuple(a.Name, b.Group);
+	});
+	NatCheck(from(records)
+		.order_by_descending([](Record const& r) { return r.Name; })
+		.then_order_by([](Record const& r) { return r.Group; })
+		.Cast<std::vector<Record>>() == expected);
+}
+
+NatTestCase(LinqOrderByRandomAccess)
+{
+	const std::vector<nInt> values{ 5, 3, 9, 1, 7 };
+	const auto sorted = from(values).order_by([](nInt i) { return i; });
+	NatCheck(sorted.count() == 5);
+	NatCheck(sorted.element_at(2) == 5);
+	NatCheck(sorted.reverse().first() == 9);
+	NatCheck(sorted.skip(3).Cast<std::vector<nInt>>() == (std::vector<nInt>{ 7, 9 }));
+	NatCheck(from_empty<nInt>().order_by([](nInt i) { return i; }).count() == 0);
+}
+
+NatTestCase(LinqOrderByConcurrentFirstAccess)
+{
+	const auto records = MakeRecords(20000);
+	for (int round = 0; round < 10; ++round)
+	{
+		// 所有线程共享同一个尚未排序的状态
+		const auto sorted = from(records).order_by([](Record const& r) { return r.Name; });
+		std::vector<std::vector<Record>> results(4);
+		std::vector<std::thread> threads;
+		for (auto& result : results)
+		{
+			threads.emplace_back([&sorted, &result]
+			{
+				result = sorted.Cast<std::vector<Record>>();
+			});
+		}
+		for (auto&& thread : threads)
+		{
+			thread.join();
+		}
+
+		for (auto&& result : results)
+		{
+			NatCheck(result.size() == records.size());
+			NatCheck(result == results.front());
+		}
+	}
+}
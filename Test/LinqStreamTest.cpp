@@ -0,0 +1,149 @@
+﻿#include "TestHarness.h"
+#include <natLinq.h>
+#include <natLinqStream.h>
+#include <natStream.h>
+#include <natStreamHelper.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace NatsuLib;
+
+namespace
+{
+	struct Item
+	{
+		nInt Key;
+		nInt Index;
+	};
+
+	natRefPointer<natMemoryStream> MakeStream(const void* data, std::size_t size)
+	{
+		return make_ref<natMemoryStream>(static_cast<ncData>(data), size, true, false, false);
+	}
+
+	std::vector<Item> MakeItems(std::size_t count)
+	{
+		std::mt19937 random{ 37 };
+		std::vector<Item> items;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			items.push_back({ static_cast<nInt>(random() % 100), static_cast<nInt>(i) });
+		}
+		return items;
+	}
+}
+
+NatTestCase(LinqFromStream)
+{
+	std::vector<nInt> values(5000);
+	for (std::size_t i = 0; i < values.size(); ++i)
+	{
+		values[i] = static_cast<nInt>(i * 7);
+	}
+
+	const auto pStream = MakeStream(values.data(), values.size() * sizeof(nInt));
+	const auto linq = from_stream<nInt>(pStream, {}, 100);
+	NatCheck(linq.Cast<std::vector<nInt>>() == values);
+	// 可以查找的流在再次遍历时回到起始位置
+	NatCheck(linq.where([](nInt i) { return i % 2 == 0; }).count() == 2500);
+
+	// take 在得到结果后停止读取，最多多读一块
+	pStream->SetPosition(NatSeek::Beg, 0);
+	const auto first = from_stream<nInt>(pStream, {}, 100).take(3).Cast<std::vector<nInt>>();
+	NatCheck(first == (std::vector<nInt>{ 0, 7, 14 }));
+	NatCheck(pStream->GetPosition() <= 100 * sizeof(nInt));
+
+	// 不完整的记录被视为错误
+	const auto pTruncated = MakeStream(values.data(), 10 * sizeof(nInt) + 1);
+	NatCheckThrows(from_stream<nInt>(pTruncated).count());
+
+	NatCheckThrows(from_stream<nInt>(nullptr));
+}
+
+NatTestCase(LinqFromStreamDecoder)
+{
+	// 每条记录为长度及对应数量的字节
+	std::string content;
+	std::vector<std::string> expected;
+	for (int i = 0; i < 300; ++i)
+	{
+		expected.push_back(std::string(i % 17, static_cast<char>('a' + i % 26)));
+		content += static_cast<char>(expected.back().size());
+		content += expected.back();
+	}
+
+	const auto decoder = [](natStream& stream, std::string& record)
+	{
+		nByte length;
+		if (stream.ReadBytes(&length, 1) != 1)
+		{
+			return false;
+		}
+		record.resize(length);
+		return !length || stream.ReadBytes(reinterpret_cast<nData>(&record[0]), length) == length;
+	};
+
+	const auto result = from_stream<std::string>(MakeStream(content.data(), content.size()), decoder, 16).Cast<std::vector<std::string>>();
+	NatCheck(result == expected);
+}
+
+NatTestCase(LinqFromLines)
+{
+	std::string content;
+	for (int i = 0; i < 500; ++i)
+	{
+		content += std::to_string(i) + "\n";
+	}
+
+	natStreamReader<StringType::Utf8> reader{ MakeStream(content.data(), content.size()) };
+	reader.SetNewLine("\n"_nv);
+	const auto lines = from_lines(reader).select([](nString const& line) { return std::stoi(std::string(line.data(), line.size())); }).Cast<std::vector<nInt>>();
+	NatCheck(lines.size() == 500);
+	for (std::size_t i = 0; i < lines.size(); ++i)
+	{
+		NatCheck(lines[i] == static_cast<nInt>(i));
+	}
+
+	const auto pReader = make_ref<natStreamReader<StringType::Utf8>>(MakeStream(content.data(), content.size()));
+	pReader->SetNewLine("\n"_nv);
+	NatCheck(from_lines(pReader).where([](nString const& line) { return line.size() == 3; }).count() == 400);
+	NatCheckThrows(from_lines(natRefPointer<natStreamReader<StringType::Utf8>>{}));
+}
+
+NatTestCase(LinqOrderByExternal)
+{
+	const auto items = MakeItems(20000);
+	auto expected = items;
+	std::stable_sort(expected.begin(), expected.end(), [](Item const& a, Item const& b) { return a.Key < b.Key; });
+
+	const auto keyOf = [](Item const& item) { return item.Key; };
+	const auto isSame = [](std::vector<Item> const& a, std::vector<Item> const& b)
+	{
+		return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](Item const& x, Item const& y) { return x.Key == y.Key && x.Index == y.Index; });
+	};
+
+	// 较小的预算使排序溢出为多个分段，较大的预算则在内存中完成
+	for (const std::size_t budget : { std::size_t{ 4096 }, std::size_t{ 1 } << 24 })
+	{
+		const auto sorted = from(items).order_by_external(decltype(keyOf){ keyOf }, budget);
+		NatCheck(isSame(sorted.Cast<std::vector<Item>>(), expected));
+		// 再次遍历时重新归并
+		NatCheck(isSame(sorted.Cast<std::vector<Item>>(), expected));
+		NatCheck(sorted.take(5).count() == 5);
+
+		auto descending = expected;
+		std::stable_sort(descending.begin(), descending.end(), [](Item const& a, Item const& b) { return a.Key > b.Key; });
+		NatCheck(isSame(from(items).order_by_descending_external(decltype(keyOf){ keyOf }, budget).Cast<std::vector<Item>>(), descending));
+	}
+
+	std::vector<nString> words;
+	for (const auto& item : MakeItems(2000))
+	{
+		words.emplace_back(natUtil::FormatString("w{0}"_nv, item.Key * 31 % 1000));
+	}
+	auto sortedWords = words;
+	std::stable_sort(sortedWords.begin(), sortedWords.end());
+	NatCheck(from(words).order_by_external([](nString const& word) { return word; }, 1024).Cast<std::vector<nString>>() == sortedWords);
+}
@@ -0,0 +1,160 @@
+﻿#include "TestHarness.h"
+#include <natLogBackend.h>
+#include <natLog.h>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace NatsuLib;
+
+namespace
+{
+	nString FormatNothing(const nByte*)
+	{
+		return {};
+	}
+
+	// 读取内存流中的全部内容并按行分割，去掉时间及日志类型的前缀
+	std::vector<std::string> ReadMessages(natRefPointer<natMemoryStream> const& stream, natLog::LogType logType)
+	{
+		const auto typeName = natLog::GetDefaultLogTypeName(logType);
+		const auto typePrefix = "[" + std::string(typeName.begin(), typeName.end()) + "] ";
+		const std::string content(reinterpret_cast<const char*>(stream->GetInternalBuffer()), static_cast<std::size_t>(stream->GetSize()));
+		std::vector<std::string> messages;
+		std::size_t begin = 0, end;
+		while ((end = content.find('\n', begin)) != std::string::npos)
+		{
+			const auto line = content.substr(begin, end - begin);
+			const auto prefix = line.find(typePrefix);
+			messages.push_back(prefix == std::string::npos ? line : line.substr(prefix + typePrefix.size()));
+			begin = end + 1;
+		}
+		return messages;
+	}
+}
+
+NatTestCase(LogRingBufferWrapAround)
+{
+	typedef detail_::LogRecordHeader Header;
+	constexpr std::size_t Capacity = 512;
+	detail_::LogRingBuffer buffer{ Capacity };
+
+	// 记录头部之后保存序号，依据写入位置模拟回绕，确认两种填充方式都出现过
+	std::size_t head = 0, implicitSkips = 0, explicitSkips = 0;
+	nuInt written = 0, read = 0;
+	for (nuInt round = 0; round < 200; ++round)
+	{
+		const auto size = sizeof(Header) + 8 * (round % 11 + 1);
+		const auto remaining = Capacity - (head & (Capacity - 1));
+		if (remaining < size)
+		{
+			++(remaining < sizeof(Header) ? implicitSkips : explicitSkips);
+			head += remaining;
+		}
+		head += size;
+
+		const auto record = buffer.Reserve(size);
+		NatCheck(record != nullptr);
+		const auto header = ::new(static_cast<void*>(record)) Header;
+		header->Size = size;
+		header->Format = &FormatNothing;
+		header->LogType = written++;
+		std::memset(record + sizeof(Header), static_cast<int>(header->LogType & 0xFF), size - sizeof(Header));
+		buffer.Commit(size);
+
+		// 每写入两条读取一次，使缓冲区中保留未读取的记录
+		if (round % 2)
+		{
+			buffer.Consume([&](Header const& h, const nByte* payload)
+			{
+				NatCheck(h.LogType == read);
+				for (std::size_t i = 0; i < h.Size - sizeof(Header); ++i)
+				{
+					NatCheck(payload[i] == static_cast<nByte>(read & 0xFF));
+				}
+				++read;
+			});
+		}
+	}
+	NatCheck(buffer.IsEmpty() && read == written);
+	NatCheck(implicitSkips > 0 && explicitSkips > 0);
+
+	// 未读取时缓冲区已满则预留失败，读取后恢复
+	nuInt reserved = 0;
+	while (const auto record = buffer.Reserve(64))
+	{
+		const auto header = ::new(static_cast<void*>(record)) Header;
+		header->Size = 64;
+		header->Format = &FormatNothing;
+		header->LogType = reserved++;
+		buffer.Commit(64);
+	}
+	NatCheck(reserved > 0 && reserved <= Capacity / 64);
+	NatCheck(buffer.Consume([](Header const&, const nByte*) {}) == reserved);
+	NatCheck(buffer.Reserve(64) != nullptr);
+}
+
+NatTestCase(AsyncLogBackendWritesExactLines)
+{
+	constexpr nuInt LinesPerThread = 500;
+	const auto stream = make_ref<natMemoryStream>(0, true, true, true);
+	// 远大于缓冲区一半，在记录日志的线程中格式化
+	const std::string oversized(3000, 'o');
+
+	{
+		// 最小的缓冲区，使记录多次回绕
+		natAsyncLogBackend backend{ 0 };
+		backend.AddSink(make_ref<natStreamLogSink>(stream));
+
+		const auto job = [&backend, &oversized](nuInt thread)
+		{
+			for (nuInt i = 0; i < LinesPerThread; ++i)
+			{
+				backend.Record(natLog::Msg, "thread {0} line {1} {2}"_nv, thread, i, i % 3 ? "short"_nv : "a somewhat longer string argument"_nv);
+				if (i == LinesPerThread / 2)
+				{
+					backend.Record(natLog::Msg, "thread {0} oversized {1}"_nv, thread, nStrView{ oversized.data(), oversized.size() });
+				}
+			}
+		};
+
+		std::thread first{ job, 0u }, second{ job, 1u };
+		first.join();
+		second.join();
+		backend.Flush();
+
+		const auto messages = ReadMessages(stream, natLog::Msg);
+		NatCheck(messages.size() == 2 * (LinesPerThread + 1));
+
+		// 同一线程的日志保持顺序，不同线程之间可以交错
+		for (nuInt thread = 0; thread < 2; ++thread)
+		{
+			std::vector<std::string> expected, actual;
+			for (nuInt i = 0; i < LinesPerThread; ++i)
+			{
+				expected.push_back("thread " + std::to_string(thread) + " line " + std::to_string(i) + (i % 3 ? " short" : " a somewhat longer string argument"));
+				if (i == LinesPerThread / 2)
+				{
+					expected.push_back("thread " + std::to_string(thread) + " oversized " + oversized);
+				}
+			}
+
+			const auto threadPrefix = "thread " + std::to_string(thread) + " ";
+			for (auto&& message : messages)
+			{
+				if (message.compare(0, threadPrefix.size(), threadPrefix) == 0)
+				{
+					actual.push_back(message);
+				}
+			}
+			NatCheck(actual == expected);
+		}
+
+		// 之后记录的日志在析构时写入
+		backend.Record(natLog::Warn, "last {0}"_nv, 1.5);
+	}
+
+	const auto messages = ReadMessages(stream, natLog::Warn);
+	NatCheck(messages.back() == "last 1.5");
+}
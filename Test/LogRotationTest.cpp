@@ -0,0 +1,227 @@
+﻿#include "TestHarness.h"
+#include <natLogBackend.h>
+#include <natCompression.h>
+#include <natUtil.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace NatsuLib;
+
+namespace
+{
+	void WriteFile(std::filesystem::path const& path, std::size_t size)
+	{
+		std::ofstream{ path, std::ios::binary } << std::string(size, 'x');
+	}
+
+	std::string ReadFile(std::filesystem::path const& path)
+	{
+		std::ostringstream content;
+		content << std::ifstream{ path, std::ios::binary }.rdbuf();
+		return content.str();
+	}
+
+	// 获得目录中除当前文件外的全部轮换出的文件
+	std::vector<std::filesystem::path> GetSegments(std::filesystem::path const& directory)
+	{
+		std::vector<std::filesystem::path> segments;
+		for (auto const& entry : std::filesystem::directory_iterator{ directory })
+		{
+			const auto name = entry.path().filename().u8string();
+			if (name != "Sink.log" && name.compare(0, 5, "Sink.") == 0)
+			{
+				segments.push_back(entry.path());
+			}
+		}
+		return segments;
+	}
+
+	std::size_t CountLines(std::string const& content)
+	{
+		return static_cast<std::size_t>(std::count(content.begin(), content.end(), '\n'));
+	}
+
+	std::filesystem::path CreateTestDirectory()
+	{
+		const auto directory = std::filesystem::temp_directory_path() / "natLogRotationTest";
+		std::filesystem::remove_all(directory);
+		std::filesystem::create_directories(directory);
+		return directory;
+	}
+
+	natRefPointer<natRotatingFileLogSink> CreateSink(std::filesystem::path const& directory, RotatingFileLogOptions const& options)
+	{
+		const auto path = (directory / "Sink.log").u8string();
+		return make_ref<natRotatingFileLogSink>(nStrView{ path.data(), path.size() }, options);
+	}
+}
+
+NatTestCase(RotatingLogSizeRotation)
+{
+	const auto directory = CreateTestDirectory();
+
+	constexpr nLen MaxFileSize = 512;
+	constexpr std::size_t LineCount = 100;
+	std::size_t activeSize = 0;
+	{
+		RotatingFileLogOptions options;
+		options.MaxFileSize = MaxFileSize;
+		options.BufferSize = 128;
+		options.Compress = false;
+		const auto sink = CreateSink(directory, options);
+		for (std::size_t i = 0; i < LineCount; ++i)
+		{
+			const auto message = natUtil::FormatString("line {0}"_nv, i);
+			sink->Write(0, std::chrono::system_clock::now(), message);
+		}
+		sink->Flush();
+		activeSize = static_cast<std::size_t>(std::filesystem::file_size(directory / "Sink.log"));
+	}
+
+	const auto segments = GetSegments(directory);
+	NatCheck(segments.size() >= 5);
+
+	// 每个轮换出的文件都在达到上限的那一行之后轮换，不会超过上限加一行
+	std::size_t lines = CountLines(ReadFile(directory / "Sink.log"));
+	for (auto const& segment : segments)
+	{
+		NatCheck(segment.extension() == ".log");
+		const auto content = ReadFile(segment);
+		NatCheck(content.size() >= MaxFileSize);
+		NatCheck(content.size() < MaxFileSize + 64);
+		lines += CountLines(content);
+	}
+	NatCheck(lines == LineCount);
+	NatCheck(activeSize < MaxFileSize);
+
+	std::filesystem::remove_all(directory);
+}
+
+NatTestCase(RotatingLogIntervalRotation)
+{
+	const auto directory = CreateTestDirectory();
+
+	{
+		RotatingFileLogOptions options;
+		options.MaxFileSize = 0;
+		options.RotationInterval = std::chrono::seconds{ 60 };
+		options.Compress = false;
+		const auto sink = CreateSink(directory, options);
+		const auto now = std::chrono::system_clock::now();
+		sink->Write(0, now, "first"_nv);
+		sink->Write(0, now + std::chrono::seconds{ 1 }, "second"_nv);
+		sink->Flush();
+		NatCheck(GetSegments(directory).empty());
+
+		// 记录时间到达间隔后，写入该记录前轮换
+		sink->Write(0, now + std::chrono::seconds{ 61 }, "third"_nv);
+		sink->Flush();
+	}
+
+	const auto segments = GetSegments(directory);
+	NatCheck(segments.size() == 1);
+	if (segments.size() == 1)
+	{
+		const auto segment = ReadFile(segments.front());
+		NatCheck(CountLines(segment) == 2);
+		NatCheck(segment.find("first") != std::string::npos && segment.find("second") != std::string::npos);
+	}
+	const auto active = ReadFile(directory / "Sink.log");
+	NatCheck(CountLines(active) == 1);
+	NatCheck(active.find("third") != std::string::npos);
+
+	std::filesystem::remove_all(directory);
+}
+
+NatTestCase(RotatingLogCompressSegment)
+{
+	const auto directory = CreateTestDirectory();
+
+	std::string expected;
+	{
+		RotatingFileLogOptions options;
+		options.MaxFileSize = 0;
+		const auto sink = CreateSink(directory, options);
+		sink->Write(0, std::chrono::system_clock::now(), "compressed line"_nv);
+		sink->Flush();
+		expected = ReadFile(directory / "Sink.log");
+		sink->RequestRotation();
+		sink->Write(0, std::chrono::system_clock::now(), "active line"_nv);
+		sink->Flush();
+		// 析构时等待后台压缩结束
+	}
+
+	// 轮换出的文件被压缩为同名的 .zip 文件，原文件被删除
+	const auto segments = GetSegments(directory);
+	NatCheck(segments.size() == 1);
+	if (segments.size() == 1)
+	{
+		const auto& archivePath = segments.front();
+		NatCheck(archivePath.extension() == ".zip");
+		const auto segmentPath = std::filesystem::path{ archivePath }.replace_extension();
+		NatCheck(!std::filesystem::exists(segmentPath));
+
+		const auto archiveName = archivePath.u8string();
+		const auto entryName = segmentPath.filename().u8string();
+		std::string content(expected.size(), 0);
+		{
+			natZipArchive archive{ make_ref<natFileStream>(nStrView{ archiveName.data(), archiveName.size() }, true, false), natZipArchive::ZipArchiveMode::Read };
+			const auto entry = archive.GetEntry(nStrView{ entryName.data(), entryName.size() });
+			NatCheck(entry);
+			if (entry)
+			{
+				const auto stream = entry->Open();
+				content.resize(static_cast<std::size_t>(stream->ReadBytes(reinterpret_cast<nData>(&content[0]), content.size())));
+			}
+		}
+		NatCheck(content == expected);
+	}
+	NatCheck(ReadFile(directory / "Sink.log").find("active line") != std::string::npos);
+
+	std::filesystem::remove_all(directory);
+}
+
+NatTestCase(RotatingLogSizeLimitOnlyRemovesSegments)
+{
+	const auto directory = CreateTestDirectory();
+
+	// 名称相近但不是本输出目标轮换出的文件不应被删除
+	const char* const unrelated[] = {
+		"Sink.log.bak", "Sink.notes.log", "Sink.20200101-000000.x.log", "Sinker.20200101-000000.0.log", "Sink.20200101.0.log", "Sink.20200101-000000.0.txt",
+	};
+	for (auto name : unrelated)
+	{
+		WriteFile(directory / name, 4096);
+	}
+	const auto oldSegment = directory / "Sink.20200101-000000.0.log";
+	const auto oldArchive = directory / "Sink.20200101-000000.1.log.zip";
+	WriteFile(oldSegment, 4096);
+	WriteFile(oldArchive, 4096);
+
+	{
+		RotatingFileLogOptions options;
+		options.MaxFileSize = 0;
+		options.Compress = false;
+		options.MaxTotalSize = 1024;
+		const auto path = (directory / "Sink.log").u8string();
+		const auto sink = make_ref<natRotatingFileLogSink>(nStrView{ path.data(), path.size() }, options);
+		sink->Write(0, std::chrono::system_clock::now(), "before rotation"_nv);
+		sink->RequestRotation();
+		sink->Write(0, std::chrono::system_clock::now(), "after rotation"_nv);
+		sink->Flush();
+	}
+
+	for (auto name : unrelated)
+	{
+		NatCheck(std::filesystem::exists(directory / name));
+	}
+	NatCheck(!std::filesystem::exists(oldSegment));
+	NatCheck(!std::filesystem::exists(oldArchive));
+	NatCheck(std::filesystem::exists(directory / "Sink.log"));
+
+	std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,57 @@
+﻿#include "TestHarness.h"
+#include <natLog.h>
+#include <vector>
+
+using namespace NatsuLib;
+
+NatTestCase(LogTypeLevels)
+{
+	// 自定义的日志类型从 3 开始，不能与预置类型冲突
+	constexpr nuInt userType = 3;
+	NatCheck(natLog::GetLogLevel(natLog::Debug) == LogLevel::Debug);
+	NatCheck(natLog::GetLogLevel(natLog::Warn) == LogLevel::Warning);
+	NatCheck(natLog::GetLogLevel(userType) == LogLevel::Info);
+	NatCheck(natLog::GetDefaultLogTypeName(natLog::Debug) == "Debug"_nv);
+}
+
+NatTestCase(LogMacrosEvaluateOnce)
+{
+	natEventBus bus;
+	natLog logger{ bus };
+	std::vector<nuInt> types;
+	logger.RegisterLogUpdateEventFunc([&types](natEventBase& event)
+	{
+		types.push_back(static_cast<natLog::EventLogUpdated&>(event).GetLogType());
+	});
+
+	std::size_t loggerEvaluated{}, typeEvaluated{}, argEvaluated{};
+	const auto getLogger = [&]() -> natLog&
+	{
+		++loggerEvaluated;
+		return logger;
+	};
+	const auto getType = [&typeEvaluated](nuInt type)
+	{
+		++typeEvaluated;
+		return type;
+	};
+	const auto getArg = [&argEvaluated]
+	{
+		return ++argEvaluated;
+	};
+
+	nat_LogMsg(getLogger(), "{0}"_nv, getArg());
+	nat_LogWarn(getLogger(), "{0}"_nv, getArg());
+	nat_LogErr(getLogger(), "{0}"_nv, getArg());
+	nat_Log(getLogger(), getType(3), "{0}"_nv, getArg());
+	NatCheck(loggerEvaluated == 4 && typeEvaluated == 1 && argEvaluated == 4);
+	NatCheck(types == (std::vector<nuInt>{ natLog::Msg, natLog::Warn, natLog::Err, 3 }));
+
+	// 被阈值过滤时不对参数求值
+	logger.SetLevel(LogLevel::Error);
+	nat_LogDebug(getLogger(), "{0}"_nv, getArg());
+	nat_LogMsg(getLogger(), "{0}"_nv, getArg());
+	nat_Log(getLogger(), getType(natLog::Warn), "{0}"_nv, getArg());
+	NatCheck(argEvaluated == 4 && typeEvaluated == 2);
+	NatCheck(types.size() == 4);
+}
@@ -0,0 +1,73 @@
+﻿#include "TestHarness.h"
+#include <natParallelLinq.h>
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <vector>
+
+using namespace NatsuLib;
+
+namespace
+{
+	std::vector<nInt> MakeValues(std::size_t count)
+	{
+		std::vector<nInt> values(count);
+		std::iota(values.begin(), values.end(), -static_cast<nInt>(count / 2));
+		return values;
+	}
+}
+
+NatTestCase(ParallelLinqMatchesSequential)
+{
+	natThreadPool pool{ 4 };
+	const auto values = MakeValues(100000);
+	// 可调用对象以值的形式保存在迭代器中，因此需以右值传入
+	auto select = [](nInt i) { return static_cast<nLong>(i) * 3; };
+	auto where = [](nLong i) { return i % 7 != 0; };
+
+	const auto expected = from(values).select(std::move(select)).where(std::move(where)).Cast<std::vector<nLong>>();
+	for (std::size_t partitions : { 0, 1, 3, 16, 1000 })
+	{
+		const auto query = from(values).as_parallel(pool, partitions).select(decltype(select){ select }).where(decltype(where){ where });
+		NatCheck(query.as_ordered().to_vector() == expected);
+
+		auto unordered = query.as_unordered().to_vector();
+		std::sort(unordered.begin(), unordered.end());
+		NatCheck(unordered == expected);
+
+		NatCheck(query.count() == expected.size());
+		NatCheck(query.sum() == std::accumulate(expected.begin(), expected.end(), nLong{}));
+		NatCheck(query.max() == *std::max_element(expected.begin(), expected.end()));
+		NatCheck(query.min() == *std::min_element(expected.begin(), expected.end()));
+		NatCheck(query.aggregate(nLong{}, [](nLong acc, nLong i) { return acc + (i & 1); }, std::plus<nLong>{}) == std::count_if(expected.begin(), expected.end(), [](nLong i) { return i & 1; }));
+		NatCheck(query.any([](nLong i) { return i == 3; }));
+		NatCheck(!query.any([](nLong i) { return i == 21; }));
+		NatCheck(query.all(decltype(where){ where }));
+		NatCheck(query.as_ordered().as_sequential().Cast<std::vector<nLong>>() == expected);
+	}
+}
+
+NatTestCase(ParallelLinqEmptyAndErrors)
+{
+	natThreadPool pool{ 2 };
+	const std::vector<nInt> empty;
+	NatCheck(from(empty).as_parallel(pool).count() == 0);
+	NatCheck(!from(empty).as_parallel(pool).any());
+	NatCheckThrows(from(empty).as_parallel(pool).max());
+	NatCheckThrows(from(empty).as_parallel(pool).aggregate(std::plus<nInt>{}));
+
+	const auto values = MakeValues(10000);
+	NatCheckThrows(from(values).as_parallel(pool, 8).select([](nInt i)
+	{
+		if (i == 100)
+		{
+			throw std::runtime_error{ "failed" };
+		}
+		return i;
+	}).to_vector());
+
+	std::atomic<nLong> sum{};
+	from(values).as_parallel(pool).for_each([&sum](nInt i) { sum += i; });
+	NatCheck(sum == std::accumulate(values.begin(), values.end(), nLong{}));
+	NatCheck(from(values).as_parallel(pool).average() == from(values).average());
+}
@@ -0,0 +1,367 @@
+﻿#include "TestHarness.h"
+#include <natRefObj.h>
+#include <natArena.h>
+#include <natObjectPool.h>
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace NatsuLib;
+
+namespace
+{
+	// 统计存活及析构次数的引用计数对象，参数为负数时构造失败
+	class Tracked
+		: public natRefObjImpl<Tracked>
+	{
+	public:
+		static nInt s_Alive;
+		static nInt s_Destroyed;
+
+		explicit Tracked(nInt value)
+			: Value{ value }
+		{
+			if (value < 0)
+			{
+				throw std::runtime_error("construction failed");
+			}
+			++s_Alive;
+		}
+
+		~Tracked()
+		{
+			--s_Alive;
+			++s_Destroyed;
+		}
+
+		nInt Value;
+	};
+
+	nInt Tracked::s_Alive{};
+	nInt Tracked::s_Destroyed{};
+
+	// 大于对象池的槽位
+	class LargeTracked
+		: public Tracked
+	{
+	public:
+		explicit LargeTracked(nInt value)
+			: Tracked{ value }, Payload{}
+		{
+		}
+
+		nByte Payload[256];
+	};
+
+	// 对齐要求超过对象池的槽位
+	class alignas(64) AlignedTracked
+		: public Tracked
+	{
+	public:
+		explicit AlignedTracked(nInt value)
+			: Tracked{ value }
+		{
+		}
+	};
+
+	// 嵌套的 natRefObjImpl，各层共用同一个引用计数及弱引用的控制块
+	class NestedTracked
+		: public natRefObjImpl<NestedTracked, Tracked>
+	{
+	public:
+		explicit NestedTracked(nInt value)
+			: natRefObjImpl{ value }
+		{
+		}
+	};
+
+	class SingleThreaded
+		: public natRefObjImpl<SingleThreaded, natRefObj, RefCountPolicy::NonAtomic>
+	{
+	public:
+		static nInt s_Alive;
+
+		SingleThreaded()
+		{
+			++s_Alive;
+		}
+
+		~SingleThreaded()
+		{
+			--s_Alive;
+		}
+	};
+
+	nInt SingleThreaded::s_Alive{};
+
+	class NestedSingleThreaded
+		: public natRefObjImpl<NestedSingleThreaded, SingleThreaded, RefCountPolicy::NonAtomic>
+	{
+	};
+
+	// 记录最近一次分配及归还的分配器
+	class RecordingAllocator
+	{
+	public:
+		void* Allocate(std::size_t size, std::size_t alignment)
+		{
+			const auto memory = ::operator new(size, std::align_val_t{ alignment });
+			LastMemory = memory;
+			LastSize = size;
+			LastAlignment = alignment;
+			++LiveCount;
+			return memory;
+		}
+
+		void Deallocate(void* ptr, std::size_t size, std::size_t alignment) noexcept
+		{
+			// 归还时的参数必须与分配时一致
+			MismatchedDeallocation |= ptr != LastMemory || size != LastSize || alignment != LastAlignment;
+			--LiveCount;
+			::operator delete(ptr, std::align_val_t{ alignment });
+		}
+
+		void* LastMemory{};
+		std::size_t LastSize{};
+		std::size_t LastAlignment{};
+		nInt LiveCount{};
+		nBool MismatchedDeallocation{};
+	};
+
+	nBool IsAlignedTo(const void* ptr, std::size_t alignment)
+	{
+		return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+	}
+}
+
+NatTestCase(RefObjAllocateWithDeallocate)
+{
+	typedef detail_::AllocatedRefObjLayout<Tracked, true> Layout;
+	static_assert(detail_::HasDeallocate<RecordingAllocator>::value);
+	static_assert(Layout::HeaderSize >= sizeof(void*) && Layout::HeaderSize % alignof(Tracked) == 0);
+
+	const auto destroyed = Tracked::s_Destroyed;
+	RecordingAllocator allocator;
+	{
+		auto obj = allocate_ref<Tracked>(allocator, 5);
+		NatCheck(obj->Value == 5 && obj.GetRefCount() == 1);
+		NatCheck(Tracked::s_Alive == 1 && allocator.LiveCount == 1);
+
+		// 对象之前保存着指向分配器的指针
+		NatCheck(allocator.LastSize == Layout::Size && allocator.LastAlignment == Layout::Alignment);
+		NatCheck(reinterpret_cast<nByte*>(obj.Get()) == static_cast<nByte*>(allocator.LastMemory) + Layout::HeaderSize);
+		NatCheck(*static_cast<RecordingAllocator**>(allocator.LastMemory) == &allocator);
+
+		auto copy = obj;
+		obj = nullptr;
+		NatCheck(Tracked::s_Alive == 1 && allocator.LiveCount == 1);
+	}
+	NatCheck(Tracked::s_Alive == 0 && Tracked::s_Destroyed == destroyed + 1);
+	NatCheck(allocator.LiveCount == 0 && !allocator.MismatchedDeallocation);
+
+	// 构造失败时归还内存
+	NatCheckThrows(allocate_ref<Tracked>(allocator, -1));
+	NatCheck(Tracked::s_Alive == 0 && Tracked::s_Destroyed == destroyed + 1);
+	NatCheck(allocator.LiveCount == 0 && !allocator.MismatchedDeallocation);
+}
+
+NatTestCase(RefObjAllocateFromArena)
+{
+	static_assert(!detail_::HasDeallocate<natArena>::value);
+	static_assert(detail_::AllocatedRefObjLayout<Tracked, false>::HeaderSize == 0);
+
+	const auto destroyed = Tracked::s_Destroyed;
+	natArena arena;
+	{
+		std::vector<natRefPointer<Tracked>> objects;
+		for (nInt i = 0; i < 100; ++i)
+		{
+			objects.emplace_back(allocate_ref<Tracked>(arena, i));
+			NatCheck(IsAlignedTo(objects.back().Get(), alignof(Tracked)));
+		}
+		NatCheck(Tracked::s_Alive == 100);
+
+		for (nInt i = 0; i < 100; ++i)
+		{
+			NatCheck(objects[i]->Value == i);
+		}
+
+		// 仅调用析构函数，内存仍由 arena 持有
+		const auto allocatedSize = arena.GetAllocatedSize();
+		objects.clear();
+		NatCheck(Tracked::s_Alive == 0 && Tracked::s_Destroyed == destroyed + 100);
+		NatCheck(arena.GetAllocatedSize() == allocatedSize);
+	}
+
+	NatCheckThrows(allocate_ref<Tracked>(arena, -1));
+	NatCheck(Tracked::s_Alive == 0 && Tracked::s_Destroyed == destroyed + 100);
+}
+
+NatTestCase(RefObjObjectPool)
+{
+	const auto destroyed = Tracked::s_Destroyed;
+	natObjectPool<Tracked> pool{ 8 };
+	{
+		std::vector<natRefPointer<Tracked>> objects;
+		for (nInt i = 0; i < 20; ++i)
+		{
+			objects.emplace_back(pool.Create(i));
+		}
+		NatCheck(pool.GetLiveCount() == 20 && pool.GetReservedCount() == 24);
+		NatCheck(Tracked::s_Alive == 20);
+
+		// 归还的槽位会被复用
+		objects.erase(objects.begin(), objects.begin() + 10);
+		NatCheck(pool.GetLiveCount() == 10 && Tracked::s_Destroyed == destroyed + 10);
+		for (nInt i = 0; i < 10; ++i)
+		{
+			objects.emplace_back(pool.Create(i));
+		}
+		NatCheck(pool.GetLiveCount() == 20 && pool.GetReservedCount() == 24);
+
+		NatCheckThrows(pool.Create(-1));
+		NatCheck(pool.GetLiveCount() == 20);
+
+		objects.clear();
+		NatCheck(pool.GetLiveCount() == 0 && pool.GetReservedCount() == 24);
+		NatCheck(Tracked::s_Alive == 0 && Tracked::s_Destroyed == destroyed + 30);
+	}
+
+	// 大小或对齐不符的对象不占用槽位
+	{
+		auto large = allocate_ref<LargeTracked>(pool, 1);
+		auto aligned = allocate_ref<AlignedTracked>(pool, 2);
+		NatCheck(large->Value == 1 && aligned->Value == 2);
+		NatCheck(IsAlignedTo(aligned.Get(), 64));
+		NatCheck(pool.GetLiveCount() == 0 && Tracked::s_Alive == 2);
+	}
+	NatCheck(pool.GetLiveCount() == 0 && pool.GetReservedCount() == 24);
+	NatCheck(Tracked::s_Alive == 0 && Tracked::s_Destroyed == destroyed + 32);
+}
+
+NatTestCase(RefObjWeakPointer)
+{
+	natWeakRefPointer<Tracked> weak;
+	NatCheck(weak.IsExpired() && weak.WeakCount() == 0 && !weak.Lock());
+
+	{
+		auto obj = make_ref<Tracked>(1);
+		weak = obj;
+		NatCheck(!weak.IsExpired() && weak.WeakCount() == 1);
+
+		// 同一对象的弱引用共用控制块
+		const natWeakRefPointer<Tracked> other{ obj };
+		auto forked = obj->ForkWeakRef();
+		NatCheck(other == weak && forked == weak && weak.WeakCount() == 3);
+		forked.Reset();
+		NatCheck(weak.WeakCount() == 2);
+
+		auto locked = weak.Lock();
+		NatCheck(locked == obj && obj.GetRefCount() == 2);
+		locked.Reset();
+		NatCheck(obj.GetRefCount() == 1);
+
+		// 类型不符时升级失败，且不影响引用计数
+		NatCheck(!weak.Lock<LargeTracked>() && obj.GetRefCount() == 1);
+	}
+
+	NatCheck(weak.IsExpired() && weak.WeakCount() == 1);
+	NatCheck(!weak.Lock() && Tracked::s_Alive == 0);
+
+	auto copy = weak;
+	NatCheck(copy.IsExpired() && !copy.Lock() && weak.WeakCount() == 2);
+}
+
+NatTestCase(RefObjWeakPointerConcurrentLock)
+{
+	for (nInt round = 0; round < 20; ++round)
+	{
+		auto obj = make_ref<Tracked>(round);
+		const natWeakRefPointer<Tracked> weak{ obj };
+		std::atomic<nBool> start{}, failed{};
+		std::vector<std::thread> threads;
+		for (nInt i = 0; i < 4; ++i)
+		{
+			threads.emplace_back([&]
+			{
+				while (!start.load())
+				{
+					std::this_thread::yield();
+				}
+
+				for (nInt j = 0; j < 1000; ++j)
+				{
+					const auto local = weak;
+					if (const auto locked = local.Lock())
+					{
+						failed.store(failed.load() || locked->Value != round || Tracked::s_Alive != 1);
+					}
+				}
+			});
+		}
+
+		// 在其他线程升级弱引用的同时释放本体
+		start.store(true);
+		std::this_thread::yield();
+		obj = nullptr;
+
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		NatCheck(!failed.load());
+		NatCheck(weak.IsExpired() && !weak.Lock() && weak.WeakCount() == 1);
+		NatCheck(Tracked::s_Alive == 0);
+	}
+}
+
+NatTestCase(RefObjNestedWeakPointer)
+{
+	natWeakRefPointer<Tracked> innerWeak;
+	natWeakRefPointer<NestedTracked> outerWeak;
+	{
+		const auto obj = make_ref<NestedTracked>(3);
+		innerWeak = natRefPointer<Tracked>{ obj };
+		outerWeak = obj;
+
+		// 无论通过哪一层获得弱引用，都使用同一个控制块
+		NatCheck(innerWeak == outerWeak && innerWeak.WeakCount() == 2);
+		NatCheck(obj.GetRefCount() == 1 && natRefPointer<Tracked>{ obj }.GetRefCount() == 2);
+
+		const auto locked = innerWeak.Lock<NestedTracked>();
+		NatCheck(locked == obj && obj.GetRefCount() == 2);
+	}
+
+	NatCheck(Tracked::s_Alive == 0);
+	NatCheck(innerWeak.IsExpired() && outerWeak.IsExpired());
+	NatCheck(!innerWeak.Lock() && !outerWeak.Lock());
+	NatCheck(innerWeak.WeakCount() == 2);
+}
+
+NatTestCase(RefObjNonAtomicPolicy)
+{
+	natWeakRefPointer<SingleThreaded> weak;
+	{
+		const auto obj = make_ref<NestedSingleThreaded>();
+		weak = natRefPointer<SingleThreaded>{ obj };
+		NatCheck(SingleThreaded::s_Alive == 1 && obj.GetRefCount() == 1 && obj->IsUnique());
+
+		{
+			auto copy = obj;
+			const auto locked = weak.Lock();
+			NatCheck(obj.GetRefCount() == 3 && locked == obj);
+			copy.Reset();
+			NatCheck(obj.GetRefCount() == 2);
+		}
+
+		NatCheck(obj.GetRefCount() == 1 && !weak.IsExpired());
+		NatCheck(natWeakRefPointer<NestedSingleThreaded>{ obj } == weak);
+	}
+
+	NatCheck(SingleThreaded::s_Alive == 0);
+	NatCheck(weak.IsExpired() && !weak.Lock() && weak.WeakCount() == 1);
+}
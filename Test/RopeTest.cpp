@@ -0,0 +1,115 @@
+﻿#include "TestHarness.h"
+#include <natRope.h>
+#include <natStream.h>
+#include <natStreamHelper.h>
+#include <random>
+#include <string>
+
+using namespace NatsuLib;
+
+namespace
+{
+	nStrView ToView(std::string const& str) noexcept
+	{
+		return { str.data(), str.size() };
+	}
+
+	nBool Matches(nRope const& rope, std::string const& model)
+	{
+		return rope.size() == model.size() && rope.ToString() == ToView(model) && rope.Compare(ToView(model)) == 0;
+	}
+}
+
+NatTestCase(RopeEditMatchesModel)
+{
+	std::mt19937 random{ 2333 };
+	nRope rope;
+	std::string model;
+
+	for (int i = 0; i < 2000; ++i)
+	{
+		const auto pos = model.empty() ? 0 : random() % (model.size() + 1);
+		switch (random() % 4)
+		{
+		case 0:
+		case 1:
+		{
+			const std::string text(random() % 40 + 1, static_cast<char>('a' + random() % 26));
+			rope.Insert(pos, ToView(text));
+			model.insert(pos, text);
+			break;
+		}
+		case 2:
+		{
+			const auto length = random() % 30;
+			rope.Erase(pos, length);
+			model.erase(std::min(pos, model.size()), length);
+			break;
+		}
+		default:
+		{
+			const std::string text(random() % 10 + 1, 'z');
+			rope += ToView(text);
+			model += text;
+			break;
+		}
+		}
+
+		NatCheck(rope.size() == model.size());
+	}
+
+	NatCheck(Matches(rope, model));
+	NatCheck(std::string(rope.begin(), rope.end()) == model);
+	for (std::size_t i = 0; i < model.size(); i += 97)
+	{
+		NatCheck(rope[i] == model[i]);
+	}
+
+	for (int i = 0; i < 100; ++i)
+	{
+		const auto begin = random() % (model.size() + 1);
+		const auto end = begin + random() % (model.size() - begin + 1);
+		NatCheck(Matches(rope.Slice(static_cast<std::ptrdiff_t>(begin), static_cast<std::ptrdiff_t>(end)), model.substr(begin, end - begin)));
+	}
+}
+
+NatTestCase(RopeFindAcrossChunks)
+{
+	nRope rope{ "hello "_nv };
+	rope += "wor"_nv;
+	rope += nRope{ "ld, world"_nv };
+	NatCheck(rope.GetChunkCount() >= 1);
+	NatCheck(rope.Find("world"_nv) == 6);
+	NatCheck(rope.Find("world"_nv, 7) == 13);
+	NatCheck(rope.FindBackward("world"_nv) == 13);
+	NatCheck(rope.Find('d') == 10);
+	NatCheck(rope.FindBackward('o') == 14);
+	NatCheck(rope.Find("xyz"_nv) == nRope::npos);
+	NatCheck(rope.StartWith("hello w"_nv) && rope.EndWith(", world"_nv));
+
+	std::vector<nString> parts;
+	rope.Split(","_nv, [&parts](nRope const& part)
+	{
+		parts.emplace_back(part.ToString());
+	});
+	NatCheck(parts.size() == 2 && parts[0] == "hello world"_nv && parts[1] == " world"_nv);
+
+	const auto copy = rope;
+	rope.Erase(0, 6);
+	NatCheck(copy.ToString() == "hello world, world"_nv);
+	NatCheck(rope.ToString() == "world, world"_nv);
+}
+
+NatTestCase(ReadToEndAsRope)
+{
+	std::string content;
+	for (int i = 0; i < 20000; ++i)
+	{
+		content += "line " + std::to_string(i) + "\n";
+	}
+
+	natStreamReader<StringType::Utf8> reader{ make_ref<natMemoryStream>(reinterpret_cast<ncData>(content.data()), content.size(), true, false, false) };
+	const auto rope = reader.ReadToEndAsRope();
+	NatCheck(rope.GetChunkCount() > 1);
+	NatCheck(Matches(rope, content));
+}
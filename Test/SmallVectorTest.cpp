@@ -0,0 +1,161 @@
+﻿#include "TestHarness.h"
+#include <natSmallVector.h>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace NatsuLib;
+
+namespace
+{
+	// 移动构造可能抛出异常，搬移时会退化为复制，复制在计数归零时抛出异常
+	struct Fragile
+	{
+		static nInt s_Alive;
+		static nInt s_CopiesLeft;
+		std::string Value;
+
+		explicit Fragile(std::string value)
+			: Value(std::move(value))
+		{
+			++s_Alive;
+		}
+
+		Fragile(Fragile const& other)
+			: Value(other.Value)
+		{
+			if (s_CopiesLeft == 0)
+			{
+				throw std::runtime_error("copy failed");
+			}
+			--s_CopiesLeft;
+			++s_Alive;
+		}
+
+		Fragile(Fragile&& other)
+			: Fragile(static_cast<Fragile const&>(other))
+		{
+		}
+
+		Fragile& operator=(Fragile const& other) = default;
+
+		~Fragile()
+		{
+			--s_Alive;
+		}
+	};
+
+	nInt Fragile::s_Alive{};
+	nInt Fragile::s_CopiesLeft{ -1 };
+}
+
+NatTestCase(SmallVectorRandomOperations)
+{
+	SmallVector<std::string, 4> vec;
+	std::vector<std::string> model;
+	std::mt19937 random{ 40 };
+
+	for (int step = 0; step < 5000; ++step)
+	{
+		const auto value = std::to_string(random() % 1000) + std::string(random() % 20, 'x');
+		switch (random() % 6)
+		{
+		case 0:
+			vec.push_back(value);
+			model.push_back(value);
+			break;
+		case 1:
+		{
+			const auto pos = model.empty() ? 0 : random() % (model.size() + 1);
+			vec.insert(vec.begin() + pos, value);
+			model.insert(model.begin() + pos, value);
+			break;
+		}
+		case 2:
+			if (!model.empty())
+			{
+				const auto pos = random() % model.size();
+				vec.erase(vec.begin() + pos);
+				model.erase(model.begin() + pos);
+			}
+			break;
+		case 3:
+			if (!model.empty())
+			{
+				vec.pop_back();
+				model.pop_back();
+			}
+			break;
+		case 4:
+		{
+			const auto count = random() % 10;
+			vec.resize(count, value);
+			model.resize(count, value);
+			break;
+		}
+		default:
+			vec.shrink_to_fit();
+			NatCheck(vec.size() > 4 || vec.IsInline());
+			break;
+		}
+
+		NatCheck(vec.size() == model.size());
+		NatCheck(std::equal(vec.begin(), vec.end(), model.begin(), model.end()));
+	}
+
+	auto copy = vec;
+	NatCheck(copy == vec);
+	auto moved = std::move(copy);
+	NatCheck(copy.empty() && moved == vec);
+	moved.assign({ "a", "b" });
+	swap(moved, vec);
+	NatCheck(vec.size() == 2 && vec.IsInline() && moved.size() == model.size());
+	NatCheckThrows(vec.at(2));
+}
+
+NatTestCase(SmallVectorRelocateIsExceptionSafe)
+{
+	{
+		SmallVector<Fragile, 2> vec;
+		vec.emplace_back("a");
+		vec.emplace_back("b");
+
+		// 增长时第二个元素的复制失败，原元素应保持不变，已复制的元素被析构
+		Fragile::s_CopiesLeft = 1;
+		NatCheckThrows(vec.emplace_back("c"));
+		Fragile::s_CopiesLeft = -1;
+		NatCheck(vec.size() == 2 && vec.IsInline());
+		NatCheck(vec[0].Value == "a" && vec[1].Value == "b");
+		NatCheck(Fragile::s_Alive == 2);
+
+		vec.emplace_back("c");
+		vec.reserve(16);
+		NatCheck(!vec.IsInline() && vec.size() == 3);
+
+		vec.pop_back();
+		Fragile::s_CopiesLeft = 0;
+		NatCheckThrows(vec.shrink_to_fit());
+		Fragile::s_CopiesLeft = -1;
+		NatCheck(!vec.IsInline() && vec[0].Value == "a" && vec[1].Value == "b");
+		NatCheck(Fragile::s_Alive == 2);
+
+		vec.shrink_to_fit();
+		NatCheck(vec.IsInline() && vec[1].Value == "b");
+	}
+	NatCheck(Fragile::s_Alive == 0);
+}
+
+NatTestCase(StaticVectorCapacity)
+{
+	StaticVector<nInt, 8> vec{ 1, 2, 3 };
+	vec.insert(vec.begin() + 1, { 7, 8 });
+	NatCheck(vec == (StaticVector<nInt, 8>{ 1, 7, 8, 2, 3 }));
+	vec.resize(8);
+	NatCheck(vec.size() == vec.capacity());
+	NatCheckThrows(vec.push_back(9));
+	NatCheck(vec.size() == 8);
+	vec.erase(vec.begin(), vec.begin() + 4);
+	NatCheck(vec.size() == 4 && vec.front() == 3);
+	NatCheckThrows(StaticVector<nInt, 2>(3));
+}
@@ -0,0 +1,107 @@
+﻿#include "TestHarness.h"
+#include <natStream.h>
+#include <natStreamHelper.h>
+#include <string>
+#include <vector>
+
+using namespace NatsuLib;
+
+namespace
+{
+	natRefPointer<natStream> MakeStream(const void* data, std::size_t size)
+	{
+		return make_ref<natMemoryStream>(static_cast<ncData>(data), size, true, false, false);
+	}
+
+	// 使用最小的缓冲区以使换行符及多字节字符跨越缓冲区边界
+	constexpr std::size_t SmallBuffer = natStreamReader<StringType::Utf8>::MinBufferSize;
+}
+
+NatTestCase(StreamReaderReadLine)
+{
+	std::vector<std::string> lines;
+	std::string content;
+	for (int i = 0; i < 200; ++i)
+	{
+		lines.push_back(std::string(i % 70, 'a' + i % 26) + u8"测试" + std::to_string(i));
+		content += lines.back() + "\r\n";
+	}
+	content += "last";
+	lines.emplace_back("last");
+
+	natStreamReader<StringType::Utf8> reader{ MakeStream(content.data(), content.size()), SmallBuffer };
+	reader.SetNewLine("\r\n"_nv);
+	nString line;
+	std::size_t count{};
+	while (reader.TryReadLine(line))
+	{
+		NatCheck(count < lines.size());
+		NatCheck(line == nStrView{ lines[count].data(), lines[count].size() });
+		++count;
+	}
+	NatCheck(count == lines.size());
+	NatCheck(reader.IsEndOfStream());
+}
+
+NatTestCase(StreamReaderLoneNewLineUnit)
+{
+	// 单独的 \r 不是换行符，应保留在行中
+	const std::string content = "a\rb\r\nc\r";
+	natStreamReader<StringType::Utf8> reader{ MakeStream(content.data(), content.size()), SmallBuffer };
+	reader.SetNewLine("\r\n"_nv);
+	NatCheck(reader.ReadLine() == "a\rb"_nv);
+	NatCheck(reader.ReadLine() == "c\r"_nv);
+	NatCheck(reader.ReadLine().empty());
+}
+
+NatTestCase(StreamReaderReadChunkKeepsCharacters)
+{
+	std::string content;
+	for (int i = 0; i < 500; ++i)
+	{
+		content += i % 3 ? u8"字" : "x";
+	}
+
+	natStreamReader<StringType::Utf8> reader{ MakeStream(content.data(), content.size()), SmallBuffer };
+	std::string result;
+	while (true)
+	{
+		const auto chunk = reader.ReadChunk(7);
+		if (chunk.empty())
+		{
+			break;
+		}
+		NatCheck(chunk.size() <= 7);
+		result.append(chunk.data(), chunk.size());
+		// 分块不会截断字符，因此下一个字节不会是 UTF-8 的后续字节
+		NatCheck(result.size() == content.size() || (static_cast<nByte>(content[result.size()]) & 0xC0) != 0x80);
+	}
+	NatCheck(result == content);
+}
+
+NatTestCase(StreamReaderMixedReads)
+{
+	const std::string content = u8"αβγ|first\nsecond|tail";
+	natStreamReader<StringType::Utf8> reader{ MakeStream(content.data(), content.size()), SmallBuffer };
+	reader.SetNewLine("\n"_nv);
+	nuInt codePoint;
+	NatCheck(reader.Peek(codePoint) && codePoint == 0x3B1);
+	NatCheck(reader.Read(codePoint) && codePoint == 0x3B1);
+	NatCheck(reader.ReadUntil({ '|' }) == u8"βγ"_nv);
+	NatCheck(reader.ReadLine() == "first"_nv);
+	NatCheck(reader.ReadUntil({ '|' }) == "second"_nv);
+	NatCheck(reader.ReadToEnd() == "tail"_nv);
+	NatCheck(!reader.Read(codePoint));
+}
+
+NatTestCase(StreamReaderUtf16)
+{
+	const std::u16string content = u"line1\n\U0001F600\U0001F600\nline3";
+	natStreamReader<StringType::Utf16> reader{ MakeStream(content.data(), content.size() * sizeof(char16_t)), SmallBuffer };
+	reader.SetNewLine(u"\n"_u16v);
+	NatCheck(reader.ReadLine() == u"line1"_u16v);
+	nuInt codePoint;
+	NatCheck(reader.Read(codePoint) && codePoint == 0x1F600);
+	NatCheck(reader.ReadLine() == u"\U0001F600"_u16v);
+	NatCheck(reader.ReadToEnd() == u"line3"_u16v);
+}
@@ -0,0 +1,97 @@
+﻿#include "TestHarness.h"
+#include <natStringBuilder.h>
+#include <thread>
+#include <vector>
+
+using namespace NatsuLib;
+
+NatTestCase(ArenaAllocate)
+{
+	natArena arena{ 256 };
+	const auto first = arena.Allocate(10, 1);
+	const auto second = arena.Allocate(8, 8);
+	NatCheck(first != second);
+	NatCheck(reinterpret_cast<std::uintptr_t>(second) % 8 == 0);
+
+	// 大于内存块大小的分配
+	const auto large = static_cast<nByte*>(arena.Allocate(1000));
+	std::fill_n(large, 1000, nByte{ 0xCC });
+
+	const auto last = arena.Allocate(16);
+	NatCheck(arena.TryExtend(last, 16, 32));
+	NatCheck(!arena.TryExtend(first, 10, 20));
+
+	const auto reserved = arena.GetReservedSize();
+	arena.Reset();
+	NatCheck(arena.GetAllocatedSize() == 0);
+	arena.Allocate(100);
+	NatCheck(arena.GetReservedSize() == reserved);
+}
+
+NatTestCase(StringBuilderAppend)
+{
+	natArena arena{ 64 };
+	nStringBuilder builder{ arena };
+	NatCheck(builder.empty());
+
+	nString expected;
+	for (int i = 0; i < 100; ++i)
+	{
+		builder.Append("abc"_nv).Append('-', 2);
+		expected.Append("abc--"_nv);
+	}
+	NatCheck(builder.GetView() == expected);
+	NatCheck(builder.ToString() == expected);
+
+	builder.pop_back();
+	NatCheck(builder.size() == expected.size() - 1);
+
+	builder.Clear();
+	builder += "x"_nv;
+	NatCheck(builder.GetView() == "x"_nv);
+
+	// 非最近分配的缓冲区扩展时需复制已有内容
+	nStringBuilder other{ arena };
+	other += "first"_nv;
+	builder.Append('y', 200);
+	NatCheck(builder.size() == 201 && builder.GetView().Find("xyy"_nv) == 0);
+	NatCheck(other.GetView() == "first"_nv);
+}
+
+NatTestCase(StringPoolIntern)
+{
+	nStringPool pool;
+	nString a{ "hello"_nv }, b{ "hello"_nv };
+	const auto internedA = pool.Intern(a);
+	const auto internedB = pool.Intern(b);
+	NatCheck(internedA.data() == internedB.data());
+	NatCheck(internedA == "hello"_nv && internedA.data()[internedA.size()] == 0);
+	NatCheck(pool.Owns(internedA));
+	NatCheck(!pool.Owns(a.GetView()));
+	NatCheck(!pool.Find("world"_nv));
+	NatCheck(pool.size() == 1);
+
+	std::vector<std::thread> threads;
+	std::vector<nStrView> results(4);
+	for (std::size_t i = 0; i < results.size(); ++i)
+	{
+		threads.emplace_back([&pool, &results, i]
+		{
+			for (int j = 0; j < 1000; ++j)
+			{
+				pool.Intern(natUtil::FormatString("{0}"_nv, j));
+			}
+			results[i] = pool.Intern("shared"_nv);
+		});
+	}
+	for (auto&& thread : threads)
+	{
+		thread.join();
+	}
+
+	NatCheck(pool.size() == 1002);
+	for (auto&& result : results)
+	{
+		NatCheck(result.data() == results[0].data());
+	}
+}
@@ -0,0 +1,76 @@
+﻿#include "TestHarness.h"
+#include <natStringUtil.h>
+#include <cmath>
+#include <limits>
+
+using namespace NatsuLib;
+
+NatTestCase(TryParseInteger)
+{
+	nInt intValue{};
+	NatCheck(natUtil::TryParse("12345"_nv, intValue) && intValue == 12345);
+	NatCheck(natUtil::TryParse("-2147483648"_nv, intValue) && intValue == std::numeric_limits<nInt>::min());
+	NatCheck(natUtil::TryParse("+7"_nv, intValue) && intValue == 7);
+	NatCheck(natUtil::TryParse("ff"_nv, intValue, 16) && intValue == 255);
+
+	intValue = 42;
+	NatCheck(!natUtil::TryParse("2147483648"_nv, intValue));
+	NatCheck(!natUtil::TryParse(""_nv, intValue));
+	NatCheck(!natUtil::TryParse("-"_nv, intValue));
+	NatCheck(!natUtil::TryParse(" 1"_nv, intValue));
+	NatCheck(!natUtil::TryParse("12a"_nv, intValue));
+	NatCheck(intValue == 42);
+
+	nuLong longValue{};
+	NatCheck(natUtil::TryParse("18446744073709551615"_nv, longValue) && longValue == std::numeric_limits<nuLong>::max());
+	NatCheck(!natUtil::TryParse("18446744073709551616"_nv, longValue));
+	NatCheck(!natUtil::TryParse("-1"_nv, longValue));
+	NatCheck(natUtil::TryParse("1234567890123456"_nv, longValue) && longValue == 1234567890123456);
+
+	nuInt u16Value{};
+	NatCheck(natUtil::TryParse(u"65535"_u16v, u16Value) && u16Value == 65535);
+}
+
+NatTestCase(TryParseFloat)
+{
+	nDouble value{};
+	NatCheck(natUtil::TryParse("0.1"_nv, value) && value == 0.1);
+	NatCheck(natUtil::TryParse("-1.5e-3"_nv, value) && value == -1.5e-3);
+	NatCheck(natUtil::TryParse("1e308"_nv, value) && value == 1e308);
+
+	value = 2.0;
+	NatCheck(!natUtil::TryParse("1.0x"_nv, value));
+	NatCheck(!natUtil::TryParse(""_nv, value));
+	NatCheck(value == 2.0);
+}
+
+NatTestCase(AppendNumber)
+{
+	nString str{ "x="_nv };
+	natUtil::AppendNumber(str, -123);
+	NatCheck(str == "x=-123"_nv);
+
+	str.Clear();
+	natUtil::AppendNumber(str, 255u, 16);
+	NatCheck(str == "ff"_nv);
+
+	str.Clear();
+	natUtil::AppendNumber(str, std::numeric_limits<nLong>::min());
+	NatCheck(str == "-9223372036854775808"_nv);
+
+	str.Clear();
+	natUtil::AppendNumber(str, 1.5, std::chars_format::fixed, 2);
+	NatCheck(str == "1.50"_nv);
+}
+
+NatTestCase(FloatRoundTrip)
+{
+	for (auto value : { 0.1, 1.0 / 3, 123456.789, 5e-324, std::numeric_limits<nDouble>::max(), -0.0 })
+	{
+		nString str;
+		natUtil::AppendNumber(str, value);
+		nDouble parsed{};
+		NatCheck(natUtil::TryParse(str, parsed));
+		NatCheck(parsed == value && std::signbit(parsed) == std::signbit(value));
+	}
+}
@@ -0,0 +1,62 @@
+﻿#include "TestHarness.h"
+#include <vector>
+
+using namespace NatsuLib;
+
+namespace TestHarness
+{
+	namespace
+	{
+		struct TestCase
+		{
+			const char* Name;
+			TestFunction Func;
+		};
+
+		std::vector<TestCase>& GetTestCases()
+		{
+			static std::vector<TestCase> s_TestCases;
+			return s_TestCases;
+		}
+	}
+
+	TestFailure::TestFailure(const char* expr, const char* file, int line)
+		: runtime_error{ std::string{ "Check failed: " } + expr + " (" + file + ":" + std::to_string(line) + ")" }
+	{
+	}
+
+	TestRegistrar::TestRegistrar(const char* name, TestFunction func)
+	{
+		GetTestCases().push_back({ name, func });
+	}
+
+	std::size_t RunAllTests(natLog& logger)
+	{
+		std::size_t failed{};
+		for (auto&& testCase : GetTestCases())
+		{
+			try
+			{
+				testCase.Func();
+				continue;
+			}
+			catch (natException& e)
+			{
+				logger.LogErr("[FAILED] {0}: {1}"_nv, testCase.Name, e.GetDesc());
+			}
+			catch (std::exception& e)
+			{
+				logger.LogErr("[FAILED] {0}: {1}"_nv, testCase.Name, e.what());
+			}
+			catch (...)
+			{
+				logger.LogErr("[FAILED] {0}: unknown exception"_nv, testCase.Name);
+			}
+
+			++failed;
+		}
+
+		logger.LogMsg("{0} of {1} test cases passed."_nv, GetTestCases().size() - failed, GetTestCases().size());
+		return failed;
+	}
+}
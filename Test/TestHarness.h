@@ -0,0 +1,43 @@
+﻿#pragma once
+#include <natLog.h>
+#include <stdexcept>
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////
+///	@brief	测试用例的注册及运行
+///	@remark	以 NatTestCase 定义的测试用例会在静态初始化时注册，由 RunAllTests 依次运行
+///			检查失败时抛出 TestFailure，测试用例中抛出的任何异常均视为失败
+////////////////////////////////////////////////////////////////////////////////
+namespace TestHarness
+{
+	typedef void(*TestFunction)();
+
+	class TestFailure
+		: public std::runtime_error
+	{
+	public:
+		TestFailure(const char* expr, const char* file, int line);
+	};
+
+	struct TestRegistrar
+	{
+		TestRegistrar(const char* name, TestFunction func);
+	};
+
+	///	@brief	运行所有已注册的测试用例
+	///	@return	失败的测试用例数
+	std::size_t RunAllTests(NatsuLib::natLog& logger);
+}
+
+#define NatTestCase(name) \
+	static void NatTest_##name(); \
+	static const ::TestHarness::TestRegistrar NatTestRegistrar_##name{ #name, &NatTest_##name }; \
+	static void NatTest_##name()
+
+#define NatCheck(...) do { if (!(__VA_ARGS__)) throw ::TestHarness::TestFailure{ #__VA_ARGS__, __FILE__, __LINE__ }; } while (false)
+
+#define NatCheckThrows(...) do { \
+	auto natCheckThrown_ = false; \
+	try { static_cast<void>(__VA_ARGS__); } catch (...) { natCheckThrown_ = true; } \
+	if (!natCheckThrown_) throw ::TestHarness::TestFailure{ "throws: " #__VA_ARGS__, __FILE__, __LINE__ }; \
+	} while (false)
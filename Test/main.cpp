@@ -1,5 +1,6 @@
 ﻿#include <iostream>
 #include <sstream>
+#include <cstring>
 
 #include <natUtil.h>
 #include <natMisc.h>
@@ -19,7 +20,16 @@
 #include <natProperty.h>
 #include <natContainer.h>
 #include <natInfixOperator.h>
+#include <natStopWatch.h>
+#include <natFlatHash.h>
+#include <natSmallVector.h>
+#include <natObjectPool.h>
+#include <filesystem>
 #include <forward_list>
+#include <thread>
+#include <unordered_map>
+
+#include "TestHarness.h"
 
 using namespace NatsuLib;
 
@@ -61,13 +71,29 @@ struct MulOp
 
 constexpr InfixOp<MulOp> Mul{};
 
-int main()
+// 参数：
+//	--tests-only	仅运行测试用例
+//	--no-pause		结束时不等待输入
+int main(int argc, char** argv)
 {
 	natEventBus eventBus;
 	natLog logger(eventBus);
 	natConsole console;
 	logger.UseDefaultAction(console);
 
+	nBool testsOnly{}, noPause{};
+	for (int i = 1; i < argc; ++i)
+	{
+		testsOnly |= !std::strcmp(argv[i], "--tests-only");
+		noPause |= !std::strcmp(argv[i], "--no-pause");
+	}
+
+	auto result = TestHarness::RunAllTests(logger) ? EXIT_FAILURE : EXIT_SUCCESS;
+	if (testsOnly)
+	{
+		return result;
+	}
+
 #ifdef _WIN32
 	console.WriteLine(console.GetTitle());
 	console.SetTitle("NatsuLib test"_nv);
@@ -130,6 +156,422 @@ int main()
 			std::cout << std::endl;
 		}
 
+		{
+			std::vector<nuInt> values(1000000);
+			nuInt seed = 1;
+			for (auto& value : values)
+			{
+				seed = seed * 1103515245u + 12345u;
+				value = (seed >> 8) % 100000;
+			}
+
+			const auto measure = [&logger](nStrView name, auto&& func)
+			{
+				natStopWatch watch;
+				const auto count = func();
+				logger.LogMsg("{0}: {1} results in {2} s"_nv, name, count, watch.GetElpased());
+			};
+
+			measure("group_by"_nv, [&values] { return from(values).group_by([](nuInt value) { return value; }).count(); });
+			measure("group_by_ordered"_nv, [&values] { return from(values).group_by_ordered([](nuInt value) { return value; }).count(); });
+			measure("distinct"_nv, [&values] { return from(values).distinct().count(); });
+			measure("distinct_ordered"_nv, [&values] { return from(values).distinct_ordered().count(); });
+			measure("join"_nv, [&values] { return from(values).take(100000).join(from(values), [](nuInt value) { return value; }, [](nuInt value) { return value; }).count(); });
+			measure("join_ordered"_nv, [&values] { return from(values).take(100000).join_ordered(from(values), [](nuInt value) { return value; }, [](nuInt value) { return value; }).count(); });
+		}
+
+		{
+			// 两者预留相同数量的桶，再插入不同数量的键以得到不同的负载因子
+			constexpr size_t bucketCount = (1 << 20) - 1;
+			std::vector<nuLong> keys(bucketCount);
+			nuLong seed = 1;
+			for (auto& key : keys)
+			{
+				seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+				key = seed;
+			}
+
+			const auto measure = [&logger, &keys](nStrView name, auto& map, size_t count)
+			{
+				natStopWatch watch;
+				for (size_t i = 0; i < count; ++i)
+				{
+					map.emplace(keys[i], i);
+				}
+				const auto insertTime = watch.GetElpased();
+
+				watch.Reset();
+				size_t found{};
+				for (size_t i = 0; i < count; ++i)
+				{
+					found += map.find(keys[i]) != map.end();
+				}
+				const auto hitTime = watch.GetElpased();
+
+				watch.Reset();
+				for (size_t i = count; i < keys.size(); ++i)
+				{
+					found += map.find(keys[i]) != map.end();
+				}
+				const auto missTime = watch.GetElpased();
+
+				logger.LogMsg("{0} (load factor {1}): insert {2} s, hit {3} s, miss {4} s, {5} found"_nv, name, map.load_factor(), insertTime, hitTime, missTime, found);
+			};
+
+			for (const auto loadFactor : { 0.25, 0.5, 0.75, 0.875 })
+			{
+				const auto count = static_cast<size_t>(bucketCount * loadFactor);
+
+				std::unordered_map<nuLong, size_t> unorderedMap;
+				unorderedMap.rehash(bucketCount);
+				measure("std::unordered_map"_nv, unorderedMap, count);
+
+				FlatHashMap<nuLong, size_t> flatHashMap;
+				flatHashMap.rehash(bucketCount);
+				measure("FlatHashMap"_nv, flatHashMap, count);
+			}
+		}
+
+		{
+			// 大量只含少数元素的短生命周期数组，元素数量不超过内联容量时 SmallVector 不需要分配内存
+			constexpr size_t iterations = 1000000;
+			const auto measure = [&logger](nStrView name, auto container)
+			{
+				natStopWatch watch;
+				size_t sum{};
+				for (size_t i = 0; i < iterations; ++i)
+				{
+					decltype(container) values;
+					for (size_t j = 0; j < i % 8; ++j)
+					{
+						values.push_back(j);
+					}
+					for (const auto value : values)
+					{
+						sum += value;
+					}
+				}
+				logger.LogMsg("{0}: {1} s, sum {2}"_nv, name, watch.GetElpased(), sum);
+			};
+
+			measure("std::vector"_nv, std::vector<size_t>{});
+			measure("SmallVector"_nv, SmallVector<size_t, 8>{});
+			measure("StaticVector"_nv, StaticVector<size_t, 8>{});
+		}
+
+		{
+			// 模拟每个压缩文件条目创建一次的流包装
+			constexpr size_t iterations = 1000000;
+			const auto stream = make_ref<natMemoryStream>(0, true, true, true);
+			const auto measure = [&logger](nStrView name, auto&& create)
+			{
+				natStopWatch watch;
+				nLen size{};
+				for (size_t i = 0; i < iterations; ++i)
+				{
+					size += create()->GetSize();
+				}
+				logger.LogMsg("{0}: {1} s, size {2}"_nv, name, watch.GetElpased(), size);
+			};
+
+			measure("make_ref"_nv, [&stream] { return make_ref<natSubStream>(stream, 0, 0); });
+
+			natObjectPool<natSubStream> subStreamPool;
+			measure("natObjectPool"_nv, [&stream, &subStreamPool] { return subStreamPool.Create(stream, 0, 0); });
+		}
+
+		{
+			// 多个线程同时将同一个弱引用升级为强引用
+			constexpr size_t iterations = 1000000;
+			struct WeakTarget : natRefObjImpl<WeakTarget, natRefObj> {};
+			const auto target = make_ref<WeakTarget>();
+			const natWeakRefPointer<WeakTarget> weakTarget = target;
+
+			for (const auto threadCount : { 1u, 2u, 4u, 8u })
+			{
+				natStopWatch watch;
+				std::vector<std::thread> threads;
+				for (nuInt i = 0; i < threadCount; ++i)
+				{
+					threads.emplace_back([&weakTarget]
+					{
+						for (size_t j = 0; j < iterations; ++j)
+						{
+							static_cast<void>(weakTarget.Lock());
+						}
+					});
+				}
+				for (auto& thread : threads)
+				{
+					thread.join();
+				}
+				logger.LogMsg("natWeakRefPointer::Lock with {0} threads: {1} s"_nv, threadCount, watch.GetElpased());
+			}
+		}
+
+		{
+			// 复制不同静态类型及引用计数策略的 natRefPointer
+			constexpr size_t iterations = 10000;
+			struct SingleThreadedObj : natRefObjImpl<SingleThreadedObj, natRefObj, RefCountPolicy::NonAtomic> {};
+			const auto measure = [&logger](nStrView name, auto const& pointer)
+			{
+				std::vector<std::decay_t<decltype(pointer)>> copies(1000);
+				natStopWatch watch;
+				for (size_t i = 0; i < iterations; ++i)
+				{
+					for (auto& copy : copies)
+					{
+						copy = pointer;
+					}
+					for (auto& copy : copies)
+					{
+						copy = nullptr;
+					}
+				}
+				logger.LogMsg("{0}: {1} s"_nv, name, watch.GetElpased());
+			};
+
+			const auto stream = make_ref<natMemoryStream>(0, true, true, true);
+			measure("natRefPointer<natStream> (virtual, atomic)"_nv, natRefPointer<natStream>{ stream });
+			measure("natRefPointer<natMemoryStream> (inlined, atomic)"_nv, stream);
+			measure("natRefPointer<SingleThreadedObj> (inlined, non-atomic)"_nv, make_ref<SingleThreadedObj>());
+		}
+
+		{
+			// 捕获 40 字节的 lambda，std::function 需要在堆上分配，Delegate 保存在内联存储中
+			constexpr size_t iterations = 1000000;
+			const auto measure = [&logger](nStrView name, auto delegate)
+			{
+				typedef decltype(delegate) Delegate_t;
+				const size_t a = 1, b = 2, c = 3, d = 4;
+				natStopWatch watch;
+				size_t sum{};
+				for (size_t i = 0; i < iterations; ++i)
+				{
+					Delegate_t func = [a, b, c, d, i](size_t x) { return a + b + c + d + i + x; };
+					const auto copy = func;
+					sum += copy(i);
+				}
+				logger.LogMsg("{0}: {1} s, sum {2}"_nv, name, watch.GetElpased(), sum);
+			};
+
+			measure("std::function"_nv, std::function<size_t(size_t)>{});
+			measure("Delegate"_nv, Delegate<size_t(size_t)>{});
+		}
+
+		{
+			// 多个线程同时向同一事件总线发送事件，Post 不再需要获得锁
+			constexpr size_t iterations = 1000000;
+			struct BenchmarkEvent : natEventBase {};
+			natEventBus bus;
+			bus.RegisterEvent<BenchmarkEvent>();
+			std::atomic<size_t> counter{};
+			for (nInt i = 0; i < 8; ++i)
+			{
+				bus.RegisterEventListener<BenchmarkEvent>([&counter](natEventBase&)
+				{
+					counter.fetch_add(1, std::memory_order_relaxed);
+				}, i % 3 - 1);
+			}
+
+			for (const auto threadCount : { 1u, 2u, 4u, 8u })
+			{
+				natStopWatch watch;
+				std::vector<std::thread> threads;
+				for (nuInt i = 0; i < threadCount; ++i)
+				{
+					threads.emplace_back([&bus, threadCount]
+					{
+						BenchmarkEvent event;
+						for (size_t j = 0; j < iterations / threadCount; ++j)
+						{
+							bus.Post(event);
+						}
+					});
+				}
+				for (auto& thread : threads)
+				{
+					thread.join();
+				}
+				logger.LogMsg("natEventBus::Post with {0} threads: {1} s"_nv, threadCount, watch.GetElpased());
+			}
+		}
+
+		{
+			// 日志更新事件处理函数写入文件，比较记录日志的线程所花费的时间
+			constexpr size_t lines = 100000;
+			std::stringstream sink;
+			const auto writeLine = [&sink](natEventBase& event)
+			{
+				sink << static_cast<natLog::EventLogUpdated&>(event).GetData() << std::endl;
+			};
+
+			{
+				natEventBus bus;
+				natLog syncLogger{ bus };
+				syncLogger.RegisterLogUpdateEventFunc(writeLine);
+				natStopWatch watch;
+				for (size_t i = 0; i < lines; ++i)
+				{
+					syncLogger.LogMsg("line {0}"_nv, i);
+				}
+				logger.LogMsg("Synchronous natLog: {0} s"_nv, watch.GetElpased());
+			}
+
+			{
+				natThreadPool dispatcher{ 1, 1 };
+				natEventBus bus;
+				AsyncEventOptions options;
+				options.Capacity = lines;
+				natStopWatch watch;
+				nDouble posted;
+				{
+					natLog asyncLogger{ bus, dispatcher, options };
+					asyncLogger.RegisterLogUpdateEventFunc(writeLine);
+					for (size_t i = 0; i < lines; ++i)
+					{
+						asyncLogger.LogMsg("line {0}"_nv, i);
+					}
+					posted = watch.GetElpased();
+				}
+				logger.LogMsg("Asynchronous natLog: {0} s in logging thread, {1} s until flushed"_nv, posted, watch.GetElpased());
+			}
+		}
+
+		{
+			// 通过事件总线与静态类型的事件通道发送同一事件
+			constexpr size_t iterations = 10000000;
+			struct CountingEvent : natEventBase
+			{
+				size_t Count = 0;
+			};
+
+			natEventBus bus;
+			bus.RegisterEvent<CountingEvent>();
+			bus.RegisterEventListener<CountingEvent>([](natEventBase& event)
+			{
+				++static_cast<CountingEvent&>(event).Count;
+			});
+			const auto channel = bus.GetChannel<CountingEvent>();
+			channel->RegisterEventListener([](CountingEvent& event)
+			{
+				++event.Count;
+			});
+
+			CountingEvent event;
+			natStopWatch busWatch;
+			for (size_t i = 0; i < iterations; ++i)
+			{
+				bus.Post(event);
+			}
+			const auto busTime = busWatch.GetElpased();
+			natStopWatch channelWatch;
+			for (size_t i = 0; i < iterations; ++i)
+			{
+				channel->Post(event);
+			}
+			logger.LogMsg("natEventBus::Post: {0} s, EventChannel::Post: {1} s, count {2}"_nv, busTime, channelWatch.GetElpased(), event.Count);
+		}
+
+		{
+			// 比较每次记录日志的耗时，同步方式在当前线程格式化并逐行刷新，异步后端仅写入二进制记录
+			constexpr size_t lines = 200000;
+			std::stringstream syncOutput;
+
+			{
+				natEventBus bus;
+				natLog syncLogger{ bus };
+				// 与 UseDefaultAction 相同的处理，但仅写入 syncOutput
+				syncLogger.RegisterLogUpdateEventFunc([&syncOutput](natEventBase& event)
+				{
+					auto&& eventLogUpdated = static_cast<natLog::EventLogUpdated&>(event);
+					const auto time = std::chrono::system_clock::to_time_t(eventLogUpdated.GetTime());
+					tm timeStruct;
+#ifdef _MSC_VER
+					localtime_s(&timeStruct, &time);
+#else
+					timeStruct = *localtime(&time);
+#endif
+					syncOutput << natUtil::FormatString("[{0}] [{1}] {2}"_nv, std::put_time(&timeStruct, "%F %T"), natLog::GetDefaultLogTypeName(static_cast<natLog::LogType>(eventLogUpdated.GetLogType())), eventLogUpdated.GetData()) << std::endl;
+				});
+				natStopWatch watch;
+				for (size_t i = 0; i < lines; ++i)
+				{
+					syncLogger.LogMsg("value {0}, ratio {1}, name {2}"_nv, i, i * 0.5, "test"_nv);
+				}
+				logger.LogMsg("Synchronous natLog: {0} ns per call"_nv, watch.GetElpased() * 1e9 / lines);
+			}
+
+			{
+				natStopWatch totalWatch;
+				nDouble elapsed;
+				{
+					natAsyncLogBackend backend;
+					backend.AddSink(make_ref<natStreamLogSink>(make_ref<natMemoryStream>(0, false, true, true)));
+					natEventBus bus;
+					natLog asyncLogger{ bus };
+					asyncLogger.UseBackend(&backend);
+					natStopWatch watch;
+					for (size_t i = 0; i < lines; ++i)
+					{
+						asyncLogger.LogMsg("value {0}, ratio {1}, name {2}"_nv, i, i * 0.5, "test"_nv);
+					}
+					elapsed = watch.GetElpased();
+				}
+				logger.LogMsg("natAsyncLogBackend: {0} ns per call, {1} s until written"_nv, elapsed * 1e9 / lines, totalWatch.GetElpased());
+			}
+		}
+
+		{
+			// 写入轮换的日志文件，超过 1 MB 的部分在后台压缩
+			constexpr size_t lines = 100000;
+			RotatingFileLogOptions options;
+			options.MaxFileSize = 1 << 20;
+			options.MaxTotalSize = 4 << 20;
+
+			natStopWatch watch;
+			{
+				natAsyncLogBackend backend;
+				backend.AddSink(make_ref<natRotatingFileLogSink>("RotatingLog.log"_nv, options));
+				natEventBus bus;
+				natLog fileLogger{ bus };
+				fileLogger.UseBackend(&backend);
+				for (size_t i = 0; i < lines; ++i)
+				{
+					fileLogger.LogMsg("value {0}, ratio {1}, name {2}"_nv, i, i * 0.5, "test"_nv);
+				}
+			}
+			logger.LogMsg("natRotatingFileLogSink: {0} lines written in {1} s"_nv, lines, watch.GetElpased());
+
+			// 删除写入的日志文件及轮换出的分段
+			std::error_code ec;
+			std::vector<std::filesystem::path> logFiles;
+			for (auto&& entry : std::filesystem::directory_iterator{ ".", ec })
+			{
+				if (entry.path().filename().u8string().compare(0, 12, "RotatingLog.") == 0)
+				{
+					logFiles.emplace_back(entry.path());
+				}
+			}
+			for (auto&& path : logFiles)
+			{
+				std::filesystem::remove(path, ec);
+			}
+		}
+
+		{
+			// 被阈值过滤的调试日志不格式化，也不对参数求值
+			constexpr size_t calls = 10000000;
+			auto category = logger.GetCategory("Test"_nv);
+			category->SetLevel(LogLevel::Info);
+			natStopWatch watch;
+			for (size_t i = 0; i < calls; ++i)
+			{
+				nat_LogDebug(*category, "value {0}, ratio {1}"_nv, i, i * 0.5);
+			}
+			logger.LogMsg("Disabled nat_LogDebug: {0} ns per call"_nv, watch.GetElpased() * 1e9 / calls);
+		}
+
 		{
 			natThreadPool pool{ 2, 4 };
 			auto ret = pool.QueueWork([](void* Param)
@@ -345,6 +787,7 @@ int main()
 #ifdef _WIN32
 	catch (natWinException& e)
 	{
+		result = EXIT_FAILURE;
 		logger.LogErr("Exception caught from {0}, file \"{1}\" line {2},\nDescription: {3}\nErrno: {4}, Msg: {5}"_nv, e.GetSource(), e.GetFile(), e.GetLine(), e.GetDesc(), e.GetErrNo(), e.GetErrMsg());
 #ifdef EnableExceptionStackTrace
 		logger.LogErr("Call stack:"_nv);
@@ -358,6 +801,7 @@ int main()
 #endif
 	catch (natErrException& e)
 	{
+		result = EXIT_FAILURE;
 		logger.LogErr("Exception caught from {0}, file \"{1}\" line {2},\nDescription: {3}\nErrno: {4}, Msg: {5}"_nv, e.GetSource(), e.GetFile(), e.GetLine(), e.GetDesc(), e.GetErrNo(), e.GetErrMsg());
 #ifdef EnableExceptionStackTrace
 		logger.LogErr("Call stack:"_nv);
@@ -374,6 +818,7 @@ int main()
 	}
 	catch (natException& e)
 	{
+		result = EXIT_FAILURE;
 		logger.LogErr("Exception caught from {0}, file \"{1}\" line {2},\nDescription: {3}"_nv, e.GetSource(), e.GetFile(), e.GetLine(), e.GetDesc());
 #ifdef EnableExceptionStackTrace
 		logger.LogErr("Call stack:"_nv);
@@ -389,9 +834,14 @@ int main()
 #endif
 	}
 
+	if (!noPause)
+	{
 #ifdef _WIN32
-	system("pause");
+		system("pause");
 #else
-	getchar();
+		getchar();
 #endif
+	}
+
+	return result;
 }